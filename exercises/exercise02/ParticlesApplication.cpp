@@ -2,47 +2,34 @@
 
 #include <ituGL/shader/Shader.h>
 #include <ituGL/geometry/VertexAttribute.h>
+#include <ituGL/geometry/Drawcall.h>
+#include <glm/mat4x4.hpp>
 #include <cassert>
 #include <array>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 
-// Structure defining that Particle data
-struct Particle
+// List of attributes of the particle vertices. Must match CpuParticleSystem::Vertex
+const std::array<VertexAttribute, 3> s_vertexAttributes =
 {
-    glm::vec2 position;
-    float size;
-    float birth;
-    float duration;
-    Color color;
-    glm::vec2 velocity;
-};
-
-// List of attributes of the particle. Must match the structure above
-const std::array<VertexAttribute, 6> s_vertexAttributes =
-{
-    VertexAttribute(Data::Type::Float, 2), // position
+    VertexAttribute(Data::Type::Float, 3), // position
     VertexAttribute(Data::Type::Float, 1), // size
-    VertexAttribute(Data::Type::Float, 1), // birth
-    VertexAttribute(Data::Type::Float, 1), // duration
     VertexAttribute(Data::Type::Float, 4), // color
-    VertexAttribute(Data::Type::Float, 2), // velocity
 };
 
 
 ParticlesApplication::ParticlesApplication()
     : Application(1024, 1024, "Particles demo")
-    , m_currentTimeUniform(0)
-    , m_gravityUniform(0)
     , m_mousePosition(0)
-    , m_particleCount(0)
-    , m_particleCapacity(2048)  // You can change the capacity here to have more particles
+    , m_particleCapacity(1 << 18)  // You can change the capacity here to have more particles
 {
 }
 
 void ParticlesApplication::Initialize()
 {
+    m_particles.Initialize(m_particleCapacity);
+
     InitializeGeometry();
 
     InitializeShaders();
@@ -53,18 +40,16 @@ void ParticlesApplication::Initialize()
     // Enable GL_PROGRAM_POINT_SIZE to have variable point size per-particle
     GetDevice().EnableFeature(GL_PROGRAM_POINT_SIZE);
 
-    // Enable GL_BLEND to have blending on the particles, and configure it as additive blending
+    // Enable GL_BLEND to have blending on the particles. It is configured before drawing each system
     GetDevice().EnableFeature(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
 
     // We need to enable V-sync, otherwise the framerate would be too high and spawn multiple particles in one click
     GetDevice().SetVSyncEnabled(true);
 
-    // Get "CurrentTime" uniform location in the shader program
-    m_currentTimeUniform = m_shaderProgram.GetUniformLocation("CurrentTime");
-
-    // Get "Gravity" uniform location in the shader program
-    m_gravityUniform = m_shaderProgram.GetUniformLocation("Gravity");
+    // GPU particles use the same gravity, and some drag so the attractor can hold them
+    m_gpuParticles.Initialize(s_gpuParticleCapacity);
+    m_gpuParticles.SetGravity(glm::vec3(0.0f, -9.8f, 0.0f));
+    m_gpuParticles.SetDrag(0.5f);
 }
 
 void ParticlesApplication::Update()
@@ -79,14 +64,34 @@ void ParticlesApplication::Update()
     // Emit particles while the left button is pressed
     if (window.IsMouseButtonPressed(Window::MouseButton::Left))
     {
-        float size = RandomRange(10.0f, 30.0f);
-        float duration = RandomRange(1.0f, 2.0f);
-        Color color = RandomColor();
         glm::vec2 velocity = 0.5f * (mousePosition - m_mousePosition) / GetDeltaTime();
 
-        EmitParticle(mousePosition, size, duration, color, velocity);
+        EmitParticles(s_particlesPerFrame, mousePosition, velocity);
     }
 
+    // Simulate the CPU particles, removing the ones that die
+    m_particles.Update(GetDeltaTime());
+
+    // Emit GPU particles while the right button is pressed. Only the emitter is set from the CPU
+    if (window.IsMouseButtonPressed(Window::MouseButton::Right))
+    {
+        GpuParticleSystem::Emitter emitter = m_gpuParticles.GetEmitter();
+        emitter.position = glm::vec3(mousePosition, 0.0f);
+        emitter.positionSpread = 0.01f;
+        emitter.velocity = glm::vec3(0.5f * (mousePosition - m_mousePosition) / GetDeltaTime(), 0.0f);
+        emitter.velocitySpread = 1.0f;
+        emitter.lifetime = glm::vec2(1.0f, 4.0f);
+        emitter.size = glm::vec2(1.0f, 3.0f);
+        m_gpuParticles.SetEmitter(emitter);
+        m_gpuParticles.Emit(static_cast<unsigned int>(s_gpuEmitRate * GetDeltaTime()));
+    }
+
+    // The middle button attracts the GPU particles to the mouse
+    float attractorStrength = window.IsMouseButtonPressed(Window::MouseButton::Middle) ? 2.0f : 0.0f;
+    m_gpuParticles.SetAttractor(0, glm::vec3(mousePosition, 0.0f), attractorStrength);
+
+    m_gpuParticles.Update(GetDeltaTime());
+
     // save the mouse position (to compare next frame and obtain velocity)
     m_mousePosition = mousePosition;
 }
@@ -99,36 +104,73 @@ void ParticlesApplication::Render()
     // Set our particles shader program
     m_shaderProgram.Use();
 
-    // Set CurrentTime uniform
-    m_shaderProgram.SetUniform(m_currentTimeUniform, GetCurrentTime());
-
-    // Set Gravity uniform
-    m_shaderProgram.SetUniform(m_gravityUniform, -9.8f);
+    // Write the vertices of the live particles directly in the VBO
+    // Mapping discards the old contents, so we don't wait for the GPU to finish drawing them
+    unsigned int particleCount = m_particles.GetCount();
+    if (particleCount > 0)
+    {
+        m_vbo.Bind();
+        std::span<std::byte> data = m_vbo.MapData(particleCount * sizeof(CpuParticleSystem::Vertex));
+        if (data.empty())
+        {
+            particleCount = 0;
+        }
+        else
+        {
+            m_particles.WriteVertices(std::span(reinterpret_cast<CpuParticleSystem::Vertex*>(data.data()), particleCount));
+
+            // The contents can be lost in rare cases, like a display mode change. Then we skip them this frame
+            if (!m_vbo.UnmapData())
+            {
+                particleCount = 0;
+            }
+        }
+        VertexBufferObject::Unbind();
+    }
 
     // Bind the particle system VAO
     m_vao.Bind();
 
-    // Draw points. The amount of points can't exceed the capacity
-    glDrawArrays(GL_POINTS, 0, std::min(m_particleCount, m_particleCapacity));
+    if (particleCount > 0)
+    {
+        // Sort the particles back to front. Positions are in normalized device coordinates, where Z points away from the camera
+        // View space looks down -Z, so the view matrix just flips Z
+        m_sorter.Sort(m_particles.GetPositionX(), m_particles.GetPositionY(), m_particles.GetPositionZ(),
+            glm::mat4(glm::vec4(1, 0, 0, 0), glm::vec4(0, 1, 0, 0), glm::vec4(0, 0, -1, 0), glm::vec4(0, 0, 0, 1)));
+
+        // Only the indices are uploaded in the sorted order. The EBO is part of the VAO state
+        m_ebo.Bind();
+        m_ebo.AllocateData(m_sorter.GetIndices(), BufferObject::Usage::StreamDraw);
+
+        // Alpha blending, that needs the particles sorted
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+        // Draw points, only the particles alive are in the VBO
+        Drawcall(Drawcall::Primitive::Points, particleCount, Data::Type::UInt).Draw();
+    }
+
+    // GPU particles use additive blending, so they don't need to be sorted. They are already in normalized device coordinates
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+    m_gpuParticles.Draw(glm::mat4(1.0f));
 
     Application::Render();
 }
 
 // Nothing to do in this method for this exercise.
-// Change s_vertexAttributes and the Particle struct to add new vertex attributes
+// Change s_vertexAttributes and CpuParticleSystem::Vertex to add new vertex attributes
 void ParticlesApplication::InitializeGeometry()
 {
     m_vbo.Bind();
 
     // Allocate enough data for all the particles
-    // Notice the DynamicDraw usage, because we will update the buffer every time we emit a particle
-    m_vbo.AllocateData(m_particleCapacity * sizeof(Particle), BufferObject::Usage::DynamicDraw);
+    // Notice the StreamDraw usage, because we will write the whole buffer every frame
+    m_vbo.AllocateData(m_particleCapacity * sizeof(CpuParticleSystem::Vertex), BufferObject::Usage::StreamDraw);
 
     m_vao.Bind();
 
     // Automatically iterate through the vertex attributes, and set the pointer
     // We use interleaved attributes, so the offset is local to the particle, and the stride is the size of the particle
-    GLsizei stride = sizeof(Particle);
+    GLsizei stride = sizeof(CpuParticleSystem::Vertex);
     GLint offset = 0;
     GLuint location = 0;
     for (const VertexAttribute& attribute : s_vertexAttributes)
@@ -160,32 +202,20 @@ void ParticlesApplication::InitializeShaders()
     }
 }
 
-void ParticlesApplication::EmitParticle(const glm::vec2& position, float size, float duration, const Color& color, const glm::vec2& velocity)
+void ParticlesApplication::EmitParticles(unsigned int count, const glm::vec2& position, const glm::vec2& velocity)
 {
-    // Initialize the particle
-    Particle particle;
-    particle.position = position;
-    particle.size = size;
-    particle.birth = GetCurrentTime();
-    particle.duration = duration;
-    particle.color = color;
-    particle.velocity = velocity;
-
-    // Get the index in the circular buffer
-    unsigned int particleIndex = m_particleCount % m_particleCapacity;
-
-    // Bind the VBO before updating data
-    m_vbo.Bind();
-
-    // Update the particle data in the VBO
-    int offset = particleIndex * sizeof(Particle);
-    m_vbo.UpdateData(std::span(&particle, 1), offset);
-
-    // Unbind the VBO
-    VertexBufferObject::Unbind();
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        // Spread the particles around the velocity of the mouse, and also in depth so they overlap in different orders
+        glm::vec3 particleVelocity(velocity + RandomRange(0.0f, 0.5f) * RandomDirection(), RandomRange(-0.4f, 0.4f));
+        float size = RandomRange(10.0f, 30.0f);
+        float duration = RandomRange(1.0f, 2.0f);
+        glm::vec3 color(RandomColor());
 
-    // Increment the particle count
-    m_particleCount++;
+        // Stop when the system is full
+        if (!m_particles.Emit(glm::vec3(position, 0.0f), particleVelocity, color, size, duration))
+            break;
+    }
 }
 
 void ParticlesApplication::LoadAndCompileShader(Shader& shader, const char* path)
@@ -3,7 +3,11 @@
 #include <ituGL/application/Application.h>
 #include <ituGL/geometry/VertexBufferObject.h>
 #include <ituGL/geometry/VertexArrayObject.h>
+#include <ituGL/geometry/ElementBufferObject.h>
 #include <ituGL/shader/ShaderProgram.h>
+#include <ituGL/particles/CpuParticleSystem.h>
+#include <ituGL/particles/GpuParticleSystem.h>
+#include <ituGL/particles/ParticleSorter.h>
 
 class ParticlesApplication : public Application
 {
@@ -25,8 +29,8 @@ private:
     // Helper function to encapsulate loading and compiling a shader
     void LoadAndCompileShader(Shader& shader, const char* path);
 
-    // Emit a new particle
-    void EmitParticle(const glm::vec2& position, float size, float duration, const Color& color, const glm::vec2& velocity);
+    // Emit new particles around the position
+    void EmitParticles(unsigned int count, const glm::vec2& position, const glm::vec2& velocity);
 
     // Helper methods for random values
     static float Random01();
@@ -35,27 +39,39 @@ private:
     static Color RandomColor();
 
 private:
-    // All particles stored in a single VBO with interleaved attributes
+    // Particles simulated in the CPU, emitted with the left button
+    CpuParticleSystem m_particles;
+
+    // Vertices of the live particles, written every frame
     VertexBufferObject m_vbo;
 
+    // Sorts the CPU particles back to front, they are drawn with alpha blending
+    ParticleSorter m_sorter;
+
+    // Indices of the vertices in the order that they are drawn
+    ElementBufferObject m_ebo;
+
     // VAO that represents the particle system
     VertexArrayObject m_vao;
 
     // Particles shader program
     ShaderProgram m_shaderProgram;
 
-    // Location of the "CurrentTime" uniform
-    ShaderProgram::Location m_currentTimeUniform;
-
-    // Location of the "Gravity" uniform
-    ShaderProgram::Location m_gravityUniform;
-
     // Mouse position during this frame
     glm::vec2 m_mousePosition;
 
-    // Total number of particles created
-    unsigned int m_particleCount;
-
     // Max number of particles that can exist at the same time
     const unsigned int m_particleCapacity;
+
+    // Particles emitted each frame with the left button
+    static constexpr unsigned int s_particlesPerFrame = 256;
+
+    // Particles emitted with the right button, simulated entirely in the GPU
+    GpuParticleSystem m_gpuParticles;
+
+    // Particles emitted each second with the right button
+    static constexpr float s_gpuEmitRate = 400000.0f;
+
+    // Particles that don't fit are not emitted
+    static constexpr unsigned int s_gpuParticleCapacity = 1 << 20;
 };
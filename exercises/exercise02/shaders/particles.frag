@@ -8,5 +8,5 @@ void main()
 {
 	float alpha = 1 - length(gl_PointCoord * 2 - 1);
 
-	FragColor = vec4(Color.rgb, Color.a * alpha);
+	FragColor = vec4(Color.rgb, Color.a * max(alpha, 0));
 }
@@ -0,0 +1,19 @@
+#version 330 core
+
+layout (location = 0) in vec4 PositionAge;
+layout (location = 1) in vec4 VelocityLifetime;
+layout (location = 2) in vec4 ColorSize;
+
+out vec4 Color;
+
+uniform mat4 ViewProjMatrix;
+
+void main()
+{
+	// Fade out during the life of the particle
+	float alpha = 1 - PositionAge.w / VelocityLifetime.w;
+	Color = vec4(ColorSize.rgb, alpha);
+
+	gl_PointSize = ColorSize.w;
+	gl_Position = ViewProjMatrix * vec4(PositionAge.xyz, 1.0);
+}
@@ -0,0 +1,6 @@
+#version 330 core
+
+// Nothing is rasterized while updating the particles
+void main()
+{
+}
@@ -0,0 +1,85 @@
+#version 330 core
+
+layout (location = 0) in vec4 PositionAge;
+layout (location = 1) in vec4 VelocityLifetime;
+layout (location = 2) in vec4 ColorSize;
+
+out vec4 UpdatedPositionAge;
+out vec4 UpdatedVelocityLifetime;
+out vec4 UpdatedColorSize;
+
+uniform float DeltaTime;
+
+// When set, the vertices have no attributes and a new particle is created from the vertex index
+uniform bool Emit;
+uniform uint RandomSeed;
+
+// Forces
+uniform vec3 Gravity;
+uniform float Drag;
+uniform vec4 Attractors[4];
+
+// Emitter ranges: position and velocity have the spread in w, lifetime range in xy and size range in zw
+uniform vec4 EmitterPosition;
+uniform vec4 EmitterVelocity;
+uniform vec3 EmitterColorMin;
+uniform vec3 EmitterColorMax;
+uniform vec4 EmitterLifetimeSize;
+
+// PCG hash, each call advances the state
+uint state;
+float Random01()
+{
+	state = state * 747796405u + 2891336453u;
+	uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+	return float((word >> 22u) ^ word) / 4294967295.0f;
+}
+
+// Uniformly distributed in a ball of radius 1
+vec3 RandomInBall()
+{
+	float z = Random01() * 2 - 1;
+	float angle = Random01() * 6.2831853f;
+	float radius = pow(Random01(), 1.0f / 3.0f);
+	return radius * vec3(sqrt(1 - z * z) * vec2(cos(angle), sin(angle)), z);
+}
+
+void main()
+{
+	if (Emit)
+	{
+		state = uint(gl_VertexID) * 1664525u + RandomSeed;
+
+		vec3 position = EmitterPosition.xyz + EmitterPosition.w * RandomInBall();
+		vec3 velocity = EmitterVelocity.xyz + EmitterVelocity.w * RandomInBall();
+		vec3 color = mix(EmitterColorMin, EmitterColorMax, vec3(Random01(), Random01(), Random01()));
+		float lifetime = mix(EmitterLifetimeSize.x, EmitterLifetimeSize.y, Random01());
+		float size = mix(EmitterLifetimeSize.z, EmitterLifetimeSize.w, Random01());
+
+		UpdatedPositionAge = vec4(position, 0);
+		UpdatedVelocityLifetime = vec4(velocity, lifetime);
+		UpdatedColorSize = vec4(color, size);
+	}
+	else
+	{
+		vec3 position = PositionAge.xyz;
+		vec3 velocity = VelocityLifetime.xyz;
+
+		vec3 acceleration = Gravity - Drag * velocity;
+		for (int i = 0; i < 4; ++i)
+		{
+			// Inverse square, clamped so that particles close to the attractor don't explode
+			vec3 offset = Attractors[i].xyz - position;
+			float distance2 = max(dot(offset, offset), 0.01f);
+			acceleration += Attractors[i].w * offset * inversesqrt(distance2) / distance2;
+		}
+
+		// Semi-implicit Euler
+		velocity += acceleration * DeltaTime;
+		position += velocity * DeltaTime;
+
+		UpdatedPositionAge = vec4(position, PositionAge.w + DeltaTime);
+		UpdatedVelocityLifetime = vec4(velocity, VelocityLifetime.w);
+		UpdatedColorSize = ColorSize;
+	}
+}
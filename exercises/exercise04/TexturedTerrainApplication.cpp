@@ -11,6 +11,8 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
+#include <algorithm>
+#include <array>
 #include <cmath>
 #include <iostream>
 #include <numbers>  // for PI constant
@@ -47,15 +49,34 @@ void TexturedTerrainApplication::Update()
 {
     Application::Update();
 
+    // Pick up the shader programs that finished building
+    if (m_shaderBatchLoader && m_shaderBatchLoader->Poll())
+    {
+        m_shaderBatchLoader.reset();
+    }
+
     const Window& window = GetMainWindow();
 
+    // Fly in a circle over the terrain, above the ground and the water
+    float angle = 0.05f * GetCurrentTime();
+    glm::vec2 cameraPosition = 0.35f * s_terrainSize * glm::vec2(std::cos(angle), std::sin(angle));
+    float groundHeight = std::max(m_terrain.GetHeight(cameraPosition), -0.15f * s_noiseScale);
+    glm::vec3 position(cameraPosition.x, groundHeight + 30.0f, cameraPosition.y);
+
+    // Look ahead, and turn with the mouse
     glm::vec2 mousePosition = window.GetMousePosition(true);
-    m_camera.SetViewMatrix(glm::vec3(0.0f, 15.0f, 15.0f), glm::vec3(mousePosition, 0.0f));
+    float heading = angle + 0.5f * std::numbers::pi_v<float> * (1.0f - mousePosition.x);
+    float pitch = 0.5f * mousePosition.y - 0.2f;
+    glm::vec3 direction(std::cos(heading) * std::cos(pitch), std::sin(pitch), std::sin(heading) * std::cos(pitch));
+    m_camera.SetViewMatrix(position, position + direction);
 
     int width, height;
     window.GetDimensions(width, height);
     float aspectRatio = static_cast<float>(width) / height;
-    m_camera.SetPerspectiveProjectionMatrix(1.0f, aspectRatio, 0.1f, 100.0f);
+    m_camera.SetPerspectiveProjectionMatrix(1.0f, aspectRatio, 0.5f, 2.0f * s_terrainSize);
+
+    // Pick the terrain nodes for the new camera
+    m_terrain.SelectNodes(position, m_camera.GetViewProjectionMatrix());
 }
 
 void TexturedTerrainApplication::Render()
@@ -65,17 +86,12 @@ void TexturedTerrainApplication::Render()
     // Clear color and depth
     GetDevice().Clear(true, Color(0.0f, 0.0f, 0.0f, 1.0f), true, 1.0f);
 
-    // Terrain patches
-    DrawObject(m_terrainPatch, *m_terrainMaterial00, glm::scale(glm::vec3(10.0f)));
-    DrawObject(m_terrainPatch, *m_terrainMaterial10, glm::translate(glm::vec3(-10.0f, 0.0f, 0.0f)) * glm::scale(glm::vec3(10.0f)));
-    DrawObject(m_terrainPatch, *m_terrainMaterial01, glm::translate(glm::vec3(0.0f, 0.0f, -10.0f)) * glm::scale(glm::vec3(10.0f)));
-    DrawObject(m_terrainPatch, *m_terrainMaterial11, glm::translate(glm::vec3(-10.0f, 0.0f, -10.0f)) * glm::scale(glm::vec3(10.0f)));
-
-    // Water patches
-    DrawObject(m_terrainPatch, *m_waterMaterial, glm::translate(glm::vec3(0.0f, -1.5f, 0.0f)) * glm::scale(glm::vec3(10.0f)));
-    DrawObject(m_terrainPatch, *m_waterMaterial, glm::translate(glm::vec3(-10.0f, -1.5f, 0.0f)) * glm::scale(glm::vec3(10.0f)));
-    DrawObject(m_terrainPatch, *m_waterMaterial, glm::translate(glm::vec3(0.0f, -1.5f, -10.0f)) * glm::scale(glm::vec3(10.0f)));
-    DrawObject(m_terrainPatch, *m_waterMaterial, glm::translate(glm::vec3(-10.0f, -1.5f, -10.0f)) * glm::scale(glm::vec3(10.0f)));
+    // Terrain
+    DrawTerrain();
+
+    // Water, covering the whole terrain
+    glm::vec3 waterCorner(-0.5f * s_terrainSize, -0.15f * s_noiseScale, -0.5f * s_terrainSize);
+    DrawObject(m_waterPatch, *m_waterMaterial, glm::translate(waterCorner) * glm::scale(glm::vec3(s_terrainSize)));
 }
 
 void TexturedTerrainApplication::InitializeTextures()
@@ -88,10 +104,10 @@ void TexturedTerrainApplication::InitializeTextures()
     m_rockTexture = LoadTexture("textures/rock.jpg");
     m_snowTexture = LoadTexture("textures/snow.jpg");
 
-    m_heightmapTexture00 = CreateHeightMap(m_gridX, m_gridY, glm::ivec2(0, 0));
-    m_heightmapTexture10 = CreateHeightMap(m_gridX, m_gridY, glm::ivec2(-1, 0));
-    m_heightmapTexture01 = CreateHeightMap(m_gridX, m_gridY, glm::ivec2(0, -1));
-    m_heightmapTexture11 = CreateHeightMap(m_gridX, m_gridY, glm::ivec2(-1, -1));
+    // A single heightmap for the whole terrain, centered on the origin
+    std::vector<float> heights = CreateHeightMap(s_heightmapSize, s_heightmapSize);
+    glm::vec3 terrainOrigin(-0.5f * s_terrainSize, 0.0f, -0.5f * s_terrainSize);
+    m_terrain.Initialize(heights, s_heightmapSize, s_heightmapSize, terrainOrigin, s_terrainSize, s_noiseScale, s_terrainLodCount);
 
     // Load water texture here
     m_waterTexture = LoadTexture("textures/water.png");
@@ -109,52 +125,49 @@ void TexturedTerrainApplication::InitializeMaterials()
     m_defaultMaterial = std::make_shared<Material>(defaultShaderProgram);
     m_defaultMaterial->SetUniformValue("Color", glm::vec4(1.0f));
 
-    // Terrain shader program
-    Shader terrainVS = m_vertexShaderLoader.Load("shaders/terrain.vert");
-    Shader terrainFS = m_fragmentShaderLoader.Load("shaders/terrain.frag");
-    std::shared_ptr<ShaderProgram> terrainShaderProgram = std::make_shared<ShaderProgram>();
-    terrainShaderProgram->Build(terrainVS, terrainFS);
-
-    // Terrain materials
-    m_terrainMaterial00 = std::make_shared<Material>(terrainShaderProgram);
-    m_terrainMaterial00->SetUniformValue("Color", glm::vec4(1.0f));
-    m_terrainMaterial00->SetUniformValue("Heightmap", m_heightmapTexture00);
-    m_terrainMaterial00->SetUniformValue("ColorTexture0", m_dirtTexture);
-    m_terrainMaterial00->SetUniformValue("ColorTexture1", m_grassTexture);
-    m_terrainMaterial00->SetUniformValue("ColorTexture2", m_rockTexture);
-    m_terrainMaterial00->SetUniformValue("ColorTexture3", m_snowTexture);
-    m_terrainMaterial00->SetUniformValue("ColorTextureRange01", glm::vec2(-0.2f, 0.0f));
-    m_terrainMaterial00->SetUniformValue("ColorTextureRange12", glm::vec2(0.1f, 0.2f));
-    m_terrainMaterial00->SetUniformValue("ColorTextureRange23", glm::vec2(0.25f, 0.3f));
-    m_terrainMaterial00->SetUniformValue("ColorTextureScale", glm::vec2(0.125f));
-
-    m_terrainMaterial10 = std::make_shared<Material>(*m_terrainMaterial00);
-    m_terrainMaterial10->SetUniformValue("Heightmap", m_heightmapTexture10);
-
-    m_terrainMaterial01 = std::make_shared<Material>(*m_terrainMaterial00);
-    m_terrainMaterial01->SetUniformValue("Heightmap", m_heightmapTexture01);
-
-    m_terrainMaterial11 = std::make_shared<Material>(*m_terrainMaterial00);
-    m_terrainMaterial11->SetUniformValue("Heightmap", m_heightmapTexture11);
-
-    // Water shader
-    Shader waterVS = m_vertexShaderLoader.Load("shaders/water.vert");
-    Shader waterFS = m_fragmentShaderLoader.Load("shaders/water.frag");
-    std::shared_ptr<ShaderProgram> waterShaderProgram = std::make_shared<ShaderProgram>();
-    waterShaderProgram->Build(waterVS, waterFS);
+    // Terrain and water programs are built in the background, their materials use the default one until they are ready
+    m_shaderBatchLoader = std::make_unique<ShaderBatchLoader>(&m_shaderProgramCache);
+
+    // Terrain material. Texture coordinates are in meters
+    // It can't be drawn with the default program, that doesn't place the nodes, so it is skipped until it is ready
+    m_terrainMaterial = std::make_shared<Material>();
+    std::array<const char*, 1> terrainVSPaths = { "shaders/terrain.vert" };
+    std::array<const char*, 1> terrainFSPaths = { "shaders/terrain.frag" };
+    m_shaderBatchLoader->Add(m_terrainMaterial, terrainVSPaths, terrainFSPaths, Material::NameSet(),
+        [this](std::shared_ptr<ShaderProgram>)
+        {
+            m_terrainMaterial->SetUniformValue("Color", glm::vec4(1.0f));
+            m_terrainMaterial->SetUniformValue("ColorTexture0", m_dirtTexture);
+            m_terrainMaterial->SetUniformValue("ColorTexture1", m_grassTexture);
+            m_terrainMaterial->SetUniformValue("ColorTexture2", m_rockTexture);
+            m_terrainMaterial->SetUniformValue("ColorTexture3", m_snowTexture);
+            m_terrainMaterial->SetUniformValue("ColorTextureRange01", glm::vec2(-0.2f, 0.0f));
+            m_terrainMaterial->SetUniformValue("ColorTextureRange12", glm::vec2(0.1f, 0.2f));
+            m_terrainMaterial->SetUniformValue("ColorTextureRange23", glm::vec2(0.25f, 0.3f));
+            m_terrainMaterial->SetUniformValue("ColorTextureScale", glm::vec2(0.1f));
+        });
 
     // Water material
-    m_waterMaterial = std::make_shared<Material>(waterShaderProgram);
-    m_waterMaterial->SetUniformValue("Color", glm::vec4(1.0f, 1.0f, 1.0f, 0.5f));
-    m_waterMaterial->SetUniformValue("ColorTexture", m_waterTexture);
-    m_waterMaterial->SetUniformValue("ColorTextureScale", glm::vec2(0.0625f));
+    m_waterMaterial = std::make_shared<Material>();
+    m_waterMaterial->SetPlaceholder(m_defaultMaterial);
     m_waterMaterial->SetBlendEquation(Material::BlendEquation::Add);
     m_waterMaterial->SetBlendParams(Material::BlendParam::SourceAlpha, Material::BlendParam::OneMinusSourceAlpha);
+    std::array<const char*, 1> waterVSPaths = { "shaders/water.vert" };
+    std::array<const char*, 1> waterFSPaths = { "shaders/water.frag" };
+    m_shaderBatchLoader->Add(m_waterMaterial, waterVSPaths, waterFSPaths, Material::NameSet(),
+        [this](std::shared_ptr<ShaderProgram>)
+        {
+            m_waterMaterial->SetUniformValue("Color", glm::vec4(1.0f, 1.0f, 1.0f, 0.5f));
+            m_waterMaterial->SetUniformValue("ColorTexture", m_waterTexture);
+            m_waterMaterial->SetUniformValue("ColorTextureScale", glm::vec2(1.0f));
+        });
+
+    m_shaderBatchLoader->Submit();
 }
 
 void TexturedTerrainApplication::InitializeMeshes()
 {
-    CreateTerrainMesh(m_terrainPatch, m_gridX, m_gridY);
+    CreateTerrainMesh(m_waterPatch, m_gridX, m_gridY);
 }
 
 std::shared_ptr<Texture2DObject> TexturedTerrainApplication::CreateDefaultTexture()
@@ -205,41 +218,55 @@ std::shared_ptr<Texture2DObject> TexturedTerrainApplication::LoadTexture(const c
     return texture;
 }
 
-std::shared_ptr<Texture2DObject> TexturedTerrainApplication::CreateHeightMap(unsigned int width, unsigned int height, glm::ivec2 coords)
+std::vector<float> TexturedTerrainApplication::CreateHeightMap(unsigned int width, unsigned int height)
 {
-    std::shared_ptr<Texture2DObject> heightmap = std::make_shared<Texture2DObject>();
+    // Same noise as the original patches, covering as many noise units as fit in the terrain
+    glm::vec2 noiseSize = glm::vec2(s_terrainSize / s_noiseScale);
 
     std::vector<float> pixels(height * width);
     for (unsigned int j = 0; j < height; ++j)
     {
         for (unsigned int i = 0; i < width; ++i)
         {
-            float x = static_cast<float>(i) / (width - 1) + coords.x;
-            float y = static_cast<float>(j) / (height - 1) + coords.y;
+            float x = (static_cast<float>(i) / (width - 1) - 0.5f) * noiseSize.x;
+            float y = (static_cast<float>(j) / (height - 1) - 0.5f) * noiseSize.y;
             pixels[j * width + i] = stb_perlin_fbm_noise3(x, y, 0.0f, 1.9f, 0.5f, 8) * 0.5f;
         }
     }
 
-    heightmap->Bind();
-    heightmap->SetImage<float>(0, width, height, TextureObject::FormatR, TextureObject::InternalFormatR16F, pixels);
-    heightmap->GenerateMipmap();
-
-    return heightmap;
+    return pixels;
 }
 
 void TexturedTerrainApplication::DrawObject(const Mesh& mesh, Material& material, const glm::mat4& worldMatrix)
 {
     material.Use();
 
-    ShaderProgram& shaderProgram = *material.GetShaderProgram();
+    // The program in use can be the one of the placeholder
+    const ShaderProgram& shaderProgram = *material.GetUsedMaterial().GetShaderProgram();
     ShaderProgram::Location locationWorldMatrix = shaderProgram.GetUniformLocation("WorldMatrix");
-    material.GetShaderProgram()->SetUniform(locationWorldMatrix, worldMatrix);
+    shaderProgram.SetUniform(locationWorldMatrix, worldMatrix);
     ShaderProgram::Location locationViewProjMatrix = shaderProgram.GetUniformLocation("ViewProjMatrix");
-    material.GetShaderProgram()->SetUniform(locationViewProjMatrix, m_camera.GetViewProjectionMatrix());
+    shaderProgram.SetUniform(locationViewProjMatrix, m_camera.GetViewProjectionMatrix());
 
     mesh.DrawSubmesh(0);
 }
 
+void TexturedTerrainApplication::DrawTerrain()
+{
+    if (!m_terrainMaterial->IsReady())
+        return;
+
+    // The terrain sets its own uniforms, with the camera of the last selection
+    m_terrain.SetMaterialUniforms(*m_terrainMaterial);
+    m_terrainMaterial->Use();
+
+    ShaderProgram& shaderProgram = *m_terrainMaterial->GetShaderProgram();
+    ShaderProgram::Location locationViewProjMatrix = shaderProgram.GetUniformLocation("ViewProjMatrix");
+    shaderProgram.SetUniform(locationViewProjMatrix, m_camera.GetViewProjectionMatrix());
+
+    m_terrain.Draw();
+}
+
 void TexturedTerrainApplication::CreateTerrainMesh(Mesh& mesh, unsigned int gridX, unsigned int gridY)
 {
     // Define the vertex structure
@@ -3,11 +3,15 @@
 #include <ituGL/application/Application.h>
 
 #include <ituGL/asset/ShaderLoader.h>
+#include <ituGL/asset/ShaderBatchLoader.h>
+#include <ituGL/asset/ShaderProgramCache.h>
 #include <ituGL/geometry/Mesh.h>
 #include <ituGL/camera/Camera.h>
 #include <ituGL/shader/Material.h>
+#include <ituGL/terrain/QuadtreeTerrain.h>
 #include <glm/mat4x4.hpp>
 #include <vector>
+#include <memory>
 
 class Texture2DObject;
 
@@ -27,9 +31,10 @@ private:
     void InitializeMeshes();
 
     void DrawObject(const Mesh& mesh, Material& material, const glm::mat4& worldMatrix);
+    void DrawTerrain();
 
     std::shared_ptr<Texture2DObject> CreateDefaultTexture();
-    std::shared_ptr<Texture2DObject> CreateHeightMap(unsigned int width, unsigned int height, glm::ivec2 coords);
+    std::vector<float> CreateHeightMap(unsigned int width, unsigned int height);
     std::shared_ptr<Texture2DObject> LoadTexture(const char* path);
 
     void CreateTerrainMesh(Mesh& mesh, unsigned int gridX, unsigned int gridY);
@@ -42,23 +47,33 @@ private:
     ShaderLoader m_vertexShaderLoader;
     ShaderLoader m_fragmentShaderLoader;
 
-    Mesh m_terrainPatch;
+    // Builds the programs of the materials while the application runs, until all of them are ready
+    ShaderProgramCache m_shaderProgramCache;
+    std::unique_ptr<ShaderBatchLoader> m_shaderBatchLoader;
+
+    // Terrain drawn with more detail close to the camera, from a single heightmap
+    QuadtreeTerrain m_terrain;
+
+    Mesh m_waterPatch;
 
     std::shared_ptr<Material> m_defaultMaterial;
-    std::shared_ptr<Material> m_terrainMaterial00;
-    std::shared_ptr<Material> m_terrainMaterial10;
-    std::shared_ptr<Material> m_terrainMaterial01;
-    std::shared_ptr<Material> m_terrainMaterial11;
+    std::shared_ptr<Material> m_terrainMaterial;
     std::shared_ptr<Material> m_waterMaterial;
 
     std::shared_ptr<Texture2DObject> m_defaultTexture;
-    std::shared_ptr<Texture2DObject> m_heightmapTexture00;
-    std::shared_ptr<Texture2DObject> m_heightmapTexture10;
-    std::shared_ptr<Texture2DObject> m_heightmapTexture01;
-    std::shared_ptr<Texture2DObject> m_heightmapTexture11;
     std::shared_ptr<Texture2DObject> m_dirtTexture;
     std::shared_ptr<Texture2DObject> m_grassTexture;
     std::shared_ptr<Texture2DObject> m_rockTexture;
     std::shared_ptr<Texture2DObject> m_snowTexture;
     std::shared_ptr<Texture2DObject> m_waterTexture;
+
+    // Side of the terrain in meters, and samples on each side of the heightmap
+    static constexpr float s_terrainSize = 1024.0f;
+    static constexpr unsigned int s_heightmapSize = 1025;
+
+    // Levels of the terrain quadtree, the leaves have a grid quad for each heightmap texel
+    static constexpr unsigned int s_terrainLodCount = 6;
+
+    // Meters in each unit of the noise. Heights are scaled the same, to keep the shape of the original patches
+    static constexpr float s_noiseScale = 128.0f;
 };
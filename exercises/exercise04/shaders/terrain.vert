@@ -1,23 +1,59 @@
 #version 330 core
 
-layout (location = 0) in vec3 VertexPosition;
-layout (location = 1) in vec3 VertexNormal;
-layout (location = 2) in vec2 VertexTexCoord;
+// Position in the grid of the node, from 0 to 1
+layout (location = 0) in vec2 GridPosition;
+
+// Per node: corner in XZ, size, and quads on each side of the grid. Then the distances where the morph starts and ends
+layout (location = 3) in vec4 NodeCornerSizeGrid;
+layout (location = 4) in vec2 NodeMorphRange;
 
 out vec3 WorldPosition;
 out vec3 WorldNormal;
 out vec2 TexCoord;
 out float Height;
 
-uniform mat4 WorldMatrix;
 uniform mat4 ViewProjMatrix;
+uniform vec3 CameraPosition;
+
 uniform sampler2D Heightmap;
+uniform vec2 HeightmapSize;
+uniform vec3 TerrainOrigin;
+uniform float TerrainSize;
+uniform float HeightScale;
+
+// Height in the heightmap, before scaling. Samples are at the texel centers, so the borders of the terrain match the first and last ones
+float SampleHeight(vec2 position)
+{
+	vec2 uv = (position - TerrainOrigin.xz) / TerrainSize;
+	return textureLod(Heightmap, (uv * (HeightmapSize - 1) + 0.5f) / HeightmapSize, 0).r;
+}
 
 void main()
 {
-	Height = texture(Heightmap, (VertexPosition.xz * 127 + 0.5f) / 128).r;
-	WorldPosition = (WorldMatrix * vec4(VertexPosition.x, Height, VertexPosition.z, 1.0)).xyz;
-	WorldNormal = (WorldMatrix * vec4(VertexNormal, 0.0)).xyz;
-	TexCoord = VertexTexCoord;
+	vec2 corner = NodeCornerSizeGrid.xy;
+	float nodeSize = NodeCornerSizeGrid.z;
+	float gridSize = NodeCornerSizeGrid.w;
+
+	vec2 position = corner + GridPosition * nodeSize;
+	float distance = length(CameraPosition - vec3(position.x, SampleHeight(position) * HeightScale + TerrainOrigin.y, position.y));
+
+	// Odd vertices slide to the previous even one, so at the end of the range the grid matches the next level
+	float morph = clamp((distance - NodeMorphRange.x) / (NodeMorphRange.y - NodeMorphRange.x), 0, 1);
+	vec2 oddOffset = fract(GridPosition * gridSize * 0.5f) * 2.0f;
+	position -= oddOffset * (nodeSize / gridSize) * morph;
+
+	Height = SampleHeight(position);
+	WorldPosition = vec3(position.x, Height * HeightScale + TerrainOrigin.y, position.y);
+
+	// Normal from the slope between the neighbor texels
+	vec2 texelSize = vec2(TerrainSize) / (HeightmapSize - 1);
+	float heightLeft = SampleHeight(position - vec2(texelSize.x, 0));
+	float heightRight = SampleHeight(position + vec2(texelSize.x, 0));
+	float heightDown = SampleHeight(position - vec2(0, texelSize.y));
+	float heightUp = SampleHeight(position + vec2(0, texelSize.y));
+	vec2 slope = vec2(heightRight - heightLeft, heightUp - heightDown) * HeightScale / (2 * texelSize);
+	WorldNormal = normalize(vec3(-slope.x, 1, -slope.y));
+
+	TexCoord = position;
 	gl_Position = ViewProjMatrix * vec4(WorldPosition, 1.0);
 }
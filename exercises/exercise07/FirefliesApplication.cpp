@@ -1,5 +1,8 @@
 #include "FirefliesApplication.h"
 
+#include "FireflyGBufferRenderPass.h"
+#include "FireflyLightsRenderPass.h"
+
 #include <ituGL/asset/ShaderLoader.h>
 #include <ituGL/asset/ModelLoader.h>
 #include <ituGL/asset/Texture2DLoader.h>
@@ -10,6 +13,9 @@
 #include <glm/gtx/transform.hpp>
 #include <imgui.h>
 
+// Fireflies that fit in the buffers of the GPU system
+static const unsigned int s_maxGpuFireflies = 32768;
+
 FirefliesApplication::FirefliesApplication()
     : Application(1024, 1024, "Fireflies demo")
     , m_renderMode(RenderMode::Deferred)
@@ -34,6 +40,7 @@ void FirefliesApplication::Initialize()
     InitializeModels();
     InitializeCamera();
     InitializeLights();
+    m_fireflySystem.Initialize(s_maxGpuFireflies);
     InitializeRenderer();
 
     DeviceGL& device = GetDevice();
@@ -255,6 +262,58 @@ void FirefliesApplication::InitializeDeferredMaterials()
         // Create material
         m_deferredMaterial = std::make_shared<Material>(shaderProgramPtr, filteredUniforms);
     }
+
+    // G-buffer material for the instanced fireflies, placed by the firefly state instead of a world matrix
+    {
+        std::vector<const char*> vertexShaderPaths;
+        vertexShaderPaths.push_back("shaders/version330.glsl");
+        vertexShaderPaths.push_back("shaders/gbuffer_instanced.vert");
+        Shader vertexShader = ShaderLoader(Shader::VertexShader).Load(vertexShaderPaths);
+
+        std::vector<const char*> fragmentShaderPaths;
+        fragmentShaderPaths.push_back("shaders/version330.glsl");
+        fragmentShaderPaths.push_back("shaders/gbuffer.frag");
+        Shader fragmentShader = ShaderLoader(Shader::FragmentShader).Load(fragmentShaderPaths);
+
+        std::shared_ptr<ShaderProgram> shaderProgramPtr = std::make_shared<ShaderProgram>();
+        shaderProgramPtr->Build(vertexShader, fragmentShader);
+
+        // Filter out uniforms that are not material properties
+        ShaderUniformCollection::NameSet filteredUniforms;
+        filteredUniforms.insert("ViewMatrix");
+        filteredUniforms.insert("ViewProjMatrix");
+
+        // Create material
+        m_gbufferInstancedMaterial = std::make_shared<Material>(shaderProgramPtr, filteredUniforms);
+    }
+
+    // Light volumes of the instanced fireflies
+    {
+        std::vector<const char*> vertexShaderPaths;
+        vertexShaderPaths.push_back("shaders/version330.glsl");
+        vertexShaderPaths.push_back("shaders/firefly_light.vert");
+        Shader vertexShader = ShaderLoader(Shader::VertexShader).Load(vertexShaderPaths);
+
+        std::vector<const char*> fragmentShaderPaths;
+        fragmentShaderPaths.push_back("shaders/version330.glsl");
+        fragmentShaderPaths.push_back("shaders/utils.glsl");
+        fragmentShaderPaths.push_back("shaders/blinn-phong.glsl");
+        fragmentShaderPaths.push_back("shaders/firefly_light.frag");
+        Shader fragmentShader = ShaderLoader(Shader::FragmentShader).Load(fragmentShaderPaths);
+
+        std::shared_ptr<ShaderProgram> shaderProgramPtr = std::make_shared<ShaderProgram>();
+        shaderProgramPtr->Build(vertexShader, fragmentShader);
+
+        // Filter out uniforms that are not material properties
+        ShaderUniformCollection::NameSet filteredUniforms;
+        filteredUniforms.insert("ViewProjMatrix");
+        filteredUniforms.insert("InvViewMatrix");
+        filteredUniforms.insert("InvProjMatrix");
+
+        // Create material, with the same range as the CPU fireflies
+        m_fireflyLightsMaterial = std::make_shared<Material>(shaderProgramPtr, filteredUniforms);
+        m_fireflyLightsMaterial->SetUniformValue("LightRange", glm::vec2(1.0f, 2.0f));
+    }
 }
 
 void FirefliesApplication::InitializeModels()
@@ -280,6 +339,28 @@ void FirefliesApplication::InitializeModels()
     // Load models
     m_fireflyModel = loader.Load("models/firefly/firefly.obj");
     m_floorModel = loader.Load("models/floor/floor.obj");
+
+    if (m_renderMode == RenderMode::Deferred)
+    {
+        // Same properties as the other materials, with the firefly scale done in the shader
+        m_gbufferInstancedMaterial->SetUniformValue("Color", glm::vec3(1.0f));
+        m_gbufferInstancedMaterial->SetUniformValue("AmbientReflectance", 1.0f);
+        m_gbufferInstancedMaterial->SetUniformValue("DiffuseReflectance", 1.0f);
+        m_gbufferInstancedMaterial->SetUniformValue("SpecularReflectance", 1.0f);
+        m_gbufferInstancedMaterial->SetUniformValue("SpecularExponent", 100.0f);
+        m_gbufferInstancedMaterial->SetUniformValue("InstanceScale", 0.25f);
+
+        // Uniform locations are different in this shader, so it needs its own loader
+        ModelLoader instancedLoader(m_gbufferInstancedMaterial);
+        instancedLoader.SetCreateMaterials(true);
+        instancedLoader.SetMaterialAttribute(VertexAttribute::Semantic::Position, "VertexPosition");
+        instancedLoader.SetMaterialAttribute(VertexAttribute::Semantic::Normal, "VertexNormal");
+        instancedLoader.SetMaterialAttribute(VertexAttribute::Semantic::TexCoord0, "VertexTexCoord");
+        instancedLoader.SetMaterialProperty(ModelLoader::MaterialProperty::DiffuseColor, "Color");
+        instancedLoader.SetMaterialProperty(ModelLoader::MaterialProperty::DiffuseTexture, "ColorTexture");
+        instancedLoader.SetMaterialProperty(ModelLoader::MaterialProperty::SpecularExponent, "SpecularExponent");
+        m_fireflyInstancedModel = instancedLoader.Load("models/firefly/firefly.obj");
+    }
 }
 
 void FirefliesApplication::InitializeCamera()
@@ -305,6 +386,8 @@ void FirefliesApplication::InitializeRenderer()
     switch (m_renderMode)
     {
     case RenderMode::Forward:
+        // The floor is a single drawcall under all the fireflies, it needs every light that reaches it
+        m_renderer.SetMaxDrawcallLights(0);
         m_renderer.AddRenderPass(std::make_unique<ForwardRenderPass>());
         break;
     case RenderMode::Deferred:
@@ -314,15 +397,21 @@ void FirefliesApplication::InitializeRenderer()
             GetMainWindow().GetDimensions(width, height);
             std::unique_ptr<GBufferRenderPass> gbufferRenderPass(std::make_unique<GBufferRenderPass>(width, height));
 
-            // Set the g-buffer textures as properties of the deferred material
-            m_deferredMaterial->SetUniformValue("DepthTexture", gbufferRenderPass->GetDepthTexture());
-            m_deferredMaterial->SetUniformValue("AlbedoTexture", gbufferRenderPass->GetAlbedoTexture());
-            m_deferredMaterial->SetUniformValue("NormalTexture", gbufferRenderPass->GetNormalTexture());
-            m_deferredMaterial->SetUniformValue("OthersTexture", gbufferRenderPass->GetOthersTexture());
+            // Set the g-buffer textures as properties of the deferred materials
+            for (std::shared_ptr<Material> material : { m_deferredMaterial, m_fireflyLightsMaterial })
+            {
+                material->SetUniformValue("DepthTexture", gbufferRenderPass->GetDepthTexture());
+                material->SetUniformValue("AlbedoTexture", gbufferRenderPass->GetAlbedoTexture());
+                material->SetUniformValue("NormalTexture", gbufferRenderPass->GetNormalTexture());
+                material->SetUniformValue("OthersTexture", gbufferRenderPass->GetOthersTexture());
+            }
+            std::shared_ptr<const FramebufferObject> gbuffer = gbufferRenderPass->GetTargetFramebuffer();
 
-            // Add the render passes
+            // Add the render passes. The GPU fireflies are drawn after the rest of the g-buffer and after the other lights
             m_renderer.AddRenderPass(std::move(gbufferRenderPass));
+            m_renderer.AddRenderPass(std::make_unique<FireflyGBufferRenderPass>(m_fireflySystem, m_fireflyInstancedModel, gbuffer));
             m_renderer.AddRenderPass(std::make_unique<DeferredRenderPass>(m_deferredMaterial));
+            m_renderer.AddRenderPass(std::make_unique<FireflyLightsRenderPass>(m_fireflySystem, m_fireflyLightsMaterial));
             break;
         }
     }
@@ -339,6 +428,16 @@ void FirefliesApplication::RenderGUI()
     ImGui::DragFloat("Light intensity", &m_lightIntensity, 0.05f, 0.0f, 100.0f);
     ImGui::Checkbox("Use random color", &m_useRandomColor);
 
+    if (m_renderMode == RenderMode::Deferred)
+    {
+        ImGui::Separator();
+        ImGui::Text("Fireflies: %u / %u", m_fireflySystem.GetCount(), m_fireflySystem.GetCapacity());
+        if (ImGui::Button("Add 1000 fireflies"))
+        {
+            AddRandomFireflies(1000);
+        }
+    }
+
     m_imGui.EndFrame();
 }
 
@@ -357,6 +456,10 @@ void FirefliesApplication::UpdateFireflies()
     }
 
     m_renderer.AddModel(m_floorModel, glm::mat4(1.0f));
+
+    // GPU fireflies never go through the renderer, they are moved and drawn by their own passes
+    m_fireflySystem.Update(GetDeltaTime());
+
     for (Firefly& firefly : m_fireflies)
     {
         float deltaTime = GetDeltaTime();
@@ -380,11 +483,18 @@ void FirefliesApplication::UpdateFireflies()
 
 void FirefliesApplication::AddFirefly(glm::vec2 position2D)
 {
-    Firefly& firefly = m_fireflies.emplace_back();
-
     float scale = 4.0;
     glm::vec3 position3D(position2D.x * scale, RandomRange(0.8f, 1.0f), position2D.y * -scale);
 
+    if (m_renderMode == RenderMode::Deferred)
+    {
+        glm::vec3 color = m_useRandomColor ? glm::vec3(RandomColor()) : m_lightColor;
+        m_fireflySystem.AddFirefly(position3D, RandomRange(-3.1416f, 3.1416f), color * m_lightIntensity);
+        return;
+    }
+
+    Firefly& firefly = m_fireflies.emplace_back();
+
     PointLight& pointLight = firefly.pointLight;
     pointLight.SetPosition(position3D);
     pointLight.SetColor(m_useRandomColor ? glm::vec3(RandomColor()) : m_lightColor);
@@ -396,6 +506,15 @@ void FirefliesApplication::AddFirefly(glm::vec2 position2D)
     firefly.rotationSpeed = 0.0f;
 }
 
+void FirefliesApplication::AddRandomFireflies(unsigned int count)
+{
+    // Spread over the same area that can be clicked
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        AddFirefly(glm::vec2(RandomRange(-1.0f, 1.0f), RandomRange(-1.0f, 1.0f)));
+    }
+}
+
 float FirefliesApplication::Random01()
 {
     return static_cast<float>(rand()) / RAND_MAX;
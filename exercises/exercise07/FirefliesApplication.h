@@ -7,6 +7,7 @@
 #include <ituGL/lighting/PointLight.h>
 #include <ituGL/renderer/Renderer.h>
 #include <ituGL/utils/DearImGui.h>
+#include "FireflySystem.h"
 #include <vector>
 
 class Texture2DObject;
@@ -36,6 +37,7 @@ private:
     void UpdateFireflies();
 
     void AddFirefly(glm::vec2 position);
+    void AddRandomFireflies(unsigned int count);
 
     float Random01();
     float RandomRange(float from, float to);
@@ -61,12 +63,16 @@ private:
     std::shared_ptr<Material> m_forwardMaterial;
     std::shared_ptr<Material> m_gbufferMaterial;
     std::shared_ptr<Material> m_deferredMaterial;
+    std::shared_ptr<Material> m_gbufferInstancedMaterial;
+    std::shared_ptr<Material> m_fireflyLightsMaterial;
 
     // Loaded models
     Model m_floorModel;
     Model m_fireflyModel;
+    // Same model, with materials that draw one instance per firefly of the GPU system
+    Model m_fireflyInstancedModel;
 
-    // Fireflies collection
+    // Fireflies collection, simulated in the CPU with one light each. Used in forward mode
     struct Firefly
     {
         PointLight pointLight;
@@ -75,6 +81,9 @@ private:
     };
     std::vector<Firefly> m_fireflies;
 
+    // Fireflies simulated in the GPU, with instanced light volumes. Used in deferred mode
+    FireflySystem m_fireflySystem;
+
     // True if mouse has been pressed and not released (to avoid creating one firefly each frame)
     bool m_mouseClicked;
 
@@ -0,0 +1,54 @@
+#include "FireflyGBufferRenderPass.h"
+
+#include "FireflySystem.h"
+#include <ituGL/renderer/Renderer.h>
+#include <ituGL/camera/Camera.h>
+#include <ituGL/geometry/Model.h>
+#include <ituGL/geometry/Mesh.h>
+#include <ituGL/shader/Material.h>
+
+FireflyGBufferRenderPass::FireflyGBufferRenderPass(const FireflySystem& fireflySystem, Model& model,
+    std::shared_ptr<const FramebufferObject> targetFramebuffer)
+    : RenderPass(targetFramebuffer)
+    , m_fireflySystem(fireflySystem)
+    , m_model(model)
+{
+    // All the submeshes share the shader program of the reference material
+    std::shared_ptr<const ShaderProgram> shaderProgram = m_model.GetMaterial(0).GetShaderProgram();
+    m_viewMatrixLocation = shaderProgram->GetUniformLocation("ViewMatrix");
+    m_viewProjMatrixLocation = shaderProgram->GetUniformLocation("ViewProjMatrix");
+
+    // The vertex arrays of the model also read the state of the fireflies
+    Mesh& mesh = m_model.GetMesh();
+    for (unsigned int vaoIndex = 0; vaoIndex < mesh.GetVertexArrayCount(); ++vaoIndex)
+    {
+        m_fireflySystem.SetupInstanceAttributes(mesh.GetVertexArray(vaoIndex));
+    }
+}
+
+void FireflyGBufferRenderPass::Render()
+{
+    if (m_fireflySystem.GetCount() == 0)
+        return;
+
+    Renderer& renderer = GetRenderer();
+    const Camera& camera = renderer.GetCurrentCamera();
+
+    bool wasSRGB = renderer.GetDevice().IsFeatureEnabled(GL_FRAMEBUFFER_SRGB);
+    renderer.GetDevice().EnableFeature(GL_FRAMEBUFFER_SRGB);
+
+    const Mesh& mesh = m_model.GetMesh();
+    for (unsigned int submeshIndex = 0; submeshIndex < mesh.GetSubmeshCount(); ++submeshIndex)
+    {
+        const Material& material = m_model.GetMaterial(submeshIndex);
+        material.Use();
+
+        std::shared_ptr<const ShaderProgram> shaderProgram = material.GetShaderProgram();
+        shaderProgram->SetUniform(m_viewMatrixLocation, camera.GetViewMatrix());
+        shaderProgram->SetUniform(m_viewProjMatrixLocation, camera.GetViewProjectionMatrix());
+
+        m_fireflySystem.DrawInstanced(mesh.GetSubmeshVertexArray(submeshIndex), mesh.GetSubmeshDrawcall(submeshIndex));
+    }
+
+    renderer.GetDevice().SetFeatureEnabled(GL_FRAMEBUFFER_SRGB, wasSRGB);
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <ituGL/renderer/RenderPass.h>
+#include <ituGL/shader/ShaderProgram.h>
+
+class FireflySystem;
+class Model;
+
+// Draws the model of all the fireflies to the g-buffer in one instanced drawcall per submesh
+// The materials of the model need a vertex shader that places each instance with the firefly state
+class FireflyGBufferRenderPass : public RenderPass
+{
+public:
+    FireflyGBufferRenderPass(const FireflySystem& fireflySystem, Model& model, std::shared_ptr<const FramebufferObject> targetFramebuffer);
+
+    void Render() override;
+
+private:
+    const FireflySystem& m_fireflySystem;
+    Model& m_model;
+
+    ShaderProgram::Location m_viewMatrixLocation;
+    ShaderProgram::Location m_viewProjMatrixLocation;
+};
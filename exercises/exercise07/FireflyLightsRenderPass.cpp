@@ -0,0 +1,78 @@
+#include "FireflyLightsRenderPass.h"
+
+#include "FireflySystem.h"
+#include <ituGL/renderer/Renderer.h>
+#include <ituGL/camera/Camera.h>
+#include <ituGL/geometry/VertexFormat.h>
+#include <ituGL/shader/Material.h>
+#include <glm/matrix.hpp>
+#include <array>
+#include <vector>
+
+FireflyLightsRenderPass::FireflyLightsRenderPass(const FireflySystem& fireflySystem, std::shared_ptr<Material> material,
+    std::shared_ptr<const FramebufferObject> targetFramebuffer)
+    : RenderPass(targetFramebuffer)
+    , m_fireflySystem(fireflySystem)
+    , m_material(material)
+{
+    std::shared_ptr<const ShaderProgram> shaderProgram = m_material->GetShaderProgram();
+    m_viewProjMatrixLocation = shaderProgram->GetUniformLocation("ViewProjMatrix");
+    m_invViewMatrixLocation = shaderProgram->GetUniformLocation("InvViewMatrix");
+    m_invProjMatrixLocation = shaderProgram->GetUniformLocation("InvProjMatrix");
+
+    // Lights are added to the image of the deferred pass, and the depth is read from the g-buffer instead
+    m_material->SetDepthTestFunction(Material::TestFunction::Always);
+    m_material->SetDepthWrite(false);
+    m_material->SetBlendEquation(Material::BlendEquation::Add);
+    m_material->SetBlendParams(Material::BlendParam::One, Material::BlendParam::One);
+
+    InitializeVolumeMesh();
+}
+
+void FireflyLightsRenderPass::Render()
+{
+    if (m_fireflySystem.GetCount() == 0)
+        return;
+
+    Renderer& renderer = GetRenderer();
+    const Camera& camera = renderer.GetCurrentCamera();
+
+    m_material->Use();
+    std::shared_ptr<const ShaderProgram> shaderProgram = m_material->GetShaderProgram();
+    shaderProgram->SetUniform(m_viewProjMatrixLocation, camera.GetViewProjectionMatrix());
+    shaderProgram->SetUniform(m_invViewMatrixLocation, glm::inverse(camera.GetViewMatrix()));
+    shaderProgram->SetUniform(m_invProjMatrixLocation, glm::inverse(camera.GetProjectionMatrix()));
+
+    // Draw the back faces, so the volumes still cover the pixels when the camera is inside
+    glCullFace(GL_FRONT);
+    m_fireflySystem.DrawInstanced(m_volumeMesh.GetSubmeshVertexArray(0), m_volumeMesh.GetSubmeshDrawcall(0));
+    glCullFace(GL_BACK);
+
+    renderer.GetDevice().SetFeatureEnabled(GL_BLEND, false);
+    glDepthFunc(GL_LESS);
+    glDepthMask(GL_TRUE);
+}
+
+void FireflyLightsRenderPass::InitializeVolumeMesh()
+{
+    VertexFormat vertexFormat;
+    vertexFormat.AddVertexAttribute<float>(3, VertexAttribute::Semantic::Position);
+
+    // Two triangles for each face, counter-clockwise seen from outside: u x v points along the normal
+    std::array<glm::vec3, 6> normals = { glm::vec3(1, 0, 0), glm::vec3(-1, 0, 0), glm::vec3(0, 1, 0), glm::vec3(0, -1, 0), glm::vec3(0, 0, 1), glm::vec3(0, 0, -1) };
+    std::array<glm::vec3, 6> axesU = { glm::vec3(0, 1, 0), glm::vec3(0, 0, 1), glm::vec3(0, 0, 1), glm::vec3(1, 0, 0), glm::vec3(1, 0, 0), glm::vec3(0, 1, 0) };
+    std::vector<glm::vec3> vertices;
+    for (unsigned int face = 0; face < normals.size(); ++face)
+    {
+        glm::vec3 n = normals[face];
+        glm::vec3 u = axesU[face];
+        glm::vec3 v = glm::cross(n, u);
+        std::array<glm::vec3, 4> corners = { n - u - v, n + u - v, n + u + v, n - u + v };
+        vertices.insert(vertices.end(), { corners[0], corners[1], corners[2], corners[0], corners[2], corners[3] });
+    }
+
+    m_volumeMesh.AddSubmesh<glm::vec3, VertexFormat::LayoutIterator>(Drawcall::Primitive::Triangles, vertices,
+        vertexFormat.LayoutBegin(static_cast<int>(vertices.size()), false), vertexFormat.LayoutEnd());
+
+    m_fireflySystem.SetupInstanceAttributes(m_volumeMesh.GetVertexArray(0));
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <ituGL/renderer/RenderPass.h>
+#include <ituGL/shader/ShaderProgram.h>
+#include <ituGL/geometry/Mesh.h>
+
+class FireflySystem;
+class Material;
+
+// Adds the light of all the fireflies to the deferred lighting, in one instanced drawcall
+// Each light is a volume around its range, so only the pixels that it can reach are shaded
+class FireflyLightsRenderPass : public RenderPass
+{
+public:
+    FireflyLightsRenderPass(const FireflySystem& fireflySystem, std::shared_ptr<Material> material,
+        std::shared_ptr<const FramebufferObject> targetFramebuffer = nullptr);
+
+    void Render() override;
+
+private:
+    void InitializeVolumeMesh();
+
+private:
+    const FireflySystem& m_fireflySystem;
+    std::shared_ptr<Material> m_material;
+
+    ShaderProgram::Location m_viewProjMatrixLocation;
+    ShaderProgram::Location m_invViewMatrixLocation;
+    ShaderProgram::Location m_invProjMatrixLocation;
+
+    // Cube from -1 to 1, scaled by the range of the lights
+    Mesh m_volumeMesh;
+};
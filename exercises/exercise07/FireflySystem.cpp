@@ -0,0 +1,130 @@
+#include "FireflySystem.h"
+
+#include <ituGL/core/DeviceGL.h>
+#include <ituGL/asset/ShaderLoader.h>
+#include <ituGL/geometry/VertexAttribute.h>
+#include <ituGL/geometry/Drawcall.h>
+#include <array>
+#include <vector>
+#include <cstdlib>
+#include <cassert>
+
+FireflySystem::FireflySystem()
+    : m_count(0)
+    , m_capacity(0)
+    , m_deltaTimeLocation(-1)
+    , m_speedLocation(-1)
+    , m_randomSeedLocation(-1)
+{
+}
+
+void FireflySystem::Initialize(unsigned int capacity)
+{
+    m_count = 0;
+    m_capacity = capacity;
+
+    // Both buffers have room for all the fireflies, the simulation only touches the first m_count
+    size_t size = capacity * sizeof(FireflyState);
+    m_stateVBO.Bind();
+    m_stateVBO.AllocateData(size, BufferObject::DynamicCopy);
+    m_nextStateVBO.Bind();
+    m_nextStateVBO.AllocateData(size, BufferObject::StreamCopy);
+
+    // The simulation reads the state as regular vertex attributes
+    VertexAttribute attribute(Data::Type::Float, 4);
+    m_simulationVAO.Bind();
+    m_stateVBO.Bind();
+    m_simulationVAO.SetAttribute(0, attribute, offsetof(FireflyState, positionHeading), sizeof(FireflyState));
+    m_simulationVAO.SetAttribute(1, attribute, offsetof(FireflyState, colorTurnSpeed), sizeof(FireflyState));
+    VertexArrayObject::Unbind();
+    VertexBufferObject::Unbind();
+
+    InitializeShaderProgram();
+}
+
+void FireflySystem::InitializeShaderProgram()
+{
+    std::vector<const char*> vertexShaderPaths;
+    vertexShaderPaths.push_back("shaders/version330.glsl");
+    vertexShaderPaths.push_back("shaders/firefly_simulation.vert");
+    Shader vertexShader = ShaderLoader(Shader::VertexShader).Load(vertexShaderPaths);
+
+    std::vector<const char*> fragmentShaderPaths;
+    fragmentShaderPaths.push_back("shaders/version330.glsl");
+    fragmentShaderPaths.push_back("shaders/empty.frag");
+    Shader fragmentShader = ShaderLoader(Shader::FragmentShader).Load(fragmentShaderPaths);
+
+    // The outputs are written in the same layout as FireflyState
+    std::array<const char*, 2> varyings = { "NextPositionHeading", "NextColorTurnSpeed" };
+    m_simulationProgram.SetTransformFeedbackVaryings(varyings);
+    m_simulationProgram.Build(vertexShader, fragmentShader);
+
+    m_deltaTimeLocation = m_simulationProgram.GetUniformLocation("DeltaTime");
+    m_speedLocation = m_simulationProgram.GetUniformLocation("Speed");
+    m_randomSeedLocation = m_simulationProgram.GetUniformLocation("RandomSeed");
+}
+
+bool FireflySystem::AddFirefly(const glm::vec3& position, float heading, const glm::vec3& color)
+{
+    if (m_count >= m_capacity)
+        return false;
+
+    FireflyState state;
+    state.positionHeading = glm::vec4(position, heading);
+    state.colorTurnSpeed = glm::vec4(color, 0.0f);
+
+    m_stateVBO.Bind();
+    m_stateVBO.UpdateData(std::span<const FireflyState>(&state, 1), m_count * sizeof(FireflyState));
+    VertexBufferObject::Unbind();
+
+    m_count++;
+    return true;
+}
+
+void FireflySystem::Update(float deltaTime)
+{
+    if (m_count == 0)
+        return;
+
+    m_simulationProgram.Use();
+    m_simulationProgram.SetUniform(m_deltaTimeLocation, deltaTime);
+    m_simulationProgram.SetUniform(m_speedLocation, s_speed);
+    m_simulationProgram.SetUniform(m_randomSeedLocation, static_cast<GLuint>(rand()));
+
+    // Only the vertex shader runs, writing each firefly in the next state
+    DeviceGL& device = DeviceGL::GetInstance();
+    device.SetFeatureEnabled(GL_RASTERIZER_DISCARD, true);
+    m_simulationVAO.Bind();
+    m_nextStateVBO.BindBase(BufferObject::TransformFeedbackBuffer, 0);
+
+    glBeginTransformFeedback(GL_POINTS);
+    Drawcall(Drawcall::Primitive::Points, m_count).Draw();
+    glEndTransformFeedback();
+
+    BufferObject::UnbindBase(BufferObject::TransformFeedbackBuffer, 0);
+    VertexArrayObject::Unbind();
+    device.SetFeatureEnabled(GL_RASTERIZER_DISCARD, false);
+
+    // Copying back keeps a single state buffer, so the VAOs that draw the fireflies don't change
+    m_stateVBO.CopyData(m_nextStateVBO, m_count * sizeof(FireflyState));
+}
+
+void FireflySystem::SetupInstanceAttributes(VertexArrayObject& vao) const
+{
+    VertexAttribute attribute(Data::Type::Float, 4);
+    vao.Bind();
+    m_stateVBO.Bind();
+    vao.SetAttribute(s_positionHeadingLocation, attribute, offsetof(FireflyState, positionHeading), sizeof(FireflyState), 1);
+    vao.SetAttribute(s_colorTurnSpeedLocation, attribute, offsetof(FireflyState, colorTurnSpeed), sizeof(FireflyState), 1);
+    VertexArrayObject::Unbind();
+    VertexBufferObject::Unbind();
+}
+
+void FireflySystem::DrawInstanced(const VertexArrayObject& vao, const Drawcall& drawcall) const
+{
+    if (m_count == 0)
+        return;
+
+    vao.Bind();
+    drawcall.DrawInstanced(m_count);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <ituGL/geometry/VertexArrayObject.h>
+#include <ituGL/geometry/VertexBufferObject.h>
+#include <ituGL/shader/ShaderProgram.h>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+class Drawcall;
+
+// Fireflies simulated and drawn in the GPU
+// Their state lives in a vertex buffer that is updated with transform feedback. It never goes back to the CPU:
+// render passes read it as instance attributes to draw the firefly models and their light volumes
+class FireflySystem
+{
+public:
+    FireflySystem();
+
+    // Build the simulation shader and allocate the state for up to capacity fireflies
+    void Initialize(unsigned int capacity);
+
+    unsigned int GetCount() const { return m_count; }
+    unsigned int GetCapacity() const { return m_capacity; }
+
+    // Add a firefly heading in the direction of the angle around the vertical axis. The color includes the light intensity
+    // Returns false if the system is already full
+    bool AddFirefly(const glm::vec3& position, float heading, const glm::vec3& color);
+
+    // Turn and advance all the fireflies
+    void Update(float deltaTime);
+
+    // Read the state as instance attributes of the VAO:
+    // - s_positionHeadingLocation: position, and angle around the vertical axis
+    // - s_colorTurnSpeedLocation: light color, and current turn speed
+    void SetupInstanceAttributes(VertexArrayObject& vao) const;
+
+    // Draw the drawcall once per firefly, with a VAO set up with SetupInstanceAttributes
+    void DrawInstanced(const VertexArrayObject& vao, const Drawcall& drawcall) const;
+
+    static constexpr GLuint s_positionHeadingLocation = 3;
+    static constexpr GLuint s_colorTurnSpeedLocation = 4;
+
+private:
+    struct FireflyState
+    {
+        glm::vec4 positionHeading;
+        glm::vec4 colorTurnSpeed;
+    };
+
+    void InitializeShaderProgram();
+
+private:
+    unsigned int m_count;
+    unsigned int m_capacity;
+
+    // Current state, and the output of the simulation that is copied back to it
+    VertexBufferObject m_stateVBO;
+    VertexBufferObject m_nextStateVBO;
+
+    // Reads the current state as vertices of the simulation
+    VertexArrayObject m_simulationVAO;
+
+    ShaderProgram m_simulationProgram;
+    ShaderProgram::Location m_deltaTimeLocation;
+    ShaderProgram::Location m_speedLocation;
+    ShaderProgram::Location m_randomSeedLocation;
+
+    // Distance moved each second
+    static constexpr float s_speed = 0.5f;
+};
@@ -0,0 +1,4 @@
+// Used by programs that only need the vertex shader, like the ones that capture its outputs with transform feedback
+void main()
+{
+}
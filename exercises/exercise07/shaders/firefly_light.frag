@@ -0,0 +1,54 @@
+//Inputs
+flat in vec3 LightPosition;
+flat in vec3 LightColor;
+
+//Outputs
+out vec4 FragColor;
+
+//Uniforms
+uniform sampler2D DepthTexture;
+uniform sampler2D AlbedoTexture;
+uniform sampler2D NormalTexture;
+uniform sampler2D OthersTexture;
+uniform mat4 InvViewMatrix;
+uniform mat4 InvProjMatrix;
+uniform vec2 LightRange;
+
+void main()
+{
+	// The volume is drawn in screen space, read the g-buffers at the pixel
+	vec2 texCoord = gl_FragCoord.xy / vec2(textureSize(DepthTexture, 0));
+	vec3 position = ReconstructViewPosition(DepthTexture, texCoord, InvProjMatrix);
+
+	// Compute view vector en view space
+	vec3 viewDir = GetDirection(position, vec3(0));
+
+	// Convert position and view vector to world space
+	position = (InvViewMatrix * vec4(position, 1)).xyz;
+	viewDir = (InvViewMatrix * vec4(viewDir, 0)).xyz;
+
+	// Skip the pixels of the volume that the light doesn't reach
+	float lightDistance = distance(position, LightPosition);
+	if (lightDistance >= LightRange.y)
+		discard;
+
+	vec3 albedo = texture(AlbedoTexture, texCoord).rgb;
+	vec3 normal = GetImplicitNormal(texture(NormalTexture, texCoord).xy);
+	vec4 others = texture(OthersTexture, texCoord);
+	normal = (InvViewMatrix * vec4(normal, 0)).xyz;
+
+	// Set surface material data
+	SurfaceData data;
+	data.normal = normal;
+	data.reflectionColor = albedo;
+	data.ambientReflectance = others.x;
+	data.diffuseReflectance = others.y;
+	data.specularReflectance = others.z;
+	data.specularExponent = (1.0f / others.w) - 1.0f;
+
+	// Same point light as ComputeLight, with the distance attenuation of the range
+	vec3 lightDir = GetDirection(position, LightPosition);
+	vec3 light = ComputeDiffuseLighting(data, lightDir) + ComputeSpecularLighting(data, lightDir, viewDir);
+	float attenuation = smoothstep(LightRange.y, LightRange.x, lightDistance);
+	FragColor = vec4(light * LightColor * attenuation, 1.0f);
+}
@@ -0,0 +1,21 @@
+//Inputs
+layout (location = 0) in vec3 VertexPosition;
+layout (location = 3) in vec4 InstancePositionHeading;
+layout (location = 4) in vec4 InstanceColorTurnSpeed;
+
+//Outputs
+flat out vec3 LightPosition;
+flat out vec3 LightColor;
+
+//Uniforms
+uniform mat4 ViewProjMatrix;
+uniform vec2 LightRange;
+
+void main()
+{
+	LightPosition = InstancePositionHeading.xyz;
+	LightColor = InstanceColorTurnSpeed.rgb;
+
+	// The volume is a cube that contains the range of the light
+	gl_Position = ViewProjMatrix * vec4(LightPosition + VertexPosition * LightRange.y, 1.0);
+}
@@ -0,0 +1,36 @@
+//Inputs
+layout (location = 0) in vec4 PositionHeading;
+layout (location = 1) in vec4 ColorTurnSpeed;
+
+//Outputs
+out vec4 NextPositionHeading;
+out vec4 NextColorTurnSpeed;
+
+//Uniforms
+uniform float DeltaTime;
+uniform float Speed;
+uniform uint RandomSeed;
+
+// Pseudo random number in [0, 1), from a PCG hash of the seed
+float Random(uint seed)
+{
+	uint state = seed * 747796405u + 2891336453u;
+	uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+	word = (word >> 22u) ^ word;
+	return float(word) / 4294967296.0f;
+}
+
+void main()
+{
+	// Change the turn speed by a random amount, different for each firefly and frame
+	float turnSpeed = ColorTurnSpeed.w + mix(-0.25f, 0.25f, Random(uint(gl_VertexID) * 1664525u + RandomSeed));
+	turnSpeed = clamp(turnSpeed, -1.57f, 1.57f);
+
+	// Rotate around the vertical axis
+	float heading = PositionHeading.w + turnSpeed * DeltaTime;
+
+	// Advance in forward direction, the -Z axis after the rotation
+	vec3 forward = -vec3(sin(heading), 0.0f, cos(heading));
+	NextPositionHeading = vec4(PositionHeading.xyz + forward * Speed * DeltaTime, heading);
+	NextColorTurnSpeed = vec4(ColorTurnSpeed.rgb, turnSpeed);
+}
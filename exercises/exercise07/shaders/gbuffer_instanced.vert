@@ -0,0 +1,32 @@
+//Inputs
+layout (location = 0) in vec3 VertexPosition;
+layout (location = 1) in vec3 VertexNormal;
+layout (location = 2) in vec2 VertexTexCoord;
+layout (location = 3) in vec4 InstancePositionHeading;
+
+//Outputs
+out vec3 ViewNormal;
+out vec2 TexCoord;
+
+//Uniforms
+uniform mat4 ViewMatrix;
+uniform mat4 ViewProjMatrix;
+uniform float InstanceScale;
+
+void main()
+{
+	// Rotation of the instance around the vertical axis
+	float s = sin(InstancePositionHeading.w);
+	float c = cos(InstancePositionHeading.w);
+	mat3 rotation = mat3(c, 0, -s, 0, 1, 0, s, 0, c);
+
+	// normal in view space (for lighting computation)
+	ViewNormal = normalize((ViewMatrix * vec4(rotation * VertexNormal, 0.0)).xyz);
+
+	// texture coordinates
+	TexCoord = VertexTexCoord;
+
+	// final vertex position (for opengl rendering, not for lighting)
+	vec3 position = rotation * (VertexPosition * InstanceScale) + InstancePositionHeading.xyz;
+	gl_Position = ViewProjMatrix * vec4(position, 1.0);
+}
@@ -1,7 +1,7 @@
 #include "SceneViewerApplication.h"
 
 #include <ituGL/asset/TextureCubemapLoader.h>
-#include <ituGL/asset/ShaderLoader.h>
+#include <ituGL/asset/ShaderProgramCache.h>
 #include <ituGL/asset/ModelLoader.h>
 
 #include <ituGL/camera/Camera.h>
@@ -50,9 +50,16 @@ void SceneViewerApplication::Update()
     // Update camera controller
     m_cameraController.Update(GetMainWindow(), GetDeltaTime());
 
-    // Add the scene nodes to the renderer
+    // Add the scene to the renderer, reading the world matrices updated this frame
+    m_scene.UpdateTransforms();
     RendererSceneVisitor rendererSceneVisitor(m_renderer);
-    m_scene.AcceptVisitor(rendererSceneVisitor);
+    rendererSceneVisitor.VisitScene(m_scene);
+
+    // Group the drawcalls that share textures, so they are drawn without binding them again
+    m_renderer.SortDrawcallCollection(0, [this](const Renderer::DrawcallInfo& a, const Renderer::DrawcallInfo& b)
+        {
+            return m_renderer.IsBatchOrder(a, b);
+        });
 }
 
 void SceneViewerApplication::Render()
@@ -114,18 +121,17 @@ void SceneViewerApplication::InitializeMaterial()
     std::vector<const char*> vertexShaderPaths;
     vertexShaderPaths.push_back("shaders/version330.glsl");
     vertexShaderPaths.push_back("shaders/default.vert");
-    Shader vertexShader = ShaderLoader(Shader::VertexShader).Load(vertexShaderPaths);
 
     std::vector<const char*> fragmentShaderPaths;
     fragmentShaderPaths.push_back("shaders/version330.glsl");
     fragmentShaderPaths.push_back("shaders/utils.glsl");
     fragmentShaderPaths.push_back("shaders/lambert-ggx.glsl");
     fragmentShaderPaths.push_back("shaders/lighting.glsl");
-    fragmentShaderPaths.push_back("shaders/default_pbr.frag");
-    Shader fragmentShader = ShaderLoader(Shader::FragmentShader).Load(fragmentShaderPaths);
+    fragmentShaderPaths.push_back("shaders/default_pbr_packed.frag");
 
+    // Use the binary from previous runs if the sources didn't change
     std::shared_ptr<ShaderProgram> shaderProgramPtr = std::make_shared<ShaderProgram>();
-    shaderProgramPtr->Build(vertexShader, fragmentShader);
+    ShaderProgramCache().Build(*shaderProgramPtr, vertexShaderPaths, fragmentShaderPaths);
 
     // Get transform related uniform locations
     ShaderProgram::Location cameraPositionLocation = shaderProgramPtr->GetUniformLocation("CameraPosition");
@@ -186,6 +192,9 @@ void SceneViewerApplication::InitializeModels()
     // Flip vertically textures loaded by the model loader
     loader.GetTexture2DLoader().SetFlipVertical(true);
 
+    // Pack the textures in arrays, materials only differ in their layers
+    loader.SetPackTextures(true);
+
     // Link vertex properties to attributes
     loader.SetMaterialAttribute(VertexAttribute::Semantic::Position, "VertexPosition");
     loader.SetMaterialAttribute(VertexAttribute::Semantic::Normal, "VertexNormal");
@@ -198,6 +207,9 @@ void SceneViewerApplication::InitializeModels()
     loader.SetMaterialProperty(ModelLoader::MaterialProperty::DiffuseTexture, "ColorTexture");
     loader.SetMaterialProperty(ModelLoader::MaterialProperty::NormalTexture, "NormalTexture");
     loader.SetMaterialProperty(ModelLoader::MaterialProperty::SpecularTexture, "SpecularTexture");
+    loader.SetMaterialProperty(ModelLoader::MaterialProperty::DiffuseTextureLayer, "ColorTextureLayer");
+    loader.SetMaterialProperty(ModelLoader::MaterialProperty::NormalTextureLayer, "NormalTextureLayer");
+    loader.SetMaterialProperty(ModelLoader::MaterialProperty::SpecularTextureLayer, "SpecularTextureLayer");
 
     // Load models
     std::shared_ptr<Model> chestModel = loader.LoadShared("models/treasure_chest/treasure_chest.obj");
@@ -0,0 +1,38 @@
+//Inputs
+in vec3 WorldPosition;
+in vec3 WorldNormal;
+in vec3 WorldTangent;
+in vec3 WorldBitangent;
+in vec2 TexCoord;
+
+//Outputs
+out vec4 FragColor;
+
+//Uniforms
+uniform vec3 Color;
+
+// Textures are packed in arrays shared by all the materials, each material has its layers
+uniform sampler2DArray ColorTexture;
+uniform sampler2DArray NormalTexture;
+uniform sampler2DArray SpecularTexture;
+uniform int ColorTextureLayer;
+uniform int NormalTextureLayer;
+uniform int SpecularTextureLayer;
+
+uniform vec3 CameraPosition;
+
+void main()
+{
+	SurfaceData data;
+	data.normal = SampleNormalMap(NormalTexture, NormalTextureLayer, TexCoord, normalize(WorldNormal), normalize(WorldTangent), normalize(WorldBitangent));
+	data.albedo = Color * texture(ColorTexture, vec3(TexCoord, ColorTextureLayer)).rgb;
+	vec3 arm = texture(SpecularTexture, vec3(TexCoord, SpecularTextureLayer)).rgb;
+	data.ambientOcclusion = arm.x;
+	data.roughness = arm.y;
+	data.metalness = arm.z;
+
+	vec3 position = WorldPosition;
+	vec3 viewDir = GetDirection(position, CameraPosition);
+	vec3 color = ComputeLighting(position, data, viewDir, true);
+	FragColor = vec4(color.rgb, 1);
+}
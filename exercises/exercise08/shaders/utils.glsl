@@ -68,3 +68,19 @@ vec3 ReconstructViewPosition(sampler2D depthTexture, vec2 texCoord, mat4 invProj
 	vec4 viewPosition = invProjMatrix * vec4(clipPosition, 1.0f);
 	return viewPosition.xyz / viewPosition.w;
 }
+
+// Sample texture map in tangent space from a layer of a texture array, and converts to the same space of the provided normal, tangent and bitangent
+vec3 SampleNormalMap(sampler2DArray normalTexture, int layer, vec2 texCoord, vec3 normal, vec3 tangent, vec3 bitangent)
+{
+	// Read normalTexture
+	vec2 normalMap = texture(normalTexture, vec3(texCoord, layer)).xy * 2 - vec2(1);
+
+	// Get implicit Z component
+	vec3 normalTangentSpace = GetImplicitNormal(normalMap);
+
+	// Create tangent space matrix
+	mat3 tangentMatrix = mat3(tangent, bitangent, normal);
+
+	// Return matrix in world space
+	return normalize(tangentMatrix * normalTangentSpace);
+}
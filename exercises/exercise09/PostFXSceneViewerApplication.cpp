@@ -3,6 +3,7 @@
 #include <ituGL/asset/TextureCubemapLoader.h>
 #include <ituGL/asset/ShaderLoader.h>
 #include <ituGL/asset/ModelLoader.h>
+#include <ituGL/asset/TextureStreamer.h>
 
 #include <ituGL/camera/Camera.h>
 #include <ituGL/scene/SceneCamera.h>
@@ -17,6 +18,7 @@
 #include <ituGL/scene/SceneModel.h>
 
 #include <ituGL/renderer/SkyboxRenderPass.h>
+#include <ituGL/renderer/TextureFeedbackRenderPass.h>
 #include <ituGL/renderer/GBufferRenderPass.h>
 #include <ituGL/renderer/DeferredRenderPass.h>
 #include <ituGL/renderer/PostFXRenderPass.h>
@@ -28,6 +30,7 @@
 PostFXSceneViewerApplication::PostFXSceneViewerApplication()
     : Application(1024, 1024, "Post FX Scene Viewer demo")
     , m_renderer(GetDevice())
+    , m_textureStreamer(std::make_shared<TextureStreamer>())
     , m_sceneFramebuffer(std::make_shared<FramebufferObject>())
     , m_exposure(1.0f)
     , m_contrast(1.0f)
@@ -61,9 +64,13 @@ void PostFXSceneViewerApplication::Update()
     // Update camera controller
     m_cameraController.Update(GetMainWindow(), GetDeltaTime());
 
-    // Add the scene nodes to the renderer
+    // Add the scene to the renderer, reading the world matrices updated this frame
+    m_scene.UpdateTransforms();
     RendererSceneVisitor rendererSceneVisitor(m_renderer);
-    m_scene.AcceptVisitor(rendererSceneVisitor);
+    rendererSceneVisitor.VisitScene(m_scene);
+
+    // Load the texture levels requested by the feedback
+    m_textureStreamer->Update();
 }
 
 void PostFXSceneViewerApplication::Render()
@@ -237,6 +244,12 @@ void PostFXSceneViewerApplication::InitializeModels()
     // Flip vertically textures loaded by the model loader
     loader.GetTexture2DLoader().SetFlipVertical(true);
 
+    // Stream the mip levels of the textures
+    loader.SetTextureStreamer(m_textureStreamer);
+
+    // Split the submeshes in meshlets, so the renderer can cull the clusters outside the view or facing away
+    loader.SetBuildMeshlets(true);
+
     // Link vertex properties to attributes
     loader.SetMaterialAttribute(VertexAttribute::Semantic::Position, "VertexPosition");
     loader.SetMaterialAttribute(VertexAttribute::Semantic::Normal, "VertexNormal");
@@ -300,6 +313,9 @@ void PostFXSceneViewerApplication::InitializeRenderer()
     int width, height;
     GetMainWindow().GetDimensions(width, height);
 
+    // Texture feedback pass, at a quarter of the resolution. It goes first, to use the drawcalls before the g-buffer pass
+    m_renderer.AddRenderPass(std::make_unique<TextureFeedbackRenderPass>(m_textureStreamer, width / 4, height / 4));
+
     // Set up deferred passes
     {
         std::unique_ptr<GBufferRenderPass> gbufferRenderPass(std::make_unique<GBufferRenderPass>(width, height));
@@ -417,6 +433,21 @@ void PostFXSceneViewerApplication::RenderGUI()
     // Draw GUI for camera controller
     m_cameraController.DrawGUI(m_imGui);
 
+    if (auto window = m_imGui.UseWindow("Texture Streaming"))
+    {
+        ImGui::Text("Resident memory: %.1f / %.1f MB", m_textureStreamer->GetResidentMemory() / 1048576.0f, m_textureStreamer->GetMemoryBudget() / 1048576.0f);
+    }
+
+    if (auto window = m_imGui.UseWindow("Meshlet Culling"))
+    {
+        bool meshletCulling = m_renderer.GetMeshletCulling();
+        if (ImGui::Checkbox("Enabled", &meshletCulling))
+        {
+            m_renderer.SetMeshletCulling(meshletCulling);
+        }
+        ImGui::Text("Drawn meshlets: %u / %u", m_renderer.GetDrawnMeshletCount(), m_renderer.GetTestedMeshletCount());
+    }
+
     if (auto window = m_imGui.UseWindow("Post FX"))
     {
         if (m_composeMaterial)
@@ -12,6 +12,7 @@
 class Texture2DObject;
 class TextureCubemapObject;
 class Material;
+class TextureStreamer;
 
 class PostFXSceneViewerApplication : public Application
 {
@@ -51,6 +52,9 @@ private:
     // Renderer
     Renderer m_renderer;
 
+    // Streams the mip levels of the model textures
+    std::shared_ptr<TextureStreamer> m_textureStreamer;
+
     // Skybox texture
     std::shared_ptr<TextureCubemapObject> m_skyboxTexture;
 
@@ -0,0 +1,22 @@
+#version 330 core
+
+//Inputs
+in vec2 TexCoord;
+
+//Outputs
+out vec2 FragFeedback;
+
+//Uniforms
+uniform float FeedbackId;
+uniform float LodBias;
+
+void main()
+{
+	// Same LOD selection as the sampler: the largest texture coordinate change between neighbour pixels
+	vec2 dx = dFdx(TexCoord);
+	vec2 dy = dFdy(TexCoord);
+	float density = max(dot(dx, dx), dot(dy, dy));
+
+	// Log2 of the derivative, corrected for the smaller size of the feedback target. The texture size is added on the CPU
+	FragFeedback = vec2(FeedbackId, 0.5f * log2(density) + LodBias);
+}
@@ -0,0 +1,18 @@
+#version 330 core
+
+//Inputs
+layout (location = 0) in vec3 VertexPosition;
+layout (location = 4) in vec2 VertexTexCoord;
+
+//Outputs
+out vec2 TexCoord;
+
+//Uniforms
+uniform mat4 WorldViewProjMatrix;
+
+void main()
+{
+	TexCoord = VertexTexCoord;
+
+	gl_Position = WorldViewProjMatrix * vec4(VertexPosition, 1.0);
+}
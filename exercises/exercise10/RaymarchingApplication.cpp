@@ -41,8 +41,8 @@ void RaymarchingApplication::Update()
     m_renderer.SetCurrentCamera(camera);
 
     // Update the material properties
-    m_material->SetUniformValue("ProjMatrix", camera.GetProjectionMatrix());
-    m_material->SetUniformValue("InvProjMatrix", glm::inverse(camera.GetProjectionMatrix()));
+    m_material->SetUniformValue(m_projMatrixLocation, camera.GetProjectionMatrix());
+    m_material->SetUniformValue(m_invProjMatrixLocation, glm::inverse(camera.GetProjectionMatrix()));
 }
 
 void RaymarchingApplication::Render()
@@ -85,14 +85,25 @@ void RaymarchingApplication::InitializeMaterial()
 {
     m_material = CreateRaymarchingMaterial("shaders/exercise10.glsl");
 
+    // Get the uniform locations
+    m_projMatrixLocation = m_material->GetUniformLocation("ProjMatrix");
+    m_invProjMatrixLocation = m_material->GetUniformLocation("InvProjMatrix");
+    m_sphereCenterLocation = m_material->GetUniformLocation("SphereCenter");
+    m_sphereRadiusLocation = m_material->GetUniformLocation("SphereRadius");
+    m_sphereColorLocation = m_material->GetUniformLocation("SphereColor");
+    m_boxMatrixLocation = m_material->GetUniformLocation("BoxMatrix");
+    m_boxSizeLocation = m_material->GetUniformLocation("BoxSize");
+    m_boxColorLocation = m_material->GetUniformLocation("BoxColor");
+    m_smoothnessLocation = m_material->GetUniformLocation("Smoothness");
+
     // Initialize material uniforms
-    m_material->SetUniformValue("SphereCenter", glm::vec3(-2, 0, -10));
-    m_material->SetUniformValue("SphereRadius", 1.25f);
-    m_material->SetUniformValue("SphereColor", glm::vec3(0, 0, 1));
-    m_material->SetUniformValue("BoxMatrix", glm::translate(glm::vec3(2, 0, -10)));
-    m_material->SetUniformValue("BoxSize", glm::vec3(1, 1, 1));
-    m_material->SetUniformValue("BoxColor", glm::vec3(1, 0, 0));
-    m_material->SetUniformValue("Smoothness", 0.25f);
+    m_material->SetUniformValue(m_sphereCenterLocation, glm::vec3(-2, 0, -10));
+    m_material->SetUniformValue(m_sphereRadiusLocation, 1.25f);
+    m_material->SetUniformValue(m_sphereColorLocation, glm::vec3(0, 0, 1));
+    m_material->SetUniformValue(m_boxMatrixLocation, glm::translate(glm::vec3(2, 0, -10)));
+    m_material->SetUniformValue(m_boxSizeLocation, glm::vec3(1, 1, 1));
+    m_material->SetUniformValue(m_boxColorLocation, glm::vec3(1, 0, 0));
+    m_material->SetUniformValue(m_smoothnessLocation, 0.25f);
 }
 
 void RaymarchingApplication::InitializeRenderer()
@@ -144,9 +155,9 @@ void RaymarchingApplication::RenderGUI()
 
             // Add controls for sphere parameters
             ImGui::DragFloat3("Center", &center[0], 0.1f);
-            m_material->SetUniformValue("SphereCenter", glm::vec3(viewMatrix * glm::vec4(center, 1.0f)));
-            ImGui::DragFloat("Radius", m_material->GetDataUniformPointer<float>("SphereRadius"), 0.1f);
-            ImGui::ColorEdit3("Color", m_material->GetDataUniformPointer<float>("SphereColor"));
+            m_material->SetUniformValue(m_sphereCenterLocation, glm::vec3(viewMatrix * glm::vec4(center, 1.0f)));
+            ImGui::DragFloat("Radius", m_material->GetDataUniformPointer<float>(m_sphereRadiusLocation), 0.1f);
+            ImGui::ColorEdit3("Color", m_material->GetDataUniformPointer<float>(m_sphereColorLocation));
 
             ImGui::TreePop();
         }
@@ -158,14 +169,14 @@ void RaymarchingApplication::RenderGUI()
             // Add controls for box parameters
             ImGui::DragFloat3("Translation", &translation[0], 0.1f);
             ImGui::DragFloat3("Rotation", &rotation[0], 0.1f);
-            m_material->SetUniformValue("BoxMatrix", viewMatrix * glm::translate(translation) * glm::eulerAngleXYZ(rotation.x, rotation.y, rotation.z));
-            ImGui::DragFloat3("Size", m_material->GetDataUniformPointer<float>("BoxSize"), 0.1f);
-            ImGui::ColorEdit3("Color", m_material->GetDataUniformPointer<float>("BoxColor"));
+            m_material->SetUniformValue(m_boxMatrixLocation, viewMatrix * glm::translate(translation) * glm::eulerAngleXYZ(rotation.x, rotation.y, rotation.z));
+            ImGui::DragFloat3("Size", m_material->GetDataUniformPointer<float>(m_boxSizeLocation), 0.1f);
+            ImGui::ColorEdit3("Color", m_material->GetDataUniformPointer<float>(m_boxColorLocation));
 
             ImGui::TreePop();
         }
 
-        ImGui::DragFloat("Smoothness", m_material->GetDataUniformPointer<float>("Smoothness"), 0.1f);
+        ImGui::DragFloat("Smoothness", m_material->GetDataUniformPointer<float>(m_smoothnessLocation), 0.1f);
     }
 
     m_imGui.EndFrame();
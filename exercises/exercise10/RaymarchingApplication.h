@@ -3,6 +3,7 @@
 #include <ituGL/application/Application.h>
 
 #include <ituGL/renderer/Renderer.h>
+#include <ituGL/shader/ShaderProgram.h>
 #include <ituGL/camera/CameraController.h>
 #include <ituGL/utils/DearImGui.h>
 
@@ -40,4 +41,15 @@ private:
 
     // Materials
     std::shared_ptr<Material> m_material;
+
+    // Uniform locations of the material, resolved once to set the values every frame
+    ShaderProgram::Location m_projMatrixLocation;
+    ShaderProgram::Location m_invProjMatrixLocation;
+    ShaderProgram::Location m_sphereCenterLocation;
+    ShaderProgram::Location m_sphereRadiusLocation;
+    ShaderProgram::Location m_sphereColorLocation;
+    ShaderProgram::Location m_boxMatrixLocation;
+    ShaderProgram::Location m_boxSizeLocation;
+    ShaderProgram::Location m_boxColorLocation;
+    ShaderProgram::Location m_smoothnessLocation;
 };
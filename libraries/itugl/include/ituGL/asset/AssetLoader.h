@@ -27,6 +27,12 @@ public:
     // Load the asset from a path into the object passed as a parameter
     virtual bool LoadInto(const char* path, T&);
 
+    // Find an asset previously loaded as shared. Returns null if not found
+    std::shared_ptr<T> FindShared(const char* path) const;
+
+    // Register an asset loaded by other means, so LoadShared returns it
+    void AddShared(const char* path, std::shared_ptr<T> asset);
+
     inline bool GetKeepShared() const { return m_keepShared; }
     inline void SetKeepShared(bool keepShared) { m_keepShared = keepShared; }
 
@@ -87,6 +93,22 @@ std::shared_ptr<T> AssetLoader<T>::LoadShared(const char* path)
     return t;
 }
 
+template <typename T>
+std::shared_ptr<T> AssetLoader<T>::FindShared(const char* path) const
+{
+    auto itAsset = m_sharedAssets.find(path);
+    return itAsset != m_sharedAssets.end() ? itAsset->second : nullptr;
+}
+
+template <typename T>
+void AssetLoader<T>::AddShared(const char* path, std::shared_ptr<T> asset)
+{
+    if (m_keepShared)
+    {
+        m_sharedAssets[path] = asset;
+    }
+}
+
 template <typename T>
 bool AssetLoader<T>::LoadInto(const char* path, T& t)
 {
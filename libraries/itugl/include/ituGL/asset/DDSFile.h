@@ -0,0 +1,63 @@
+#pragma once
+
+#include <ituGL/texture/TextureObject.h>
+#include <vector>
+#include <span>
+#include <cstddef>
+#include <algorithm>
+
+// Container for block compressed 2D textures with their mip chain, stored in DDS format
+// Files are written with the DX10 extended header. Legacy DXT1, DXT5, ATI1 and ATI2 files can also be read
+class DDSFile
+{
+public:
+    DDSFile();
+
+    // Read the file. Returns false if the file is missing or uses an unsupported format
+    // The data of the levels before firstLevel is skipped, those levels keep their size but have no data
+    bool Load(const char* path, int firstLevel = 0);
+
+    // Read only the size, format and number of levels, without the data of any level
+    bool LoadHeader(const char* path);
+
+    // Write the file with all the levels added. All the levels must have their data
+    bool Save(const char* path) const;
+
+    // Remove all the levels and set the format and size of level 0
+    void Reset(GLsizei width, GLsizei height, TextureObject::InternalFormat internalFormat);
+
+    // Append the next level of the mip chain. Returns the span to be filled with the compressed blocks
+    std::span<std::byte> AddLevel();
+
+    inline GLsizei GetWidth() const { return m_width; }
+    inline GLsizei GetHeight() const { return m_height; }
+    inline TextureObject::InternalFormat GetInternalFormat() const { return m_internalFormat; }
+
+    inline int GetLevelCount() const { return static_cast<int>(m_levelOffsets.size()); }
+
+    // Get the size of a specific level
+    inline GLsizei GetLevelWidth(int level) const { return std::max(m_width >> level, 1); }
+    inline GLsizei GetLevelHeight(int level) const { return std::max(m_height >> level, 1); }
+
+    // Get the compressed blocks of a specific level. It can't be a level skipped on load
+    std::span<const std::byte> GetLevelData(int level) const;
+
+private:
+    // Convert from and to the DXGI_FORMAT values used in the DX10 header
+    static TextureObject::InternalFormat GetInternalFormat(unsigned int dxgiFormat);
+    static unsigned int GetDXGIFormat(TextureObject::InternalFormat internalFormat);
+
+private:
+    GLsizei m_width;
+    GLsizei m_height;
+    TextureObject::InternalFormat m_internalFormat;
+
+    // Blocks of all the levels, one after the other
+    std::vector<std::byte> m_data;
+
+    // Offset of each level inside m_data
+    std::vector<size_t> m_levelOffsets;
+
+    // Levels before this one were skipped on load, their range in m_data is empty
+    int m_firstLevel;
+};
@@ -5,11 +5,18 @@
 #include <ituGL/geometry/Model.h>
 #include <ituGL/geometry/Mesh.h>
 #include <ituGL/asset/Texture2DLoader.h>
+#include <ituGL/asset/TextureStreamer.h>
+#include <ituGL/asset/TextureArrayPacker.h>
+#include <ituGL/geometry/VertexFormat.h>
+#include <ituGL/geometry/Meshlet.h>
+#include <ituGL/geometry/MeshBounds.h>
+#include <ituGL/utils/MappedFile.h>
+#include <glm/vec3.hpp>
 #include <vector>
+#include <future>
 
 struct aiMesh;
 struct aiMaterial;
-class VertexFormat;
 
 // Asset loader for Models. Contains a pointer to a reference material for loaded submeshes
 class ModelLoader : public AssetLoader<Model>
@@ -18,8 +25,15 @@ public:
     // Enum to read material properties from the file
     enum class MaterialProperty;
 
+    // Enum to select how the vertex attributes are stored
+    enum class VertexQuantization;
+
+    // Handle to a model loaded in the background
+    class AsyncModel;
+
 public:
     ModelLoader(std::shared_ptr<Material> referenceMaterial = nullptr);
+    ~ModelLoader();
 
     std::shared_ptr<Material> GetReferenceMaterial() const;
     void SetReferenceMaterial(std::shared_ptr<Material> referenceMaterial);
@@ -30,9 +44,51 @@ public:
     Texture2DLoader& GetTexture2DLoader();
     const Texture2DLoader& GetTexture2DLoader() const;
 
+    // If set, material textures are created by the streamer, with only their coarse levels resident
+    std::shared_ptr<TextureStreamer> GetTextureStreamer() const;
+    void SetTextureStreamer(std::shared_ptr<TextureStreamer> textureStreamer);
+
+    // If true, the textures of all the materials of a model are packed in texture arrays, with one layer each
+    // Texture properties receive the array, and the layer properties its layer. Ignored if there is a texture streamer
+    bool GetPackTextures() const;
+    void SetPackTextures(bool packTextures);
+
+    // Packer that keeps the arrays created for the loaded models
+    inline const TextureArrayPacker& GetTextureArrayPacker() const { return m_textureArrayPacker; }
+
+    // Storage of the vertex attributes of the imported meshes. Quantized meshes are also split to fit in 16-bit indices
+    VertexQuantization GetVertexQuantization() const;
+    void SetVertexQuantization(VertexQuantization vertexQuantization);
+
+    // If true, quantized meshes store the positions as 16-bit normalized values inside the bounds of each submesh
+    // The submesh local matrix converts them back, so they are only correct when rendered with the Renderer
+    bool GetQuantizePositions() const;
+    void SetQuantizePositions(bool quantizePositions);
+
+    // If true, triangle submeshes are split in meshlets with bounds, so the renderer can cull the clusters that are not visible
+    bool GetBuildMeshlets() const;
+    void SetBuildMeshlets(bool buildMeshlets);
+
+    // If true, a CPU copy of the triangles is kept in the mesh, for ray picking and other queries
+    bool GetKeepTriangles() const;
+    void SetKeepTriangles(bool keepTriangles);
+
+    // Folder where the binary mesh cache is stored. Set it empty to always import from the source file
+    const std::string& GetCacheFolder() const;
+    void SetCacheFolder(const char* cacheFolder);
+
     // Load the model from the path
     Model Load(const char* path) override;
 
+    // Start loading the model in a worker thread. File import and vertex packing happen in the worker,
+    // the GL objects and materials are created later in UpdateAsyncLoads
+    std::shared_ptr<AsyncModel> LoadAsync(const char* path);
+
+    // Create the GL objects of the models finished by the worker threads. Must be called from the GL thread
+    // Stops after timeBudget seconds, and continues on the next call. Returns the number of models still pending
+    // Each call uploads at least one submesh, if any is ready, so the loads progress with any budget
+    unsigned int UpdateAsyncLoads(double timeBudget);
+
     // Maps a semantic to an attribute in the shader program used by the material
     bool SetMaterialAttribute(VertexAttribute::Semantic semantic, const char* attributeName);
 
@@ -40,27 +96,164 @@ public:
     bool SetMaterialProperty(MaterialProperty materialProperty, const char* uniformName);
 
 private:
-    // Generate a submesh from the loaded mesh data
-    void GenerateSubmesh(Mesh& mesh, const aiMesh& meshData);
+    // Vertex and element data of a submesh, packed and ready to be uploaded
+    // The data spans point to the storage vectors when imported, or to the mapped cache file
+    struct SubmeshData
+    {
+        VertexFormat vertexFormat;
+        std::span<const GLubyte> vertexData;
+        std::vector<GLubyte> vertexStorage;
+        Data::Type elementType;
+        std::vector<Drawcall::Primitive> primitives;
+        // End offset in bytes of each primitive range
+        std::vector<int> elementCounts;
+        std::span<const GLubyte> elementData;
+        std::vector<GLubyte> elementStorage;
+        unsigned int materialIndex;
+        // Stored positions are transformed by positionOffset + positionScale * position. Offset 0 and scale 1 if not quantized
+        glm::vec3 positionOffset;
+        float positionScale;
+        // Bounds of the vertices in model space, computed before quantization
+        MeshBounds bounds;
+        // Clusters of triangles, with bounds in the space of the stored positions
+        std::vector<Meshlet> meshlets;
+        // Optional CPU copy of the triangles, with float positions in model space
+        std::vector<glm::vec3> trianglePositions;
+        std::vector<unsigned int> triangleIndices;
+    };
+
+    // Material properties read from the file, with texture paths relative to the base folder
+    struct MaterialData
+    {
+        // Bitmask with one bit for each MaterialProperty found
+        unsigned int propertyMask;
+        glm::vec3 ambientColor;
+        glm::vec3 diffuseColor;
+        glm::vec3 specularColor;
+        float specularExponent;
+        std::string diffuseTexture;
+        std::string normalTexture;
+        std::string specularTexture;
+    };
+
+    // Model data imported from the file, without any GL objects
+    struct ModelData
+    {
+        // Path to the base folder of the file, to find the textures
+        std::string baseFolder;
+        // Cache file the submesh data points to, if it was loaded from the cache
+        MappedFile cacheFile;
+        std::vector<SubmeshData> submeshes;
+        std::vector<MaterialData> materials;
+        // Textures decoded with their mip levels in the worker thread, by full path
+        std::unordered_map<std::string, Texture2DLoader::MipChain> textures;
+    };
+
+    // Settings that change the imported data. Each combination has its own cache file
+    struct ImportSettings
+    {
+        VertexQuantization vertexQuantization;
+        bool quantizePositions;
+        bool buildMeshlets;
+        bool keepTriangles;
+    };
+
+    // Model being loaded in the background
+    struct AsyncLoad
+    {
+        std::shared_ptr<AsyncModel> asyncModel;
+        std::future<std::unique_ptr<ModelData>> future;
+        std::unique_ptr<ModelData> modelData;
+        unsigned int submeshIndex;
+    };
+
+private:
+    // Import the file and pack the vertex data. Doesn't use GL, so it can run in a worker thread
+    // Uses the cache file if it is up to date, otherwise imports the source file and writes the cache
+    static std::unique_ptr<ModelData> ImportModelData(std::string path, std::string cacheFolder, ImportSettings importSettings);
+
+    // Get the path of the cache file for a specific source file and import settings
+    static std::string GetCacheFilePath(const std::string& cacheFolder, const std::string& path, const ImportSettings& importSettings);
+
+    // Map the cache file and point the submesh data to it. Fails if the cache is older than the source
+    static bool LoadModelCache(const std::string& cacheFilePath, long long sourceTime, ModelData& modelData);
+
+    // Write the imported data to the cache file
+    static void SaveModelCache(const std::string& cacheFilePath, long long sourceTime, const ModelData& modelData);
+
+    // Decode the textures of the materials and generate their mip levels. Doesn't use GL, so it can run in a worker thread
+    // Only the textures in the property mask are decoded. Textures with a compressed file are skipped if preferCompressed is set
+    static void DecodeTextures(ModelData& modelData, unsigned int propertyMask, bool flipVertical, bool preferCompressed, const MipmapGenerator* generator);
+
+    // Get the texture property whose presence enables this property. Layer properties depend on their texture
+    static MaterialProperty GetMaskProperty(MaterialProperty materialProperty);
+
+    // Get the texture formats used for each texture property
+    static void GetTextureFormat(MaterialProperty materialProperty, TextureObject::Format& format, TextureObject::InternalFormat& internalFormat);
+
+    // Generate a submesh with the collected data. Must be called from the GL thread
+    void GenerateSubmesh(Mesh& mesh, SubmeshData& submeshData);
+
+    // Build the vertex and element data from the mesh data. Adds one submesh, or several if the mesh is split
+    // The vertex data is packed with up to threadCount threads
+    static void CollectSubmeshData(const aiMesh& meshData, const ImportSettings& importSettings,
+        unsigned int threadCount, std::vector<SubmeshData>& submeshes);
+
+    // Reorder the triangles for the vertex cache and overdraw, and the vertices by first use. Only for triangle lists
+    static void OptimizeSubmeshData(SubmeshData& submeshData);
+
+    // Split a triangle list in parts of up to maxVertexCount vertices, keeping the order of the triangles
+    // Vertices are numbered by first use in each part, so the order for the vertex fetch is kept too
+    static void SplitSubmeshData(const SubmeshData& submeshData, unsigned int maxVertexCount, std::vector<SubmeshData>& parts);
+
+    // Build the meshlets of a triangle list, from its float positions
+    static void BuildSubmeshMeshlets(SubmeshData& submeshData);
+
+    // Copy the float positions and the indices of a triangle list, before they are quantized
+    static void CollectSubmeshTriangles(SubmeshData& submeshData);
+
+    // Convert the float vertex data to the quantized format. Meshlet bounds are converted too
+    static void QuantizeSubmeshData(SubmeshData& submeshData, VertexQuantization vertexQuantization, bool quantizePositions);
+
+    // Add a submesh and its material to the model. Must be called from the GL thread
+    void AddSubmesh(Model& model, ModelData& modelData, unsigned int submeshIndex);
+
+    // Read the material properties from the file data
+    static void CollectMaterialData(const aiMaterial& aiMaterialData, MaterialData& materialData);
+
+    // Read the path of the texture of the specific type, if there is one
+    static bool CollectTexturePath(const aiMaterial& aiMaterialData, int textureType, std::string& texturePath);
+
+    // Decode the textures that are not decoded yet and pack all of them in texture arrays. Must be called from the GL thread
+    void PackTextures(ModelData& modelData);
+
+    // Get the layer of a packed texture, with the path relative to the base folder. Layer 0 if it was not packed
+    GLint GetTextureLayer(const std::string& texturePath) const;
 
     // Generate a material from the loaded material data
-    std::shared_ptr<Material> GenerateMaterial(const aiMaterial& materialData);
+    std::shared_ptr<Material> GenerateMaterial(ModelData& modelData, const MaterialData& materialData);
 
-    // Load a texture of the specific type in the location
-    void LoadTexture(const aiMaterial& materialData, int textureType, Material& material, ShaderProgram::Location location,
-        TextureObject::Format format, TextureObject::InternalFormat internalFormat) const;
+    // Load the texture in the location, with the path relative to the base folder
+    // Uses the texture decoded in the worker thread, if there is one
+    void LoadTexture(ModelData& modelData, MaterialProperty materialProperty, const std::string& texturePath,
+        Material& material, ShaderProgram::Location location) const;
 
-    // Build the vertex data from the mesh data
-    static std::vector<GLubyte> CollectVertexData(const aiMesh& meshData, VertexFormat& vertexFormat, bool interleaved);
+    // Build the vertex data from the mesh data. Blocks of vertices are packed in parallel, with up to threadCount threads
+    static std::vector<GLubyte> CollectVertexData(const aiMesh& meshData, VertexFormat& vertexFormat, bool interleaved, unsigned int threadCount = 1);
 
     // Build the element data from the mesh data
     static std::vector<GLubyte> CollectElementData(const aiMesh& meshData, Data::Type& elementType,
         std::vector<Drawcall::Primitive>& primitives, std::vector<int>& elementCounts);
 
+    // Narrow the face indices to the element type T, and find the primitive ranges. The element data is already allocated
+    template<typename T>
+    static void CollectElements(const aiMesh& meshData, std::span<GLubyte> elementData,
+        std::vector<Drawcall::Primitive>& primitives, std::vector<int>& elementCounts);
+
     // Get the correct vertex data pointer for a specific semantic
     static const void* GetVertexDataPointer(const aiMesh& meshData, VertexAttribute::Semantic semantic, int& stride);
 
-    // Copy one buffer to another preserving the stride
+    // Copy one buffer to another preserving the stride. Common sizes use a fixed size copy instead of a memcpy call per element
     static void CopyBuffer(void* dstBuffer, size_t dstStride, const void* srcBuffer, size_t srcStride, size_t count, size_t size);
 
     // Get the type of primitive depending on the number of elements
@@ -70,6 +263,9 @@ private:
     // Path to the base folder where we are loading the current model
     std::string m_baseFolder;
 
+    // Folder where the binary mesh cache is stored
+    std::string m_cacheFolder;
+
     // Pointer to the reference material
     std::shared_ptr<Material> m_referenceMaterial;
 
@@ -84,6 +280,39 @@ private:
 
     // Texture loader to cache already loaded shared textures
     mutable Texture2DLoader m_textureLoader;
+
+    // Optional streamer for the material textures
+    std::shared_ptr<TextureStreamer> m_textureStreamer;
+
+    // Should pack the material textures in texture arrays
+    bool m_packTextures;
+
+    // Texture arrays with the packed material textures
+    TextureArrayPacker m_textureArrayPacker;
+
+    // Settings for the vertex data of the imported models
+    ImportSettings m_importSettings;
+
+    // Models waiting for the worker threads, or being uploaded
+    std::vector<AsyncLoad> m_asyncLoads;
+};
+
+class ModelLoader::AsyncModel
+{
+public:
+    AsyncModel();
+
+    // The model is ready when all the submeshes and materials have been created
+    inline bool IsReady() const { return m_ready; }
+
+    // Get the model. Submeshes are added while loading, so it can be rendered partially before it is ready
+    inline std::shared_ptr<Model> GetModel() const { return m_model; }
+
+private:
+    friend class ModelLoader;
+
+    std::shared_ptr<Model> m_model;
+    bool m_ready;
 };
 
 enum class ModelLoader::MaterialProperty
@@ -95,4 +324,20 @@ enum class ModelLoader::MaterialProperty
     DiffuseTexture,
     NormalTexture,
     SpecularTexture,
+    // Layers of the textures in their arrays, when textures are packed
+    DiffuseTextureLayer,
+    NormalTextureLayer,
+    SpecularTextureLayer,
+};
+
+enum class ModelLoader::VertexQuantization
+{
+    // 32-bit floats for all the attributes
+    None,
+    // Normals and tangents as signed normalized 10:10:10:2, with the bitangent sign in the tangent w instead of a bitangent
+    // The shader rebuilds it as cross(normal, tangent.xyz) * tangent.w. 2-component texture coordinates as half floats
+    Packed,
+    // Like Packed, but normals and tangents are 16-bit octahedral vectors in xy that the shader needs to decode
+    // The tangent has 4 components to keep the bitangent sign in w
+    Octahedral,
 };
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <ituGL/shader/ShaderProgram.h>
+#include <ituGL/shader/Shader.h>
+#include <ituGL/shader/Material.h>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <string>
+#include <array>
+#include <span>
+
+class ShaderProgramCache;
+
+// Compiles and links a group of shader programs at once, without waiting for each shader to finish.
+// When GL_KHR_parallel_shader_compile is available the driver compiles them in background threads,
+// and Poll can be called every frame to find the programs that are ready.
+// Programs can't be used until their ready callback is called. Materials added with their program keep using
+// their placeholder material until then, and get the uniforms of the program when it is ready
+class ShaderBatchLoader
+{
+public:
+    // Function called when a program has been linked successfully
+    using ReadyCallback = std::function<void(std::shared_ptr<ShaderProgram>)>;
+
+public:
+    // Programs found in the cache are ready without compiling, and the ones built are stored in it
+    ShaderBatchLoader(const ShaderProgramCache* programCache = nullptr);
+
+    // Check if the driver compiles shaders in background threads
+    bool IsParallelCompileSupported() const;
+
+    // Queue a program with vertex and fragment shaders. The program is not ready until the callback is called
+    std::shared_ptr<ShaderProgram> Add(std::span<const char*> vertexShaderPaths, std::span<const char*> fragmentShaderPaths,
+        const ReadyCallback& readyCallback = nullptr);
+
+    // Queue the program of a material. When it is ready, the material changes to it, skipping the filtered uniforms,
+    // and then the callback is called, to set the values of the uniforms
+    std::shared_ptr<ShaderProgram> Add(std::shared_ptr<Material> material,
+        std::span<const char*> vertexShaderPaths, std::span<const char*> fragmentShaderPaths,
+        const Material::NameSet& filteredUniforms = Material::NameSet(), const ReadyCallback& readyCallback = nullptr);
+
+    // Start compiling and linking all the queued programs
+    void Submit();
+
+    // Call the callbacks of the programs that are ready. Returns true if there are no pending programs
+    bool Poll();
+
+    // Block until all the submitted programs are ready
+    void Wait();
+
+    // Get the number of programs that are not ready yet
+    unsigned int GetPendingCount() const;
+
+private:
+    // Program waiting to be compiled and linked
+    struct PendingProgram
+    {
+        std::shared_ptr<ShaderProgram> shaderProgram;
+        Shader vertexShader;
+        Shader fragmentShader;
+        ReadyCallback readyCallback;
+        // Sources of each stage, to store the program in the cache
+        std::array<std::vector<std::string>, 2> stageSources;
+        // If the program was loaded from the cache, so there is nothing to compile
+        bool cached;
+        bool submitted;
+    };
+
+    // Check if a submitted program finished, without blocking if the driver can tell
+    bool IsComplete(const PendingProgram& pendingProgram) const;
+
+    // Check the results of a program that finished and call its callback
+    void Complete(PendingProgram& pendingProgram) const;
+
+    // Check the compilation results of a shader and print the errors
+    static bool CheckCompilation(const Shader& shader);
+
+private:
+    // Programs not ready yet. They hold GL objects, so they are never moved, only the pointers
+    std::vector<std::unique_ptr<PendingProgram>> m_pendingPrograms;
+
+    // Optional cache of program binaries
+    const ShaderProgramCache* m_programCache;
+
+    // If GL_KHR_parallel_shader_compile (or the ARB version) is available
+    bool m_parallelCompileSupported;
+};
@@ -3,6 +3,8 @@
 #include <ituGL/asset/AssetLoader.h>
 #include <ituGL/shader/Shader.h>
 #include <span>
+#include <string>
+#include <vector>
 
 class ShaderLoader : AssetLoader<Shader>
 {
@@ -20,8 +22,14 @@ public:
     Shader* LoadNew(std::span<const char*> paths);
     bool LoadInto(Shader& shader, std::span<const char*> paths);
 
+    // Create and compile a shader from source code that has already been read
+    Shader Load(std::span<const std::string> sources);
+
     static Shader Load(Shader::Type type, const char* path);
 
+    // Read the source code of the files without creating a shader
+    static std::vector<std::string> ReadSources(std::span<const char*> paths);
+
 private:
     void Compile(Shader& shader);
 
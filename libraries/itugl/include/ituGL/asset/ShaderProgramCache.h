@@ -0,0 +1,47 @@
+#pragma once
+
+#include <ituGL/shader/ShaderProgram.h>
+#include <string>
+#include <vector>
+#include <span>
+
+// Builds shader programs from source files and stores the linked binaries on disk.
+// The binaries are keyed by a hash of the sources and the driver version, so later runs
+// can skip compiling and linking. If the driver rejects a binary, the program is built from source
+class ShaderProgramCache
+{
+public:
+    ShaderProgramCache(const char* cacheFolder = "shadercache/");
+
+    const std::string& GetCacheFolder() const;
+    void SetCacheFolder(const char* cacheFolder);
+
+    // Build a shader program with a compute shader
+    bool Build(ShaderProgram& shaderProgram, std::span<const char*> computeShaderPaths);
+
+    // Build a shader program with vertex and fragment shaders
+    bool Build(ShaderProgram& shaderProgram, std::span<const char*> vertexShaderPaths, std::span<const char*> fragmentShaderPaths);
+
+    // Load a program built before from the same sources, with the list of sources of each stage. Returns false if it is not cached
+    bool Load(ShaderProgram& shaderProgram, std::span<const std::vector<std::string>> stageSources) const;
+
+    // Store a program linked from the sources. It must be linked after calling SetBinaryRetrievable(true)
+    void Store(const ShaderProgram& shaderProgram, std::span<const std::vector<std::string>> stageSources) const;
+
+private:
+    // Hash the source code of all the stages, together with the driver version
+    static unsigned long long ComputeHash(std::span<const std::vector<std::string>> stageSources);
+
+    // Get the path of the cache file for a specific hash
+    std::string GetCacheFilePath(unsigned long long hash) const;
+
+    // Try to load the program binary from the cache file
+    bool LoadBinary(ShaderProgram& shaderProgram, const std::string& cacheFilePath) const;
+
+    // Store the program binary in the cache file
+    void SaveBinary(const ShaderProgram& shaderProgram, const std::string& cacheFilePath) const;
+
+private:
+    // Folder where the cache files are stored
+    std::string m_cacheFolder;
+};
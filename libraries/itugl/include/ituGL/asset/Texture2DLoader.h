@@ -2,15 +2,28 @@
 
 #include <ituGL/asset/TextureLoader.h>
 #include <ituGL/texture/Texture2DObject.h>
+#include <ituGL/texture/MipmapGenerator.h>
+#include <string>
+#include <vector>
 
 // Asset loader for Texture2DObject
 class Texture2DLoader : public TextureLoader<Texture2DObject>
 {
+public:
+    // Decoded image with all its levels, ready to be uploaded
+    struct MipChain
+    {
+        Data::Type dataType;
+        // Level of the image stored in levels[0]. Finer levels were not generated
+        int firstLevel;
+        std::vector<MipmapGenerator::Level> levels;
+    };
+
 public:
     Texture2DLoader();
     Texture2DLoader(TextureObject::Format format, TextureObject::InternalFormat internalFormat);
 
-    // Load the texture from the path
+    // Load the texture from the path. Files with .dds extension are loaded as block compressed textures
     Texture2DObject Load(const char* path) override;
 
     // Helper to easily load a shared texture
@@ -21,8 +34,37 @@ public:
     inline bool GetFlipVertical() const { return m_flipVertical; }
     inline void SetFlipVertical(bool flipVertical) { m_flipVertical = flipVertical; }
 
+    inline bool GetPreferCompressed() const { return m_preferCompressed; }
+    inline void SetPreferCompressed(bool preferCompressed) { m_preferCompressed = preferCompressed; }
+
+    // Generator used for the mip levels. Its sRGB option is set from the internal format on each load
+    inline MipmapGenerator& GetMipmapGenerator() { return m_mipmapGenerator; }
+    inline const MipmapGenerator& GetMipmapGenerator() const { return m_mipmapGenerator; }
+
+    // Get the path of the compressed file that replaces a source image: same name, with .dds extension
+    static std::string GetCompressedPath(const char* path);
+
+    // Decode the image and generate its mip levels. It doesn't use GL, so it can run in any thread
+    // If the generator is null, only level 0 is loaded. Otherwise, the levels before firstLevel are skipped
+    static bool LoadMipChain(const char* path, TextureObject::Format format, TextureObject::InternalFormat internalFormat,
+        bool flipVertical, const MipmapGenerator* generator, MipChain& mipChain, int firstLevel = 0);
+
+    // Create a texture with immutable storage for all the levels of the chain, that must start at level 0. Must be called in the GL thread
+    static Texture2DObject CreateTexture(const MipChain& mipChain, TextureObject::Format format, TextureObject::InternalFormat internalFormat);
+
+private:
+    // Load the mip chain stored in a compressed file
+    bool LoadCompressed(const char* path, Texture2DObject& texture2D);
+
 private:
     // If true, the texture will be flipped vertically on load
     // This option exists because some systems define the vertical origin as "up", and others as "down"
     bool m_flipVertical;
+
+    // If true, a compressed file next to the source image is loaded instead, if it exists
+    // Compressed files are stored with their final orientation and mip chain, so flip and mipmap options don't apply
+    bool m_preferCompressed;
+
+    // Generates the mip levels on the CPU, filtering in linear space
+    MipmapGenerator m_mipmapGenerator;
 };
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <ituGL/asset/Texture2DLoader.h>
+#include <ituGL/texture/Texture2DArrayObject.h>
+#include <unordered_map>
+#include <string>
+#include <vector>
+#include <memory>
+#include <span>
+
+// Packs 2D textures with the same size, format and number of levels as layers of texture arrays
+// Materials that sample the same arrays can be drawn one after the other without binding textures again
+class TextureArrayPacker
+{
+public:
+    // Array and layer where a texture was packed
+    struct PackedTexture
+    {
+        std::shared_ptr<Texture2DArrayObject> textureArray;
+        GLint layer;
+    };
+
+public:
+    TextureArrayPacker();
+
+    // Add a texture to be packed in the next build. The mip chain is kept until then
+    // Textures are identified by path. Adding a path that is already packed or pending does nothing
+    void Add(const std::string& path, Texture2DLoader::MipChain&& mipChain,
+        TextureObject::Format format, TextureObject::InternalFormat internalFormat);
+
+    // Check if the texture is packed or pending
+    bool Contains(const std::string& path) const;
+
+    // Create the arrays for all the pending textures. Must be called in the GL thread
+    void Build();
+
+    // Find where a texture was packed. Returns false if it was not packed in any build
+    bool Find(const std::string& path, PackedTexture& packedTexture) const;
+
+    // Number of arrays created by all the builds
+    inline unsigned int GetTextureArrayCount() const { return m_textureArrayCount; }
+
+private:
+    // Texture waiting for the next build
+    struct PendingTexture
+    {
+        std::string path;
+        Texture2DLoader::MipChain mipChain;
+        TextureObject::Format format;
+        TextureObject::InternalFormat internalFormat;
+    };
+
+private:
+    // Check if two pending textures can go in the same array
+    static bool IsSameGroup(const PendingTexture& a, const PendingTexture& b);
+
+    // Order pending textures so the ones that can share an array are together
+    static bool IsGroupOrder(const PendingTexture& a, const PendingTexture& b);
+
+    // Create one array with the textures in the range, one layer each
+    std::shared_ptr<Texture2DArrayObject> CreateTextureArray(std::span<const PendingTexture> textures);
+
+private:
+    std::vector<PendingTexture> m_pendingTextures;
+
+    std::unordered_map<std::string, PackedTexture> m_packedTextures;
+
+    unsigned int m_textureArrayCount;
+};
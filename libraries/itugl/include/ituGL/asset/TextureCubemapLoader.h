@@ -2,6 +2,7 @@
 
 #include <ituGL/asset/TextureLoader.h>
 #include <ituGL/texture/TextureCubemapObject.h>
+#include <ituGL/texture/MipmapGenerator.h>
 
 // Asset loader for TextureCubemapObject
 class TextureCubemapLoader : public TextureLoader<TextureCubemapObject>
@@ -18,7 +19,16 @@ public:
         TextureObject::Format format, TextureObject::InternalFormat internalFormat,
         bool generateMipmap = true);
 
+    // Generator used for the mip levels. Its sRGB option is set from the internal format on each load
+    inline MipmapGenerator& GetMipmapGenerator() { return m_mipmapGenerator; }
+    inline const MipmapGenerator& GetMipmapGenerator() const { return m_mipmapGenerator; }
+
+private:
+    // Copy the face at cell (x, y) of the cross layout to its own image
+    void ExtractFace(std::span<const std::byte> dataSrc, std::vector<std::byte>& dataDst, int x, int y, int side, Data::Type dataType);
+
 private:
-    void LoadFace(TextureCubemapObject& textureCubemap, TextureCubemapObject::Face face, std::span<const std::byte> dataSrc, std::span<std::byte> dataDst, int x, int y, int side, Data::Type dataType);
+    // Generates the mip levels on the CPU, filtering across the edges of the faces
+    MipmapGenerator m_mipmapGenerator;
 };
 
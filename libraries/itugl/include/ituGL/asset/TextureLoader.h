@@ -42,6 +42,9 @@ class TextureLoaderUtils
 public:
     static std::span<const std::byte> LoadTexture2DData(const char* path, int& width, int& height, Data::Type& dataType, TextureObject::Format format, TextureObject::InternalFormat internalFormat, bool flipVertical);
     static void FreeTexture2DData(std::span<const std::byte> data);
+
+    // Read only the header of the image: its size, and the data type that LoadTexture2DData would return
+    static bool GetTexture2DInfo(const char* path, int& width, int& height, Data::Type& dataType, TextureObject::InternalFormat internalFormat);
 private:
     static bool IsHDR(TextureObject::InternalFormat internalFormat);
 };
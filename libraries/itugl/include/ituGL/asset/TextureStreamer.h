@@ -0,0 +1,176 @@
+#pragma once
+
+#include <ituGL/texture/Texture2DObject.h>
+#include <ituGL/texture/MipmapGenerator.h>
+#include <ituGL/core/Data.h>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <string>
+#include <memory>
+#include <span>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+class Material;
+
+// Streams the mip levels of 2D textures depending on how they are sampled on screen
+// Textures start with only the coarse levels resident. The feedback pass reports the finest level sampled for each texture,
+// and a background thread loads the finer levels while the resident memory stays under the budget
+// When memory is needed, the least recently used textures lose their finest levels
+class TextureStreamer
+{
+public:
+    TextureStreamer(size_t memoryBudget = 256ull << 20);
+    ~TextureStreamer();
+
+    // Not copyable, it owns the background thread
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator = (const TextureStreamer&) = delete;
+
+    // Create a streamed texture with only the coarse levels resident. Loading the same path again returns the same texture
+    // If there is a compressed .dds file next to the image, the levels are read from it. Returns null if the file can't be loaded
+    std::shared_ptr<Texture2DObject> Load(const char* path, TextureObject::Format format, TextureObject::InternalFormat internalFormat,
+        bool flipVertical = false, bool normalMap = false);
+
+    // Maximum memory used by the resident levels, in bytes
+    inline size_t GetMemoryBudget() const { return m_memoryBudget; }
+    inline void SetMemoryBudget(size_t memoryBudget) { m_memoryBudget = memoryBudget; }
+
+    // Memory used by the resident levels, in bytes. Estimated from the size of the uploaded data
+    inline size_t GetResidentMemory() const { return m_residentMemory; }
+
+    // Levels of this size or smaller are loaded with the texture and always stay resident
+    inline GLsizei GetMinResidentSize() const { return m_minResidentSize; }
+    inline void SetMinResidentSize(GLsizei minResidentSize) { m_minResidentSize = minResidentSize; }
+
+    // Generator for the mip levels of uncompressed images. Its sRGB option is set from the internal format of each texture
+    inline MipmapGenerator& GetMipmapGenerator() { return m_mipmapGenerator; }
+    inline const MipmapGenerator& GetMipmapGenerator() const { return m_mipmapGenerator; }
+
+    // Get the id that the feedback pass writes for the streamed textures of the material. 0 if the material has none
+    unsigned int GetFeedbackId(const Material& material);
+
+    // Read the feedback of one frame: for each pixel, the feedback id and the log2 of the texture coordinate derivatives
+    void ProcessFeedback(std::span<const float> feedback);
+
+    // Upload the levels loaded in the background, request the levels needed by the feedback and release memory over the budget
+    // Must be called from the GL thread, once per frame
+    void Update();
+
+private:
+    // Texture with part of its levels resident
+    struct StreamedTexture
+    {
+        std::string path;
+        TextureObject::Format format;
+        TextureObject::InternalFormat internalFormat;
+        bool flipVertical;
+        bool normalMap;
+        std::shared_ptr<Texture2DObject> texture;
+        // Size of level 0
+        GLsizei width;
+        GLsizei height;
+        int levelCount;
+        // Bytes per pixel of uncompressed levels, 0 if block compressed
+        size_t pixelSize;
+        // Finest level uploaded. All the levels from this one to the last are resident
+        int residentLevel;
+        // Finest level that is always resident
+        int minResidentLevel;
+        // Finest level sampled in the last feedback
+        int requestedLevel;
+        // Feedback frame where the texture was last sampled
+        unsigned int lastUsedFrame;
+        // If the background thread is loading levels for this texture
+        bool loading;
+        // If the file could not be loaded again, no more requests are made
+        bool failed;
+    };
+
+    // Levels requested to the background thread, in [firstLevel, lastLevel)
+    struct LoadRequest
+    {
+        unsigned int textureIndex;
+        std::string path;
+        TextureObject::Format format;
+        TextureObject::InternalFormat internalFormat;
+        bool flipVertical;
+        MipmapGenerator generator;
+        int firstLevel;
+        int lastLevel;
+        // Memory reserved for the levels
+        size_t memory;
+    };
+
+    // Levels decoded by the background thread
+    struct LoadedLevels
+    {
+        unsigned int textureIndex;
+        // Number of levels of the whole texture
+        int levelCount;
+        bool compressed;
+        Data::Type dataType;
+        int firstLevel;
+        std::vector<MipmapGenerator::Level> levels;
+        size_t memory;
+    };
+
+private:
+    // Read the size, format and number of levels of the texture from the header of its file
+    static bool LoadInfo(StreamedTexture& streamedTexture);
+
+    // Decode the file and keep the levels of the request. Doesn't use GL, so it can run in the background thread
+    static bool LoadLevels(const LoadRequest& request, LoadedLevels& loadedLevels);
+
+    // Upload the loaded levels to the texture and make them resident
+    void UploadLevels(const LoadedLevels& loadedLevels);
+
+    // Release the finest resident level of the texture
+    void ReleaseLevel(StreamedTexture& streamedTexture);
+
+    // Release levels of the least recently used textures, until the required memory fits in the budget
+    // Textures sampled in protectedFrame or later are not released. Returns false if there is not enough memory to release
+    bool ReleaseMemory(size_t requiredMemory, unsigned int protectedFrame);
+
+    // Memory used by a level of the texture
+    static size_t GetLevelMemory(const StreamedTexture& streamedTexture, int level);
+
+    // Path of the compressed file that contains the levels, or empty if the image must be decoded
+    static std::string FindCompressedPath(const std::string& path);
+
+    // Create the request for a range of levels of the texture
+    LoadRequest CreateRequest(unsigned int textureIndex, int firstLevel, int lastLevel) const;
+
+    // Loop of the background thread
+    void ProcessRequests();
+
+private:
+    size_t m_memoryBudget;
+    size_t m_residentMemory;
+    // Memory reserved for the requests that are still loading
+    size_t m_pendingMemory;
+    GLsizei m_minResidentSize;
+    MipmapGenerator m_mipmapGenerator;
+
+    // Number of feedbacks processed
+    unsigned int m_feedbackFrame;
+
+    std::vector<StreamedTexture> m_textures;
+    // Index of the textures, by path and by texture object
+    std::unordered_map<std::string, unsigned int> m_pathIndices;
+    std::unordered_map<const TextureObject*, unsigned int> m_textureIndices;
+
+    // Streamed textures of each material. The feedback id is the index + 1
+    std::vector<std::vector<unsigned int>> m_feedbackGroups;
+    std::unordered_map<const Material*, unsigned int> m_materialFeedbackIds;
+
+    // Shared with the background thread
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::deque<LoadRequest> m_requests;
+    std::vector<LoadedLevels> m_loadedLevels;
+    bool m_stop;
+    std::thread m_thread;
+};
@@ -13,6 +13,8 @@ public:
         ArrayBuffer = GL_ARRAY_BUFFER,
         // Element Buffer Object
         ElementArrayBuffer = GL_ELEMENT_ARRAY_BUFFER,
+        // Output of the vertex processing, captured with transform feedback
+        TransformFeedbackBuffer = GL_TRANSFORM_FEEDBACK_BUFFER,
         // TODO: There are more types, add them when they are supported
     };
 
@@ -58,6 +60,19 @@ public:
     // Modify the contents of the buffer, starting at offset
     void UpdateData(std::span<const std::byte> data, size_t offset = 0);
 
+    // Map size bytes of the buffer, starting at offset, to write them directly from the CPU. The buffer must stay bound
+    // All the previous contents are discarded, so the GPU doesn't need to finish the draws still reading them
+    std::span<std::byte> MapData(size_t size, size_t offset = 0);
+    // Finish writing the mapped range. Returns false if the contents were lost and must be written again
+    bool UnmapData();
+
+    // Copy size bytes from another buffer, without reading them back to the CPU
+    void CopyData(const BufferObject& source, size_t size, size_t sourceOffset = 0, size_t offset = 0);
+
+    // Bind the buffer to an indexed binding point of the target, like the outputs of transform feedback
+    void BindBase(Target target, GLuint index) const;
+    static void UnbindBase(Target target, GLuint index);
+
 protected:
     // Bind the specific target. Used by the Bind() method in derived classes
     void Bind(Target target) const;
@@ -20,6 +20,9 @@ public:
         UShort = GL_UNSIGNED_SHORT,
         Int = GL_INT,
         UInt = GL_UNSIGNED_INT,
+        // Packed types, 4 components in 32 bits: 10 bits for xyz and 2 bits for w
+        Int2101010Rev = GL_INT_2_10_10_10_REV,
+        UInt2101010Rev = GL_UNSIGNED_INT_2_10_10_10_REV,
         // And more...
     };
 
@@ -37,6 +40,9 @@ public:
     // Get size in bytes for each Type
     static unsigned int GetTypeSize(Type type);
 
+    // If all the components of the type are packed in a single value of GetTypeSize bytes
+    static bool IsPacked(Type type);
+
     // Convert data to a span of bytes
     template <typename T>
     static std::span<std::byte> GetBytes(T& data);
@@ -39,6 +39,9 @@ public:
     // Clear the framebuffer with the specified color, depth and stencil
     void Clear(bool clearColor, const Color& color, bool clearDepth, GLdouble depth, bool clearStencil, GLint stencil);
 
+    // Check if an OpenGL extension is supported by the current context
+    bool IsExtensionSupported(const char* extension) const;
+
     // Get if a feature is enabled
     bool IsFeatureEnabled(GLenum feature) const;
     // enable / disable a feature
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+#include <glm/common.hpp>
+#include <vector>
+#include <span>
+#include <limits>
+#include <utility>
+
+// Bounding volume hierarchy over axis aligned boxes, built with the surface area heuristic
+// Nodes are stored in a flat array, with the two children of a node next to each other and after their parent
+class Bvh
+{
+public:
+    struct Node
+    {
+        glm::vec3 boundsMin;
+        // Leaf: first primitive in the primitive indices. Inner node: index of the first child, the second one follows it
+        unsigned int firstIndex;
+        glm::vec3 boundsMax;
+        // Number of primitives in a leaf, 0 for inner nodes
+        unsigned int primitiveCount;
+
+        inline bool IsLeaf() const { return primitiveCount > 0; }
+    };
+
+public:
+    Bvh();
+
+    // Build the hierarchy for the primitives with these bounds
+    void Build(std::span<const glm::vec3> boundsMin, std::span<const glm::vec3> boundsMax, unsigned int maxLeafSize = s_defaultMaxLeafSize);
+
+    // Recompute the bounds of the nodes for new primitive bounds, keeping the tree. The number of primitives must not change
+    void Refit(std::span<const glm::vec3> boundsMin, std::span<const glm::vec3> boundsMax);
+
+    // Expected cost of a query with the surface area heuristic, in primitive tests. It grows as the tree is refitted
+    float GetCost() const;
+
+    inline bool IsEmpty() const { return m_nodes.empty(); }
+    inline unsigned int GetPrimitiveCount() const { return static_cast<unsigned int>(m_primitiveIndices.size()); }
+
+    inline std::span<const Node> GetNodes() const { return m_nodes; }
+
+    // Primitives in the order of the leaves
+    inline std::span<const unsigned int> GetPrimitiveIndices() const { return m_primitiveIndices; }
+
+    // Visit the leaves whose nodes, and all their ancestors, pass the test
+    // nodeTest(boundsMin, boundsMax) returns if the node is visited. visitLeaf(primitiveIndices) gets the primitives of each leaf
+    template<typename TNodeTest, typename TLeafVisitor>
+    void Traverse(TNodeTest&& nodeTest, TLeafVisitor&& visitLeaf) const;
+
+    // Visit the leaves crossed by the ray, nearest first
+    // visitLeaf(primitiveIndices, maxDistance) gets the primitives of each leaf, and can reduce maxDistance when it finds a hit
+    template<typename TLeafVisitor>
+    void TraverseRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, TLeafVisitor&& visitLeaf) const;
+
+    // Slab test of the ray against the box. On hit, distance is where the ray enters the box, 0 if it starts inside
+    static bool IntersectsRay(const glm::vec3& boundsMin, const glm::vec3& boundsMax,
+        const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance, float& distance);
+
+private:
+    static float GetSurfaceArea(const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+
+    // Split the primitives of the node, or leave it as a leaf if that is cheaper. Returns false if the node is a leaf
+    // With maxLeafSize 0, the primitives are split in two halves without evaluating the cost
+    bool SplitNode(unsigned int nodeIndex, std::span<const glm::vec3> boundsMin, std::span<const glm::vec3> boundsMax, unsigned int maxLeafSize);
+
+    // Set the bounds of the node from its primitives
+    void UpdateLeafBounds(Node& node, std::span<const glm::vec3> boundsMin, std::span<const glm::vec3> boundsMax) const;
+
+private:
+    std::vector<Node> m_nodes;
+    std::vector<unsigned int> m_primitiveIndices;
+
+    // Default number of primitives that can share a leaf
+    static const unsigned int s_defaultMaxLeafSize = 4;
+
+    // Number of buckets where the split positions are evaluated on each axis
+    static const unsigned int s_binCount = 12;
+
+    // Maximum depth of the traversal stack
+    static const unsigned int s_maxDepth = 64;
+};
+
+template<typename TNodeTest, typename TLeafVisitor>
+void Bvh::Traverse(TNodeTest&& nodeTest, TLeafVisitor&& visitLeaf) const
+{
+    if (m_nodes.empty())
+        return;
+
+    unsigned int stack[s_maxDepth];
+    unsigned int stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0)
+    {
+        const Node& node = m_nodes[stack[--stackSize]];
+        if (!nodeTest(node.boundsMin, node.boundsMax))
+            continue;
+
+        if (node.IsLeaf())
+        {
+            visitLeaf(std::span<const unsigned int>(m_primitiveIndices.data() + node.firstIndex, node.primitiveCount));
+        }
+        else
+        {
+            stack[stackSize++] = node.firstIndex + 1;
+            stack[stackSize++] = node.firstIndex;
+        }
+    }
+}
+
+template<typename TLeafVisitor>
+void Bvh::TraverseRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, TLeafVisitor&& visitLeaf) const
+{
+    float distance;
+    glm::vec3 inverseDirection = 1.0f / direction;
+    if (m_nodes.empty() || !IntersectsRay(m_nodes[0].boundsMin, m_nodes[0].boundsMax, origin, inverseDirection, maxDistance, distance))
+        return;
+
+    // Nodes are pushed with the distance where the ray enters them, so they can be skipped after a closer hit
+    std::pair<unsigned int, float> stack[s_maxDepth];
+    unsigned int stackSize = 0;
+    stack[stackSize++] = std::make_pair(0u, distance);
+    while (stackSize > 0)
+    {
+        auto [nodeIndex, nodeDistance] = stack[--stackSize];
+        if (nodeDistance > maxDistance)
+            continue;
+
+        const Node& node = m_nodes[nodeIndex];
+        if (node.IsLeaf())
+        {
+            visitLeaf(std::span<const unsigned int>(m_primitiveIndices.data() + node.firstIndex, node.primitiveCount), maxDistance);
+            continue;
+        }
+
+        const Node& first = m_nodes[node.firstIndex];
+        const Node& second = m_nodes[node.firstIndex + 1];
+        float firstDistance, secondDistance;
+        bool firstHit = IntersectsRay(first.boundsMin, first.boundsMax, origin, inverseDirection, maxDistance, firstDistance);
+        bool secondHit = IntersectsRay(second.boundsMin, second.boundsMax, origin, inverseDirection, maxDistance, secondDistance);
+
+        // Push the farthest child first, so the nearest one is visited next
+        if (firstHit && secondHit)
+        {
+            bool firstNearest = firstDistance <= secondDistance;
+            stack[stackSize++] = firstNearest ? std::make_pair(node.firstIndex + 1, secondDistance) : std::make_pair(node.firstIndex, firstDistance);
+            stack[stackSize++] = firstNearest ? std::make_pair(node.firstIndex, firstDistance) : std::make_pair(node.firstIndex + 1, secondDistance);
+        }
+        else if (firstHit)
+        {
+            stack[stackSize++] = std::make_pair(node.firstIndex, firstDistance);
+        }
+        else if (secondHit)
+        {
+            stack[stackSize++] = std::make_pair(node.firstIndex + 1, secondDistance);
+        }
+    }
+}
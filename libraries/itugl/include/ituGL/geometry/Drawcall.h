@@ -1,6 +1,7 @@
 #pragma once
 
 #include <ituGL/core/Data.h>
+#include <span>
 
 // Helper class to store the parameters of a drawcall
 class Drawcall
@@ -31,9 +32,21 @@ public:
     // Check if the drawcall is valid
     inline bool IsValid() const { return m_primitive != Primitive::Invalid && m_count > 0; }
 
+    inline Primitive GetPrimitive() const { return m_primitive; }
+    inline GLint GetFirst() const { return m_first; }
+    inline GLsizei GetCount() const { return m_count; }
+    inline Data::Type GetEboType() const { return m_eboType; }
+
     // Execute the drawcall
     void Draw() const;
 
+    // Execute the drawcall several times in a single call, the shader tells them apart with gl_InstanceID
+    void DrawInstanced(GLsizei instanceCount) const;
+
+    // Execute the drawcall only for some ranges of the elements, in a single call. Requires an EBO
+    // Offsets are in bytes from the start of the EBO, like the ones GL expects
+    void DrawRanges(std::span<const void* const> elementOffsets, std::span<const GLsizei> counts) const;
+
 private:
     // Type of primitive to be rendered
     Primitive m_primitive;
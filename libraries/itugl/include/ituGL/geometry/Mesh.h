@@ -5,8 +5,14 @@
 #include <ituGL/geometry/VertexArrayObject.h>
 #include <ituGL/geometry/VertexAttribute.h>
 #include <ituGL/geometry/Drawcall.h>
+#include <ituGL/geometry/Meshlet.h>
+#include <ituGL/geometry/MeshBounds.h>
+#include <ituGL/geometry/Bvh.h>
 #include <ituGL/shader/ShaderProgram.h>
+#include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
 #include <vector>
+#include <memory>
 #include <unordered_map>
 
 // Class that groups several VBO, EBO and VAO that are part of the same object
@@ -108,11 +114,47 @@ public:
 
     inline unsigned int GetVertexArrayCount() const { return static_cast<unsigned int>(m_vaos.size()); }
     inline const VertexArrayObject& GetVertexArray(unsigned int vaoIndex) const { return m_vaos[vaoIndex]; }
+    // Non-const access to add attributes from other buffers, like per instance data
+    inline VertexArrayObject& GetVertexArray(unsigned int vaoIndex) { return m_vaos[vaoIndex]; }
 
     inline unsigned int GetSubmeshCount() const { return static_cast<unsigned int>(m_submeshes.size()); }
     inline const VertexArrayObject& GetSubmeshVertexArray(unsigned int submeshIndex) const { return m_vaos[m_submeshes[submeshIndex].vaoIndex]; }
     inline const Drawcall& GetSubmeshDrawcall(unsigned int submeshIndex) const { return m_submeshes[submeshIndex].drawcall; }
 
+    // Optional matrix applied to the vertices of the submesh before the world matrix, for example to dequantize the positions
+    inline bool HasSubmeshLocalMatrix(unsigned int submeshIndex) const { return m_submeshes[submeshIndex].hasLocalMatrix; }
+    inline const glm::mat4& GetSubmeshLocalMatrix(unsigned int submeshIndex) const { return m_submeshes[submeshIndex].localMatrix; }
+    void SetSubmeshLocalMatrix(unsigned int submeshIndex, const glm::mat4& localMatrix);
+
+    // Optional clusters of the submesh triangles, so the renderer can skip the ones that are not visible
+    inline std::span<const Meshlet> GetSubmeshMeshlets(unsigned int submeshIndex) const { return m_submeshes[submeshIndex].meshlets; }
+    void SetSubmeshMeshlets(unsigned int submeshIndex, std::vector<Meshlet> meshlets);
+
+    // Optional bounds of the submesh vertices, in model space (the local matrix already applied)
+    inline bool HasSubmeshBounds(unsigned int submeshIndex) const { return m_submeshes[submeshIndex].hasBounds; }
+    inline const MeshBounds& GetSubmeshBounds(unsigned int submeshIndex) const { return m_submeshes[submeshIndex].bounds; }
+    void SetSubmeshBounds(unsigned int submeshIndex, const MeshBounds& bounds);
+
+    // Bounds of all the submeshes, only valid if every submesh has bounds. The oriented box is the one of the single submesh,
+    // or the axis aligned box if there are more. The version increases when they change, for example while the mesh is loading
+    inline bool HasBounds() const { return m_hasBounds; }
+    inline const MeshBounds& GetBounds() const { return m_bounds; }
+    inline unsigned int GetBoundsVersion() const { return m_boundsVersion; }
+
+    // Optional CPU copy of the triangles of the submesh, with the positions in model space (the local matrix already applied)
+    inline bool HasSubmeshTriangles(unsigned int submeshIndex) const { return !m_submeshes[submeshIndex].triangleIndices.empty(); }
+    inline std::span<const glm::vec3> GetSubmeshTrianglePositions(unsigned int submeshIndex) const { return m_submeshes[submeshIndex].trianglePositions; }
+    inline std::span<const unsigned int> GetSubmeshTriangleIndices(unsigned int submeshIndex) const { return m_submeshes[submeshIndex].triangleIndices; }
+    void SetSubmeshTriangles(unsigned int submeshIndex, std::vector<glm::vec3> positions, std::vector<unsigned int> indices);
+
+    // Hierarchy over the triangles of the submesh. Built the first time it is needed, so it is not thread safe
+    const Bvh& GetSubmeshTriangleBvh(unsigned int submeshIndex) const;
+
+    // Find the closest triangle of the submesh hit by the ray, in model space, before maxDistance. Only for submeshes with triangles
+    // On hit, maxDistance is set to the distance along the ray, in units of direction, and barycentrics to the weights of vertices 1 and 2
+    bool IntersectSubmesh(unsigned int submeshIndex, const glm::vec3& origin, const glm::vec3& direction, float& maxDistance,
+        unsigned int& triangleIndex, glm::vec2& barycentrics) const;
+
     // Draws a submesh
     void DrawSubmesh(int submeshIndex) const;
 
@@ -123,6 +165,14 @@ private:
     {
         unsigned int vaoIndex;
         Drawcall drawcall;
+        bool hasLocalMatrix;
+        glm::mat4 localMatrix;
+        std::vector<Meshlet> meshlets;
+        bool hasBounds;
+        MeshBounds bounds;
+        std::vector<glm::vec3> trianglePositions;
+        std::vector<unsigned int> triangleIndices;
+        mutable std::unique_ptr<Bvh> triangleBvh;
     };
 
 private:
@@ -131,11 +181,16 @@ private:
 
     inline ElementBufferObject& GetElementBuffer(unsigned int eboIndex) { return m_ebos[eboIndex]; }
 
-    inline VertexArrayObject& GetVertexArray(unsigned int vaoIndex) { return m_vaos[vaoIndex]; }
-
     inline const Submesh& GetSubmesh(unsigned int submeshIndex) const { return m_submeshes[submeshIndex]; }
     inline Submesh& GetSubmesh(unsigned int submeshIndex) { return m_submeshes[submeshIndex]; }
 
+    // Merge the bounds of the submeshes in the bounds of the mesh
+    void UpdateBounds();
+
+    // Ray and triangle intersection, Moller-Trumbore. Returns the distance along the ray and the barycentrics of vertices 1 and 2
+    static bool IntersectTriangle(const glm::vec3& origin, const glm::vec3& direction,
+        const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, float& distance, glm::vec2& barycentrics);
+
     // Set a vertex attribute in a VAO, using the specified layout, and increases the location index according to the size of the attribute
     void SetupVertexAttribute(VertexArrayObject& vao, const VertexAttribute::Layout& attributeLayout, GLuint& location, const SemanticMap& locations);
 
@@ -151,6 +206,11 @@ private:
 
     // Submeshes contained in this mesh
     std::vector<Submesh> m_submeshes;
+
+    // Bounds of all the submeshes
+    bool m_hasBounds;
+    MeshBounds m_bounds;
+    unsigned int m_boundsVersion;
 };
 
 template<typename T>
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+#include <glm/mat3x3.hpp>
+
+// Bounding volumes of the vertices of a submesh, in model space
+// Each one is tighter for different shapes, so the users pick the one that fits their test
+struct MeshBounds
+{
+    // Axis aligned box, as center and half size
+    glm::vec3 aabbCenter;
+    glm::vec3 aabbExtents;
+
+    // Bounding sphere
+    glm::vec3 sphereCenter;
+    float sphereRadius;
+
+    // Oriented box along the principal axes of the vertices, as center, unit axes in the columns, and half size along each axis
+    // It is the axis aligned box when that one is smaller
+    glm::vec3 boxCenter;
+    glm::mat3 boxAxes;
+    glm::vec3 boxExtents;
+};
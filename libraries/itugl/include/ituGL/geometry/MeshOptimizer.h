@@ -0,0 +1,76 @@
+#pragma once
+
+#include <ituGL/core/Object.h>
+#include <ituGL/geometry/Meshlet.h>
+#include <ituGL/geometry/MeshBounds.h>
+#include <glm/vec3.hpp>
+#include <vector>
+#include <span>
+
+// Reorders triangle lists and vertex data to render faster, without changing the result
+// It only works with indices and CPU data, so it can run in worker threads and without a GPU
+class MeshOptimizer
+{
+public:
+    // Efficiency of the post-transform vertex cache for an index list
+    struct CacheStatistics
+    {
+        // Average cache miss ratio: vertices transformed per triangle. Between 0.5 (ideal) and 3
+        float acmr;
+        // Average transform to vertex ratio: vertices transformed per vertex used. 1 is ideal
+        float atvr;
+    };
+
+public:
+    // Reorder the vertices, the triangles and their clusters of a triangle list in one go
+    // Vertex data is interleaved, with vertexSize bytes per vertex and the position as 3 floats at positionOffset
+    // Returns the number of vertices left, unused vertices are removed from the end of the data
+    static unsigned int Optimize(std::span<unsigned int> indices, std::span<GLubyte> vertexData, size_t vertexSize, size_t positionOffset,
+        unsigned int cacheSize = s_defaultCacheSize);
+
+    // Reorder the triangles to reuse the vertices in the post-transform cache, with the Tipsify algorithm
+    // If clusterStarts is not null, it receives the first triangle of each cluster, where the algorithm had to jump to a new area
+    static void OptimizeVertexCache(std::span<unsigned int> indices, unsigned int vertexCount,
+        unsigned int cacheSize = s_defaultCacheSize, std::vector<unsigned int>* clusterStarts = nullptr);
+
+    // Reorder the clusters of an index list optimized for the vertex cache, so the ones facing outwards are drawn first
+    // Clusters are split further while the cache efficiency is within threshold of the original one
+    static void OptimizeOverdraw(std::span<unsigned int> indices, std::span<const unsigned int> clusterStarts,
+        std::span<const GLubyte> vertexData, size_t vertexSize, size_t positionOffset,
+        unsigned int cacheSize = s_defaultCacheSize, float threshold = 1.05f);
+
+    // Reorder the vertices in the order they are first used by the indices, so they are fetched sequentially
+    // Indices are remapped to the new order. Returns the number of vertices used
+    static unsigned int OptimizeVertexFetch(std::span<unsigned int> indices, std::span<GLubyte> vertexData, size_t vertexSize);
+
+    // Split a triangle list in meshlets of consecutive triangles, with up to maxVertices vertices and maxTriangles triangles each
+    // Triangles keep their order, so the list should be optimized for the vertex cache first to get compact meshlets
+    static std::vector<Meshlet> BuildMeshlets(std::span<const unsigned int> indices, std::span<const GLubyte> vertexData, size_t vertexSize,
+        size_t positionOffset, unsigned int maxVertices = s_defaultMeshletVertices, unsigned int maxTriangles = s_defaultMeshletTriangles);
+
+    // Compute the bounds of all the vertices: the box, a sphere with Ritter's algorithm, and an oriented box from the covariance
+    static MeshBounds ComputeBounds(std::span<const GLubyte> vertexData, size_t vertexSize, size_t positionOffset);
+
+    // Simulate a FIFO post-transform cache with the triangle list
+    static CacheStatistics AnalyzeVertexCache(std::span<const unsigned int> indices, unsigned int vertexCount,
+        unsigned int cacheSize = s_defaultCacheSize);
+
+private:
+    // Read the position of a vertex from the interleaved data
+    static glm::vec3 GetPosition(std::span<const GLubyte> vertexData, size_t vertexSize, size_t positionOffset, unsigned int vertex);
+
+    // Compute the bounding sphere and the normal cone of the triangles in the meshlet range
+    static void ComputeMeshletBounds(Meshlet& meshlet, std::span<const unsigned int> indices, std::span<const GLubyte> vertexData,
+        size_t vertexSize, size_t positionOffset);
+
+    // Eigenvectors of a symmetric matrix, as the columns of a rotation matrix, with Jacobi rotations
+    static glm::mat3 ComputeEigenvectors(glm::mat3 matrix);
+
+private:
+    // Common size of the post-transform cache in current hardware
+    static const unsigned int s_defaultCacheSize = 16;
+
+    // Meshlet limits that fit the usual mesh shader and cluster culling budgets
+    static const unsigned int s_defaultMeshletVertices = 64;
+    static const unsigned int s_defaultMeshletTriangles = 124;
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+
+// Small cluster of triangles, stored as a range of consecutive elements of a submesh
+// Its bounds allow culling the cluster before drawing: a sphere for the frustum, and a normal cone for back faces
+struct Meshlet
+{
+    // Range of the cluster, in elements from the first element of the submesh
+    unsigned int firstElement;
+    unsigned int elementCount;
+
+    // Bounding sphere of the vertices
+    glm::vec3 center;
+    float radius;
+
+    // All the triangles face away from the cameras where dot(normalize(coneApex - camera), coneAxis) >= coneCutoff
+    // The cutoff is 1 or more if the normals are too spread to cull the cluster
+    glm::vec3 coneApex;
+    glm::vec3 coneAxis;
+    float coneCutoff;
+};
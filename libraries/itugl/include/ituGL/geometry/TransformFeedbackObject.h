@@ -0,0 +1,50 @@
+#pragma once
+
+#include <ituGL/core/Object.h>
+#include <ituGL/geometry/Drawcall.h>
+
+class BufferObject;
+
+// Transform Feedback Object stores the buffers that capture the outputs of the vertex processing
+// It also keeps how many vertices were written in the last capture, so they can be drawn without reading the count back
+class TransformFeedbackObject : public Object
+{
+public:
+    TransformFeedbackObject();
+    virtual ~TransformFeedbackObject();
+
+    // Move semantics
+    TransformFeedbackObject(TransformFeedbackObject&& transformFeedback) noexcept;
+    TransformFeedbackObject& operator = (TransformFeedbackObject&& transformFeedback) noexcept;
+
+    // Implements the Bind required by Object
+    void Bind() const override;
+    // Unbinds currently bound TransformFeedbackObject
+    static void Unbind();
+
+    // Set the buffer that receives the outputs at the binding index. The object must be bound
+    void SetBuffer(GLuint index, const BufferObject& buffer);
+
+    // Start and finish capturing the primitives of the drawcalls in between. The object must be bound
+    // Primitives that don't fit in the buffers are dropped
+    void Begin(Drawcall::Primitive primitive);
+    void End();
+
+    // Draw the vertices captured the last time, without the CPU knowing how many there are
+    // It doesn't need to be bound, but something must have been captured before
+    void Draw(Drawcall::Primitive primitive) const;
+
+#ifndef NDEBUG
+    // Check if there is any TransformFeedbackObject currently bound
+    inline static bool IsAnyBound() { return s_boundHandle != Object::NullHandle; }
+#endif
+
+protected:
+#ifndef NDEBUG
+    // Check if this TransformFeedbackObject is currently bound
+    inline bool IsBound() const override { return s_boundHandle == GetHandle(); }
+
+    // Handle of the TransformFeedbackObject that is currently bound
+    static Handle s_boundHandle;
+#endif
+};
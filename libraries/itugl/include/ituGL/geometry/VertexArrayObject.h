@@ -25,7 +25,8 @@ public:
     // Sets what VertexAttribute is assigned to location, and how to access the data:
     // offset: where to start looking in the buffer
     // stride: how far each element is from the previous one. Default value 0 will use the attribute size
-    void SetAttribute(GLuint location, const VertexAttribute& attribute, GLint offset, GLsizei stride = 0);
+    // divisor: if not 0, the attribute advances once every divisor instances instead of once per vertex
+    void SetAttribute(GLuint location, const VertexAttribute& attribute, GLint offset, GLsizei stride = 0, GLuint divisor = 0);
 
 #ifndef NDEBUG
     // Check if there is any VertexArrayObject currently bound
@@ -32,8 +32,8 @@ public:
     inline bool IsNormalized() const { return m_normalized; }
     inline Semantic GetSemantic() const { return m_semantic; }
 
-    // Gets the size of the attribute
-    inline int GetSize() const { return Data::GetTypeSize(m_type) * m_components; }
+    // Gets the size of the attribute. Packed types store all the components in a single value
+    inline int GetSize() const { return Data::GetTypeSize(m_type) * (Data::IsPacked(m_type) ? 1 : m_components); }
 
     // Gets how many location indices the attribute needs (usually 1)
     int GetLocationSize() const;
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <vector>
+#include <span>
+#include <utility>
+
+class Light;
+
+// Uniform grid over the influence spheres of the lights, to find the ones that reach an object without testing all of them
+// Cells are hashed in buckets, so the grid has no bounds. It is meant to be rebuilt every frame
+class LightGrid
+{
+public:
+    LightGrid();
+
+    // Cell size, 0 picks it from the average light range
+    float GetCellSize() const { return m_cellSize; }
+    void SetCellSize(float cellSize) { m_cellSize = cellSize; }
+
+    // Insert each light in the cells that its range overlaps. Lights without range go in a list that reaches everything
+    void Build(std::span<const Light* const> lights);
+
+    // Get the indices of the lights that reach the sphere, strongest first, keeping up to maxLights of them (0 keeps all)
+    // A negative radius means the bounds are unknown, then all the lights are candidates
+    void Query(const glm::vec3& center, float radius, unsigned int maxLights, std::vector<unsigned int>& lightIndices);
+
+    // Rough light that reaches the sphere: intensity of the brightest channel, with the distance attenuation at its closest point
+    static float EstimateContribution(const Light& light, const glm::vec3& center, float radius);
+
+private:
+    glm::ivec3 GetCell(const glm::vec3& position) const;
+    unsigned int GetBucket(const glm::ivec3& cell) const;
+
+    // Number of cells between the corners of the box, counted in floats because a large box can overflow the cell coordinates
+    float GetCellCount(const glm::vec3& minPosition, const glm::vec3& maxPosition) const;
+
+private:
+    float m_cellSize;
+
+    // Cell size used by the last build
+    float m_buildCellSize;
+
+    std::vector<const Light*> m_lights;
+
+    // Influence sphere of each light, with negative radius for the ones in the global list
+    std::vector<glm::vec4> m_lightSpheres;
+
+    // Lights without range, or that would cover too many cells
+    std::vector<unsigned int> m_globalLights;
+
+    // Lights of each bucket, from m_bucketOffsets[bucket] to m_bucketOffsets[bucket + 1]
+    std::vector<unsigned int> m_bucketOffsets;
+    std::vector<unsigned int> m_bucketLights;
+
+    // Bucket of each light inserted, as (bucket, light), while building
+    std::vector<glm::uvec2> m_entries;
+
+    // Last query that visited each light, so lights in several buckets are only tested once
+    std::vector<unsigned int> m_lightQueries;
+    unsigned int m_queryIndex;
+
+    // Candidates of the current query, as (contribution, light index)
+    std::vector<std::pair<float, unsigned int>> m_candidates;
+
+    // Lights covering more cells than this go in the global list
+    static constexpr float s_maxLightCells = 64.0f;
+
+    // Queries covering more cells than this test all the lights
+    static constexpr float s_maxQueryCells = 256.0f;
+};
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <vector>
+#include <array>
+#include <span>
+
+// Particles simulated in the CPU, for when the GPU can't run the simulation or to run it without a window
+// Particles are stored as structure of arrays, so the integration reads each array linearly and processes several particles
+// per instruction. Dead particles are found in blocks shared between threads, and then each thread integrates and compacts
+// whole arrays in place, so every array is read and written once per update
+// It doesn't use any GL objects: the vertices are written to memory provided by the caller, like a mapped buffer
+class CpuParticleSystem
+{
+public:
+    // Vertex written for each live particle. The alpha of the color fades out with the age
+    struct Vertex
+    {
+        glm::vec3 position;
+        float size;
+        glm::vec4 color;
+    };
+
+public:
+    CpuParticleSystem();
+
+    // Allocate the arrays for up to capacity particles
+    void Initialize(unsigned int capacity);
+
+    inline unsigned int GetCount() const { return m_count; }
+    inline unsigned int GetCapacity() const { return m_capacity; }
+
+    // Forces: constant acceleration, and drag proportional to the velocity
+    const glm::vec3& GetGravity() const { return m_gravity; }
+    void SetGravity(const glm::vec3& gravity) { m_gravity = gravity; }
+    float GetDrag() const { return m_drag; }
+    void SetDrag(float drag) { m_drag = drag; }
+
+    // Add a particle that lives lifetime seconds. Returns false if the system is already full
+    bool Emit(const glm::vec3& position, const glm::vec3& velocity, const glm::vec3& color, float size, float lifetime);
+
+    // Position coordinates of the live particles, in the same order as the vertices
+    inline std::span<const float> GetPositionX() const { return std::span(m_particles[PositionX].data(), m_count); }
+    inline std::span<const float> GetPositionY() const { return std::span(m_particles[PositionY].data(), m_count); }
+    inline std::span<const float> GetPositionZ() const { return std::span(m_particles[PositionZ].data(), m_count); }
+
+    // Remove all the particles
+    void Clear() { m_count = 0; }
+
+    // Advance the simulation and remove the particles that die. The live particles keep their relative order
+    void Update(float deltaTime);
+
+    // Write one vertex for each live particle. There must be room for GetCount() vertices
+    void WriteVertices(std::span<Vertex> vertices) const;
+
+    // Particles processed by each task, when the work is split in blocks. Blocks are small enough to balance the threads
+    static constexpr unsigned int s_blockSize = 4096;
+
+private:
+    // Particles processed together with SIMD instructions. Blocks are made of whole groups
+    static constexpr unsigned int s_groupSize = 8;
+
+    enum Attribute
+    {
+        PositionX, PositionY, PositionZ,
+        VelocityX, VelocityY, VelocityZ,
+        Age, Lifetime, Size,
+        ColorR, ColorG, ColorB,
+        AttributeCount
+    };
+
+    // One array for each attribute, all of them with room for the capacity
+    using ParticleArrays = std::array<std::vector<float>, AttributeCount>;
+
+    unsigned int GetBlockCount() const { return (m_count + s_blockSize - 1) / s_blockSize; }
+
+    // Find the particles of the block that are still alive after deltaTime, and store the runs of consecutive live particles
+    // at the start of the block. Returns how many are alive
+    unsigned int FindLiveRuns(unsigned int begin, unsigned int end, float deltaTime, unsigned int& runCount);
+
+    // Call function(source, destination, count) for each run of live particles, in order
+    template<typename TFunction>
+    void ForEachRun(TFunction&& function) const;
+
+    // Move the live particles to their compacted position, integrating them on the way
+    void MoveAxis(unsigned int axis, float deltaTime);
+    void MoveAge(float deltaTime);
+    void MoveAttribute(Attribute attribute);
+
+private:
+    unsigned int m_count;
+    unsigned int m_capacity;
+
+    // Live particles, compacted in place after each update
+    ParticleArrays m_particles;
+
+    // Runs of live particles of each block, stored in the range of the block: the first particle of each run,
+    // and how many live particles of the block come before it
+    std::vector<unsigned int> m_runSources;
+    std::vector<unsigned int> m_runOffsets;
+
+    // Live particles and runs of each block, and where the live particles start in the compacted output
+    std::vector<unsigned int> m_blockLiveCounts;
+    std::vector<unsigned int> m_blockRunCounts;
+    std::vector<unsigned int> m_blockOffsets;
+
+    glm::vec3 m_gravity;
+    float m_drag;
+};
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <ituGL/geometry/VertexArrayObject.h>
+#include <ituGL/geometry/VertexBufferObject.h>
+#include <ituGL/geometry/TransformFeedbackObject.h>
+#include <ituGL/shader/ShaderProgram.h>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+#include <array>
+
+// Particles emitted, simulated and drawn in the GPU. The CPU only sets the parameters and the number of particles to emit
+// Each update runs the live particles through a shader that applies the forces and drops the dead ones, then appends the new ones
+// The output is captured with transform feedback, so it stays compact, and its size is only known by the GPU
+// Shaders are loaded from shaders/particles/, relative to the working directory
+class GpuParticleSystem
+{
+public:
+    // Ranges of the properties of the new particles. Each particle gets a random value in each range
+    struct Emitter
+    {
+        glm::vec3 position;
+        // Particles start in a sphere of this radius around the position
+        float positionSpread;
+
+        glm::vec3 velocity;
+        // A random vector up to this length is added to the velocity
+        float velocitySpread;
+
+        glm::vec3 colorMin;
+        glm::vec3 colorMax;
+
+        // Seconds that the particle lives, and point size in pixels
+        glm::vec2 lifetime;
+        glm::vec2 size;
+    };
+
+public:
+    GpuParticleSystem();
+
+    // Build the shaders and allocate the buffers for up to capacity particles
+    void Initialize(unsigned int capacity);
+
+    unsigned int GetCapacity() const { return m_capacity; }
+
+    const Emitter& GetEmitter() const { return m_emitter; }
+    void SetEmitter(const Emitter& emitter) { m_emitter = emitter; }
+
+    // Forces: constant acceleration, and drag proportional to the velocity
+    const glm::vec3& GetGravity() const { return m_gravity; }
+    void SetGravity(const glm::vec3& gravity) { m_gravity = gravity; }
+    float GetDrag() const { return m_drag; }
+    void SetDrag(float drag) { m_drag = drag; }
+
+    // Points that pull the particles with the strength divided by the squared distance. Negative strength pushes them away
+    static constexpr unsigned int GetMaxAttractors() { return s_maxAttractors; }
+    void SetAttractor(unsigned int index, const glm::vec3& position, float strength);
+
+    // Emit count particles with the current emitter in the next update. Particles that don't fit in the capacity are lost
+    void Emit(unsigned int count);
+
+    // Advance the simulation, adding the particles emitted since the last update
+    void Update(float deltaTime);
+
+    // Draw the live particles as points
+    void Draw(const glm::mat4& viewProjMatrix) const;
+
+private:
+    struct Particle
+    {
+        glm::vec4 positionAge;
+        glm::vec4 velocityLifetime;
+        glm::vec4 colorSize;
+    };
+
+    void InitializeBuffers();
+    void InitializeShaderPrograms();
+
+private:
+    unsigned int m_capacity;
+
+    // Particles are read from one buffer and written to the other, then they swap
+    std::array<VertexBufferObject, 2> m_vbos;
+    std::array<VertexArrayObject, 2> m_vaos;
+    std::array<TransformFeedbackObject, 2> m_transformFeedbacks;
+    unsigned int m_currentBuffer;
+    bool m_hasParticles;
+
+    // Emission doesn't read any attribute, particles are created from their index
+    VertexArrayObject m_emitVAO;
+    unsigned int m_emitCount;
+    Emitter m_emitter;
+
+    glm::vec3 m_gravity;
+    float m_drag;
+    static constexpr unsigned int s_maxAttractors = 4;
+    std::array<glm::vec4, s_maxAttractors> m_attractors;
+
+    ShaderProgram m_updateProgram;
+    ShaderProgram::Location m_deltaTimeLocation;
+    ShaderProgram::Location m_emitLocation;
+    ShaderProgram::Location m_randomSeedLocation;
+    ShaderProgram::Location m_gravityLocation;
+    ShaderProgram::Location m_dragLocation;
+    ShaderProgram::Location m_attractorsLocation;
+    ShaderProgram::Location m_emitterPositionLocation;
+    ShaderProgram::Location m_emitterVelocityLocation;
+    ShaderProgram::Location m_emitterColorMinLocation;
+    ShaderProgram::Location m_emitterColorMaxLocation;
+    ShaderProgram::Location m_emitterLifetimeSizeLocation;
+
+    ShaderProgram m_drawProgram;
+    ShaderProgram::Location m_viewProjMatrixLocation;
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <glm/mat4x4.hpp>
+#include <vector>
+#include <array>
+#include <span>
+
+// Sorts particles back to front, to draw them with alpha blending
+// Only the indices are sorted, to use them as an element buffer, so the vertex data is never reordered
+// The keys are the view space depths, sorted with a radix sort split between threads
+class ParticleSorter
+{
+public:
+    ParticleSorter();
+
+    // Sort the particles with the coordinates in the arrays, as seen by a camera with the view matrix
+    void Sort(std::span<const float> positionX, std::span<const float> positionY, std::span<const float> positionZ,
+        const glm::mat4& viewMatrix);
+
+    // Indices of the last sort, from the farthest particle to the closest
+    inline std::span<const unsigned int> GetIndices() const { return std::span(m_indices.data(), m_count); }
+
+    // Particles handled by each task. Histograms are per block, so a stable sort only needs them in order
+    static constexpr unsigned int s_blockSize = 16384;
+
+    // Blocks needed to split the passes of the sort between threads
+    static constexpr unsigned int s_minParallelBlockCount = 4;
+
+private:
+    // Map the float to an unsigned integer with the same order, so it can be sorted by its bits
+    static unsigned int GetSortableKey(float value);
+
+    void ComputeKeys(std::span<const float> positionX, std::span<const float> positionY, std::span<const float> positionZ,
+        const glm::mat4& viewMatrix);
+
+    // One pass of the radix sort, ordering the current keys by the digit at the shift into the other buffers
+    // Returns false, without doing anything, if all the keys have the same digit
+    bool SortDigit(unsigned int shift);
+
+private:
+    unsigned int m_count;
+
+    // Keys and indices, and the buffers where each pass writes them
+    std::vector<unsigned int> m_keys;
+    std::vector<unsigned int> m_indices;
+    std::vector<unsigned int> m_nextKeys;
+    std::vector<unsigned int> m_nextIndices;
+
+    // Bits sorted in each pass, and number of different digits
+    static constexpr unsigned int s_digitBits = 8;
+    static constexpr unsigned int s_digitCount = 1 << s_digitBits;
+
+    // Count of each digit in each block, then the position where the block writes the first key with that digit
+    std::vector<std::array<unsigned int, s_digitCount>> m_blockHistograms;
+};
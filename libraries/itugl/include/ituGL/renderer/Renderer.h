@@ -5,6 +5,7 @@
 #include <ituGL/geometry/Drawcall.h>
 #include <ituGL/geometry/Mesh.h>
 #include <ituGL/shader/Material.h>
+#include <ituGL/lighting/LightGrid.h>
 #include <glm/mat4x4.hpp>
 #include <vector>
 #include <unordered_map>
@@ -27,18 +28,25 @@ public:
     class DrawcallInfo
     {
     public:
-        DrawcallInfo(const Material& material, unsigned int worldMatrixIndex, const VertexArrayObject& vao, const Drawcall& drawcall);
+        DrawcallInfo(const Material& material, unsigned int worldMatrixIndex, unsigned int lightListIndex, const VertexArrayObject& vao,
+            const Drawcall& drawcall, std::span<const Meshlet> meshlets = {});
 
         const Material& GetMaterial() const { return m_material; }
         unsigned int GetWorldMatrixIndex() const { return m_worldMatrixIndex; }
+        // List of the lights that reach the drawcall, see GetDrawcallLights
+        unsigned int GetLightListIndex() const { return m_lightListIndex; }
         const VertexArrayObject& GetVAO() const { return m_vao; }
         const Drawcall& GetDrawcall() const { return m_drawcall; }
+        // Clusters of the drawcall triangles, empty if it has none
+        std::span<const Meshlet> GetMeshlets() const { return m_meshlets; }
 
     private:
         std::reference_wrapper<const Material> m_material;
         unsigned int m_worldMatrixIndex;
+        unsigned int m_lightListIndex;
         std::reference_wrapper<const VertexArrayObject> m_vao;
         std::reference_wrapper<const Drawcall> m_drawcall;
+        std::span<const Meshlet> m_meshlets;
     };
 
     using DrawcallSupportedFunction = std::function<bool(const DrawcallInfo& drawcallInfo)>;
@@ -85,6 +93,15 @@ public:
     std::span<const Light* const> GetLights() const;
     void AddLight(const Light& light);
 
+    // Lights that reach the drawcall, strongest first, found in the light grid when rendering starts
+    std::span<const Light* const> GetDrawcallLights(const DrawcallInfo& drawcallInfo) const;
+
+    // Most lights kept for each drawcall, the weakest ones are dropped. 0 keeps all the lights that reach it
+    unsigned int GetMaxDrawcallLights() const { return m_maxDrawcallLights; }
+    void SetMaxDrawcallLights(unsigned int maxDrawcallLights) { m_maxDrawcallLights = maxDrawcallLights; }
+
+    LightGrid& GetLightGrid() { return m_lightGrid; }
+
     std::span<const DrawcallInfo> GetDrawcalls(unsigned int collectionIndex) const;
     void AddModel(const Model& model, const glm::mat4& worldMatrix);
 
@@ -94,6 +111,8 @@ public:
     void SortDrawcallCollection(unsigned int index, const DrawcallSortFunction& drawcallSortFunction);
     bool IsBackToFront(const DrawcallInfo& a, const DrawcallInfo& b) const;
     bool IsFrontToBack(const DrawcallInfo& a, const DrawcallInfo& b) const;
+    // Sort to group drawcalls that share shader program and textures, so PrepareDrawcall can batch them
+    bool IsBatchOrder(const DrawcallInfo& a, const DrawcallInfo& b) const;
 
     const Mesh& GetFullscreenMesh() const;
 
@@ -109,6 +128,17 @@ public:
 
     void PrepareDrawcall(const DrawcallInfo& drawcallInfo, Material::OverrideFlags materialOverride = Material::NoOverride);
 
+    // Draw the drawcall prepared last. If it has meshlets, only the clusters visible from the current camera are drawn
+    void Draw(const DrawcallInfo& drawcallInfo) const;
+
+    // Cull the meshlets of the drawcalls against the frustum and by their normal cone, when they are prepared
+    bool GetMeshletCulling() const { return m_meshletCulling; }
+    void SetMeshletCulling(bool meshletCulling) { m_meshletCulling = meshletCulling; }
+
+    // Meshlets tested and drawn in the last call to Render
+    unsigned int GetTestedMeshletCount() const { return m_testedMeshletCount; }
+    unsigned int GetDrawnMeshletCount() const { return m_drawnMeshletCount; }
+
     void SetLightingRenderStates(bool firstPass);
 
     void Render();
@@ -116,10 +146,16 @@ public:
 private:
     void Reset();
 
+    // Fill the light list of each drawcall from the light grid
+    void AssignLights();
+
     void InitializeFullscreenMesh();
 
     const glm::mat4& GetWorldMatrix(const DrawcallInfo& drawcallInfo) const;
 
+    // Find the visible meshlets of the drawcall with the current camera, and merge them in element ranges for Draw
+    void CullMeshlets(const DrawcallInfo& drawcallInfo);
+
 private:
     DeviceGL& m_device;
 
@@ -127,11 +163,35 @@ private:
 
     std::shared_ptr<const Material> m_currentMaterial;
 
+    // Last material prepared in the current pass. The next drawcall keeps its program and textures if it is batch compatible
+    const Material* m_batchMaterial;
+
+    bool m_meshletCulling;
+    unsigned int m_testedMeshletCount;
+    unsigned int m_drawnMeshletCount;
+
+    // Visible ranges of the last drawcall prepared, if it had meshlets
+    const Drawcall* m_culledDrawcall;
+    std::vector<unsigned char> m_meshletVisibility;
+    std::vector<const void*> m_meshletOffsets;
+    std::vector<GLsizei> m_meshletCounts;
+
     std::shared_ptr<const FramebufferObject> m_defaultFramebuffer;
     std::shared_ptr<const FramebufferObject> m_currentFramebuffer;
 
     std::vector<const Light*> m_lights;
 
+    LightGrid m_lightGrid;
+    unsigned int m_maxDrawcallLights;
+
+    // World bounding sphere of each light list, with negative radius if the submesh has no bounds
+    std::vector<glm::vec4> m_lightListBounds;
+
+    // Lights of each list, from m_lightListOffsets[list] to m_lightListOffsets[list + 1]
+    std::vector<unsigned int> m_lightListOffsets;
+    std::vector<const Light*> m_lightListLights;
+    std::vector<unsigned int> m_lightIndices;
+
     std::vector<glm::mat4> m_worldMatrices;
 
     std::vector<DrawcallCollection> m_drawcallCollections;
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <ituGL/renderer/RenderPass.h>
+
+#include <ituGL/shader/ShaderProgram.h>
+#include <vector>
+#include <memory>
+
+class TextureStreamer;
+class Texture2DObject;
+
+// Renders the drawcalls to a small framebuffer, writing the feedback id of the material and the texture coordinate derivatives
+// The result is read back and sent to the texture streamer, to find the mip levels that are sampled
+// It uses its own framebuffer, so it should go before a pass that sets its target framebuffer
+class TextureFeedbackRenderPass : public RenderPass
+{
+public:
+    TextureFeedbackRenderPass(std::shared_ptr<TextureStreamer> textureStreamer, int width, int height, int drawcallCollectionIndex = 0);
+
+    // The feedback is rendered once every frameInterval frames, to reduce the cost of the read back
+    inline int GetFrameInterval() const { return m_frameInterval; }
+    inline void SetFrameInterval(int frameInterval) { m_frameInterval = frameInterval; }
+
+    void Render() override;
+
+private:
+    void InitTextures();
+    void InitFramebuffer();
+    void InitShaderProgram();
+
+private:
+    std::shared_ptr<TextureStreamer> m_textureStreamer;
+
+    int m_width;
+    int m_height;
+    int m_drawcallCollectionIndex;
+
+    int m_frameInterval;
+    int m_frameIndex;
+
+    std::shared_ptr<Texture2DObject> m_feedbackTexture;
+    std::shared_ptr<Texture2DObject> m_depthTexture;
+
+    std::shared_ptr<ShaderProgram> m_shaderProgram;
+    ShaderProgram::Location m_worldViewProjMatrixLocation;
+    ShaderProgram::Location m_feedbackIdLocation;
+    ShaderProgram::Location m_lodBiasLocation;
+    bool m_shaderProgramRegistered;
+
+    // Feedback read back from the GPU, 2 floats per pixel
+    std::vector<float> m_feedback;
+};
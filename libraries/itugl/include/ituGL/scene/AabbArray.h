@@ -0,0 +1,45 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+#include <vector>
+#include <span>
+
+// Axis aligned boxes stored as structure of arrays, one array for each coordinate of the centers and the half sizes
+// Batch tests read each array linearly, so they can process several boxes per instruction
+class AabbArray
+{
+public:
+    AabbArray();
+
+    inline unsigned int GetSize() const { return static_cast<unsigned int>(m_centerX.size()); }
+    void Resize(unsigned int size);
+
+    inline glm::vec3 GetCenter(unsigned int index) const { return glm::vec3(m_centerX[index], m_centerY[index], m_centerZ[index]); }
+    inline glm::vec3 GetExtents(unsigned int index) const { return glm::vec3(m_extentsX[index], m_extentsY[index], m_extentsZ[index]); }
+    void Set(unsigned int index, const glm::vec3& center, const glm::vec3& extents);
+
+    void PushBack(const glm::vec3& center, const glm::vec3& extents);
+    void PopBack();
+
+    // Copy the box at index from to index to
+    void Copy(unsigned int from, unsigned int to);
+
+    // Reorder the boxes so that box i is the old box order[i]
+    void Permute(std::span<const unsigned int> order);
+
+    // Arrays of each coordinate
+    inline std::span<const float> GetCenterX() const { return m_centerX; }
+    inline std::span<const float> GetCenterY() const { return m_centerY; }
+    inline std::span<const float> GetCenterZ() const { return m_centerZ; }
+    inline std::span<const float> GetExtentsX() const { return m_extentsX; }
+    inline std::span<const float> GetExtentsY() const { return m_extentsY; }
+    inline std::span<const float> GetExtentsZ() const { return m_extentsZ; }
+
+private:
+    std::vector<float> m_centerX;
+    std::vector<float> m_centerY;
+    std::vector<float> m_centerZ;
+    std::vector<float> m_extentsX;
+    std::vector<float> m_extentsY;
+    std::vector<float> m_extentsZ;
+};
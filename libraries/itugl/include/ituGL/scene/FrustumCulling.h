@@ -0,0 +1,43 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+#include <array>
+#include <vector>
+#include <span>
+
+class AabbArray;
+
+// Test many bounds against the planes of a view frustum at once
+// Bounds are read as structure of arrays, in blocks of 32 that fill one word of the visibility mask
+// The loops over a block have no branches and read each coordinate linearly, so the compiler can vectorize them
+class FrustumCulling
+{
+public:
+    // Planes of the frustum, pointing inwards and normalized, in the space that the matrix transforms from
+    using Planes = std::array<glm::vec4, 6>;
+    static Planes GetPlanes(const glm::mat4& viewProjectionMatrix);
+
+    // Bit i of the mask is set if bounds i are inside or intersect the frustum
+    static inline unsigned int GetMaskSize(unsigned int count) { return (count + s_blockSize - 1) / s_blockSize; }
+    static inline bool IsVisible(std::span<const unsigned int> visibilityMask, unsigned int index)
+    {
+        return (visibilityMask[index / s_blockSize] >> (index % s_blockSize)) & 1u;
+    }
+
+    // Fill the visibility mask of the boxes and return the number of visible ones
+    static unsigned int CullAabbs(const Planes& planes, const AabbArray& bounds, std::vector<unsigned int>& visibilityMask);
+
+    // Fill the visibility mask of the spheres and return the number of visible ones
+    static unsigned int CullSpheres(const Planes& planes, std::span<const float> centerX, std::span<const float> centerY,
+        std::span<const float> centerZ, std::span<const float> radius, std::vector<unsigned int>& visibilityMask);
+
+    // Test a single box or sphere, one plane after the other
+    static bool IsAabbVisible(const Planes& planes, const glm::vec3& center, const glm::vec3& extents);
+    static bool IsSphereVisible(const Planes& planes, const glm::vec3& center, float radius);
+
+private:
+    // Bounds tested together, one bit each in a word of the mask
+    static constexpr unsigned int s_blockSize = 32;
+};
@@ -1,8 +1,10 @@
 #pragma once
 
 #include <ituGL/scene/SceneVisitor.h>
+#include <vector>
 
 class Renderer;
+class Scene;
 class SceneCamera;
 class SceneLight;
 class SceneModel;
@@ -19,6 +21,19 @@ public:
 
     void VisitModel(SceneModel& sceneModel) override;
 
+    // Add the cameras, lights and models of the scene streaming through its component arrays, without visiting each node
+    // World matrices are taken from the last call to Scene::UpdateTransforms
+    // Models whose meshes have bounds are only added if their world bounds are inside the frustum of the camera
+    void VisitScene(const Scene& scene);
+
+    inline bool GetFrustumCulling() const { return m_frustumCulling; }
+    inline void SetFrustumCulling(bool frustumCulling) { m_frustumCulling = frustumCulling; }
+
 private:
     Renderer& m_renderer;
+
+    bool m_frustumCulling;
+
+    // Visibility of the scene entities, one bit each
+    std::vector<unsigned int> m_visibilityMask;
 };
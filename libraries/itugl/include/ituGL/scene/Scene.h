@@ -1,19 +1,129 @@
 #pragma once
 
+#include <ituGL/scene/SceneBvh.h>
+#include <ituGL/scene/AabbArray.h>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/mat4x4.hpp>
 #include <unordered_map>
+#include <vector>
 #include <string>
 #include <memory>
+#include <span>
+#include <limits>
 
 class SceneNode;
 class SceneVisitor;
+class Transform;
+class Model;
+class Light;
+class Camera;
 
+// Scene data stored in dense arrays, indexed by entity
+// Entities have stable ids, and their transforms, world matrices and bounds are kept in contiguous arrays
+// Models, lights, cameras and nodes are optional components, each in its own dense array, so they can be iterated linearly
 class Scene
 {
+public:
+    // Stable id of an entity. Ids of destroyed entities can be reused
+    using EntityId = unsigned int;
+    static constexpr EntityId InvalidEntity = ~0u;
+
+    // Closest triangle hit by a ray
+    struct RaycastHit
+    {
+        EntityId entity;
+        unsigned int submeshIndex;
+        unsigned int triangleIndex;
+        // Weights of the second and third vertices of the triangle. The first one is 1 - x - y
+        glm::vec2 barycentrics;
+        // Distance along the ray, in units of the direction
+        float distance;
+        glm::vec3 position;
+    };
+
 public:
     Scene();
     ~Scene();
 
+    // Entities
+    EntityId CreateEntity(std::shared_ptr<Transform> transform = nullptr);
+    void DestroyEntity(EntityId entity);
+    bool IsValidEntity(EntityId entity) const;
+
+    inline unsigned int GetEntityCount() const { return static_cast<unsigned int>(m_entities.size()); }
+
+    // Dense index of the entity in the arrays. It changes when other entities are destroyed, or when the hierarchy is sorted
+    unsigned int GetEntityIndex(EntityId entity) const;
+
+    // Ids of the entities, in dense order
+    inline std::span<const EntityId> GetEntities() const { return m_entities; }
+
+    // Transform of the entity. Entities without transform use the identity
+    // The hierarchy follows the parents of the transforms: if the parent transform belongs to another entity, that entity is the parent
+    std::shared_ptr<Transform> GetEntityTransform(EntityId entity) const;
+    void SetEntityTransform(EntityId entity, std::shared_ptr<Transform> transform);
+
+    // Bounds of the entity in local space, as center and half size
+    void SetEntityLocalBounds(EntityId entity, const glm::vec3& center, const glm::vec3& extents);
+
+    // World matrix and bounds of the entity, from the last call to UpdateTransforms
+    const glm::mat4& GetEntityWorldMatrix(EntityId entity) const;
+    glm::vec3 GetEntityBoundsCenter(EntityId entity) const;
+    glm::vec3 GetEntityBoundsExtents(EntityId entity) const;
+
+    // World matrices and world axis aligned bounds of all the entities, in dense order
+    // Bounds are stored as structure of arrays, for batch tests like FrustumCulling::CullAabbs
+    inline std::span<const glm::mat4> GetWorldMatrices() const { return m_worldMatrices; }
+    inline const AabbArray& GetBounds() const { return m_bounds; }
+
+    // Recompute the world matrices and bounds of the entities whose transform, or the transform of a parent, changed
+    // Entities are kept sorted by depth, parents before children, so the update is a single linear pass over each level
+    void UpdateTransforms();
+
+    // Threads used to update the levels of the hierarchy with many entities
+    inline unsigned int GetTransformThreadCount() const { return m_transformThreadCount; }
+    inline void SetTransformThreadCount(unsigned int threadCount) { m_transformThreadCount = threadCount; }
+
+    // Number of world matrices recomputed in the last call to UpdateTransforms
+    inline unsigned int GetUpdatedTransformCount() const { return m_updatedTransformCount; }
+
+    // Hierarchy over the world bounds of the models, for spatial queries. Refitted by UpdateTransforms
+    inline SceneBvh& GetBvh() { return m_bvh; }
+    inline const SceneBvh& GetBvh() const { return m_bvh; }
+
+    // Find the closest triangle of the models hit by the ray. Only submeshes with triangles kept in the mesh can be hit
+    // The hierarchy of the scene finds the models, and the hierarchy of each submesh its triangles
+    bool Raycast(const glm::vec3& origin, const glm::vec3& direction, RaycastHit& hit,
+        float maxDistance = std::numeric_limits<float>::max()) const;
+
+    // Components
+    // The local bounds of a model entity follow the bounds of its mesh, also when they change while the mesh is loading
+    // Meshes without bounds use a unit box, so the scale of the transform stands for their size
+    std::shared_ptr<Model> GetEntityModel(EntityId entity) const;
+    void SetEntityModel(EntityId entity, std::shared_ptr<Model> model);
+
+    std::shared_ptr<Light> GetEntityLight(EntityId entity) const;
+    void SetEntityLight(EntityId entity, std::shared_ptr<Light> light);
+
+    std::shared_ptr<Camera> GetEntityCamera(EntityId entity) const;
+    void SetEntityCamera(EntityId entity, std::shared_ptr<Camera> camera);
+
+    // Components in dense order, with the entity that owns each one
+    inline std::span<const std::shared_ptr<Model>> GetModels() const { return m_models.GetComponents(); }
+    inline std::span<const EntityId> GetModelEntities() const { return m_models.GetEntities(); }
+    inline std::span<const std::shared_ptr<Light>> GetLights() const { return m_lights.GetComponents(); }
+    inline std::span<const EntityId> GetLightEntities() const { return m_lights.GetEntities(); }
+    inline std::span<const std::shared_ptr<Camera>> GetCameras() const { return m_cameras.GetComponents(); }
+    inline std::span<const EntityId> GetCameraEntities() const { return m_cameras.GetEntities(); }
+
+    // Entity by name. Only entities added as nodes, or named explicitly, are in the name index
+    EntityId FindEntity(const std::string& name) const;
+    void SetEntityName(EntityId entity, const std::string& name);
+
+    // Scene nodes are kept as a component of their entity
     std::shared_ptr<SceneNode> GetSceneNode(const std::string& name) const;
+    std::shared_ptr<SceneNode> GetSceneNode(EntityId entity) const;
 
     bool AddSceneNode(std::shared_ptr<SceneNode> node);
 
@@ -24,5 +134,135 @@ public:
     void AcceptVisitor(SceneVisitor& visitor) const;
 
 private:
-    std::unordered_map<std::string, std::shared_ptr<SceneNode>> m_nodes;
+    // Dense array of components of type T, with a sparse index by entity id
+    template<typename T>
+    class ComponentArray
+    {
+    public:
+        bool Contains(EntityId entity) const;
+        const T* Find(EntityId entity) const;
+
+        // Add or replace the component of the entity
+        void Set(EntityId entity, const T& component);
+        void Remove(EntityId entity);
+
+        inline std::span<const T> GetComponents() const { return m_components; }
+        inline std::span<const EntityId> GetEntities() const { return m_entities; }
+
+    private:
+        std::vector<T> m_components;
+        std::vector<EntityId> m_entities;
+        // Index in the dense arrays of each entity id
+        std::vector<unsigned int> m_indices;
+    };
+
+private:
+    void RemoveEntityName(EntityId entity);
+
+    // Dense index of the parent of the entity at index, InvalidIndex if the parent transform is not in the scene
+    unsigned int FindParentIndex(unsigned int index) const;
+
+    // Sort the entities by depth in the hierarchy and mark all of them as dirty
+    void SortHierarchy();
+
+    // Recompute the world matrix and bounds of the entity at index, if it or its parent is dirty
+    void UpdateTransform(unsigned int index);
+
+    // Copy the bounds of the model mesh to the local bounds of the entity at index
+    void UpdateModelBounds(unsigned int index, const Model& model);
+
+private:
+    // Dense index of each entity id, or InvalidIndex if the id is free
+    std::vector<unsigned int> m_entityIndices;
+    std::vector<EntityId> m_freeEntities;
+
+    // Per entity data, in dense order
+    std::vector<EntityId> m_entities;
+    std::vector<std::shared_ptr<Transform>> m_transforms;
+    std::vector<glm::mat4> m_worldMatrices;
+    std::vector<glm::vec3> m_localBoundsCenters;
+    std::vector<glm::vec3> m_localBoundsExtents;
+    // Version of the mesh bounds copied to the local bounds of each model entity
+    std::vector<unsigned int> m_localBoundsVersions;
+    AabbArray m_bounds;
+
+    // Hierarchy, in dense order. Parents always come before their children
+    std::vector<unsigned int> m_parentIndices;
+    std::vector<unsigned int> m_transformVersions;
+    std::vector<unsigned char> m_dirtyFlags;
+    // First dense index of each level of depth, and the end of the last one
+    std::vector<unsigned int> m_levelOffsets;
+    bool m_hierarchyChanged;
+
+    // Entity that owns each transform, to find the parent entities
+    std::unordered_map<const Transform*, EntityId> m_transformEntities;
+
+    unsigned int m_transformThreadCount;
+    unsigned int m_updatedTransformCount;
+
+    SceneBvh m_bvh;
+
+    // Components
+    ComponentArray<std::shared_ptr<Model>> m_models;
+    ComponentArray<std::shared_ptr<Light>> m_lights;
+    ComponentArray<std::shared_ptr<Camera>> m_cameras;
+    ComponentArray<std::shared_ptr<SceneNode>> m_nodes;
+
+    // Optional side index of the entities by name
+    std::unordered_map<std::string, EntityId> m_names;
+    std::unordered_map<EntityId, std::string> m_entityNames;
+
+    static constexpr unsigned int InvalidIndex = ~0u;
+
+    // Minimum number of entities processed by each thread in the transform update
+    static const unsigned int s_transformBlockSize = 1024;
 };
+
+template<typename T>
+bool Scene::ComponentArray<T>::Contains(EntityId entity) const
+{
+    return entity < m_indices.size() && m_indices[entity] != InvalidIndex;
+}
+
+template<typename T>
+const T* Scene::ComponentArray<T>::Find(EntityId entity) const
+{
+    return Contains(entity) ? &m_components[m_indices[entity]] : nullptr;
+}
+
+template<typename T>
+void Scene::ComponentArray<T>::Set(EntityId entity, const T& component)
+{
+    if (Contains(entity))
+    {
+        m_components[m_indices[entity]] = component;
+        return;
+    }
+    if (entity >= m_indices.size())
+    {
+        m_indices.resize(entity + 1, InvalidIndex);
+    }
+    m_indices[entity] = static_cast<unsigned int>(m_components.size());
+    m_components.push_back(component);
+    m_entities.push_back(entity);
+}
+
+template<typename T>
+void Scene::ComponentArray<T>::Remove(EntityId entity)
+{
+    if (!Contains(entity))
+        return;
+
+    // Move the last component into the hole to keep the array dense
+    unsigned int index = m_indices[entity];
+    unsigned int lastIndex = static_cast<unsigned int>(m_components.size() - 1);
+    if (index != lastIndex)
+    {
+        m_components[index] = std::move(m_components[lastIndex]);
+        m_entities[index] = m_entities[lastIndex];
+        m_indices[m_entities[index]] = index;
+    }
+    m_components.pop_back();
+    m_entities.pop_back();
+    m_indices[entity] = InvalidIndex;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <ituGL/geometry/Bvh.h>
+#include <glm/mat4x4.hpp>
+#include <vector>
+#include <future>
+
+class Scene;
+
+// Bounding volume hierarchy over the world bounds of the models in a scene
+// It is refitted when the transforms change, and rebuilt in the background when the refitted tree gets too slow
+// Queries return the ids of the entities whose bounds pass the test. Results are appended leaf by leaf
+class SceneBvh
+{
+public:
+    SceneBvh();
+    ~SceneBvh();
+
+    // Not copyable, it can own a background build
+    SceneBvh(const SceneBvh&) = delete;
+    SceneBvh& operator = (const SceneBvh&) = delete;
+
+    // Refit the tree to the current bounds of the scene, or rebuild it if the models changed
+    void Update(const Scene& scene);
+
+    // Rebuild the tree now, waiting for any background build
+    void Rebuild(const Scene& scene);
+
+    // A background rebuild starts when the cost of the tree grows over this factor of its cost when it was built
+    inline float GetRebuildThreshold() const { return m_rebuildThreshold; }
+    inline void SetRebuildThreshold(float rebuildThreshold) { m_rebuildThreshold = rebuildThreshold; }
+
+    inline bool IsRebuilding() const { return m_rebuild.valid(); }
+
+    inline const Bvh& GetBvh() const { return m_bvh; }
+
+    // Entity of each primitive of the tree
+    inline std::span<const unsigned int> GetEntities() const { return m_entities; }
+
+    // World bounds of each primitive of the tree
+    inline std::span<const glm::vec3> GetBoundsMin() const { return m_boundsMin; }
+    inline std::span<const glm::vec3> GetBoundsMax() const { return m_boundsMax; }
+
+    // Entities whose bounds are inside or intersect the view frustum
+    void QueryFrustum(const glm::mat4& viewProjectionMatrix, std::vector<unsigned int>& entities) const;
+
+    // Entities whose bounds intersect the sphere
+    void QuerySphere(const glm::vec3& center, float radius, std::vector<unsigned int>& entities) const;
+
+    // Entities whose bounds intersect the box
+    void QueryAabb(const glm::vec3& boundsMin, const glm::vec3& boundsMax, std::vector<unsigned int>& entities) const;
+
+    // Entities whose bounds are crossed by the ray, in the order their leaves are reached, nearest first
+    void QueryRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, std::vector<unsigned int>& entities) const;
+
+private:
+    // Tree built in the background, with the entities it was built for
+    struct BuildResult
+    {
+        Bvh bvh;
+        std::vector<unsigned int> entities;
+        float cost;
+    };
+
+private:
+    // Read the world bounds of the model entities
+    static void CollectBounds(const Scene& scene, std::span<const unsigned int> entities,
+        std::vector<glm::vec3>& boundsMin, std::vector<glm::vec3>& boundsMax);
+
+    static BuildResult Build(std::vector<unsigned int> entities, std::vector<glm::vec3> boundsMin, std::vector<glm::vec3> boundsMax);
+
+    void StartRebuild(const Scene& scene);
+
+    // Append the entities whose bounds pass test(boundsMin, boundsMax). The same test culls the nodes
+    template<typename TTest>
+    void Query(TTest&& test, std::vector<unsigned int>& entities) const;
+
+private:
+    Bvh m_bvh;
+    std::vector<unsigned int> m_entities;
+    float m_buildCost;
+    float m_rebuildThreshold;
+
+    // World bounds of the entities, as they were when the tree was last built or refitted
+    std::vector<glm::vec3> m_boundsMin;
+    std::vector<glm::vec3> m_boundsMax;
+
+    std::future<BuildResult> m_rebuild;
+};
@@ -1,10 +1,10 @@
 #pragma once
 
 #include <ituGL/scene/Bounds.h>
+#include <ituGL/scene/Scene.h>
 #include <string>
 #include <memory>
 
-class Scene;
 class SceneVisitor;
 class Transform;
 
@@ -19,6 +19,9 @@ public:
     const std::string& GetName() const;
     void Rename(const std::string& name);
 
+    // Entity of the node in its owner scene, InvalidEntity if it is not in a scene
+    inline Scene::EntityId GetEntity() const { return m_entity; }
+
     std::shared_ptr<Transform> GetTransform();
     std::shared_ptr<const Transform> GetTransform() const;
     void SetTransform(std::shared_ptr<Transform> transform);
@@ -30,13 +33,14 @@ public:
     virtual void AcceptVisitor(SceneVisitor& visitor);
     virtual void AcceptVisitor(SceneVisitor& visitor) const;
 
-private:
+protected:
     friend class Scene;
 
     Scene* GetOwnerScene() const;
-    void SetOwnerScene(Scene* scene);
+    void SetOwnerScene(Scene* scene, Scene::EntityId entity);
 
     Scene* m_scene;
+    Scene::EntityId m_entity;
 
 protected:
     std::string m_name;
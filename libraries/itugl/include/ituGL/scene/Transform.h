@@ -10,25 +10,31 @@ public:
     Transform();
 
     inline glm::vec3 GetTranslation() const { return m_translation; }
-    inline void SetTranslation(const glm::vec3& translation) { m_translation = translation; m_dirty = true; }
+    inline void SetTranslation(const glm::vec3& translation) { m_translation = translation; m_dirty = true; ++m_version; }
 
     inline glm::vec3 GetRotation() const { return m_rotation; }
-    inline void SetRotation(const glm::vec3& rotation) { m_rotation = rotation; m_dirty = true; }
+    inline void SetRotation(const glm::vec3& rotation) { m_rotation = rotation; m_dirty = true; ++m_version; }
 
     inline glm::vec3 GetScale() const { return m_scale; }
-    inline void SetScale(const glm::vec3& scale) { m_scale = scale; m_dirty = true; }
+    inline void SetScale(const glm::vec3& scale) { m_scale = scale; m_dirty = true; ++m_version; }
 
     inline std::shared_ptr<Transform> GetParent() const { return m_parent; }
-    inline void SetParent(std::shared_ptr<Transform> parent) { m_parent = parent; m_dirty = true; }
+    inline void SetParent(std::shared_ptr<Transform> parent) { m_parent = parent; m_dirty = true; ++m_version; }
 
     glm::mat4 GetTranslationMatrix() const;
     glm::mat4 GetRotationMatrix() const;
     glm::mat4 GetScaleMatrix() const;
 
+    // Translation, rotation and scale combined, without the parent
+    glm::mat4 GetLocalMatrix() const;
+
     glm::mat4 GetTransformMatrix() const;
 
     bool IsDirty() const;
 
+    // Incremented each time the transform or its parent is set. Used to find the transforms that changed since they were last read
+    inline unsigned int GetVersion() const { return m_version; }
+
 private:
     glm::vec3 m_translation;
     glm::vec3 m_rotation;
@@ -39,4 +45,6 @@ private:
     // Cached matrix
     mutable glm::mat4 m_matrix;
     mutable bool m_dirty;
+
+    unsigned int m_version;
 };
@@ -45,6 +45,17 @@ public:
     void SetShaderSetupFunction(ShaderSetupFunction shaderSetupFunction);
 
 
+    // If the material has a shader program and can be used. Otherwise, its placeholder is used instead
+    bool IsReady() const;
+
+    // Material used while this one has no shader program, for example while the program is built in the background
+    std::shared_ptr<const Material> GetPlaceholder() const;
+    void SetPlaceholder(std::shared_ptr<const Material> placeholder);
+
+    // Get the material that Use sets: this one if it is ready, otherwise the placeholder
+    const Material& GetUsedMaterial() const;
+
+
     // The test function for the depth test, if depth test is enabled
     TestFunction GetDepthTestFunction() const;
     void SetDepthTestFunction(TestFunction function);
@@ -126,7 +137,16 @@ public:
     // You can skip depth, stencil or blending using the override flags
     void Use(OverrideFlags overrideFlags = OverrideFlags::NoOverride) const;
 
+    // Check if the material can be used after the other one keeping the same shader program and textures
+    bool IsBatchCompatible(const Material& other) const;
+
+    // Use the material after a batch compatible one. Only data uniforms and render states are set
+    void UseBatched(OverrideFlags overrideFlags = OverrideFlags::NoOverride) const;
+
 private:
+    // Run the shader setup function and set the render states that are not skipped
+    void UseStates(OverrideFlags overrideFlags) const;
+
     // Set all the properties relative to depth
     void UseDepthTest() const;
 
@@ -140,6 +160,9 @@ private:
     // Function pointer to prepare the shader used by the material
     ShaderSetupFunction m_shaderSetupFunction;
 
+    // Material used until this one has a shader program
+    std::shared_ptr<const Material> m_placeholder;
+
     // Test function for depth. Default: Less
     TestFunction m_depthTestFunction;
 
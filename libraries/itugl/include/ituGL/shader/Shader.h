@@ -47,9 +47,15 @@ public:
     // Compile the shader source code
     bool Compile();
 
+    // Start compiling the shader source code, without waiting for the result
+    void BeginCompile();
+
     // Check if the shader has been successfully compiled
     bool IsCompiled() const;
 
+    // Check if the compilation has finished, without blocking. Requires GL_KHR_parallel_shader_compile
+    bool IsCompilationComplete() const;
+
     // Get compilation error messages in case of a failure
     void GetCompilationErrors(std::span<char> errors) const;
 };
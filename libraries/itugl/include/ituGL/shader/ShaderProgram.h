@@ -17,6 +17,7 @@
 #include <glm/mat4x4.hpp>
 
 #include <span>
+#include <vector>
 
 class Shader;
 class TextureObject;
@@ -71,9 +72,28 @@ public:
         return Build(vertexShader, fragmentShader, tesselationControlShader, &tesselationEvaluationShader, &geometryShader);
     }
 
+    // Attach the shaders and start linking, without waiting for the compilation or linking to finish
+    void BeginBuild(const Shader& vertexShader, const Shader& fragmentShader);
+
     // Check if shaders have been linked to create a valid program
     bool IsLinked() const;
 
+    // Check if the linking has finished, without blocking. Requires GL_KHR_parallel_shader_compile
+    bool IsLinkingComplete() const;
+
+    // Hint the driver that the binary will be retrieved after linking. Call before building the program
+    void SetBinaryRetrievable(bool retrievable);
+
+    // Outputs of the last vertex stage captured with transform feedback, interleaved in one buffer. Call before building the program
+    void SetTransformFeedbackVaryings(std::span<const char* const> varyings);
+
+    // Get the driver specific binary of a linked program, so it can be stored and loaded with LoadBinary
+    bool GetBinary(GLenum& binaryFormat, std::vector<GLubyte>& binary) const;
+
+    // Load a binary previously obtained with GetBinary, instead of building the program
+    // Returns false if the driver rejects the binary (for example, after a driver update)
+    bool LoadBinary(GLenum binaryFormat, std::span<const GLubyte> binary);
+
     // Get a string with linking error messages
     // The max length of the string returned is determined by the capacity of the span
     void GetLinkingErrors(std::span<char> errors) const;
@@ -8,6 +8,7 @@
 #include <unordered_set>
 #include <string>
 #include <cstring>
+#include <string_view>
 #include <memory>
 
 class ShaderUniformCollection
@@ -16,6 +17,9 @@ public:
     // Alias for a set of names
     using NameSet = std::unordered_set<std::string>;
 
+    // Identifier of a uniform, built from the hash of its name. Can be computed at compile time
+    class UniformId;
+
 public:
     ShaderUniformCollection();
     // Initialize with the shader program, will extract all the properties. Skip the names in filtered uniforms
@@ -31,8 +35,12 @@ public:
     // Get the vertex attribute location by name
     ShaderProgram::Location GetAttributeLocation(const char* name) const;
 
-    // Get the shader uniform location by name
-    ShaderProgram::Location GetUniformLocation(const char* name) const;
+    // Get the shader uniform location by name. Uniforms in the collection are found without querying OpenGL
+    inline ShaderProgram::Location GetUniformLocation(const char* name) const;
+
+    // Get the shader uniform location by id. Resolve it once and use the location to set values quickly
+    // Names that are not in the collection, like filtered uniforms or array elements, are queried to OpenGL
+    ShaderProgram::Location GetUniformLocation(UniformId id) const;
 
     // Get uniform value for different types, using the name or the uniform location
     template<typename T>
@@ -50,16 +58,20 @@ public:
     template<typename T>
     void GetUniformValues(ShaderProgram::Location location, std::span<T> value) const;
 
-    // Set uniform value for different types, using the name or the uniform location
+    // Set uniform value for different types, using the name, the id or the uniform location
     template<typename T>
     void SetUniformValue(const char* name, const T& value);
     template<typename T>
+    void SetUniformValue(UniformId id, const T& value);
+    template<typename T>
     void SetUniformValue(ShaderProgram::Location location, const T& value);
     template<typename T>
     void SetUniformValue(ShaderProgram::Location location, const std::shared_ptr<T>& value);
     template<typename T>
     void SetUniformValues(const char* name, std::span<const T> value);
     template<typename T>
+    void SetUniformValues(UniformId id, std::span<const T> value);
+    template<typename T>
     void SetUniformValues(ShaderProgram::Location location, std::span<const T> value);
 
     // Get the pointer to the uniform data
@@ -68,9 +80,20 @@ public:
     template<typename T>
     T* GetDataUniformPointer(ShaderProgram::Location location);
 
+    // Get all the textures set in the collection
+    void GetTextures(std::vector<std::shared_ptr<const TextureObject>>& textures) const;
+
+    // Compare the textures with another collection of the same shader program, in uniform order
+    // Returns 0 if they are the same, and a negative or positive value to sort them otherwise
+    // Collections with different texture uniforms, because of their filtered uniforms, are never the same
+    int CompareTextures(const ShaderUniformCollection& other) const;
+
     // Set all the properties to the shader. Requires the shader program to be in use
     void SetUniforms() const;
 
+    // Set only the data properties, keeping the textures bound by a collection with the same textures
+    void SetDataUniforms() const;
+
 private:
     // Different dimensions of the properties
     enum class UniformDimension
@@ -110,6 +133,14 @@ private:
         std::shared_ptr<const TextureObject> texture;
     };
 
+    // Name of a uniform in the collection, with the hash of its id
+    struct UniformName
+    {
+        unsigned int hash;
+        ShaderProgram::Location location;
+        std::string name;
+    };
+
 private:
     // Get a data uniform
     DataUniform& GetDataUniform(ShaderProgram::Location location);
@@ -119,6 +150,9 @@ private:
     TextureUniform& GetTextureUniform(ShaderProgram::Location location);
     const TextureUniform& GetTextureUniform(ShaderProgram::Location location) const;
 
+    // Register the uniform name so it can be found by id later
+    void AddUniformId(const char* name, ShaderProgram::Location location);
+
     // Read all the uniforms in the shader and store them as properties
     // Can skip by name those in the filteredUniforms
     void ExtractUniforms(const NameSet& filteredUniforms = NameSet());
@@ -185,10 +219,13 @@ private:
     // The list of texture properties
     std::vector<TextureUniform> m_textureUniforms;
 
-    // Map to find data properties in the data list
-    std::unordered_map<ShaderProgram::Location, int> m_locationDataIndex;
-    // Map to find texture properties in the texture list
-    std::unordered_map<ShaderProgram::Location, int> m_locationTextureIndex;
+    // Tables indexed by location to find data properties in the data list. -1 if not present
+    std::vector<int> m_locationDataIndex;
+    // Tables indexed by location to find texture properties in the texture list. -1 if not present
+    std::vector<int> m_locationTextureIndex;
+
+    // List of uniform names and their locations, sorted by hash. Names with the same hash are next to each other
+    std::vector<UniformName> m_uniformNames;
 
     // Buffers that store the values for data properties
     std::vector<int> m_intDataValues;
@@ -197,6 +234,39 @@ private:
     std::vector<double> m_doubleDataValues;
 };
 
+class ShaderUniformCollection::UniformId
+{
+public:
+    // The id keeps the name to tell apart names with the same hash, so the name must outlive it, like a string literal
+    constexpr explicit UniformId(const char* name) : m_hash(Hash(name)), m_name(name) {}
+
+    constexpr unsigned int GetHash() const { return m_hash; }
+    constexpr const char* GetName() const { return m_name; }
+
+    constexpr bool operator == (const UniformId& other) const { return m_hash == other.m_hash && std::string_view(m_name) == other.m_name; }
+    constexpr bool operator != (const UniformId& other) const { return !(*this == other); }
+
+private:
+    // 32-bit FNV-1a hash of the string
+    static constexpr unsigned int Hash(const char* name)
+    {
+        unsigned int hash = 2166136261u;
+        for (; *name; ++name)
+        {
+            hash = (hash ^ static_cast<unsigned char>(*name)) * 16777619u;
+        }
+        return hash;
+    }
+
+private:
+    unsigned int m_hash;
+    const char* m_name;
+};
+
+inline ShaderProgram::Location ShaderUniformCollection::GetUniformLocation(const char* name) const
+{
+    return GetUniformLocation(UniformId(name));
+}
 
 template<typename T>
 inline T ShaderUniformCollection::GetUniformValue(const char* name) const
@@ -259,7 +329,13 @@ void ShaderUniformCollection::GetUniformValues(ShaderProgram::Location location,
 template<typename T>
 inline void ShaderUniformCollection::SetUniformValue(const char* name, const T& value)
 {
-    ShaderProgram::Location location = GetUniformLocation(name);
+    SetUniformValue(UniformId(name), value);
+}
+
+template<typename T>
+inline void ShaderUniformCollection::SetUniformValue(UniformId id, const T& value)
+{
+    ShaderProgram::Location location = GetUniformLocation(id);
     //assert(location >= 0);
     if (location >= 0) // Replaced assert with silent skip
     {
@@ -286,7 +362,13 @@ void ShaderUniformCollection::SetUniformValue(ShaderProgram::Location location,
 template<typename T>
 inline void ShaderUniformCollection::SetUniformValues(const char* name, std::span<const T> values)
 {
-    ShaderProgram::Location location = GetUniformLocation(name);
+    SetUniformValues(UniformId(name), values);
+}
+
+template<typename T>
+inline void ShaderUniformCollection::SetUniformValues(UniformId id, std::span<const T> values)
+{
+    ShaderProgram::Location location = GetUniformLocation(id);
     assert(location >= 0);
     SetUniformValues(location, values);
 }
@@ -388,7 +470,12 @@ T* ShaderUniformCollection::GetDataUniformPointer(ShaderProgram::Location locati
 template<typename T>
 void ShaderUniformCollection::AddUniform(const DataUniform& uniform)
 {
-    m_locationDataIndex.insert(std::make_pair(uniform.location, static_cast<int>(m_dataUniforms.size())));
+    assert(uniform.location >= 0);
+    if (uniform.location >= static_cast<int>(m_locationDataIndex.size()))
+    {
+        m_locationDataIndex.resize(uniform.location + 1, -1);
+    }
+    m_locationDataIndex[uniform.location] = static_cast<int>(m_dataUniforms.size());
     m_dataUniforms.push_back(uniform);
 
     std::vector<T>& values = GetDataValues<T>();
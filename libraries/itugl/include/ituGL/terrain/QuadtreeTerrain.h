@@ -0,0 +1,133 @@
+#pragma once
+
+#include <ituGL/geometry/Mesh.h>
+#include <ituGL/geometry/VertexBufferObject.h>
+#include <ituGL/scene/FrustumCulling.h>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/mat4x4.hpp>
+#include <vector>
+#include <array>
+#include <memory>
+#include <span>
+
+class Texture2DObject;
+class Material;
+
+// Terrain drawn with a quadtree of nodes, with more detail close to the camera (CDLOD)
+// All the nodes draw the same grid mesh, instanced, and the vertex shader moves it to the node and reads the height from a
+// single heightmap. Nodes are picked by their distance to the camera, so the number of vertices drawn doesn't depend on
+// the size of the terrain. Close to the distance where the detail changes, the vertices morph to the coarser grid,
+// so there are no cracks or pops between levels
+//
+// The vertex shader gets the grid position in [0, 1] at location 0 and, per instance:
+// - s_nodeLocation (vec4): corner of the node in XZ, its size, and the quads on each side of its grid
+// - s_morphLocation (vec2): distances where the morph starts and ends
+// And the uniforms set by SetMaterialUniforms: Heightmap, HeightmapSize, TerrainOrigin, TerrainSize, HeightScale, CameraPosition
+class QuadtreeTerrain
+{
+public:
+    QuadtreeTerrain();
+
+    // Build the terrain from a heightmap of width x height samples, covering a square of side size in XZ from origin (the minimum corner)
+    // World heights are origin.y + height * heightScale. The quadtree has lodCount levels, the leaves are the most detailed
+    void Initialize(std::span<const float> heights, unsigned int width, unsigned int height,
+        const glm::vec3& origin, float size, float heightScale, unsigned int lodCount);
+
+    inline unsigned int GetLodCount() const { return m_lodCount; }
+    inline std::shared_ptr<Texture2DObject> GetHeightmap() const { return m_heightmap; }
+
+    // Distance where each level stops being used, as a multiple of the size of its nodes
+    // Lower values drop the detail closer to the camera. The default leaves room for the morph between levels
+    inline float GetLodDistanceFactor() const { return m_lodDistanceFactor; }
+    void SetLodDistanceFactor(float lodDistanceFactor) { m_lodDistanceFactor = lodDistanceFactor; }
+
+    // World height at the XZ position, interpolated like the shader does. Positions outside are clamped to the border
+    float GetHeight(const glm::vec2& position) const;
+
+    // Set the heightmap and the terrain uniforms that the vertex shader needs
+    // Call it after SelectNodes, the morph uses the camera position of the selection
+    void SetMaterialUniforms(Material& material) const;
+
+    // Pick the nodes to draw for a camera, skipping the ones outside the frustum
+    void SelectNodes(const glm::vec3& cameraPosition, const glm::mat4& viewProjMatrix);
+
+    // Nodes picked by the last SelectNodes
+    inline unsigned int GetNodeCount() const { return static_cast<unsigned int>(m_nodes[0].size() + m_nodes[1].size()); }
+
+    // Draw all the selected nodes, with the shader program of the material in use
+    void Draw() const;
+
+    // Quads on each side of the grid of a node
+    static constexpr unsigned int s_gridSize = 32;
+
+    // Fraction of the distance range of a level where the morph to the next level starts
+    static constexpr float s_morphStart = 0.7f;
+
+    static constexpr GLuint s_nodeLocation = 3;
+    static constexpr GLuint s_morphLocation = 4;
+
+private:
+    struct Node
+    {
+        glm::vec4 cornerSizeGrid;
+        glm::vec2 morphRange;
+    };
+
+    // Nodes are drawn whole, or only one quadrant when the rest is covered by its children
+    // Quadrants use a grid with half the quads, to keep the vertex spacing of their level
+    enum NodeType
+    {
+        WholeNode,
+        QuadrantNode,
+        NodeTypeCount
+    };
+
+    void CreateGridMesh(Mesh& mesh, VertexBufferObject& nodeVBO, unsigned int gridSize);
+
+    // Min and max height of each node of each level, from the samples that the node covers
+    void ComputeNodeHeights(std::span<const float> heights);
+
+    // Add the node, or its children, if it is visible
+    void SelectNode(unsigned int lod, unsigned int x, unsigned int y);
+
+    // Add the area of a node to draw it with the detail of a level
+    void AddNode(NodeType type, unsigned int lod, unsigned int x, unsigned int y, unsigned int drawLod);
+
+    // Nodes on each side of a level, and their size in XZ
+    inline unsigned int GetNodesPerSide(unsigned int lod) const { return 1u << (m_lodCount - 1 - lod); }
+    inline float GetNodeSize(unsigned int lod) const { return m_size / static_cast<float>(GetNodesPerSide(lod)); }
+
+    // Bounding box of the node in world space
+    void GetNodeBox(unsigned int lod, unsigned int x, unsigned int y, glm::vec3& minPosition, glm::vec3& maxPosition) const;
+
+    bool IsNodeVisible(const glm::vec3& minPosition, const glm::vec3& maxPosition) const;
+    bool IsNodeInRange(const glm::vec3& minPosition, const glm::vec3& maxPosition, float distance) const;
+
+private:
+    glm::vec3 m_origin;
+    float m_size;
+    float m_heightScale;
+    unsigned int m_lodCount;
+    float m_lodDistanceFactor;
+
+    // Copy of the heights, to compute the bounds and to query them
+    std::vector<float> m_heights;
+    glm::uvec2 m_heightmapSize;
+    std::shared_ptr<Texture2DObject> m_heightmap;
+
+    // Min and max height of each node, by level and then by row
+    std::vector<std::vector<glm::vec2>> m_nodeHeights;
+
+    // Distance where each level stops being used
+    std::vector<float> m_lodDistances;
+
+    // Grid shared by all the nodes of each type, and the per-instance data of the selected ones
+    std::array<Mesh, NodeTypeCount> m_gridMeshes;
+    std::array<VertexBufferObject, NodeTypeCount> m_nodeVBOs;
+    std::array<std::vector<Node>, NodeTypeCount> m_nodes;
+
+    // Selection state
+    glm::vec3 m_cameraPosition;
+    FrustumCulling::Planes m_frustumPlanes;
+};
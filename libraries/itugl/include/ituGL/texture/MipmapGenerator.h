@@ -0,0 +1,122 @@
+#pragma once
+
+#include <ituGL/core/Data.h>
+#include <ituGL/texture/TextureObject.h>
+#include <vector>
+#include <array>
+#include <span>
+
+// Generates the mip chain of images on the CPU, so it can run outside the GL thread
+// Filtering happens in linear space with floating point precision, and the result is converted back to the original data type
+class MipmapGenerator
+{
+public:
+    // Filter used to compute each level from the previous one
+    enum class Filter;
+
+    // One level of the mip chain, with the pixels in the same data type and number of components as the source
+    struct Level
+    {
+        GLsizei width;
+        GLsizei height;
+        std::vector<std::byte> data;
+    };
+
+public:
+    MipmapGenerator();
+
+    inline Filter GetFilter() const { return m_filter; }
+    inline void SetFilter(Filter filter) { m_filter = filter; }
+
+    // If true, the RGB components are sRGB encoded and filtered in linear space. Only for UByte data
+    inline bool GetSRGB() const { return m_srgb; }
+    inline void SetSRGB(bool srgb) { m_srgb = srgb; }
+
+    // If true, the RGB components are normals in [0, 1] and they are renormalized after filtering
+    inline bool GetNormalMap() const { return m_normalMap; }
+    inline void SetNormalMap(bool normalMap) { m_normalMap = normalMap; }
+
+    // Alpha test reference value. If greater than 0, alpha is scaled in each level to keep the same coverage as level 0
+    inline float GetAlphaCoverageReference() const { return m_alphaCoverageReference; }
+    inline void SetAlphaCoverageReference(float alphaCoverageReference) { m_alphaCoverageReference = alphaCoverageReference; }
+
+    // If true, the filter wraps around the borders of 2D images, otherwise it clamps
+    inline bool GetWrap() const { return m_wrap; }
+    inline void SetWrap(bool wrap) { m_wrap = wrap; }
+
+    inline unsigned int GetThreadCount() const { return m_threadCount; }
+    inline void SetThreadCount(unsigned int threadCount) { m_threadCount = threadCount; }
+
+    // Configure sRGB for the internal format of the texture
+    void SetInternalFormat(TextureObject::InternalFormat internalFormat);
+
+    // Generate all the levels of a 2D image, down to 1x1. Level 0 is a copy of the source
+    // Levels before firstLevel are not generated: the source is filtered directly to the size of firstLevel, that is the first level returned
+    std::vector<Level> Generate(std::span<const std::byte> data, GLsizei width, GLsizei height, int componentCount, Data::Type dataType,
+        int firstLevel = 0) const;
+
+    // Generate all the levels of the 6 faces of a cubemap. The filter reads across the edges into the neighbour faces
+    // Faces are in GL order: +X, -X, +Y, -Y, +Z, -Z
+    std::array<std::vector<Level>, 6> GenerateCubemap(const std::array<std::span<const std::byte>, 6>& faces, GLsizei side, int componentCount, Data::Type dataType) const;
+
+    // Number of levels of a full mip chain
+    static int GetLevelCount(GLsizei width, GLsizei height);
+
+private:
+    // Image with 4 float components per pixel, in linear space
+    struct Image
+    {
+        GLsizei width;
+        GLsizei height;
+        std::vector<float> pixels;
+    };
+
+    // Weights of the source pixels for each destination pixel, along one axis
+    struct FilterTaps
+    {
+        int tapCount;
+        std::vector<int> firstIndices;
+        std::vector<float> weights;
+    };
+
+private:
+    // Convert the source data to a linear float image
+    Image ConvertToImage(std::span<const std::byte> data, GLsizei width, GLsizei height, int componentCount, Data::Type dataType) const;
+
+    // Convert the linear float image back to the source data type, scaling alpha
+    Level ConvertToLevel(const Image& image, float alphaScale, int componentCount, Data::Type dataType) const;
+
+    // Compute the taps to resize one axis from sourceSize to destinationSize
+    FilterTaps ComputeTaps(int sourceSize, int destinationSize) const;
+
+    // Filter the image to a smaller size, with separable passes
+    Image Resize(const Image& image, GLsizei width, GLsizei height) const;
+
+    // Filter the 6 faces of a cubemap to half their size, fetching from the neighbour faces on the borders
+    std::array<Image, 6> DownsampleCubemap(const std::array<Image, 6>& faces) const;
+
+    // Apply the corrections that happen after filtering
+    void PostProcess(Image& image) const;
+
+    // Find the alpha scale that gives the same coverage as level 0. The image is not modified, so errors don't accumulate
+    float ComputeAlphaScale(const Image& image, float alphaCoverage) const;
+
+    // Fraction of pixels with alpha above the reference, after scaling alpha
+    float ComputeAlphaCoverage(const Image& image, float alphaScale) const;
+
+private:
+    Filter m_filter;
+    bool m_srgb;
+    bool m_normalMap;
+    float m_alphaCoverageReference;
+    bool m_wrap;
+    unsigned int m_threadCount;
+};
+
+enum class MipmapGenerator::Filter
+{
+    // Average of the 2x2 pixels. Fast, but a bit blurry and prone to aliasing
+    Box,
+    // Windowed sinc, keeps more detail without ringing
+    Kaiser,
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <ituGL/texture/TextureObject.h>
+#include <ituGL/core/Data.h>
+
+// Array of 2D textures with the same size and format. Each layer is sampled with its index as the third coordinate
+class Texture2DArrayObject : public TextureObjectBase<TextureObject::Texture2DArray>
+{
+public:
+    Texture2DArrayObject();
+
+    // Initialize all the layers of a level with a specific format
+    void SetImage(GLint level,
+        GLsizei width, GLsizei height, GLsizei layerCount,
+        Format format, InternalFormat internalFormat);
+
+    // Allocate all the levels of all the layers at once, with immutable storage when supported. Format is only used by the fallback
+    void SetStorage(GLsizei levelCount,
+        GLsizei width, GLsizei height, GLsizei layerCount,
+        Format format, InternalFormat internalFormat);
+
+    // Replace the whole image of a level of one layer, after the storage has been allocated
+    void SetSubImage(GLint level, GLint layer,
+        GLsizei width, GLsizei height,
+        Format format, std::span<const std::byte> data, Data::Type type);
+
+    // Get the maximum number of layers supported by the context
+    static GLsizei GetMaxLayerCount();
+};
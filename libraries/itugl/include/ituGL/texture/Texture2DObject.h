@@ -20,6 +20,24 @@ public:
         GLsizei width, GLsizei height,
         Format format, InternalFormat internalFormat,
         std::span<const T> data, Data::Type type = Data::Type::None);
+
+    // Initialize the texture2D with block compressed data. The data must contain the whole image of the level
+    void SetCompressedImage(GLint level,
+        GLsizei width, GLsizei height,
+        InternalFormat internalFormat, std::span<const std::byte> data);
+
+    // Free the memory of a level of a texture with mutable storage, redefining it with size 0
+    void ReleaseImage(GLint level, Format format, InternalFormat internalFormat);
+
+    // Allocate all the levels at once, with immutable storage when supported. Format is only used by the fallback
+    void SetStorage(GLsizei levelCount,
+        GLsizei width, GLsizei height,
+        Format format, InternalFormat internalFormat);
+
+    // Replace a region of a level, after the storage has been allocated
+    void SetSubImage(GLint level,
+        GLint x, GLint y, GLsizei width, GLsizei height,
+        Format format, std::span<const std::byte> data, Data::Type type);
 };
 
 // Set image with data in bytes
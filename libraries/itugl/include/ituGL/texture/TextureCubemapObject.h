@@ -28,6 +28,13 @@ public:
     void SetImage(GLint level, Face face, GLsizei side,
         Format format, InternalFormat internalFormat,
         std::span<const T> data, Data::Type type = Data::Type::None);
+
+    // Allocate all the levels of the 6 faces at once, with immutable storage when supported. Format is only used by the fallback
+    void SetStorage(GLsizei levelCount, GLsizei side, Format format, InternalFormat internalFormat);
+
+    // Replace the whole image of a level of one face, after the storage has been allocated
+    void SetSubImage(GLint level, Face face, GLsizei side,
+        Format format, std::span<const std::byte> data, Data::Type type);
 };
 
 // Set image with data in bytes
@@ -3,6 +3,16 @@
 #include <ituGL/core/Object.h>
 #include <span>
 
+// S3TC formats come from EXT_texture_compression_s3tc, supported by all desktop drivers
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
 // Abstract OpenGL object that encapsulates a Texture
 // There are different subtypes depending on the target
 class TextureObject : public Object
@@ -75,6 +85,23 @@ public:
     // Get number of components of the data type of the texture (packed components count as 1)
     static int GetDataComponentCount(InternalFormat internalFormat);
 
+    // Check if the internal format is stored in 4x4 blocks (BC1-BC7)
+    static bool IsBlockCompressed(InternalFormat internalFormat);
+
+    // Get the size in bytes of a 4x4 block of a block compressed format
+    static int GetBlockSize(InternalFormat internalFormat);
+
+    // Get the size in bytes of an image of a block compressed format
+    static size_t GetCompressedImageSize(InternalFormat internalFormat, GLsizei width, GLsizei height);
+
+    // Check if the context can allocate immutable storage for all the levels at once (glTexStorage, GL 4.2)
+    static bool IsImmutableStorageSupported();
+
+    // Get the sized format to use for immutable storage, which doesn't accept unsized formats
+    // Unsized formats get 8 bits per component, like most drivers do with mutable storage
+    // Returns InternalFormatInvalid for the generic compressed formats, they only work with mutable storage
+    static InternalFormat GetSizedInternalFormat(InternalFormat internalFormat);
+
     // Set active texture unit
     static void SetActiveTexture(GLint textureUnit);
 
@@ -229,6 +256,15 @@ enum TextureObject::InternalFormat : GLint
     InternalFormatRGBACompressed = GL_COMPRESSED_RGBA,
     InternalFormatSRGBCompressed = GL_COMPRESSED_SRGB,
     InternalFormatSRGBACompressed = GL_COMPRESSED_SRGB_ALPHA,
+    // Block compressed
+    InternalFormatBC1 = GL_COMPRESSED_RGB_S3TC_DXT1_EXT,
+    InternalFormatBC1SRGB = GL_COMPRESSED_SRGB_S3TC_DXT1_EXT,
+    InternalFormatBC3 = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT,
+    InternalFormatBC3SRGB = GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT,
+    InternalFormatBC4 = GL_COMPRESSED_RED_RGTC1,
+    InternalFormatBC5 = GL_COMPRESSED_RG_RGTC2,
+    InternalFormatBC7 = GL_COMPRESSED_RGBA_BPTC_UNORM,
+    InternalFormatBC7SRGB = GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM,
     // Depth Stencil
     InternalFormatDepth = GL_DEPTH_COMPONENT,
     InternalFormatDepth16 = GL_DEPTH_COMPONENT16,
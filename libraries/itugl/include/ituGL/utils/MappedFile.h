@@ -0,0 +1,39 @@
+#pragma once
+
+#include <span>
+#include <cstddef>
+
+// Read-only view of a file mapped in memory. The pages are loaded by the OS when they are accessed,
+// so the contents can be used directly without reading them into an intermediate buffer
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    // Not copyable, it owns the mapping
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator = (const MappedFile&) = delete;
+
+    // Map the whole file. Returns false if the file could not be opened or is empty
+    bool Open(const char* path);
+
+    // Unmap the file. Spans returned by GetData become invalid
+    void Close();
+
+    inline bool IsOpen() const { return m_data != nullptr; }
+
+    // Get the contents of the file
+    inline std::span<const std::byte> GetData() const { return std::span<const std::byte>(m_data, m_size); }
+
+private:
+    // Address of the mapped contents
+    const std::byte* m_data;
+    // Size of the file in bytes
+    size_t m_size;
+
+#ifdef _WIN32
+    // Handle to the mapping object
+    void* m_mappingHandle;
+#endif
+};
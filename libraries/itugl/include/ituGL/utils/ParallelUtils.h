@@ -0,0 +1,48 @@
+#pragma once
+
+#include <thread>
+#include <type_traits>
+#include <algorithm>
+
+// Helpers to split CPU work between threads
+// The work runs on a pool of worker threads that is created on first use and kept until the program exits,
+// so it can be used every frame without creating threads each time
+class ParallelUtils
+{
+public:
+    // Number of threads used when none is specified
+    static unsigned int GetDefaultThreadCount() { return std::max(std::thread::hardware_concurrency(), 1u); }
+
+    // Call function(index) for each index in [0, count). Each thread takes the next index until all of them are done
+    // The calling thread also takes part, and the call returns when all the indices are processed
+    // Calls made from inside another For run in the calling thread only
+    template<typename TFunction>
+    static void For(unsigned int count, TFunction&& function, unsigned int threadCount = GetDefaultThreadCount());
+
+private:
+    // Function called for each index, with the context that holds the actual function
+    using IndexFunction = void(*)(void* context, unsigned int index);
+
+    // Run the indices in the worker pool. If another thread is using the pool, temporary threads are created instead
+    static void Run(unsigned int count, IndexFunction function, void* context, unsigned int threadCount);
+};
+
+template<typename TFunction>
+void ParallelUtils::For(unsigned int count, TFunction&& function, unsigned int threadCount)
+{
+    // No need for more threads than indices
+    threadCount = std::clamp(threadCount, 1u, std::max(count, 1u));
+    if (threadCount == 1)
+    {
+        for (unsigned int index = 0; index < count; ++index)
+        {
+            function(index);
+        }
+        return;
+    }
+
+    // The pool is not a template, it only gets a pointer to the function
+    using Function = std::remove_reference_t<TFunction>;
+    IndexFunction indexFunction = [](void* context, unsigned int index) { (*static_cast<Function*>(context))(index); };
+    Run(count, indexFunction, const_cast<void*>(static_cast<const void*>(&function)), threadCount);
+}
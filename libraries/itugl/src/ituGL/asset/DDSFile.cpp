@@ -0,0 +1,297 @@
+#include <ituGL/asset/DDSFile.h>
+
+#include <fstream>
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <climits>
+#include <cassert>
+
+// Layout of the DDS headers, as documented for Direct3D
+struct DDSPixelFormat
+{
+    unsigned int size;
+    unsigned int flags;
+    unsigned int fourCC;
+    unsigned int rgbBitCount;
+    unsigned int bitMasks[4];
+};
+
+struct DDSHeader
+{
+    unsigned int size;
+    unsigned int flags;
+    unsigned int height;
+    unsigned int width;
+    unsigned int pitchOrLinearSize;
+    unsigned int depth;
+    unsigned int mipMapCount;
+    unsigned int reserved1[11];
+    DDSPixelFormat pixelFormat;
+    unsigned int caps[4];
+    unsigned int reserved2;
+};
+
+struct DDSHeaderDX10
+{
+    unsigned int dxgiFormat;
+    unsigned int resourceDimension;
+    unsigned int miscFlag;
+    unsigned int arraySize;
+    unsigned int miscFlags2;
+};
+
+static_assert(sizeof(DDSHeader) == 124 && sizeof(DDSPixelFormat) == 32 && sizeof(DDSHeaderDX10) == 20);
+
+static constexpr unsigned int MakeFourCC(const char fourCC[5])
+{
+    return static_cast<unsigned int>(fourCC[0]) | (static_cast<unsigned int>(fourCC[1]) << 8)
+        | (static_cast<unsigned int>(fourCC[2]) << 16) | (static_cast<unsigned int>(fourCC[3]) << 24);
+}
+
+static const unsigned int s_ddsMagic = MakeFourCC("DDS ");
+
+// Flags of the header
+static const unsigned int s_ddsFlagsCaps = 0x1;
+static const unsigned int s_ddsFlagsHeight = 0x2;
+static const unsigned int s_ddsFlagsWidth = 0x4;
+static const unsigned int s_ddsFlagsPixelFormat = 0x1000;
+static const unsigned int s_ddsFlagsMipMapCount = 0x20000;
+static const unsigned int s_ddsFlagsLinearSize = 0x80000;
+static const unsigned int s_ddsPixelFormatFourCC = 0x4;
+static const unsigned int s_ddsCapsComplex = 0x8;
+static const unsigned int s_ddsCapsTexture = 0x1000;
+static const unsigned int s_ddsCapsMipMap = 0x400000;
+static const unsigned int s_ddsDimensionTexture2D = 3;
+
+// Larger than the maximum texture size of any GL implementation
+static const unsigned int s_ddsMaxSize = 1u << 16;
+
+DDSFile::DDSFile() : m_width(0), m_height(0), m_internalFormat(TextureObject::InternalFormatInvalid), m_firstLevel(0)
+{
+}
+
+bool DDSFile::Load(const char* path, int firstLevel)
+{
+    Reset(0, 0, TextureObject::InternalFormatInvalid);
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    unsigned int magic;
+    DDSHeader header;
+    if (!file.read(reinterpret_cast<char*>(&magic), sizeof(magic)) || magic != s_ddsMagic ||
+        !file.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.size != sizeof(DDSHeader))
+    {
+        return false;
+    }
+
+    // Find the format, in the legacy FourCC or in the extended header
+    TextureObject::InternalFormat internalFormat = TextureObject::InternalFormatInvalid;
+    if (header.pixelFormat.flags & s_ddsPixelFormatFourCC)
+    {
+        unsigned int fourCC = header.pixelFormat.fourCC;
+        if (fourCC == MakeFourCC("DX10"))
+        {
+            DDSHeaderDX10 headerDX10;
+            if (!file.read(reinterpret_cast<char*>(&headerDX10), sizeof(headerDX10)) ||
+                headerDX10.resourceDimension != s_ddsDimensionTexture2D || headerDX10.arraySize > 1)
+            {
+                return false;
+            }
+            internalFormat = GetInternalFormat(headerDX10.dxgiFormat);
+        }
+        else if (fourCC == MakeFourCC("DXT1"))
+        {
+            internalFormat = TextureObject::InternalFormatBC1;
+        }
+        else if (fourCC == MakeFourCC("DXT5"))
+        {
+            internalFormat = TextureObject::InternalFormatBC3;
+        }
+        else if (fourCC == MakeFourCC("ATI1") || fourCC == MakeFourCC("BC4U"))
+        {
+            internalFormat = TextureObject::InternalFormatBC4;
+        }
+        else if (fourCC == MakeFourCC("ATI2") || fourCC == MakeFourCC("BC5U"))
+        {
+            internalFormat = TextureObject::InternalFormatBC5;
+        }
+    }
+    // Sizes larger than any texture are rejected, so the sizes of the levels can't overflow
+    if (internalFormat == TextureObject::InternalFormatInvalid || header.width == 0 || header.height == 0 ||
+        header.width > s_ddsMaxSize || header.height > s_ddsMaxSize)
+    {
+        return false;
+    }
+
+    Reset(header.width, header.height, internalFormat);
+
+    // The file can't have more levels than the full mip chain of its size
+    unsigned int maxLevelCount = std::bit_width(std::max(header.width, header.height));
+    int levelCount = (header.flags & s_ddsFlagsMipMapCount) ? std::clamp(header.mipMapCount, 1u, maxLevelCount) : 1;
+
+    // Check that the file has the data of all the levels before allocating them
+    size_t dataSize = 0;
+    for (int level = 0; level < levelCount; ++level)
+    {
+        dataSize += TextureObject::GetCompressedImageSize(internalFormat, GetLevelWidth(level), GetLevelHeight(level));
+    }
+    std::streampos dataStart = file.tellg();
+    file.seekg(0, std::ios::end);
+    std::streampos fileEnd = file.tellg();
+    file.seekg(dataStart);
+    if (dataStart < 0 || fileEnd < dataStart || static_cast<size_t>(fileEnd - dataStart) < dataSize)
+    {
+        Reset(0, 0, TextureObject::InternalFormatInvalid);
+        return false;
+    }
+
+    // Seek over the skipped levels instead of reading them
+    size_t skippedSize = 0;
+    m_firstLevel = std::clamp(firstLevel, 0, levelCount);
+    for (int level = 0; level < m_firstLevel; ++level)
+    {
+        skippedSize += TextureObject::GetCompressedImageSize(internalFormat, GetLevelWidth(level), GetLevelHeight(level));
+        m_levelOffsets.push_back(0);
+    }
+    file.seekg(static_cast<std::streamoff>(skippedSize), std::ios::cur);
+
+    for (int level = m_firstLevel; level < levelCount; ++level)
+    {
+        std::span<std::byte> levelData = AddLevel();
+        if (!file.read(reinterpret_cast<char*>(levelData.data()), levelData.size()))
+        {
+            Reset(0, 0, TextureObject::InternalFormatInvalid);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool DDSFile::LoadHeader(const char* path)
+{
+    return Load(path, INT_MAX);
+}
+
+bool DDSFile::Save(const char* path) const
+{
+    assert(GetLevelCount() > 0 && m_firstLevel == 0);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    DDSHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.size = sizeof(DDSHeader);
+    header.flags = s_ddsFlagsCaps | s_ddsFlagsHeight | s_ddsFlagsWidth | s_ddsFlagsPixelFormat | s_ddsFlagsMipMapCount | s_ddsFlagsLinearSize;
+    header.height = m_height;
+    header.width = m_width;
+    header.pitchOrLinearSize = static_cast<unsigned int>(GetLevelData(0).size());
+    header.mipMapCount = GetLevelCount();
+    header.pixelFormat.size = sizeof(DDSPixelFormat);
+    header.pixelFormat.flags = s_ddsPixelFormatFourCC;
+    header.pixelFormat.fourCC = MakeFourCC("DX10");
+    header.caps[0] = s_ddsCapsTexture | (GetLevelCount() > 1 ? s_ddsCapsComplex | s_ddsCapsMipMap : 0);
+
+    DDSHeaderDX10 headerDX10;
+    headerDX10.dxgiFormat = GetDXGIFormat(m_internalFormat);
+    headerDX10.resourceDimension = s_ddsDimensionTexture2D;
+    headerDX10.miscFlag = 0;
+    headerDX10.arraySize = 1;
+    headerDX10.miscFlags2 = 0;
+
+    file.write(reinterpret_cast<const char*>(&s_ddsMagic), sizeof(s_ddsMagic));
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(&headerDX10), sizeof(headerDX10));
+    file.write(reinterpret_cast<const char*>(m_data.data()), m_data.size());
+    return file.good();
+}
+
+void DDSFile::Reset(GLsizei width, GLsizei height, TextureObject::InternalFormat internalFormat)
+{
+    m_width = width;
+    m_height = height;
+    m_internalFormat = internalFormat;
+    m_data.clear();
+    m_levelOffsets.clear();
+    m_firstLevel = 0;
+}
+
+std::span<std::byte> DDSFile::AddLevel()
+{
+    assert(TextureObject::IsBlockCompressed(m_internalFormat));
+
+    int level = GetLevelCount();
+    size_t levelSize = TextureObject::GetCompressedImageSize(m_internalFormat, GetLevelWidth(level), GetLevelHeight(level));
+    size_t levelOffset = m_data.size();
+    m_levelOffsets.push_back(levelOffset);
+    m_data.resize(levelOffset + levelSize);
+    return std::span<std::byte>(m_data.data() + levelOffset, levelSize);
+}
+
+std::span<const std::byte> DDSFile::GetLevelData(int level) const
+{
+    assert(level >= m_firstLevel && level < GetLevelCount());
+    size_t levelOffset = m_levelOffsets[level];
+    size_t levelEnd = level + 1 < GetLevelCount() ? m_levelOffsets[level + 1] : m_data.size();
+    return std::span<const std::byte>(m_data.data() + levelOffset, levelEnd - levelOffset);
+}
+
+TextureObject::InternalFormat DDSFile::GetInternalFormat(unsigned int dxgiFormat)
+{
+    switch (dxgiFormat)
+    {
+    case 71:
+        return TextureObject::InternalFormatBC1;
+    case 72:
+        return TextureObject::InternalFormatBC1SRGB;
+    case 77:
+        return TextureObject::InternalFormatBC3;
+    case 78:
+        return TextureObject::InternalFormatBC3SRGB;
+    case 80:
+        return TextureObject::InternalFormatBC4;
+    case 83:
+        return TextureObject::InternalFormatBC5;
+    case 98:
+        return TextureObject::InternalFormatBC7;
+    case 99:
+        return TextureObject::InternalFormatBC7SRGB;
+    default:
+        // Not supported
+        return TextureObject::InternalFormatInvalid;
+    }
+}
+
+unsigned int DDSFile::GetDXGIFormat(TextureObject::InternalFormat internalFormat)
+{
+    switch (internalFormat)
+    {
+    case TextureObject::InternalFormatBC1:
+        return 71;
+    case TextureObject::InternalFormatBC1SRGB:
+        return 72;
+    case TextureObject::InternalFormatBC3:
+        return 77;
+    case TextureObject::InternalFormatBC3SRGB:
+        return 78;
+    case TextureObject::InternalFormatBC4:
+        return 80;
+    case TextureObject::InternalFormatBC5:
+        return 83;
+    case TextureObject::InternalFormatBC7:
+        return 98;
+    case TextureObject::InternalFormatBC7SRGB:
+        return 99;
+    default:
+        // DXGI_FORMAT_UNKNOWN
+        return 0;
+    }
+}
@@ -3,207 +3,1587 @@
 #include <ituGL/geometry/VertexFormat.h>
 #include <ituGL/shader/Material.h>
 #include <ituGL/asset/Texture2DLoader.h>
+#include <ituGL/geometry/MeshOptimizer.h>
+#include <ituGL/geometry/ElementBufferObject.h>
+#include <ituGL/utils/ParallelUtils.h>
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
+#include <glm/packing.hpp>
+#include <glm/gtc/packing.hpp>
+#include <glm/gtc/matrix_transform.hpp>
 #include <iostream>
-#include <bit>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <array>
+#include <atomic>
+#include <thread>
+#include <cstring>
+
+// Header stored at the beginning of each mesh cache file
+struct ModelCacheHeader
+{
+    // Identifies the file type and the version of the layout
+    unsigned int magic;
+    unsigned int version;
+    // Modification time of the source file when the cache was written
+    long long sourceTime;
+    unsigned int materialCount;
+    unsigned int submeshCount;
+};
+
+// Material record, followed by the characters of the 3 texture paths
+struct ModelCacheMaterial
+{
+    unsigned int propertyMask;
+    float ambientColor[3];
+    float diffuseColor[3];
+    float specularColor[3];
+    float specularExponent;
+    unsigned int texturePathLengths[3];
+};
+
+// Submesh record, followed by the attributes, the primitive ranges, the meshlets, the triangles, the vertex data and the element data
+struct ModelCacheSubmesh
+{
+    unsigned int attributeCount;
+    unsigned int primitiveCount;
+    unsigned int elementType;
+    unsigned int materialIndex;
+    unsigned long long vertexDataSize;
+    unsigned long long elementDataSize;
+    float positionOffset[3];
+    float positionScale;
+    MeshBounds bounds;
+    unsigned int meshletCount;
+    unsigned int trianglePositionCount;
+    unsigned int triangleIndexCount;
+};
+
+struct ModelCacheAttribute
+{
+    unsigned int type;
+    unsigned int components;
+    unsigned int normalized;
+    unsigned int semantic;
+};
+
+struct ModelCachePrimitive
+{
+    unsigned int primitive;
+    int elementCount;
+};
+
+static const unsigned int s_modelCacheMagic = 0x4d4c4749; // "IGLM"
+static const unsigned int s_modelCacheVersion = 7;
+// Vertex and element data start at aligned offsets in the file
+static const size_t s_modelCacheAlignment = 16;
+
+// Vertices are packed in blocks of this size, that can run in parallel
+static const unsigned int s_vertexBlockSize = 1 << 16;
+
+// Quantized meshes are split to fit in 16-bit indices
+static const unsigned int s_maxQuantizedVertexCount = 0xFFFF;
+
+// Reads the records sequentially from the mapped cache file, checking the bounds
+class ModelCacheReader
+{
+public:
+    ModelCacheReader(std::span<const std::byte> data) : m_data(data), m_offset(0) {}
+
+    template<typename T>
+    bool Read(T& value)
+    {
+        std::span<const std::byte> bytes;
+        bool success = ReadBytes(sizeof(T), bytes);
+        if (success)
+        {
+            std::memcpy(&value, bytes.data(), sizeof(T));
+        }
+        return success;
+    }
+
+    bool ReadBytes(size_t size, std::span<const std::byte>& bytes)
+    {
+        if (size > m_data.size() - m_offset)
+        {
+            return false;
+        }
+        bytes = m_data.subspan(m_offset, size);
+        m_offset += size;
+        return true;
+    }
+
+    bool ReadString(size_t length, std::string& value)
+    {
+        std::span<const std::byte> bytes;
+        bool success = ReadBytes(length, bytes);
+        if (success)
+        {
+            value.assign(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+        }
+        return success;
+    }
+
+    void Align()
+    {
+        m_offset = std::min((m_offset + s_modelCacheAlignment - 1) & ~(s_modelCacheAlignment - 1), m_data.size());
+    }
+
+private:
+    std::span<const std::byte> m_data;
+    size_t m_offset;
+};
 
 ModelLoader::ModelLoader(std::shared_ptr<Material> referenceMaterial)
-    : m_referenceMaterial(referenceMaterial)
+    : m_cacheFolder("meshcache/")
+    , m_referenceMaterial(referenceMaterial)
     , m_createMaterials(false)
+    , m_packTextures(false)
+    , m_importSettings{ VertexQuantization::None, false, false, false }
 {
     m_textureLoader.SetGenerateMipmap(true);
+    m_textureLoader.SetPreferCompressed(true);
+}
+
+ModelLoader::~ModelLoader()
+{
+    // Destroying the futures waits for the worker threads that are still running
+}
+
+ModelLoader::AsyncModel::AsyncModel() : m_model(std::make_shared<Model>()), m_ready(false)
+{
+}
+
+std::shared_ptr<Material> ModelLoader::GetReferenceMaterial() const
+{
+    return m_referenceMaterial;
+}
+
+void ModelLoader::SetReferenceMaterial(std::shared_ptr<Material> referenceMaterial)
+{
+    // Clear the previous attribute map
+    m_materialAttributeMap.clear();
+
+    m_referenceMaterial = referenceMaterial;
+}
+
+bool ModelLoader::GetCreateMaterials() const
+{
+    return m_createMaterials;
+}
+
+void ModelLoader::SetCreateMaterials(bool createMaterials)
+{
+    m_createMaterials = createMaterials;
+}
+
+Texture2DLoader& ModelLoader::GetTexture2DLoader()
+{
+    return m_textureLoader;
+}
+
+const Texture2DLoader& ModelLoader::GetTexture2DLoader() const
+{
+    return m_textureLoader;
+}
+
+std::shared_ptr<TextureStreamer> ModelLoader::GetTextureStreamer() const
+{
+    return m_textureStreamer;
+}
+
+void ModelLoader::SetTextureStreamer(std::shared_ptr<TextureStreamer> textureStreamer)
+{
+    m_textureStreamer = textureStreamer;
+}
+
+bool ModelLoader::GetPackTextures() const
+{
+    return m_packTextures;
+}
+
+void ModelLoader::SetPackTextures(bool packTextures)
+{
+    m_packTextures = packTextures;
+}
+
+ModelLoader::VertexQuantization ModelLoader::GetVertexQuantization() const
+{
+    return m_importSettings.vertexQuantization;
+}
+
+void ModelLoader::SetVertexQuantization(VertexQuantization vertexQuantization)
+{
+    m_importSettings.vertexQuantization = vertexQuantization;
+}
+
+bool ModelLoader::GetQuantizePositions() const
+{
+    return m_importSettings.quantizePositions;
+}
+
+void ModelLoader::SetQuantizePositions(bool quantizePositions)
+{
+    m_importSettings.quantizePositions = quantizePositions;
+}
+
+bool ModelLoader::GetBuildMeshlets() const
+{
+    return m_importSettings.buildMeshlets;
+}
+
+void ModelLoader::SetBuildMeshlets(bool buildMeshlets)
+{
+    m_importSettings.buildMeshlets = buildMeshlets;
+}
+
+bool ModelLoader::GetKeepTriangles() const
+{
+    return m_importSettings.keepTriangles;
+}
+
+void ModelLoader::SetKeepTriangles(bool keepTriangles)
+{
+    m_importSettings.keepTriangles = keepTriangles;
+}
+
+const std::string& ModelLoader::GetCacheFolder() const
+{
+    return m_cacheFolder;
+}
+
+void ModelLoader::SetCacheFolder(const char* cacheFolder)
+{
+    m_cacheFolder = cacheFolder;
+}
+
+bool ModelLoader::SetMaterialAttribute(VertexAttribute::Semantic semantic, const char* attributeName)
+{
+    bool found = false;
+    ShaderProgram::Location location = m_referenceMaterial->GetAttributeLocation(attributeName);
+    if (location != -1)
+    {
+        m_materialAttributeMap.insert(std::make_pair(semantic, location));
+        found = true;
+    }
+    return found;
+}
+
+bool ModelLoader::SetMaterialProperty(MaterialProperty materialProperty, const char* uniformName)
+{
+    bool found = false;
+    ShaderProgram::Location location = m_referenceMaterial->GetUniformLocation(uniformName);
+    if (location != -1)
+    {
+        m_materialPropertyMap.insert(std::make_pair(materialProperty, location));
+        found = true;
+    }
+    return found;
 }
 
-std::shared_ptr<Material> ModelLoader::GetReferenceMaterial() const
-{
-    return m_referenceMaterial;
+Model ModelLoader::Load(const char* path)
+{
+    Model model;
+
+    // Import and upload in the same thread
+    std::unique_ptr<ModelData> modelData = ImportModelData(path, m_cacheFolder, m_importSettings);
+    if (modelData)
+    {
+        model.SetMesh(std::make_shared<Mesh>());
+        for (unsigned int submeshIndex = 0; submeshIndex < modelData->submeshes.size(); ++submeshIndex)
+        {
+            AddSubmesh(model, *modelData, submeshIndex);
+        }
+    }
+
+    return model;
+}
+
+std::shared_ptr<ModelLoader::AsyncModel> ModelLoader::LoadAsync(const char* path)
+{
+    AsyncLoad& asyncLoad = m_asyncLoads.emplace_back();
+    asyncLoad.asyncModel = std::make_shared<AsyncModel>();
+
+    // Textures are only decoded if the materials are going to use them, and the streamer doesn't load them
+    unsigned int texturePropertyMask = 0;
+    if (m_createMaterials && !m_textureStreamer)
+    {
+        for (auto& materialPropertyPair : m_materialPropertyMap)
+        {
+            texturePropertyMask |= 1u << static_cast<unsigned int>(materialPropertyPair.first);
+        }
+    }
+
+    // The worker gets copies of the loader settings, they can change while it runs
+    bool flipVertical = m_textureLoader.GetFlipVertical();
+    bool preferCompressed = m_textureLoader.GetPreferCompressed();
+    bool generateMipmap = m_textureLoader.GetGenerateMipmap();
+    MipmapGenerator mipmapGenerator = m_textureLoader.GetMipmapGenerator();
+    asyncLoad.future = std::async(std::launch::async,
+        [path = std::string(path), cacheFolder = m_cacheFolder, importSettings = m_importSettings,
+        texturePropertyMask, flipVertical, preferCompressed, generateMipmap, mipmapGenerator]()
+        {
+            std::unique_ptr<ModelData> modelData = ImportModelData(path, cacheFolder, importSettings);
+            if (modelData && texturePropertyMask != 0)
+            {
+                DecodeTextures(*modelData, texturePropertyMask, flipVertical, preferCompressed, generateMipmap ? &mipmapGenerator : nullptr);
+            }
+            return modelData;
+        });
+    asyncLoad.submeshIndex = 0;
+    return asyncLoad.asyncModel;
+}
+
+unsigned int ModelLoader::UpdateAsyncLoads(double timeBudget)
+{
+    auto startTime = std::chrono::steady_clock::now();
+    auto IsBudgetExceeded = [&]()
+    {
+        std::chrono::duration<double> duration = std::chrono::steady_clock::now() - startTime;
+        return duration.count() > timeBudget;
+    };
+
+    // At least one submesh is uploaded on each call, so the loads finish even if the frame used all the budget
+    bool uploaded = false;
+
+    for (AsyncLoad& asyncLoad : m_asyncLoads)
+    {
+        // Collect the results of the worker threads that finished
+        if (!asyncLoad.modelData)
+        {
+            if (asyncLoad.future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            {
+                continue;
+            }
+
+            asyncLoad.modelData = asyncLoad.future.get();
+            if (!asyncLoad.modelData)
+            {
+                // The file could not be imported, nothing to upload
+                asyncLoad.asyncModel->m_ready = true;
+                continue;
+            }
+            asyncLoad.asyncModel->m_model->SetMesh(std::make_shared<Mesh>());
+        }
+
+        // Upload one submesh at a time, until we run out of time
+        Model& model = *asyncLoad.asyncModel->m_model;
+        ModelData& modelData = *asyncLoad.modelData;
+        while (asyncLoad.submeshIndex < modelData.submeshes.size() && (!uploaded || !IsBudgetExceeded()))
+        {
+            AddSubmesh(model, modelData, asyncLoad.submeshIndex);
+            asyncLoad.submeshIndex++;
+            uploaded = true;
+        }
+
+        if (asyncLoad.submeshIndex == modelData.submeshes.size())
+        {
+            asyncLoad.asyncModel->m_ready = true;
+        }
+
+        if (IsBudgetExceeded())
+        {
+            break;
+        }
+    }
+
+    // Remove the loads that are finished
+    std::erase_if(m_asyncLoads, [](const AsyncLoad& asyncLoad) { return asyncLoad.asyncModel->IsReady(); });
+
+    return static_cast<unsigned int>(m_asyncLoads.size());
+}
+
+std::unique_ptr<ModelLoader::ModelData> ModelLoader::ImportModelData(std::string path, std::string cacheFolder, ImportSettings importSettings)
+{
+    std::unique_ptr<ModelData> modelData = std::make_unique<ModelData>();
+    modelData->baseFolder = path;
+    modelData->baseFolder.resize(modelData->baseFolder.rfind('/') + 1);
+
+    // The cache is valid while the source file is not modified
+    std::error_code errorCode;
+    long long sourceTime = std::filesystem::last_write_time(path, errorCode).time_since_epoch().count();
+    std::string cacheFilePath;
+    if (!cacheFolder.empty() && !errorCode)
+    {
+        cacheFilePath = GetCacheFilePath(cacheFolder, path, importSettings);
+        if (LoadModelCache(cacheFilePath, sourceTime, *modelData))
+        {
+            return modelData;
+        }
+    }
+
+    // Read the file using Assimp importer
+    Assimp::Importer importer;
+    const aiScene* scene = importer.ReadFile(path,
+        aiProcess_CalcTangentSpace | aiProcess_GenNormals | aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | aiProcess_SortByPType);
+
+    // If the file was not loaded, there is no data
+    if (!scene)
+    {
+        return nullptr;
+    }
+
+    // Pack the data of all the meshes in parallel, to be added later as submeshes
+    // Threads left over when there are few meshes are used to pack the vertices of each mesh
+    unsigned int threadCount = ParallelUtils::GetDefaultThreadCount();
+    unsigned int meshThreadCount = std::max(threadCount / std::max(scene->mNumMeshes, 1u), 1u);
+    std::vector<std::vector<SubmeshData>> meshSubmeshes(scene->mNumMeshes);
+    ParallelUtils::For(scene->mNumMeshes, [&](unsigned int meshIndex)
+        {
+            const aiMesh& meshData = *scene->mMeshes[meshIndex];
+            CollectSubmeshData(meshData, importSettings, meshThreadCount, meshSubmeshes[meshIndex]);
+        }, threadCount);
+
+    // Keep the order of the meshes. The spans point to the storage vectors, so the data must be moved
+    for (std::vector<SubmeshData>& submeshes : meshSubmeshes)
+    {
+        for (SubmeshData& submeshData : submeshes)
+        {
+            modelData->submeshes.push_back(std::move(submeshData));
+        }
+    }
+
+    // Read the material properties, to create the materials later
+    modelData->materials.resize(scene->mNumMaterials);
+    for (unsigned int materialIndex = 0; materialIndex < scene->mNumMaterials; ++materialIndex)
+    {
+        CollectMaterialData(*scene->mMaterials[materialIndex], modelData->materials[materialIndex]);
+    }
+
+    if (!cacheFilePath.empty())
+    {
+        SaveModelCache(cacheFilePath, sourceTime, *modelData);
+    }
+
+    return modelData;
+}
+
+std::string ModelLoader::GetCacheFilePath(const std::string& cacheFolder, const std::string& path, const ImportSettings& importSettings)
+{
+    // 64-bit FNV-1a of the source path
+    unsigned long long hash = 14695981039346656037ull;
+    for (char c : path)
+    {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+    }
+
+    std::stringstream stringStream;
+    stringStream << cacheFolder << std::hex << std::setw(16) << std::setfill('0') << hash;
+
+    // Each import of the same file with different settings has its own cache
+    if (importSettings.vertexQuantization != VertexQuantization::None)
+    {
+        stringStream << "_q" << static_cast<int>(importSettings.vertexQuantization) << (importSettings.quantizePositions ? "p" : "");
+    }
+    if (importSettings.buildMeshlets)
+    {
+        stringStream << "_m";
+    }
+    if (importSettings.keepTriangles)
+    {
+        stringStream << "_t";
+    }
+    stringStream << ".mesh";
+    return stringStream.str();
+}
+
+bool ModelLoader::LoadModelCache(const std::string& cacheFilePath, long long sourceTime, ModelData& modelData)
+{
+    if (!modelData.cacheFile.Open(cacheFilePath.c_str()))
+    {
+        return false;
+    }
+
+    ModelCacheReader reader(modelData.cacheFile.GetData());
+
+    ModelCacheHeader header;
+    if (!reader.Read(header) || header.magic != s_modelCacheMagic || header.version != s_modelCacheVersion || header.sourceTime != sourceTime)
+    {
+        modelData.cacheFile.Close();
+        return false;
+    }
+
+    bool success = true;
+
+    modelData.materials.resize(header.materialCount);
+    for (MaterialData& materialData : modelData.materials)
+    {
+        ModelCacheMaterial cacheMaterial;
+        success = success && reader.Read(cacheMaterial);
+        if (!success)
+        {
+            break;
+        }
+        materialData.propertyMask = cacheMaterial.propertyMask;
+        materialData.ambientColor = glm::vec3(cacheMaterial.ambientColor[0], cacheMaterial.ambientColor[1], cacheMaterial.ambientColor[2]);
+        materialData.diffuseColor = glm::vec3(cacheMaterial.diffuseColor[0], cacheMaterial.diffuseColor[1], cacheMaterial.diffuseColor[2]);
+        materialData.specularColor = glm::vec3(cacheMaterial.specularColor[0], cacheMaterial.specularColor[1], cacheMaterial.specularColor[2]);
+        materialData.specularExponent = cacheMaterial.specularExponent;
+        success = success && reader.ReadString(cacheMaterial.texturePathLengths[0], materialData.diffuseTexture);
+        success = success && reader.ReadString(cacheMaterial.texturePathLengths[1], materialData.normalTexture);
+        success = success && reader.ReadString(cacheMaterial.texturePathLengths[2], materialData.specularTexture);
+    }
+
+    if (success)
+    {
+        modelData.submeshes.resize(header.submeshCount);
+    }
+    for (SubmeshData& submeshData : modelData.submeshes)
+    {
+        ModelCacheSubmesh cacheSubmesh;
+        reader.Align();
+        success = success && reader.Read(cacheSubmesh) && cacheSubmesh.attributeCount > 0 && cacheSubmesh.materialIndex < header.materialCount;
+        if (!success)
+        {
+            break;
+        }
+
+        submeshData.vertexFormat.Clear();
+        for (unsigned int attributeIndex = 0; success && attributeIndex < cacheSubmesh.attributeCount; ++attributeIndex)
+        {
+            ModelCacheAttribute cacheAttribute;
+            success = reader.Read(cacheAttribute);
+            if (success)
+            {
+                submeshData.vertexFormat.AddVertexAttribute(static_cast<Data::Type>(cacheAttribute.type), cacheAttribute.components,
+                    cacheAttribute.normalized != 0, static_cast<VertexAttribute::Semantic>(cacheAttribute.semantic));
+            }
+        }
+
+        for (unsigned int primitiveIndex = 0; success && primitiveIndex < cacheSubmesh.primitiveCount; ++primitiveIndex)
+        {
+            ModelCachePrimitive cachePrimitive;
+            success = reader.Read(cachePrimitive);
+            if (success)
+            {
+                submeshData.primitives.push_back(static_cast<Drawcall::Primitive>(cachePrimitive.primitive));
+                submeshData.elementCounts.push_back(cachePrimitive.elementCount);
+            }
+        }
+
+        for (unsigned int meshletIndex = 0; success && meshletIndex < cacheSubmesh.meshletCount; ++meshletIndex)
+        {
+            success = reader.Read(submeshData.meshlets.emplace_back());
+        }
+
+        for (unsigned int positionIndex = 0; success && positionIndex < cacheSubmesh.trianglePositionCount; ++positionIndex)
+        {
+            success = reader.Read(submeshData.trianglePositions.emplace_back());
+        }
+        for (unsigned int index = 0; success && index < cacheSubmesh.triangleIndexCount; ++index)
+        {
+            success = reader.Read(submeshData.triangleIndices.emplace_back());
+        }
+
+        submeshData.elementType = static_cast<Data::Type>(cacheSubmesh.elementType);
+        submeshData.materialIndex = cacheSubmesh.materialIndex;
+        submeshData.positionOffset = glm::vec3(cacheSubmesh.positionOffset[0], cacheSubmesh.positionOffset[1], cacheSubmesh.positionOffset[2]);
+        submeshData.positionScale = cacheSubmesh.positionScale;
+        submeshData.bounds = cacheSubmesh.bounds;
+
+        // Point directly to the mapped memory, no copies
+        std::span<const std::byte> vertexBytes, elementBytes;
+        reader.Align();
+        success = success && reader.ReadBytes(cacheSubmesh.vertexDataSize, vertexBytes);
+        reader.Align();
+        success = success && reader.ReadBytes(cacheSubmesh.elementDataSize, elementBytes);
+        if (success)
+        {
+            submeshData.vertexData = std::span<const GLubyte>(reinterpret_cast<const GLubyte*>(vertexBytes.data()), vertexBytes.size());
+            submeshData.elementData = std::span<const GLubyte>(reinterpret_cast<const GLubyte*>(elementBytes.data()), elementBytes.size());
+        }
+    }
+
+    if (!success)
+    {
+        // Corrupted or truncated file, import from the source instead
+        modelData.submeshes.clear();
+        modelData.materials.clear();
+        modelData.cacheFile.Close();
+    }
+    return success;
+}
+
+void ModelLoader::SaveModelCache(const std::string& cacheFilePath, long long sourceTime, const ModelData& modelData)
+{
+    std::error_code errorCode;
+    std::filesystem::create_directories(std::filesystem::path(cacheFilePath).parent_path(), errorCode);
+
+    // Write to a temporary file first, so other loads never map a partial file
+    // Each save uses its own file, in case several loads of the same model save it at the same time
+    static std::atomic<unsigned int> s_tempFileCounter = 0;
+    std::ostringstream tempFilePathStream;
+    tempFilePathStream << cacheFilePath << '.' << std::this_thread::get_id() << '.' << s_tempFileCounter++ << ".tmp";
+    std::string tempFilePath = tempFilePathStream.str();
+    std::ofstream file(tempFilePath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        return;
+    }
+
+    auto Write = [&file](const void* data, size_t size)
+    {
+        file.write(static_cast<const char*>(data), size);
+    };
+    auto Align = [&file]()
+    {
+        static const char zeros[s_modelCacheAlignment] = {};
+        size_t offset = static_cast<size_t>(file.tellp());
+        file.write(zeros, (s_modelCacheAlignment - offset % s_modelCacheAlignment) % s_modelCacheAlignment);
+    };
+
+    ModelCacheHeader header;
+    header.magic = s_modelCacheMagic;
+    header.version = s_modelCacheVersion;
+    header.sourceTime = sourceTime;
+    header.materialCount = static_cast<unsigned int>(modelData.materials.size());
+    header.submeshCount = static_cast<unsigned int>(modelData.submeshes.size());
+    Write(&header, sizeof(header));
+
+    for (const MaterialData& materialData : modelData.materials)
+    {
+        ModelCacheMaterial cacheMaterial;
+        cacheMaterial.propertyMask = materialData.propertyMask;
+        for (int i = 0; i < 3; ++i)
+        {
+            cacheMaterial.ambientColor[i] = materialData.ambientColor[i];
+            cacheMaterial.diffuseColor[i] = materialData.diffuseColor[i];
+            cacheMaterial.specularColor[i] = materialData.specularColor[i];
+        }
+        cacheMaterial.specularExponent = materialData.specularExponent;
+        cacheMaterial.texturePathLengths[0] = static_cast<unsigned int>(materialData.diffuseTexture.size());
+        cacheMaterial.texturePathLengths[1] = static_cast<unsigned int>(materialData.normalTexture.size());
+        cacheMaterial.texturePathLengths[2] = static_cast<unsigned int>(materialData.specularTexture.size());
+        Write(&cacheMaterial, sizeof(cacheMaterial));
+        Write(materialData.diffuseTexture.data(), materialData.diffuseTexture.size());
+        Write(materialData.normalTexture.data(), materialData.normalTexture.size());
+        Write(materialData.specularTexture.data(), materialData.specularTexture.size());
+    }
+
+    for (const SubmeshData& submeshData : modelData.submeshes)
+    {
+        ModelCacheSubmesh cacheSubmesh;
+        cacheSubmesh.attributeCount = submeshData.vertexFormat.GetAttributeCount();
+        cacheSubmesh.primitiveCount = static_cast<unsigned int>(submeshData.primitives.size());
+        cacheSubmesh.elementType = static_cast<unsigned int>(submeshData.elementType);
+        cacheSubmesh.materialIndex = submeshData.materialIndex;
+        cacheSubmesh.vertexDataSize = submeshData.vertexData.size();
+        cacheSubmesh.elementDataSize = submeshData.elementData.size();
+        for (int i = 0; i < 3; ++i)
+        {
+            cacheSubmesh.positionOffset[i] = submeshData.positionOffset[i];
+        }
+        cacheSubmesh.positionScale = submeshData.positionScale;
+        cacheSubmesh.bounds = submeshData.bounds;
+        cacheSubmesh.meshletCount = static_cast<unsigned int>(submeshData.meshlets.size());
+        cacheSubmesh.trianglePositionCount = static_cast<unsigned int>(submeshData.trianglePositions.size());
+        cacheSubmesh.triangleIndexCount = static_cast<unsigned int>(submeshData.triangleIndices.size());
+        Align();
+        Write(&cacheSubmesh, sizeof(cacheSubmesh));
+
+        for (int attributeIndex = 0; attributeIndex < submeshData.vertexFormat.GetAttributeCount(); ++attributeIndex)
+        {
+            VertexAttribute attribute = submeshData.vertexFormat.GetAttribute(attributeIndex);
+            ModelCacheAttribute cacheAttribute;
+            cacheAttribute.type = static_cast<unsigned int>(attribute.GetType());
+            cacheAttribute.components = attribute.GetComponents();
+            cacheAttribute.normalized = attribute.IsNormalized() ? 1 : 0;
+            cacheAttribute.semantic = static_cast<unsigned int>(attribute.GetSemantic());
+            Write(&cacheAttribute, sizeof(cacheAttribute));
+        }
+
+        for (size_t primitiveIndex = 0; primitiveIndex < submeshData.primitives.size(); ++primitiveIndex)
+        {
+            ModelCachePrimitive cachePrimitive;
+            cachePrimitive.primitive = static_cast<unsigned int>(submeshData.primitives[primitiveIndex]);
+            cachePrimitive.elementCount = submeshData.elementCounts[primitiveIndex];
+            Write(&cachePrimitive, sizeof(cachePrimitive));
+        }
+
+        Write(submeshData.meshlets.data(), submeshData.meshlets.size() * sizeof(Meshlet));
+        Write(submeshData.trianglePositions.data(), submeshData.trianglePositions.size() * sizeof(glm::vec3));
+        Write(submeshData.triangleIndices.data(), submeshData.triangleIndices.size() * sizeof(unsigned int));
+
+        Align();
+        Write(submeshData.vertexData.data(), submeshData.vertexData.size());
+        Align();
+        Write(submeshData.elementData.data(), submeshData.elementData.size());
+    }
+
+    bool success = file.good();
+    file.close();
+    if (success)
+    {
+        std::filesystem::rename(tempFilePath, cacheFilePath, errorCode);
+    }
+    if (!success || errorCode)
+    {
+        std::filesystem::remove(tempFilePath, errorCode);
+    }
+}
+
+void ModelLoader::AddSubmesh(Model& model, ModelData& modelData, unsigned int submeshIndex)
+{
+    SubmeshData& submeshData = modelData.submeshes[submeshIndex];
+    GenerateSubmesh(model.GetMesh(), submeshData);
+
+    std::shared_ptr<Material> material = m_referenceMaterial;
+    if (m_createMaterials)
+    {
+        // Create a new material with the material data
+        m_baseFolder = modelData.baseFolder;
+
+        // All the textures of the model are packed before the first material is created
+        if (submeshIndex == 0 && m_packTextures && !m_textureStreamer)
+        {
+            PackTextures(modelData);
+        }
+
+        material = GenerateMaterial(modelData, modelData.materials[submeshData.materialIndex]);
+    }
+    model.AddMaterial(material);
+}
+
+void ModelLoader::CollectSubmeshData(const aiMesh& meshData, const ImportSettings& importSettings,
+    unsigned int threadCount, std::vector<SubmeshData>& submeshes)
+{
+    SubmeshData submeshData;
+
+    // Collect vertex data
+    bool interleaved = true;
+    submeshData.vertexStorage = CollectVertexData(meshData, submeshData.vertexFormat, interleaved, threadCount);
+    submeshData.vertexData = submeshData.vertexStorage;
+
+    // Collect element data
+    submeshData.elementStorage = CollectElementData(meshData, submeshData.elementType, submeshData.primitives, submeshData.elementCounts);
+    submeshData.elementData = submeshData.elementStorage;
+
+    submeshData.materialIndex = meshData.mMaterialIndex;
+    submeshData.positionOffset = glm::vec3(0.0f);
+    submeshData.positionScale = 1.0f;
+
+    // Meshes are split by primitive type on import, the optimization only applies to triangles
+    // The spans point to the storage vectors, so the data must be moved, never copied
+    size_t firstSubmesh = submeshes.size();
+    if (meshData.mPrimitiveTypes == aiPrimitiveType_TRIANGLE)
+    {
+        OptimizeSubmeshData(submeshData);
+
+        // The optimized order keeps the triangles of each part close together
+        size_t vertexCount = submeshData.vertexData.size() / submeshData.vertexFormat.GetSize();
+        if (importSettings.vertexQuantization != VertexQuantization::None && vertexCount > s_maxQuantizedVertexCount)
+        {
+            SplitSubmeshData(submeshData, s_maxQuantizedVertexCount, submeshes);
+        }
+        else
+        {
+            submeshes.push_back(std::move(submeshData));
+        }
+
+        if (importSettings.buildMeshlets)
+        {
+            for (size_t submeshIndex = firstSubmesh; submeshIndex < submeshes.size(); ++submeshIndex)
+            {
+                BuildSubmeshMeshlets(submeshes[submeshIndex]);
+            }
+        }
+
+        if (importSettings.keepTriangles)
+        {
+            for (size_t submeshIndex = firstSubmesh; submeshIndex < submeshes.size(); ++submeshIndex)
+            {
+                CollectSubmeshTriangles(submeshes[submeshIndex]);
+            }
+        }
+    }
+    else
+    {
+        submeshes.push_back(std::move(submeshData));
+    }
+
+    // Bounds use the float positions, before they are quantized
+    for (size_t submeshIndex = firstSubmesh; submeshIndex < submeshes.size(); ++submeshIndex)
+    {
+        // Position is always the first attribute of the interleaved data
+        SubmeshData& part = submeshes[submeshIndex];
+        part.bounds = MeshOptimizer::ComputeBounds(part.vertexData, part.vertexFormat.GetSize(), 0);
+    }
+
+    if (importSettings.vertexQuantization != VertexQuantization::None)
+    {
+        for (size_t submeshIndex = firstSubmesh; submeshIndex < submeshes.size(); ++submeshIndex)
+        {
+            QuantizeSubmeshData(submeshes[submeshIndex], importSettings.vertexQuantization, importSettings.quantizePositions);
+        }
+    }
+}
+
+// Read and write unaligned values in the interleaved vertex data. Writing advances the destination pointer
+template<typename T>
+static T ReadVertexValue(std::span<const GLubyte> vertexData, size_t offset)
+{
+    T value;
+    std::memcpy(&value, &vertexData[offset], sizeof(T));
+    return value;
+}
+
+template<typename T>
+static void WriteVertexValue(GLubyte*& dst, const T& value)
+{
+    std::memcpy(dst, &value, sizeof(T));
+    dst += sizeof(T);
+}
+
+// Convert the element data between any element type and 32-bit indices
+template<typename T>
+static void ReadElements(std::span<const GLubyte> elementData, std::vector<unsigned int>& indices)
+{
+    indices.resize(elementData.size() / sizeof(T));
+    for (size_t i = 0; i < indices.size(); ++i)
+    {
+        T element;
+        std::memcpy(&element, &elementData[i * sizeof(T)], sizeof(T));
+        indices[i] = element;
+    }
+}
+
+template<typename T>
+static void WriteElements(std::span<const unsigned int> indices, std::vector<GLubyte>& elementData)
+{
+    elementData.resize(indices.size() * sizeof(T));
+    for (size_t i = 0; i < indices.size(); ++i)
+    {
+        T element = static_cast<T>(indices[i]);
+        std::memcpy(&elementData[i * sizeof(T)], &element, sizeof(T));
+    }
+}
+
+// Read the element data of any element type as 32-bit indices
+static bool ReadIndices(std::span<const GLubyte> elementData, Data::Type elementType, std::vector<unsigned int>& indices)
+{
+    switch (elementType)
+    {
+    case Data::Type::UByte:
+        ReadElements<GLubyte>(elementData, indices);
+        return true;
+    case Data::Type::UShort:
+        ReadElements<GLushort>(elementData, indices);
+        return true;
+    case Data::Type::UInt:
+        ReadElements<GLuint>(elementData, indices);
+        return true;
+    default:
+        return false;
+    }
+}
+
+void ModelLoader::OptimizeSubmeshData(SubmeshData& submeshData)
+{
+    // Position is always the first attribute of the interleaved data
+    assert(submeshData.vertexFormat.GetAttributeCount() > 0);
+    assert(submeshData.primitives.size() == 1 && submeshData.primitives[0] == Drawcall::Primitive::Triangles);
+
+    std::vector<unsigned int> indices;
+    if (!ReadIndices(submeshData.elementStorage, submeshData.elementType, indices))
+    {
+        assert(false);
+        return;
+    }
+
+    size_t vertexSize = submeshData.vertexFormat.GetSize();
+    unsigned int vertexCount = MeshOptimizer::Optimize(indices, submeshData.vertexStorage, vertexSize, 0);
+    submeshData.vertexStorage.resize(vertexCount * vertexSize);
+    submeshData.vertexData = submeshData.vertexStorage;
+
+    // Unused vertices were removed, a smaller type may fit now
+    submeshData.elementType = ElementBufferObject::GetSmallestType(vertexCount);
+    switch (submeshData.elementType)
+    {
+    case Data::Type::UByte:
+        WriteElements<GLubyte>(indices, submeshData.elementStorage);
+        break;
+    case Data::Type::UShort:
+        WriteElements<GLushort>(indices, submeshData.elementStorage);
+        break;
+    default:
+        WriteElements<GLuint>(indices, submeshData.elementStorage);
+        break;
+    }
+    submeshData.elementData = submeshData.elementStorage;
+    submeshData.elementCounts.assign(1, static_cast<int>(submeshData.elementStorage.size()));
+}
+
+void ModelLoader::BuildSubmeshMeshlets(SubmeshData& submeshData)
+{
+    assert(submeshData.primitives.size() == 1 && submeshData.primitives[0] == Drawcall::Primitive::Triangles);
+
+    std::vector<unsigned int> indices;
+    if (ReadIndices(submeshData.elementData, submeshData.elementType, indices))
+    {
+        // Position is always the first attribute of the interleaved data
+        submeshData.meshlets = MeshOptimizer::BuildMeshlets(indices, submeshData.vertexData, submeshData.vertexFormat.GetSize(), 0);
+    }
+}
+
+void ModelLoader::CollectSubmeshTriangles(SubmeshData& submeshData)
+{
+    assert(submeshData.primitives.size() == 1 && submeshData.primitives[0] == Drawcall::Primitive::Triangles);
+
+    if (ReadIndices(submeshData.elementData, submeshData.elementType, submeshData.triangleIndices))
+    {
+        // Position is always the first attribute of the interleaved data
+        size_t vertexSize = submeshData.vertexFormat.GetSize();
+        size_t vertexCount = submeshData.vertexData.size() / vertexSize;
+        submeshData.trianglePositions.resize(vertexCount);
+        for (size_t i = 0; i < vertexCount; ++i)
+        {
+            submeshData.trianglePositions[i] = ReadVertexValue<glm::vec3>(submeshData.vertexData, i * vertexSize);
+        }
+    }
+}
+
+void ModelLoader::SplitSubmeshData(const SubmeshData& submeshData, unsigned int maxVertexCount, std::vector<SubmeshData>& parts)
+{
+    assert(submeshData.elementType == Data::Type::UInt);
+    assert(maxVertexCount >= 3);
+
+    std::vector<unsigned int> indices;
+    ReadElements<GLuint>(submeshData.elementData, indices);
+
+    size_t vertexSize = submeshData.vertexFormat.GetSize();
+    size_t vertexCount = submeshData.vertexData.size() / vertexSize;
+
+    // Index of each vertex in the current part, or invalid if it is not used yet
+    const unsigned int invalidIndex = ~0u;
+    std::vector<unsigned int> partIndexMap(vertexCount, invalidIndex);
+    std::vector<unsigned int> partVertices;
+    std::vector<unsigned int> partIndices;
+
+    auto AddPart = [&]()
+    {
+        SubmeshData& part = parts.emplace_back();
+        part.vertexFormat = submeshData.vertexFormat;
+        part.vertexStorage.resize(partVertices.size() * vertexSize);
+        for (size_t i = 0; i < partVertices.size(); ++i)
+        {
+            std::memcpy(&part.vertexStorage[i * vertexSize], &submeshData.vertexData[partVertices[i] * vertexSize], vertexSize);
+            partIndexMap[partVertices[i]] = invalidIndex;
+        }
+        part.vertexData = part.vertexStorage;
+
+        part.elementType = ElementBufferObject::GetSmallestType(static_cast<unsigned int>(partVertices.size()));
+        switch (part.elementType)
+        {
+        case Data::Type::UByte:
+            WriteElements<GLubyte>(partIndices, part.elementStorage);
+            break;
+        case Data::Type::UShort:
+            WriteElements<GLushort>(partIndices, part.elementStorage);
+            break;
+        default:
+            WriteElements<GLuint>(partIndices, part.elementStorage);
+            break;
+        }
+        part.elementData = part.elementStorage;
+        part.primitives.assign(1, Drawcall::Primitive::Triangles);
+        part.elementCounts.assign(1, static_cast<int>(part.elementStorage.size()));
+        part.materialIndex = submeshData.materialIndex;
+        part.positionOffset = submeshData.positionOffset;
+        part.positionScale = submeshData.positionScale;
+
+        partVertices.clear();
+        partIndices.clear();
+    };
+
+    for (size_t triangle = 0; triangle + 2 < indices.size(); triangle += 3)
+    {
+        // Count the vertices that the triangle would add to the part
+        unsigned int newVertexCount = 0;
+        for (size_t corner = 0; corner < 3; ++corner)
+        {
+            unsigned int index = indices[triangle + corner];
+            bool repeated = (corner > 0 && index == indices[triangle]) || (corner > 1 && index == indices[triangle + 1]);
+            if (partIndexMap[index] == invalidIndex && !repeated)
+            {
+                newVertexCount++;
+            }
+        }
+
+        if (partVertices.size() + newVertexCount > maxVertexCount)
+        {
+            AddPart();
+        }
+
+        for (size_t corner = 0; corner < 3; ++corner)
+        {
+            unsigned int index = indices[triangle + corner];
+            if (partIndexMap[index] == invalidIndex)
+            {
+                partIndexMap[index] = static_cast<unsigned int>(partVertices.size());
+                partVertices.push_back(index);
+            }
+            partIndices.push_back(partIndexMap[index]);
+        }
+    }
+
+    if (!partIndices.empty())
+    {
+        AddPart();
+    }
 }
 
-void ModelLoader::SetReferenceMaterial(std::shared_ptr<Material> referenceMaterial)
+// Map a unit vector to the octahedron, and the octahedron to the [-1, 1] square
+static glm::vec2 EncodeOctahedral(const glm::vec3& vector)
 {
-    // Clear the previous attribute map
-    m_materialAttributeMap.clear();
-
-    m_referenceMaterial = referenceMaterial;
+    glm::vec3 octahedron = vector / (std::abs(vector.x) + std::abs(vector.y) + std::abs(vector.z));
+    glm::vec2 encoded(octahedron.x, octahedron.y);
+    if (octahedron.z < 0.0f)
+    {
+        // Fold the lower half over the diagonals
+        glm::vec2 sign(encoded.x >= 0.0f ? 1.0f : -1.0f, encoded.y >= 0.0f ? 1.0f : -1.0f);
+        encoded = (1.0f - glm::abs(glm::vec2(encoded.y, encoded.x))) * sign;
+    }
+    return encoded;
 }
 
-bool ModelLoader::GetCreateMaterials() const
+static glm::vec3 SafeNormalize(const glm::vec3& vector, const glm::vec3& fallback)
 {
-    return m_createMaterials;
+    float length = glm::length(vector);
+    return length > 0.0f ? vector / length : fallback;
 }
 
-void ModelLoader::SetCreateMaterials(bool createMaterials)
+void ModelLoader::QuantizeSubmeshData(SubmeshData& submeshData, VertexQuantization vertexQuantization, bool quantizePositions)
 {
-    m_createMaterials = createMaterials;
-}
+    assert(vertexQuantization != VertexQuantization::None);
 
-Texture2DLoader& ModelLoader::GetTexture2DLoader()
-{
-    return m_textureLoader;
-}
+    size_t srcVertexSize = submeshData.vertexFormat.GetSize();
+    unsigned int vertexCount = static_cast<unsigned int>(submeshData.vertexData.size() / srcVertexSize);
 
-const Texture2DLoader& ModelLoader::GetTexture2DLoader() const
-{
-    return m_textureLoader;
-}
+    // Offsets of the source normal and bitangent in the interleaved vertex, -1 if missing
+    int normalOffset = -1;
+    int bitangentOffset = -1;
 
-bool ModelLoader::SetMaterialAttribute(VertexAttribute::Semantic semantic, const char* attributeName)
-{
-    bool found = false;
-    ShaderProgram::Location location = m_referenceMaterial->GetAttributeLocation(attributeName);
-    if (location != -1)
+    // Build the quantized format, and remember where each attribute comes from
+    struct AttributeCopy
     {
-        m_materialAttributeMap.insert(std::make_pair(semantic, location));
-        found = true;
+        VertexAttribute::Semantic semantic;
+        int srcOffset;
+        int srcSize;
+        bool half;
+    };
+    std::vector<AttributeCopy> attributeCopies;
+    VertexFormat vertexFormat;
+    auto itEnd = submeshData.vertexFormat.LayoutEnd();
+    for (auto it = submeshData.vertexFormat.LayoutBegin(vertexCount, true); it != itEnd; it++)
+    {
+        const VertexAttribute& attribute = it->GetAttribute();
+        VertexAttribute::Semantic semantic = attribute.GetSemantic();
+        bool half = false;
+        switch (semantic)
+        {
+        case VertexAttribute::Semantic::Position:
+            if (quantizePositions)
+            {
+                // w is always 1, the 4th component keeps the attribute aligned
+                vertexFormat.AddVertexAttribute(Data::Type::UShort, 4, true, semantic);
+            }
+            else
+            {
+                vertexFormat.AddVertexAttribute(attribute.GetType(), attribute.GetComponents(), attribute.IsNormalized(), semantic);
+            }
+            break;
+        case VertexAttribute::Semantic::Normal:
+            normalOffset = it->GetOffset();
+            if (vertexQuantization == VertexQuantization::Octahedral)
+            {
+                vertexFormat.AddVertexAttribute(Data::Type::Short, 2, true, semantic);
+            }
+            else
+            {
+                vertexFormat.AddVertexAttribute(Data::Type::Int2101010Rev, 4, true, semantic);
+            }
+            break;
+        case VertexAttribute::Semantic::Tangent:
+            if (vertexQuantization == VertexQuantization::Octahedral)
+            {
+                vertexFormat.AddVertexAttribute(Data::Type::Short, 4, true, semantic);
+            }
+            else
+            {
+                vertexFormat.AddVertexAttribute(Data::Type::Int2101010Rev, 4, true, semantic);
+            }
+            break;
+        case VertexAttribute::Semantic::Bitangent:
+            // Only its sign is kept, in the tangent. The attribute is not copied
+            bitangentOffset = it->GetOffset();
+            continue;
+        default:
+            if (semantic >= VertexAttribute::Semantic::TexCoord0 && semantic <= VertexAttribute::Semantic::TexCoord7
+                && attribute.GetType() == Data::Type::Float && attribute.GetComponents() == 2)
+            {
+                vertexFormat.AddVertexAttribute(Data::Type::Half, 2, false, semantic);
+                half = true;
+            }
+            else
+            {
+                vertexFormat.AddVertexAttribute(attribute.GetType(), attribute.GetComponents(), attribute.IsNormalized(), semantic);
+            }
+            break;
+        }
+        attributeCopies.push_back({ semantic, it->GetOffset(), attribute.GetSize(), half });
     }
-    return found;
-}
 
-bool ModelLoader::SetMaterialProperty(MaterialProperty materialProperty, const char* uniformName)
-{
-    bool found = false;
-    ShaderProgram::Location location = m_referenceMaterial->GetUniformLocation(uniformName);
-    if (location != -1)
+    // Positions are stored in the bounds of the submesh, with the same scale on all the axes
+    // A uniform scale keeps the normals correct when the shader transforms them with the world matrix
+    glm::vec3 boundsMin(0.0f);
+    float positionScale = 1.0f;
+    if (quantizePositions && vertexCount > 0)
     {
-        m_materialPropertyMap.insert(std::make_pair(materialProperty, location));
-        found = true;
+        glm::vec3 boundsMax;
+        boundsMin = boundsMax = ReadVertexValue<glm::vec3>(submeshData.vertexData, 0);
+        for (unsigned int vertex = 1; vertex < vertexCount; ++vertex)
+        {
+            glm::vec3 position = ReadVertexValue<glm::vec3>(submeshData.vertexData, vertex * srcVertexSize);
+            boundsMin = glm::min(boundsMin, position);
+            boundsMax = glm::max(boundsMax, position);
+        }
+        glm::vec3 extents = boundsMax - boundsMin;
+        positionScale = std::max(std::max(extents.x, extents.y), extents.z);
+        if (positionScale <= 0.0f)
+        {
+            positionScale = 1.0f;
+        }
     }
-    return found;
-}
-
-Model ModelLoader::Load(const char* path)
-{
-    Model model;
-
-    // Read the file using Assimp importer
-    Assimp::Importer importer;
-    const aiScene* scene = importer.ReadFile(path,
-        aiProcess_CalcTangentSpace | aiProcess_GenNormals | aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | aiProcess_SortByPType);
-
-    m_baseFolder = path;
-    m_baseFolder.resize(m_baseFolder.rfind('/') + 1);
 
-    // If the file was loaded, load all the meshes as submeshes
-    if (scene)
+    size_t dstVertexSize = vertexFormat.GetSize();
+    std::vector<GLubyte> vertexStorage(vertexCount * dstVertexSize);
+    for (unsigned int vertex = 0; vertex < vertexCount; ++vertex)
     {
-        model.SetMesh(std::make_shared<Mesh>());
-        Mesh& mesh = model.GetMesh();
-        for (unsigned int meshIndex = 0; meshIndex < scene->mNumMeshes; ++meshIndex)
+        size_t srcVertex = vertex * srcVertexSize;
+        GLubyte* dst = &vertexStorage[vertex * dstVertexSize];
+
+        glm::vec3 normal(0.0f, 0.0f, 1.0f);
+        if (normalOffset >= 0)
         {
-            aiMesh& meshData = *scene->mMeshes[meshIndex];
-            GenerateSubmesh(mesh, meshData);
+            normal = SafeNormalize(ReadVertexValue<glm::vec3>(submeshData.vertexData, srcVertex + normalOffset), normal);
+        }
 
-            std::shared_ptr<Material> material = m_referenceMaterial;
-            if (m_createMaterials)
+        for (const AttributeCopy& attributeCopy : attributeCopies)
+        {
+            size_t src = srcVertex + attributeCopy.srcOffset;
+            switch (attributeCopy.semantic)
             {
-                // Create a new material with the material data
-                material = GenerateMaterial(*scene->mMaterials[meshData.mMaterialIndex]);
+            case VertexAttribute::Semantic::Position:
+                if (quantizePositions)
+                {
+                    glm::vec3 position = (ReadVertexValue<glm::vec3>(submeshData.vertexData, src) - boundsMin) / positionScale;
+                    WriteVertexValue(dst, glm::packUnorm4x16(glm::vec4(position, 1.0f)));
+                }
+                else
+                {
+                    std::memcpy(dst, &submeshData.vertexData[src], attributeCopy.srcSize);
+                    dst += attributeCopy.srcSize;
+                }
+                break;
+            case VertexAttribute::Semantic::Normal:
+                if (vertexQuantization == VertexQuantization::Octahedral)
+                {
+                    WriteVertexValue(dst, glm::packSnorm2x16(EncodeOctahedral(normal)));
+                }
+                else
+                {
+                    WriteVertexValue(dst, glm::packSnorm3x10_1x2(glm::vec4(normal, 0.0f)));
+                }
+                break;
+            case VertexAttribute::Semantic::Tangent:
+            {
+                glm::vec3 tangent = SafeNormalize(ReadVertexValue<glm::vec3>(submeshData.vertexData, src), glm::vec3(1.0f, 0.0f, 0.0f));
+                float bitangentSign = 1.0f;
+                if (bitangentOffset >= 0)
+                {
+                    glm::vec3 bitangent = ReadVertexValue<glm::vec3>(submeshData.vertexData, srcVertex + bitangentOffset);
+                    bitangentSign = glm::dot(glm::cross(normal, tangent), bitangent) < 0.0f ? -1.0f : 1.0f;
+                }
+                if (vertexQuantization == VertexQuantization::Octahedral)
+                {
+                    WriteVertexValue(dst, glm::packSnorm4x16(glm::vec4(EncodeOctahedral(tangent), 0.0f, bitangentSign)));
+                }
+                else
+                {
+                    WriteVertexValue(dst, glm::packSnorm3x10_1x2(glm::vec4(tangent, bitangentSign)));
+                }
+                break;
+            }
+            default:
+                if (attributeCopy.half)
+                {
+                    WriteVertexValue(dst, glm::packHalf2x16(ReadVertexValue<glm::vec2>(submeshData.vertexData, src)));
+                }
+                else
+                {
+                    std::memcpy(dst, &submeshData.vertexData[src], attributeCopy.srcSize);
+                    dst += attributeCopy.srcSize;
+                }
+                break;
             }
-            model.AddMaterial(material);
         }
     }
 
-    return model;
+    submeshData.vertexFormat = vertexFormat;
+    submeshData.vertexStorage = std::move(vertexStorage);
+    submeshData.vertexData = submeshData.vertexStorage;
+    submeshData.positionOffset = boundsMin;
+    submeshData.positionScale = positionScale;
+
+    // The renderer culls the meshlets with the local matrix included, so the bounds follow the stored positions
+    for (Meshlet& meshlet : submeshData.meshlets)
+    {
+        meshlet.center = (meshlet.center - boundsMin) / positionScale;
+        meshlet.radius /= positionScale;
+        meshlet.coneApex = (meshlet.coneApex - boundsMin) / positionScale;
+    }
 }
 
-void ModelLoader::GenerateSubmesh(Mesh& mesh, const aiMesh& meshData)
+void ModelLoader::GenerateSubmesh(Mesh& mesh, SubmeshData& submeshData)
 {
-    // Collect vertex data
-    VertexFormat vertexFormat;
-    bool interleaved = true;
-    std::vector<GLubyte> vertexData = CollectVertexData(meshData, vertexFormat, interleaved);
-    int vboIndex = mesh.AddVertexData<GLubyte>(vertexData);
-
-    // Collect element data
-    Data::Type elementType;
-    std::vector<Drawcall::Primitive> primitives;
-    std::vector<int> elementCounts;
-    std::vector<GLubyte> elementData = CollectElementData(meshData, elementType, primitives, elementCounts);
-    int eboIndex = mesh.AddElementData<GLubyte>(elementData);
+    int vboIndex = mesh.AddVertexData<GLubyte>(submeshData.vertexData);
+    int eboIndex = mesh.AddElementData<GLubyte>(submeshData.elementData);
 
-    // Add submeshes
+    // Add submeshes. Element counts are stored in bytes
+    int vertexCount = static_cast<int>(submeshData.vertexData.size() / submeshData.vertexFormat.GetSize());
+    int elementSize = Data::GetTypeSize(submeshData.elementType);
     int start = 0;
-    assert(primitives.size() == elementCounts.size());
-    for (int i = 0; i < primitives.size(); ++i)
+    assert(submeshData.primitives.size() == submeshData.elementCounts.size());
+    for (int i = 0; i < submeshData.primitives.size(); ++i)
     {
-        Drawcall::Primitive primitive = primitives[i];
-        int end = elementCounts[i];
-        mesh.AddSubmesh(primitive, start, end - start, elementType, eboIndex, vboIndex, vertexFormat.LayoutBegin(static_cast<int>(vertexData.size()), interleaved), vertexFormat.LayoutEnd(), m_materialAttributeMap);
+        Drawcall::Primitive primitive = submeshData.primitives[i];
+        int end = submeshData.elementCounts[i];
+        unsigned int submeshIndex = mesh.AddSubmesh(primitive, start, (end - start) / elementSize, submeshData.elementType, vboIndex, eboIndex,
+            submeshData.vertexFormat.LayoutBegin(vertexCount, true), submeshData.vertexFormat.LayoutEnd(), m_materialAttributeMap);
         start = end;
+
+        // Convert the quantized positions back to the model space
+        if (submeshData.positionScale != 1.0f || submeshData.positionOffset != glm::vec3(0.0f))
+        {
+            glm::mat4 localMatrix = glm::translate(glm::mat4(1.0f), submeshData.positionOffset);
+            mesh.SetSubmeshLocalMatrix(submeshIndex, glm::scale(localMatrix, glm::vec3(submeshData.positionScale)));
+        }
+
+        mesh.SetSubmeshBounds(submeshIndex, submeshData.bounds);
+
+        if (!submeshData.meshlets.empty())
+        {
+            mesh.SetSubmeshMeshlets(submeshIndex, submeshData.meshlets);
+        }
+
+        if (!submeshData.triangleIndices.empty())
+        {
+            mesh.SetSubmeshTriangles(submeshIndex, submeshData.trianglePositions, submeshData.triangleIndices);
+        }
+    }
+}
+
+void ModelLoader::CollectMaterialData(const aiMaterial& aiMaterialData, MaterialData& materialData)
+{
+    auto AddProperty = [&materialData](MaterialProperty materialProperty)
+    {
+        materialData.propertyMask |= 1u << static_cast<unsigned int>(materialProperty);
+    };
+
+    materialData.propertyMask = 0;
+    materialData.ambientColor = glm::vec3(0.0f);
+    materialData.diffuseColor = glm::vec3(0.0f);
+    materialData.specularColor = glm::vec3(0.0f);
+    materialData.specularExponent = 0.0f;
+    aiColor3D color;
+    if (aiMaterialData.Get(AI_MATKEY_COLOR_AMBIENT, color) == aiReturn_SUCCESS)
+    {
+        materialData.ambientColor = glm::vec3(color.r, color.g, color.b);
+        AddProperty(MaterialProperty::AmbientColor);
+    }
+    if (aiMaterialData.Get(AI_MATKEY_COLOR_DIFFUSE, color) == aiReturn_SUCCESS)
+    {
+        materialData.diffuseColor = glm::vec3(color.r, color.g, color.b);
+        AddProperty(MaterialProperty::DiffuseColor);
+    }
+    if (aiMaterialData.Get(AI_MATKEY_COLOR_SPECULAR, color) == aiReturn_SUCCESS)
+    {
+        materialData.specularColor = glm::vec3(color.r, color.g, color.b);
+        AddProperty(MaterialProperty::SpecularColor);
+    }
+    if (aiMaterialData.Get(AI_MATKEY_SHININESS, materialData.specularExponent) == aiReturn_SUCCESS)
+    {
+        AddProperty(MaterialProperty::SpecularExponent);
+    }
+    if (CollectTexturePath(aiMaterialData, aiTextureType_DIFFUSE, materialData.diffuseTexture))
+    {
+        AddProperty(MaterialProperty::DiffuseTexture);
+    }
+    if (CollectTexturePath(aiMaterialData, aiTextureType_NORMALS, materialData.normalTexture))
+    {
+        AddProperty(MaterialProperty::NormalTexture);
+    }
+    if (CollectTexturePath(aiMaterialData, aiTextureType_SHININESS, materialData.specularTexture))
+    {
+        AddProperty(MaterialProperty::SpecularTexture);
+    }
+}
+
+bool ModelLoader::CollectTexturePath(const aiMaterial& aiMaterialData, int textureTypeValue, std::string& texturePath)
+{
+    bool found = false;
+    aiTextureType textureType = static_cast<aiTextureType>(textureTypeValue);
+    if (aiMaterialData.GetTextureCount(textureType) > 0)
+    {
+        assert(aiMaterialData.GetTextureCount(textureType) == 1);
+        aiString aiTexturePath;
+        if (aiMaterialData.GetTexture(textureType, 0, &aiTexturePath) == aiReturn_SUCCESS)
+        {
+            texturePath = aiTexturePath.C_Str();
+            found = true;
+        }
     }
+    return found;
 }
 
-std::shared_ptr<Material> ModelLoader::GenerateMaterial(const aiMaterial& materialData)
+std::shared_ptr<Material> ModelLoader::GenerateMaterial(ModelData& modelData, const MaterialData& materialData)
 {
     std::shared_ptr<Material> material = std::make_shared<Material>(*m_referenceMaterial);
-    float value;
     for (auto& materialPropertyPair : m_materialPropertyMap)
     {
-        aiColor3D color;
         MaterialProperty materialProperty = materialPropertyPair.first;
         ShaderProgram::Location location = materialPropertyPair.second;
+        if ((materialData.propertyMask & (1u << static_cast<unsigned int>(GetMaskProperty(materialProperty)))) == 0)
+        {
+            continue;
+        }
+
         switch (materialProperty)
         {
         case MaterialProperty::AmbientColor:
-            if (materialData.Get(AI_MATKEY_COLOR_AMBIENT, color) == aiReturn_SUCCESS)
-            {
-                material->SetUniformValue(location, glm::vec3(color.r, color.g, color.b));
-            }
+            material->SetUniformValue(location, materialData.ambientColor);
             break;
         case MaterialProperty::DiffuseColor:
-            if (materialData.Get(AI_MATKEY_COLOR_DIFFUSE, color) == aiReturn_SUCCESS)
-            {
-                material->SetUniformValue(location, glm::vec3(color.r, color.g, color.b));
-            }
+            material->SetUniformValue(location, materialData.diffuseColor);
             break;
         case MaterialProperty::SpecularColor:
-            if (materialData.Get(AI_MATKEY_COLOR_SPECULAR, color) == aiReturn_SUCCESS)
-            {
-                material->SetUniformValue(location, glm::vec3(color.r, color.g, color.b));
-            }
+            material->SetUniformValue(location, materialData.specularColor);
             break;
         case MaterialProperty::SpecularExponent:
-            if (materialData.Get(AI_MATKEY_SHININESS, value) == aiReturn_SUCCESS)
-            {
-                material->SetUniformValue(location, value);
-            }
+            material->SetUniformValue(location, materialData.specularExponent);
             break;
         case MaterialProperty::DiffuseTexture:
-            LoadTexture(materialData, aiTextureType_DIFFUSE, *material, location, TextureObject::FormatRGBA, TextureObject::InternalFormatSRGBA8);
+            LoadTexture(modelData, materialProperty, materialData.diffuseTexture, *material, location);
             break;
         case MaterialProperty::NormalTexture:
-            LoadTexture(materialData, aiTextureType_NORMALS, *material, location, TextureObject::FormatRGB, TextureObject::InternalFormatRGB8);
+            LoadTexture(modelData, materialProperty, materialData.normalTexture, *material, location);
             break;
         case MaterialProperty::SpecularTexture:
-            LoadTexture(materialData, aiTextureType_SHININESS, *material, location, TextureObject::FormatRGB, TextureObject::InternalFormatSRGB8);
+            LoadTexture(modelData, materialProperty, materialData.specularTexture, *material, location);
+            break;
+        case MaterialProperty::DiffuseTextureLayer:
+            material->SetUniformValue(location, GetTextureLayer(materialData.diffuseTexture));
+            break;
+        case MaterialProperty::NormalTextureLayer:
+            material->SetUniformValue(location, GetTextureLayer(materialData.normalTexture));
+            break;
+        case MaterialProperty::SpecularTextureLayer:
+            material->SetUniformValue(location, GetTextureLayer(materialData.specularTexture));
             break;
         }
     }
     return material;
 }
 
-void ModelLoader::LoadTexture(const aiMaterial& materialData, int textureTypeValue, Material& material, ShaderProgram::Location location,
-    TextureObject::Format format, TextureObject::InternalFormat internalFormat) const
+void ModelLoader::LoadTexture(ModelData& modelData, MaterialProperty materialProperty, const std::string& texturePath,
+    Material& material, ShaderProgram::Location location) const
 {
-    aiTextureType textureType = static_cast<aiTextureType>(textureTypeValue);
-    if (materialData.GetTextureCount(textureType) > 0)
+    TextureObject::Format format;
+    TextureObject::InternalFormat internalFormat;
+    GetTextureFormat(materialProperty, format, internalFormat);
+
+    std::string path = m_baseFolder + texturePath;
+    if (m_packTextures && !m_textureStreamer)
     {
-        assert(materialData.GetTextureCount(textureType) == 1);
-        aiString texturePath;
-        if (materialData.GetTexture(textureType, 0, &texturePath) == aiReturn_SUCCESS)
+        // The uniform samples the whole array, the layer is set by its own property
+        TextureArrayPacker::PackedTexture packedTexture;
+        if (m_textureArrayPacker.Find(path, packedTexture))
+        {
+            material.SetUniformValue(location, packedTexture.textureArray);
+        }
+        return;
+    }
+
+    std::shared_ptr<Texture2DObject> texture = m_textureLoader.FindShared(path.c_str());
+    if (!texture && m_textureStreamer)
+    {
+        texture = m_textureStreamer->Load(path.c_str(), format, internalFormat, m_textureLoader.GetFlipVertical(),
+            materialProperty == MaterialProperty::NormalTexture);
+    }
+    else if (!texture)
+    {
+        auto itTexture = modelData.textures.find(path);
+        if (itTexture != modelData.textures.end())
+        {
+            // Decoded in the worker thread, only the upload is left
+            texture = std::make_shared<Texture2DObject>(Texture2DLoader::CreateTexture(itTexture->second, format, internalFormat));
+            m_textureLoader.AddShared(path.c_str(), texture);
+            modelData.textures.erase(itTexture);
+        }
+        else
         {
-            texturePath = m_baseFolder + texturePath.C_Str();
             m_textureLoader.SetFormat(format);
             m_textureLoader.SetInternalFormat(internalFormat);
-            std::shared_ptr<Texture2DObject> texture = m_textureLoader.LoadShared(texturePath.C_Str());
-            material.SetUniformValue(location, texture);
+            m_textureLoader.GetMipmapGenerator().SetNormalMap(materialProperty == MaterialProperty::NormalTexture);
+            texture = m_textureLoader.LoadShared(path.c_str());
+        }
+    }
+    material.SetUniformValue(location, texture);
+}
+
+void ModelLoader::DecodeTextures(ModelData& modelData, unsigned int propertyMask, bool flipVertical, bool preferCompressed, const MipmapGenerator* generator)
+{
+    for (const MaterialData& materialData : modelData.materials)
+    {
+        const std::array<std::pair<MaterialProperty, const std::string*>, 3> textures = {
+            std::make_pair(MaterialProperty::DiffuseTexture, &materialData.diffuseTexture),
+            std::make_pair(MaterialProperty::NormalTexture, &materialData.normalTexture),
+            std::make_pair(MaterialProperty::SpecularTexture, &materialData.specularTexture),
+        };
+        for (auto& texture : textures)
+        {
+            unsigned int propertyBit = 1u << static_cast<unsigned int>(texture.first);
+            if ((materialData.propertyMask & propertyMask & propertyBit) == 0)
+            {
+                continue;
+            }
+
+            // Skip the textures already decoded, and the ones that Texture2DLoader loads from a compressed file
+            std::string path = modelData.baseFolder + *texture.second;
+            std::string compressedPath = Texture2DLoader::GetCompressedPath(path.c_str());
+            if (modelData.textures.contains(path) || compressedPath == path || (preferCompressed && std::filesystem::exists(compressedPath)))
+            {
+                continue;
+            }
+
+            TextureObject::Format format;
+            TextureObject::InternalFormat internalFormat;
+            GetTextureFormat(texture.first, format, internalFormat);
+
+            MipmapGenerator textureGenerator = generator ? *generator : MipmapGenerator();
+            textureGenerator.SetInternalFormat(internalFormat);
+            textureGenerator.SetNormalMap(texture.first == MaterialProperty::NormalTexture);
+
+            Texture2DLoader::MipChain mipChain;
+            if (Texture2DLoader::LoadMipChain(path.c_str(), format, internalFormat, flipVertical, generator ? &textureGenerator : nullptr, mipChain))
+            {
+                modelData.textures.emplace(path, std::move(mipChain));
+            }
+        }
+    }
+}
+
+void ModelLoader::PackTextures(ModelData& modelData)
+{
+    for (const MaterialData& materialData : modelData.materials)
+    {
+        const std::array<std::pair<MaterialProperty, const std::string*>, 3> textures = {
+            std::make_pair(MaterialProperty::DiffuseTexture, &materialData.diffuseTexture),
+            std::make_pair(MaterialProperty::NormalTexture, &materialData.normalTexture),
+            std::make_pair(MaterialProperty::SpecularTexture, &materialData.specularTexture),
+        };
+        for (auto& texture : textures)
+        {
+            unsigned int propertyBit = 1u << static_cast<unsigned int>(texture.first);
+            std::string path = modelData.baseFolder + *texture.second;
+            if ((materialData.propertyMask & propertyBit) == 0 || !m_materialPropertyMap.contains(texture.first)
+                || m_textureArrayPacker.Contains(path))
+            {
+                continue;
+            }
+
+            TextureObject::Format format;
+            TextureObject::InternalFormat internalFormat;
+            GetTextureFormat(texture.first, format, internalFormat);
+
+            // Use the levels decoded in the worker thread, or decode them now
+            // Compressed files can't be packed with the rest, the source image is always used
+            Texture2DLoader::MipChain mipChain;
+            auto itTexture = modelData.textures.find(path);
+            if (itTexture != modelData.textures.end())
+            {
+                mipChain = std::move(itTexture->second);
+                modelData.textures.erase(itTexture);
+            }
+            else
+            {
+                MipmapGenerator generator = m_textureLoader.GetMipmapGenerator();
+                generator.SetInternalFormat(internalFormat);
+                generator.SetNormalMap(texture.first == MaterialProperty::NormalTexture);
+                if (!Texture2DLoader::LoadMipChain(path.c_str(), format, internalFormat, m_textureLoader.GetFlipVertical(),
+                    m_textureLoader.GetGenerateMipmap() ? &generator : nullptr, mipChain))
+                {
+                    continue;
+                }
+            }
+
+            m_textureArrayPacker.Add(path, std::move(mipChain), format, internalFormat);
         }
     }
+
+    m_textureArrayPacker.Build();
+}
+
+GLint ModelLoader::GetTextureLayer(const std::string& texturePath) const
+{
+    TextureArrayPacker::PackedTexture packedTexture;
+    return m_textureArrayPacker.Find(m_baseFolder + texturePath, packedTexture) ? packedTexture.layer : 0;
+}
+
+ModelLoader::MaterialProperty ModelLoader::GetMaskProperty(MaterialProperty materialProperty)
+{
+    switch (materialProperty)
+    {
+    case MaterialProperty::DiffuseTextureLayer:
+        return MaterialProperty::DiffuseTexture;
+    case MaterialProperty::NormalTextureLayer:
+        return MaterialProperty::NormalTexture;
+    case MaterialProperty::SpecularTextureLayer:
+        return MaterialProperty::SpecularTexture;
+    default:
+        return materialProperty;
+    }
+}
+
+void ModelLoader::GetTextureFormat(MaterialProperty materialProperty, TextureObject::Format& format, TextureObject::InternalFormat& internalFormat)
+{
+    switch (materialProperty)
+    {
+    case MaterialProperty::DiffuseTexture:
+        format = TextureObject::FormatRGBA;
+        internalFormat = TextureObject::InternalFormatSRGBA8;
+        break;
+    case MaterialProperty::NormalTexture:
+        format = TextureObject::FormatRGB;
+        internalFormat = TextureObject::InternalFormatRGB8;
+        break;
+    case MaterialProperty::SpecularTexture:
+        format = TextureObject::FormatRGB;
+        internalFormat = TextureObject::InternalFormatSRGB8;
+        break;
+    default:
+        assert(false);
+        format = TextureObject::FormatInvalid;
+        internalFormat = TextureObject::InternalFormatInvalid;
+        break;
+    }
 }
 
-std::vector<GLubyte> ModelLoader::CollectVertexData(const aiMesh& meshData, VertexFormat& vertexFormat, bool interleaved)
+std::vector<GLubyte> ModelLoader::CollectVertexData(const aiMesh& meshData, VertexFormat& vertexFormat, bool interleaved, unsigned int threadCount)
 {
     vertexFormat.Clear();
 
@@ -236,68 +1616,131 @@ std::vector<GLubyte> ModelLoader::CollectVertexData(const aiMesh& meshData, Vert
     std::vector<GLubyte> vertexData;
     vertexData.resize(vertexFormat.GetSize() * meshData.mNumVertices);
 
-    // Pack the vertex data all together
+    // Resolve the layout of the attributes once, for all the blocks
+    struct AttributeCopy
+    {
+        VertexAttribute::Semantic semantic;
+        size_t size;
+        GLubyte* dstBuffer;
+        size_t dstStride;
+        const GLubyte* srcBuffer;
+        size_t srcStride;
+    };
+    std::vector<AttributeCopy> attributeCopies;
     auto it = vertexFormat.LayoutBegin(meshData.mNumVertices, interleaved);
     auto itEnd = vertexFormat.LayoutEnd();
     for (; it != itEnd; it++)
     {
         const VertexAttribute& attribute = it->GetAttribute();
-        int dstStride = it->GetStride();
-        void* dstBuffer = &vertexData[it->GetOffset()];
         int srcStride = 0;
         const void* srcBuffer = GetVertexDataPointer(meshData, attribute.GetSemantic(), srcStride);
         assert(srcBuffer);
-        CopyBuffer(dstBuffer, dstStride, srcBuffer, srcStride, meshData.mNumVertices, attribute.GetSize());
+        attributeCopies.push_back({ attribute.GetSemantic(), static_cast<size_t>(attribute.GetSize()),
+            &vertexData[it->GetOffset()], static_cast<size_t>(it->GetStride()), static_cast<const GLubyte*>(srcBuffer), static_cast<size_t>(srcStride) });
     }
 
+    // Pack the vertex data all together, one block of vertices at a time
+    unsigned int blockCount = (meshData.mNumVertices + s_vertexBlockSize - 1) / s_vertexBlockSize;
+    ParallelUtils::For(blockCount, [&](unsigned int blockIndex)
+        {
+            size_t first = static_cast<size_t>(blockIndex) * s_vertexBlockSize;
+            size_t count = std::min<size_t>(s_vertexBlockSize, meshData.mNumVertices - first);
+            for (const AttributeCopy& attributeCopy : attributeCopies)
+            {
+                GLubyte* dstBuffer = attributeCopy.dstBuffer + first * attributeCopy.dstStride;
+                const GLubyte* srcBuffer = attributeCopy.srcBuffer + first * attributeCopy.srcStride;
+                if (attributeCopy.semantic >= VertexAttribute::Semantic::Color0 && attributeCopy.semantic <= VertexAttribute::Semantic::Color7)
+                {
+                    // Colors are stored as floats, and packed as normalized bytes
+                    for (size_t i = 0; i < count; ++i, dstBuffer += attributeCopy.dstStride, srcBuffer += attributeCopy.srcStride)
+                    {
+                        glm::vec4 color;
+                        std::memcpy(&color, srcBuffer, sizeof(color));
+                        GLuint packedColor = glm::packUnorm4x8(color);
+                        std::memcpy(dstBuffer, &packedColor, sizeof(packedColor));
+                    }
+                }
+                else
+                {
+                    CopyBuffer(dstBuffer, attributeCopy.dstStride, srcBuffer, attributeCopy.srcStride, count, attributeCopy.size);
+                }
+            }
+        }, threadCount);
+
     return vertexData;
 }
 
 std::vector<GLubyte> ModelLoader::CollectElementData(const aiMesh& meshData, Data::Type& elementType,
     std::vector<Drawcall::Primitive>& primitives, std::vector<int>& elementCounts)
 {
-    std::vector<GLubyte> elementData;
-
     elementType = ElementBufferObject::GetSmallestType(meshData.mNumVertices);
     int elementSize = Data::GetTypeSize(elementType);
 
-    //Reserve max possible size
-    elementData.reserve(meshData.mNumFaces * elementSize * 3);
-
-    int numIndices = 0;
+    // Count the indices first, so the data is allocated only once
+    size_t indexCount = 0;
     for (unsigned int faceIndex = 0; faceIndex < meshData.mNumFaces; ++faceIndex)
     {
-        aiFace& face = meshData.mFaces[faceIndex];
+        indexCount += meshData.mFaces[faceIndex].mNumIndices;
+    }
+    std::vector<GLubyte> elementData(indexCount * elementSize);
+
+    switch (elementType)
+    {
+    case Data::Type::UByte:
+        CollectElements<GLubyte>(meshData, elementData, primitives, elementCounts);
+        break;
+    case Data::Type::UShort:
+        CollectElements<GLushort>(meshData, elementData, primitives, elementCounts);
+        break;
+    default:
+        CollectElements<GLuint>(meshData, elementData, primitives, elementCounts);
+        break;
+    }
 
-        int currentSize = static_cast<int>(elementData.size());
-        elementData.resize(currentSize + face.mNumIndices * elementSize);
+    return elementData;
+}
 
-        void* dstBuffer = &elementData[currentSize];
-        unsigned int dstStride = elementSize;
-        const void* srcBuffer = face.mIndices;
-        unsigned int srcStride = sizeof(*face.mIndices);
+template<typename T>
+void ModelLoader::CollectElements(const aiMesh& meshData, std::span<GLubyte> elementData,
+    std::vector<Drawcall::Primitive>& primitives, std::vector<int>& elementCounts)
+{
+    // The data comes from a vector of bytes, allocated with enough alignment for any element type
+    T* elements = reinterpret_cast<T*>(elementData.data());
+    size_t elementIndex = 0;
 
-        if (std::endian::native == std::endian::big)
-        {
-            intptr_t srcAddress = reinterpret_cast<intptr_t>(srcBuffer);
-            srcAddress += srcStride - elementSize;
-            srcBuffer = reinterpret_cast<const void*>(srcAddress);
-        }
-        CopyBuffer(dstBuffer, dstStride, srcBuffer, srcStride, face.mNumIndices, elementSize);
+    unsigned int numIndices = 0;
+    for (unsigned int faceIndex = 0; faceIndex < meshData.mNumFaces; ++faceIndex)
+    {
+        const aiFace& face = meshData.mFaces[faceIndex];
 
         if (numIndices != face.mNumIndices)
         {
             numIndices = face.mNumIndices;
             primitives.push_back(GetPrimitiveType(face.mNumIndices));
-            if (currentSize > 0)
+            if (elementIndex > 0)
             {
-                elementCounts.push_back(currentSize);
+                elementCounts.push_back(static_cast<int>(elementIndex * sizeof(T)));
             }
         }
-    }
-    elementCounts.push_back(static_cast<int>(elementData.size()));
 
-    return elementData;
+        // Triangles are the common case, with a fixed number of indices
+        T* faceElements = &elements[elementIndex];
+        if (face.mNumIndices == 3)
+        {
+            faceElements[0] = static_cast<T>(face.mIndices[0]);
+            faceElements[1] = static_cast<T>(face.mIndices[1]);
+            faceElements[2] = static_cast<T>(face.mIndices[2]);
+        }
+        else
+        {
+            for (unsigned int i = 0; i < face.mNumIndices; ++i)
+            {
+                faceElements[i] = static_cast<T>(face.mIndices[i]);
+            }
+        }
+        elementIndex += face.mNumIndices;
+    }
+    elementCounts.push_back(static_cast<int>(elementIndex * sizeof(T)));
 }
 
 const void* ModelLoader::GetVertexDataPointer(const aiMesh& meshData, VertexAttribute::Semantic semantic, int& stride)
@@ -358,17 +1801,43 @@ const void* ModelLoader::GetVertexDataPointer(const aiMesh& meshData, VertexAttr
     return data;
 }
 
+// Copy elements of a fixed size between strided buffers. The fixed size turns each copy into a few register moves
+template<size_t Size>
+static void CopyStrided(unsigned char* dstBytes, size_t dstStride, const unsigned char* srcBytes, size_t srcStride, size_t count)
+{
+    for (size_t i = 0; i < count; ++i, srcBytes += srcStride, dstBytes += dstStride)
+    {
+        std::memcpy(dstBytes, srcBytes, Size);
+    }
+}
+
 void ModelLoader::CopyBuffer(void* dstBuffer, size_t dstStride, const void* srcBuffer, size_t srcStride, size_t count, size_t size)
 {
+    const unsigned char* srcBytes = static_cast<const unsigned char*>(srcBuffer);
+    unsigned char* dstBytes = static_cast<unsigned char*>(dstBuffer);
     if (srcStride == size && (dstStride == 0 || dstStride == srcStride))
     {
         memcpy(dstBuffer, srcBuffer, size * count);
     }
+    else if (size == 4)
+    {
+        CopyStrided<4>(dstBytes, dstStride, srcBytes, srcStride, count);
+    }
+    else if (size == 8)
+    {
+        CopyStrided<8>(dstBytes, dstStride, srcBytes, srcStride, count);
+    }
+    else if (size == 12)
+    {
+        CopyStrided<12>(dstBytes, dstStride, srcBytes, srcStride, count);
+    }
+    else if (size == 16)
+    {
+        CopyStrided<16>(dstBytes, dstStride, srcBytes, srcStride, count);
+    }
     else
     {
-        const unsigned char* srcBytes = static_cast<const unsigned char*>(srcBuffer);
-        unsigned char* dstBytes = static_cast<unsigned char*>(dstBuffer);
-        for (int i = 0; i < count; ++i, srcBytes += srcStride, dstBytes += dstStride)
+        for (size_t i = 0; i < count; ++i, srcBytes += srcStride, dstBytes += dstStride)
         {
             memcpy(dstBytes, srcBytes, size);
         }
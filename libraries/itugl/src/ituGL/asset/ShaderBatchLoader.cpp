@@ -0,0 +1,205 @@
+#include <ituGL/asset/ShaderBatchLoader.h>
+
+#include <ituGL/asset/ShaderLoader.h>
+#include <ituGL/asset/ShaderProgramCache.h>
+#include <ituGL/core/DeviceGL.h>
+#include <GLFW/glfw3.h>
+#include <array>
+#include <cassert>
+#include <iostream>
+
+// Not included in the core profile loader, requested manually when the extension is available
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+ShaderBatchLoader::ShaderBatchLoader(const ShaderProgramCache* programCache)
+    : m_programCache(programCache), m_parallelCompileSupported(false)
+{
+    DeviceGL& device = DeviceGL::GetInstance();
+
+    const char* maxThreadsFunctionName = nullptr;
+    if (device.IsExtensionSupported("GL_KHR_parallel_shader_compile"))
+    {
+        maxThreadsFunctionName = "glMaxShaderCompilerThreadsKHR";
+    }
+    else if (device.IsExtensionSupported("GL_ARB_parallel_shader_compile"))
+    {
+        maxThreadsFunctionName = "glMaxShaderCompilerThreadsARB";
+    }
+
+    if (maxThreadsFunctionName)
+    {
+        m_parallelCompileSupported = true;
+
+        // Let the driver choose how many threads to use
+        auto maxShaderCompilerThreads = reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(glfwGetProcAddress(maxThreadsFunctionName));
+        if (maxShaderCompilerThreads)
+        {
+            maxShaderCompilerThreads(0xFFFFFFFF);
+        }
+    }
+}
+
+bool ShaderBatchLoader::IsParallelCompileSupported() const
+{
+    return m_parallelCompileSupported;
+}
+
+std::shared_ptr<ShaderProgram> ShaderBatchLoader::Add(std::span<const char*> vertexShaderPaths, std::span<const char*> fragmentShaderPaths,
+    const ReadyCallback& readyCallback)
+{
+    std::unique_ptr<PendingProgram> pendingProgram(new PendingProgram{ std::make_shared<ShaderProgram>(),
+        Shader(Shader::VertexShader), Shader(Shader::FragmentShader), readyCallback, {}, false, false });
+
+    pendingProgram->stageSources[0] = ShaderLoader::ReadSources(vertexShaderPaths);
+    pendingProgram->stageSources[1] = ShaderLoader::ReadSources(fragmentShaderPaths);
+
+    // A cached program is already linked, it only waits for the next Poll to call the callback
+    if (m_programCache && m_programCache->Load(*pendingProgram->shaderProgram, pendingProgram->stageSources))
+    {
+        pendingProgram->cached = true;
+    }
+    else
+    {
+        // Only set the source code here, compilation starts on Submit
+        std::vector<const char*> vertexSourceCode;
+        for (const std::string& source : pendingProgram->stageSources[0])
+        {
+            vertexSourceCode.push_back(source.c_str());
+        }
+        pendingProgram->vertexShader.SetSource(vertexSourceCode);
+
+        std::vector<const char*> fragmentSourceCode;
+        for (const std::string& source : pendingProgram->stageSources[1])
+        {
+            fragmentSourceCode.push_back(source.c_str());
+        }
+        pendingProgram->fragmentShader.SetSource(fragmentSourceCode);
+    }
+
+    std::shared_ptr<ShaderProgram> shaderProgram = pendingProgram->shaderProgram;
+    m_pendingPrograms.push_back(std::move(pendingProgram));
+    return shaderProgram;
+}
+
+std::shared_ptr<ShaderProgram> ShaderBatchLoader::Add(std::shared_ptr<Material> material,
+    std::span<const char*> vertexShaderPaths, std::span<const char*> fragmentShaderPaths,
+    const Material::NameSet& filteredUniforms, const ReadyCallback& readyCallback)
+{
+    assert(material);
+    return Add(vertexShaderPaths, fragmentShaderPaths,
+        [material, filteredUniforms, readyCallback](std::shared_ptr<ShaderProgram> shaderProgram)
+        {
+            material->ChangeShader(shaderProgram, filteredUniforms);
+            if (readyCallback)
+            {
+                readyCallback(shaderProgram);
+            }
+        });
+}
+
+void ShaderBatchLoader::Submit()
+{
+    // Submit all the shaders first, so the driver can compile them at the same time
+    for (std::unique_ptr<PendingProgram>& pendingProgram : m_pendingPrograms)
+    {
+        if (!pendingProgram->submitted && !pendingProgram->cached)
+        {
+            pendingProgram->vertexShader.BeginCompile();
+            pendingProgram->fragmentShader.BeginCompile();
+        }
+    }
+
+    // Then link the programs. Linking waits for the shaders in the driver threads, not here
+    for (std::unique_ptr<PendingProgram>& pendingProgram : m_pendingPrograms)
+    {
+        if (!pendingProgram->submitted)
+        {
+            if (!pendingProgram->cached)
+            {
+                pendingProgram->shaderProgram->SetBinaryRetrievable(m_programCache != nullptr);
+                pendingProgram->shaderProgram->BeginBuild(pendingProgram->vertexShader, pendingProgram->fragmentShader);
+            }
+            pendingProgram->submitted = true;
+        }
+    }
+}
+
+bool ShaderBatchLoader::Poll()
+{
+    // Completed programs are replaced with the last one, the order of the callbacks doesn't matter
+    for (size_t i = 0; i < m_pendingPrograms.size();)
+    {
+        if (IsComplete(*m_pendingPrograms[i]))
+        {
+            Complete(*m_pendingPrograms[i]);
+            std::swap(m_pendingPrograms[i], m_pendingPrograms.back());
+            m_pendingPrograms.pop_back();
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    return m_pendingPrograms.empty();
+}
+
+void ShaderBatchLoader::Wait()
+{
+    // Querying the status blocks until the linking is finished
+    for (std::unique_ptr<PendingProgram>& pendingProgram : m_pendingPrograms)
+    {
+        assert(pendingProgram->submitted);
+        Complete(*pendingProgram);
+    }
+    m_pendingPrograms.clear();
+}
+
+unsigned int ShaderBatchLoader::GetPendingCount() const
+{
+    return static_cast<unsigned int>(m_pendingPrograms.size());
+}
+
+bool ShaderBatchLoader::IsComplete(const PendingProgram& pendingProgram) const
+{
+    // Without the extension, we can't know without blocking, so we just wait
+    return pendingProgram.submitted && (pendingProgram.cached || !m_parallelCompileSupported ||
+        pendingProgram.shaderProgram->IsLinkingComplete());
+}
+
+void ShaderBatchLoader::Complete(PendingProgram& pendingProgram) const
+{
+    ShaderProgram& shaderProgram = *pendingProgram.shaderProgram;
+    if (shaderProgram.IsLinked())
+    {
+        if (m_programCache && !pendingProgram.cached)
+        {
+            m_programCache->Store(shaderProgram, pendingProgram.stageSources);
+        }
+
+        if (pendingProgram.readyCallback)
+        {
+            pendingProgram.readyCallback(pendingProgram.shaderProgram);
+        }
+    }
+    else if (CheckCompilation(pendingProgram.vertexShader) && CheckCompilation(pendingProgram.fragmentShader))
+    {
+        // Shaders compiled, so the error comes from linking
+        std::array<char, 512> infoLog;
+        shaderProgram.GetLinkingErrors(infoLog);
+        std::cout << "ERROR::PROGRAM::LINKING_FAILED\n" << infoLog.data() << std::endl;
+    }
+}
+
+bool ShaderBatchLoader::CheckCompilation(const Shader& shader)
+{
+    bool compiled = shader.IsCompiled();
+    if (!compiled)
+    {
+        std::array<char, 512> infoLog;
+        shader.GetCompilationErrors(infoLog);
+        const char* typeName = shader.IsType(Shader::VertexShader) ? "VERTEX" : "FRAGMENT";
+        std::cout << "ERROR::SHADER::" << typeName << "::COMPILATION_FAILED\n" << infoLog.data() << std::endl;
+    }
+    return compiled;
+}
@@ -35,18 +35,18 @@ Shader ShaderLoader::Load(const char* path)
 }
 
 Shader ShaderLoader::Load(std::span<const char*> paths)
+{
+    std::vector<std::string> sourceCodeStrings = ReadSources(paths);
+    return Load(sourceCodeStrings);
+}
+
+Shader ShaderLoader::Load(std::span<const std::string> sources)
 {
     Shader shader(m_type);
-    std::vector<std::stringstream> stringStreams(paths.size());
-    std::vector<std::string> sourceCodeStrings(paths.size());
-    std::vector<const char*> sourceCode(paths.size());
-    for (int i = 0; i < paths.size(); ++i)
+    std::vector<const char*> sourceCode(sources.size());
+    for (size_t i = 0; i < sources.size(); ++i)
     {
-        std::ifstream file(paths[i]);
-        assert(file.is_open());
-        stringStreams[i] << file.rdbuf() << '\0';
-        sourceCodeStrings[i] = stringStreams[i].str();
-        sourceCode[i] = sourceCodeStrings[i].c_str();
+        sourceCode[i] = sources[i].c_str();
     }
     shader.SetSource(sourceCode);
     Compile(shader);
@@ -111,3 +111,17 @@ Shader ShaderLoader::Load(Shader::Type type, const char* path)
     ShaderLoader shaderLoader(type);
     return shaderLoader.Load(path);
 }
+
+std::vector<std::string> ShaderLoader::ReadSources(std::span<const char*> paths)
+{
+    std::vector<std::string> sourceCodeStrings(paths.size());
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        std::ifstream file(paths[i]);
+        assert(file.is_open());
+        std::stringstream stringStream;
+        stringStream << file.rdbuf() << '\0';
+        sourceCodeStrings[i] = stringStream.str();
+    }
+    return sourceCodeStrings;
+}
@@ -0,0 +1,184 @@
+#include <ituGL/asset/ShaderProgramCache.h>
+
+#include <ituGL/asset/ShaderLoader.h>
+#include <ituGL/shader/Shader.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <array>
+#include <cstring>
+#include <cassert>
+
+// Header stored at the beginning of each cache file
+struct ShaderProgramCacheHeader
+{
+    // Identifies the file type and the version of the layout
+    unsigned int magic;
+    unsigned int version;
+    // Format of the binary returned by the driver
+    GLenum binaryFormat;
+    // Size in bytes of the binary that follows the header
+    unsigned int binarySize;
+};
+
+static const unsigned int s_cacheMagic = 0x50474c49; // "ILGP"
+static const unsigned int s_cacheVersion = 1;
+
+ShaderProgramCache::ShaderProgramCache(const char* cacheFolder) : m_cacheFolder(cacheFolder)
+{
+}
+
+const std::string& ShaderProgramCache::GetCacheFolder() const
+{
+    return m_cacheFolder;
+}
+
+void ShaderProgramCache::SetCacheFolder(const char* cacheFolder)
+{
+    m_cacheFolder = cacheFolder;
+}
+
+bool ShaderProgramCache::Build(ShaderProgram& shaderProgram, std::span<const char*> computeShaderPaths)
+{
+    std::array<std::vector<std::string>, 1> stageSources;
+    stageSources[0] = ShaderLoader::ReadSources(computeShaderPaths);
+
+    if (Load(shaderProgram, stageSources))
+    {
+        return true;
+    }
+
+    // Cache miss, build from source and store the result
+    Shader computeShader = ShaderLoader(Shader::ComputeShader).Load(stageSources[0]);
+    shaderProgram.SetBinaryRetrievable(true);
+    bool linked = shaderProgram.Build(computeShader);
+    if (linked)
+    {
+        Store(shaderProgram, stageSources);
+    }
+    return linked;
+}
+
+bool ShaderProgramCache::Build(ShaderProgram& shaderProgram, std::span<const char*> vertexShaderPaths, std::span<const char*> fragmentShaderPaths)
+{
+    std::array<std::vector<std::string>, 2> stageSources;
+    stageSources[0] = ShaderLoader::ReadSources(vertexShaderPaths);
+    stageSources[1] = ShaderLoader::ReadSources(fragmentShaderPaths);
+
+    if (Load(shaderProgram, stageSources))
+    {
+        return true;
+    }
+
+    // Cache miss, build from source and store the result
+    Shader vertexShader = ShaderLoader(Shader::VertexShader).Load(stageSources[0]);
+    Shader fragmentShader = ShaderLoader(Shader::FragmentShader).Load(stageSources[1]);
+    shaderProgram.SetBinaryRetrievable(true);
+    bool linked = shaderProgram.Build(vertexShader, fragmentShader);
+    if (linked)
+    {
+        Store(shaderProgram, stageSources);
+    }
+    return linked;
+}
+
+bool ShaderProgramCache::Load(ShaderProgram& shaderProgram, std::span<const std::vector<std::string>> stageSources) const
+{
+    return LoadBinary(shaderProgram, GetCacheFilePath(ComputeHash(stageSources)));
+}
+
+void ShaderProgramCache::Store(const ShaderProgram& shaderProgram, std::span<const std::vector<std::string>> stageSources) const
+{
+    SaveBinary(shaderProgram, GetCacheFilePath(ComputeHash(stageSources)));
+}
+
+unsigned long long ShaderProgramCache::ComputeHash(std::span<const std::vector<std::string>> stageSources)
+{
+    // 64-bit FNV-1a
+    unsigned long long hash = 14695981039346656037ull;
+    auto hashBytes = [&hash](const char* bytes, size_t size)
+    {
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash = (hash ^ static_cast<unsigned char>(bytes[i])) * 1099511628211ull;
+        }
+    };
+
+    // The binary is only valid for the same driver
+    std::array<GLenum, 3> driverStrings = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+    for (GLenum name : driverStrings)
+    {
+        const char* driverString = reinterpret_cast<const char*>(glGetString(name));
+        if (driverString)
+        {
+            hashBytes(driverString, std::strlen(driverString) + 1);
+        }
+    }
+
+    // Sources already include the null terminator. Add a separator between stages
+    for (const std::vector<std::string>& sources : stageSources)
+    {
+        for (const std::string& source : sources)
+        {
+            hashBytes(source.data(), source.size());
+        }
+        hashBytes("|", 1);
+    }
+    return hash;
+}
+
+std::string ShaderProgramCache::GetCacheFilePath(unsigned long long hash) const
+{
+    std::stringstream stringStream;
+    stringStream << m_cacheFolder << std::hex << std::setw(16) << std::setfill('0') << hash << ".bin";
+    return stringStream.str();
+}
+
+bool ShaderProgramCache::LoadBinary(ShaderProgram& shaderProgram, const std::string& cacheFilePath) const
+{
+    std::ifstream file(cacheFilePath, std::ios::binary);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    ShaderProgramCacheHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        header.magic != s_cacheMagic || header.version != s_cacheVersion)
+    {
+        return false;
+    }
+
+    std::vector<GLubyte> binary(header.binarySize);
+    if (!file.read(reinterpret_cast<char*>(binary.data()), binary.size()))
+    {
+        return false;
+    }
+
+    return shaderProgram.LoadBinary(header.binaryFormat, binary);
+}
+
+void ShaderProgramCache::SaveBinary(const ShaderProgram& shaderProgram, const std::string& cacheFilePath) const
+{
+    ShaderProgramCacheHeader header;
+    std::vector<GLubyte> binary;
+    if (!shaderProgram.GetBinary(header.binaryFormat, binary))
+    {
+        // Some drivers don't support any binary format
+        return;
+    }
+    header.magic = s_cacheMagic;
+    header.version = s_cacheVersion;
+    header.binarySize = static_cast<unsigned int>(binary.size());
+
+    std::error_code errorCode;
+    std::filesystem::create_directories(m_cacheFolder, errorCode);
+
+    std::ofstream file(cacheFilePath, std::ios::binary | std::ios::trunc);
+    if (file.is_open())
+    {
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(binary.data()), binary.size());
+    }
+}
@@ -1,15 +1,20 @@
 #include <ituGL/asset/Texture2DLoader.h>
 
+#include <ituGL/asset/DDSFile.h>
+#include <filesystem>
+#include <algorithm>
 #include <cassert>
 
 Texture2DLoader::Texture2DLoader()
     : m_flipVertical(false)
+    , m_preferCompressed(false)
 {
 }
 
 Texture2DLoader::Texture2DLoader(TextureObject::Format format, TextureObject::InternalFormat internalFormat)
     : TextureLoader(format, internalFormat)
     , m_flipVertical(false)
+    , m_preferCompressed(false)
 {
 }
 
@@ -17,41 +22,124 @@ Texture2DObject Texture2DLoader::Load(const char* path)
 {
     Texture2DObject texture2D;
 
+    // Compressed files contain the final texture, no decoding needed
+    std::string compressedPath = GetCompressedPath(path);
+    bool isCompressedPath = compressedPath == path;
+    if (isCompressedPath || (m_preferCompressed && std::filesystem::exists(compressedPath)))
+    {
+        if (LoadCompressed(compressedPath.c_str(), texture2D))
+        {
+            return texture2D;
+        }
+
+        // If the compressed file is broken, decode the original image instead. A .dds path has no image to fall back to
+        assert(!isCompressedPath);
+        if (isCompressedPath)
+        {
+            return texture2D;
+        }
+    }
+
+    // Decode the image and generate the mip levels on the CPU
+    m_mipmapGenerator.SetInternalFormat(m_internalFormat);
+    MipChain mipChain;
+    bool loaded = LoadMipChain(path, m_format, m_internalFormat, m_flipVertical, m_generateMipmap ? &m_mipmapGenerator : nullptr, mipChain);
+    assert(loaded);
+    if (loaded)
+    {
+        texture2D = CreateTexture(mipChain, m_format, m_internalFormat);
+    }
+    return texture2D;
+}
+
+bool Texture2DLoader::LoadMipChain(const char* path, TextureObject::Format format, TextureObject::InternalFormat internalFormat,
+    bool flipVertical, const MipmapGenerator* generator, MipChain& mipChain, int firstLevel)
+{
     // Load texture data using stbimage library
     int width, height;
     Data::Type dataType;
-    std::span<const std::byte> data = LoadTexture2DData(path, width, height, dataType, m_flipVertical);
+    std::span<const std::byte> data = TextureLoaderUtils::LoadTexture2DData(path, width, height, dataType, format, internalFormat, flipVertical);
+    if (data.empty())
+    {
+        return false;
+    }
 
-    // If data was loaded, copy it to the texture object
-    assert(!data.empty());
-    if (!data.empty())
+    mipChain.dataType = dataType;
+    if (generator)
+    {
+        // The image may have changed since the level was requested, the last level is always generated
+        mipChain.firstLevel = std::min(firstLevel, MipmapGenerator::GetLevelCount(width, height) - 1);
+        mipChain.levels = generator->Generate(data, width, height, TextureObject::GetComponentCount(format), dataType, mipChain.firstLevel);
+    }
+    else
     {
-        texture2D.Bind();
-        texture2D.SetImage<std::byte>(0, width, height, m_format, m_internalFormat, data, dataType);
+        mipChain.firstLevel = 0;
+        mipChain.levels.clear();
+        mipChain.levels.push_back(MipmapGenerator::Level{ width, height, std::vector<std::byte>(data.begin(), data.end()) });
+    }
 
-        texture2D.SetParameter(TextureObject::ParameterEnum::MinFilter, GL_LINEAR);
-        texture2D.SetParameter(TextureObject::ParameterEnum::MagFilter, GL_LINEAR);
+    // Free loaded data (not needed anymore)
+    TextureLoaderUtils::FreeTexture2DData(data);
+    return true;
+}
 
-        // Generate mipmap if needed
-        if (m_generateMipmap)
-        {
-            texture2D.GenerateMipmap();
-            texture2D.SetParameter(TextureObject::ParameterEnum::MinFilter, GL_LINEAR_MIPMAP_LINEAR);
+Texture2DObject Texture2DLoader::CreateTexture(const MipChain& mipChain, TextureObject::Format format, TextureObject::InternalFormat internalFormat)
+{
+    assert(!mipChain.levels.empty() && mipChain.firstLevel == 0);
 
-            // Adjust mip levels
-            texture2D.SetParameter(TextureObject::ParameterFloat::MinLod, 0.0f);
-            float maxLod = 1.0f + std::floorf(std::log2f(static_cast<float>(std::max(width, height))));
-            texture2D.SetParameter(TextureObject::ParameterFloat::MaxLod, maxLod);
-        }
+    Texture2DObject texture2D;
+    texture2D.Bind();
 
-        texture2D.Unbind();
+    GLsizei levelCount = static_cast<GLsizei>(mipChain.levels.size());
+    texture2D.SetStorage(levelCount, mipChain.levels[0].width, mipChain.levels[0].height, format, internalFormat);
 
-        // Free loaded data (not needed anymore)
-        FreeTexture2DData(data);
+    // Rows of the small levels are not aligned to 4 bytes
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (GLint level = 0; level < levelCount; ++level)
+    {
+        const MipmapGenerator::Level& levelData = mipChain.levels[level];
+        texture2D.SetSubImage(level, 0, 0, levelData.width, levelData.height, format, levelData.data, mipChain.dataType);
     }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    texture2D.SetParameter(TextureObject::ParameterEnum::MinFilter, levelCount > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    texture2D.SetParameter(TextureObject::ParameterEnum::MagFilter, GL_LINEAR);
+    texture2D.SetParameter(TextureObject::ParameterInt::MaxLevel, levelCount - 1);
+
+    texture2D.Unbind();
     return texture2D;
 }
 
+bool Texture2DLoader::LoadCompressed(const char* path, Texture2DObject& texture2D)
+{
+    DDSFile ddsFile;
+    if (!ddsFile.Load(path))
+    {
+        return false;
+    }
+
+    // Upload all the levels as they are stored
+    texture2D.Bind();
+    int levelCount = ddsFile.GetLevelCount();
+    for (int level = 0; level < levelCount; ++level)
+    {
+        texture2D.SetCompressedImage(level, ddsFile.GetLevelWidth(level), ddsFile.GetLevelHeight(level),
+            ddsFile.GetInternalFormat(), ddsFile.GetLevelData(level));
+    }
+
+    texture2D.SetParameter(TextureObject::ParameterEnum::MinFilter, levelCount > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    texture2D.SetParameter(TextureObject::ParameterEnum::MagFilter, GL_LINEAR);
+    texture2D.SetParameter(TextureObject::ParameterInt::MaxLevel, levelCount - 1);
+
+    texture2D.Unbind();
+    return true;
+}
+
+std::string Texture2DLoader::GetCompressedPath(const char* path)
+{
+    return std::filesystem::path(path).replace_extension(".dds").string();
+}
+
 std::shared_ptr<Texture2DObject> Texture2DLoader::LoadTextureShared(const char* path,
     TextureObject::Format format, TextureObject::InternalFormat internalFormat, bool generateMipmap, bool flipVertical)
 {
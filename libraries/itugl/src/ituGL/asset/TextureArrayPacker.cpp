@@ -0,0 +1,116 @@
+#include <ituGL/asset/TextureArrayPacker.h>
+
+#include <algorithm>
+#include <tuple>
+#include <cassert>
+
+TextureArrayPacker::TextureArrayPacker() : m_textureArrayCount(0)
+{
+}
+
+void TextureArrayPacker::Add(const std::string& path, Texture2DLoader::MipChain&& mipChain,
+    TextureObject::Format format, TextureObject::InternalFormat internalFormat)
+{
+    assert(!mipChain.levels.empty() && mipChain.firstLevel == 0);
+    if (!Contains(path))
+    {
+        m_pendingTextures.push_back(PendingTexture{ path, std::move(mipChain), format, internalFormat });
+    }
+}
+
+bool TextureArrayPacker::Contains(const std::string& path) const
+{
+    return m_packedTextures.contains(path) || std::any_of(m_pendingTextures.begin(), m_pendingTextures.end(),
+        [&](const PendingTexture& pendingTexture) { return pendingTexture.path == path; });
+}
+
+void TextureArrayPacker::Build()
+{
+    std::sort(m_pendingTextures.begin(), m_pendingTextures.end(), IsGroupOrder);
+
+    // Arrays can't grow after they are created, so each build creates new ones
+    const size_t maxLayerCount = static_cast<size_t>(Texture2DArrayObject::GetMaxLayerCount());
+    auto itGroupBegin = m_pendingTextures.begin();
+    while (itGroupBegin != m_pendingTextures.end())
+    {
+        auto itGroupEnd = std::find_if_not(itGroupBegin, m_pendingTextures.end(),
+            [&](const PendingTexture& pendingTexture) { return IsSameGroup(*itGroupBegin, pendingTexture); });
+
+        // Groups bigger than the layer limit are split in several arrays
+        size_t groupSize = static_cast<size_t>(itGroupEnd - itGroupBegin);
+        for (size_t first = 0; first < groupSize; first += maxLayerCount)
+        {
+            std::span<const PendingTexture> textures(&*itGroupBegin + first, std::min(maxLayerCount, groupSize - first));
+            std::shared_ptr<Texture2DArrayObject> textureArray = CreateTextureArray(textures);
+            for (size_t layer = 0; layer < textures.size(); ++layer)
+            {
+                m_packedTextures[textures[layer].path] = PackedTexture{ textureArray, static_cast<GLint>(layer) };
+            }
+        }
+
+        itGroupBegin = itGroupEnd;
+    }
+
+    m_pendingTextures.clear();
+}
+
+bool TextureArrayPacker::Find(const std::string& path, PackedTexture& packedTexture) const
+{
+    auto itPacked = m_packedTextures.find(path);
+    if (itPacked == m_packedTextures.end())
+    {
+        return false;
+    }
+    packedTexture = itPacked->second;
+    return true;
+}
+
+bool TextureArrayPacker::IsSameGroup(const PendingTexture& a, const PendingTexture& b)
+{
+    return !IsGroupOrder(a, b) && !IsGroupOrder(b, a);
+}
+
+bool TextureArrayPacker::IsGroupOrder(const PendingTexture& a, const PendingTexture& b)
+{
+    auto GetGroupKey = [](const PendingTexture& pendingTexture)
+    {
+        const MipmapGenerator::Level& level0 = pendingTexture.mipChain.levels[0];
+        return std::make_tuple(pendingTexture.internalFormat, pendingTexture.format, pendingTexture.mipChain.dataType,
+            level0.width, level0.height, pendingTexture.mipChain.levels.size());
+    };
+    return GetGroupKey(a) < GetGroupKey(b);
+}
+
+std::shared_ptr<Texture2DArrayObject> TextureArrayPacker::CreateTextureArray(std::span<const PendingTexture> textures)
+{
+    const PendingTexture& first = textures[0];
+    const std::vector<MipmapGenerator::Level>& firstLevels = first.mipChain.levels;
+    GLsizei levelCount = static_cast<GLsizei>(firstLevels.size());
+
+    std::shared_ptr<Texture2DArrayObject> textureArray = std::make_shared<Texture2DArrayObject>();
+    textureArray->Bind();
+    textureArray->SetStorage(levelCount, firstLevels[0].width, firstLevels[0].height, static_cast<GLsizei>(textures.size()),
+        first.format, first.internalFormat);
+
+    // Rows of the small levels are not aligned to 4 bytes
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (GLint layer = 0; layer < static_cast<GLint>(textures.size()); ++layer)
+    {
+        const Texture2DLoader::MipChain& mipChain = textures[layer].mipChain;
+        for (GLint level = 0; level < levelCount; ++level)
+        {
+            const MipmapGenerator::Level& levelData = mipChain.levels[level];
+            textureArray->SetSubImage(level, layer, levelData.width, levelData.height, first.format, levelData.data, mipChain.dataType);
+        }
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    textureArray->SetParameter(TextureObject::ParameterEnum::MinFilter, levelCount > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    textureArray->SetParameter(TextureObject::ParameterEnum::MagFilter, GL_LINEAR);
+    textureArray->SetParameter(TextureObject::ParameterInt::MaxLevel, levelCount - 1);
+
+    Texture2DArrayObject::Unbind();
+
+    m_textureArrayCount++;
+    return textureArray;
+}
@@ -1,7 +1,8 @@
 #include <ituGL/asset/TextureCubemapLoader.h>
 
+#include <algorithm>
+#include <cstring>
 #include <cassert>
-#include <stb_image.h>
 
 TextureCubemapLoader::TextureCubemapLoader()
 {
@@ -30,31 +31,56 @@ TextureCubemapObject TextureCubemapLoader::Load(const char* path)
 
         int side = width / 4;
 
-        textureCubemap.Bind();
-
-        int pixelSize = TextureObject::GetComponentCount(m_format) * Data::GetTypeSize(dataType);
-        std::vector<std::byte> faceData(side * side * pixelSize);
-        LoadFace(textureCubemap, TextureCubemapObject::Face::Left,   data, faceData, 0, 1, side, dataType);
-        LoadFace(textureCubemap, TextureCubemapObject::Face::Right,  data, faceData, 2, 1, side, dataType);
-        LoadFace(textureCubemap, TextureCubemapObject::Face::Bottom, data, faceData, 1, 2, side, dataType);
-        LoadFace(textureCubemap, TextureCubemapObject::Face::Top,    data, faceData, 1, 0, side, dataType);
-        LoadFace(textureCubemap, TextureCubemapObject::Face::Front,  data, faceData, 3, 1, side, dataType);
-        LoadFace(textureCubemap, TextureCubemapObject::Face::Back,   data, faceData, 1, 1, side, dataType);
+        // Extract the faces in GL order: +X, -X, +Y, -Y, +Z, -Z
+        std::array<std::vector<std::byte>, 6> faceData;
+        ExtractFace(data, faceData[0], 2, 1, side, dataType);
+        ExtractFace(data, faceData[1], 0, 1, side, dataType);
+        ExtractFace(data, faceData[2], 1, 0, side, dataType);
+        ExtractFace(data, faceData[3], 1, 2, side, dataType);
+        ExtractFace(data, faceData[4], 1, 1, side, dataType);
+        ExtractFace(data, faceData[5], 3, 1, side, dataType);
 
-        textureCubemap.SetParameter(TextureObject::ParameterEnum::MinFilter, GL_LINEAR);
-        textureCubemap.SetParameter(TextureObject::ParameterEnum::MagFilter, GL_LINEAR);
+        // Free loaded data (not needed anymore)
+        FreeTexture2DData(data);
 
-        // Generate mipmap if needed
+        // Generate mipmap if needed, on the CPU and in linear space
+        std::array<std::vector<MipmapGenerator::Level>, 6> faceLevels;
         if (m_generateMipmap)
         {
-            textureCubemap.GenerateMipmap();
-            textureCubemap.SetParameter(TextureObject::ParameterEnum::MinFilter, GL_LINEAR_MIPMAP_LINEAR);
+            m_mipmapGenerator.SetInternalFormat(m_internalFormat);
+            std::array<std::span<const std::byte>, 6> faces;
+            std::copy(faceData.begin(), faceData.end(), faces.begin());
+            faceLevels = m_mipmapGenerator.GenerateCubemap(faces, side, TextureObject::GetComponentCount(m_format), dataType);
+        }
+        else
+        {
+            for (int face = 0; face < 6; ++face)
+            {
+                faceLevels[face].push_back(MipmapGenerator::Level{ side, side, std::move(faceData[face]) });
+            }
+        }
+
+        textureCubemap.Bind();
+
+        GLsizei levelCount = static_cast<GLsizei>(faceLevels[0].size());
+        textureCubemap.SetStorage(levelCount, side, m_format, m_internalFormat);
 
-            // Adjust mip levels
-            textureCubemap.SetParameter(TextureObject::ParameterFloat::MinLod, 0.0f);
-            float maxLod = 1.0f + std::floorf(std::log2f(static_cast<float>(std::max(width, height))));
-            textureCubemap.SetParameter(TextureObject::ParameterFloat::MaxLod, maxLod);
+        // Rows of the small levels are not aligned to 4 bytes
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        for (int face = 0; face < 6; ++face)
+        {
+            TextureCubemapObject::Face faceTarget = static_cast<TextureCubemapObject::Face>(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face);
+            for (GLint level = 0; level < levelCount; ++level)
+            {
+                const MipmapGenerator::Level& levelData = faceLevels[face][level];
+                textureCubemap.SetSubImage(level, faceTarget, levelData.width, m_format, levelData.data, dataType);
+            }
         }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+        textureCubemap.SetParameter(TextureObject::ParameterEnum::MinFilter, levelCount > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+        textureCubemap.SetParameter(TextureObject::ParameterEnum::MagFilter, GL_LINEAR);
+        textureCubemap.SetParameter(TextureObject::ParameterInt::MaxLevel, levelCount - 1);
 
         // Clamp to edge to avoid filtering on the edges
         textureCubemap.SetParameter(TextureObject::ParameterEnum::WrapR, GL_CLAMP_TO_EDGE);
@@ -62,9 +88,6 @@ TextureCubemapObject TextureCubemapLoader::Load(const char* path)
         textureCubemap.SetParameter(TextureObject::ParameterEnum::WrapT, GL_CLAMP_TO_EDGE);
 
         textureCubemap.Unbind();
-
-        // Free loaded data (not needed anymore)
-        FreeTexture2DData(data);
     }
     return textureCubemap;
 }
@@ -77,21 +100,20 @@ std::shared_ptr<TextureCubemapObject> TextureCubemapLoader::LoadTextureShared(co
     return loader.LoadShared(path);
 }
 
-void TextureCubemapLoader::LoadFace(TextureCubemapObject& textureCubemap, TextureCubemapObject::Face face, std::span<const std::byte> dataSrc, std::span<std::byte> dataDst, int x, int y, int side, Data::Type dataType)
+void TextureCubemapLoader::ExtractFace(std::span<const std::byte> dataSrc, std::vector<std::byte>& dataDst, int x, int y, int side, Data::Type dataType)
 {
     int pixelSize = TextureObject::GetComponentCount(m_format) * Data::GetTypeSize(dataType);
     int rowSize = side * pixelSize;
     int stride = 4 * rowSize;
     int srcOffset = y * side * stride + x * rowSize;
     int dstOffset = 0;
+    dataDst.resize(side * rowSize);
     for (int i = 0; i < side; ++i)
     {
         assert(srcOffset + rowSize <= dataSrc.size());
         assert(dstOffset + rowSize <= dataDst.size());
-        memcpy(&dataDst[dstOffset], &dataSrc[srcOffset], rowSize);
+        std::memcpy(&dataDst[dstOffset], &dataSrc[srcOffset], rowSize);
         srcOffset += stride;
         dstOffset += rowSize;
     }
-
-    textureCubemap.SetImage<std::byte>(0, face, side, m_format, m_internalFormat, dataDst, dataType);
 }
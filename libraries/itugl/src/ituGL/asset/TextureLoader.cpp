@@ -3,6 +3,8 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
+#include <algorithm>
+
 std::span<const std::byte> TextureLoaderUtils::LoadTexture2DData(const char* path, int& width, int& height, Data::Type& dataType, TextureObject::Format format, TextureObject::InternalFormat internalFormat, bool flipVertical)
 {
     std::span<const std::byte> dataSpan;
@@ -10,9 +12,6 @@ std::span<const std::byte> TextureLoaderUtils::LoadTexture2DData(const char* pat
     int componentCount = TextureObject::GetComponentCount(format);
     int originalComponentCount;
 
-    // Set flip vertical on load if needed
-    stbi_set_flip_vertically_on_load(flipVertical ? 1 : 0);
-
     if (IsHDR(internalFormat))
     {
         float* data = stbi_loadf(path, &width, &height, &originalComponentCount, componentCount);
@@ -27,6 +26,17 @@ std::span<const std::byte> TextureLoaderUtils::LoadTexture2DData(const char* pat
         dataSpan = Data::GetBytes(dataSpanByte);
         dataType = Data::Type::UByte;
     }
+
+    // Flip vertical here instead of using stbi_set_flip_vertically_on_load, that is a global setting and not safe with several loading threads
+    if (flipVertical && !dataSpan.empty())
+    {
+        size_t rowSize = dataSpan.size() / height;
+        std::byte* rows = const_cast<std::byte*>(dataSpan.data());
+        for (int y = 0; y < height / 2; ++y)
+        {
+            std::swap_ranges(rows + y * rowSize, rows + (y + 1) * rowSize, rows + (height - 1 - y) * rowSize);
+        }
+    }
     return dataSpan;
 }
 
@@ -36,6 +46,13 @@ void TextureLoaderUtils::FreeTexture2DData(std::span<const std::byte> data)
     stbi_image_free(const_cast<void*>(dataPtr));
 }
 
+bool TextureLoaderUtils::GetTexture2DInfo(const char* path, int& width, int& height, Data::Type& dataType, TextureObject::InternalFormat internalFormat)
+{
+    int originalComponentCount;
+    dataType = IsHDR(internalFormat) ? Data::Type::Float : Data::Type::UByte;
+    return stbi_info(path, &width, &height, &originalComponentCount) != 0;
+}
+
 bool TextureLoaderUtils::IsHDR(TextureObject::InternalFormat internalFormat)
 {
     switch (internalFormat)
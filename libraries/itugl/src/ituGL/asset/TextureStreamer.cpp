@@ -0,0 +1,451 @@
+#include <ituGL/asset/TextureStreamer.h>
+
+#include <ituGL/asset/Texture2DLoader.h>
+#include <ituGL/asset/DDSFile.h>
+#include <ituGL/shader/Material.h>
+#include <filesystem>
+#include <iostream>
+#include <algorithm>
+#include <climits>
+#include <cfloat>
+#include <cmath>
+#include <cassert>
+
+TextureStreamer::TextureStreamer(size_t memoryBudget)
+    : m_memoryBudget(memoryBudget)
+    , m_residentMemory(0)
+    , m_pendingMemory(0)
+    , m_minResidentSize(64)
+    , m_feedbackFrame(0)
+    , m_stop(false)
+{
+    m_mipmapGenerator.SetFilter(MipmapGenerator::Filter::Kaiser);
+    m_thread = std::thread(&TextureStreamer::ProcessRequests, this);
+}
+
+TextureStreamer::~TextureStreamer()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_condition.notify_all();
+    m_thread.join();
+}
+
+std::shared_ptr<Texture2DObject> TextureStreamer::Load(const char* path, TextureObject::Format format, TextureObject::InternalFormat internalFormat,
+    bool flipVertical, bool normalMap)
+{
+    auto itPath = m_pathIndices.find(path);
+    if (itPath != m_pathIndices.end())
+    {
+        return m_textures[itPath->second].texture;
+    }
+
+    unsigned int textureIndex = static_cast<unsigned int>(m_textures.size());
+    StreamedTexture& streamedTexture = m_textures.emplace_back();
+    streamedTexture.path = path;
+    streamedTexture.format = format;
+    streamedTexture.internalFormat = internalFormat;
+    streamedTexture.flipVertical = flipVertical;
+    streamedTexture.normalMap = normalMap;
+    streamedTexture.width = 0;
+    streamedTexture.height = 0;
+    streamedTexture.levelCount = 0;
+    streamedTexture.pixelSize = 0;
+    streamedTexture.loading = false;
+    streamedTexture.failed = false;
+    streamedTexture.lastUsedFrame = 0;
+
+    // Read only the header to know the size, then load just the levels that are always resident
+    LoadedLevels loadedLevels;
+    bool loaded = LoadInfo(streamedTexture);
+    if (loaded)
+    {
+        streamedTexture.minResidentLevel = streamedTexture.levelCount - 1;
+        while (streamedTexture.minResidentLevel > 0 &&
+            std::max(streamedTexture.width, streamedTexture.height) >> (streamedTexture.minResidentLevel - 1) <= m_minResidentSize)
+        {
+            streamedTexture.minResidentLevel--;
+        }
+        streamedTexture.residentLevel = streamedTexture.levelCount;
+        streamedTexture.requestedLevel = streamedTexture.levelCount - 1;
+
+        loaded = LoadLevels(CreateRequest(textureIndex, streamedTexture.minResidentLevel, streamedTexture.levelCount), loadedLevels)
+            && loadedLevels.levelCount == streamedTexture.levelCount;
+    }
+    if (!loaded)
+    {
+        std::cout << "ERROR::TEXTURE_STREAMER::LOAD_FAILED\n" << path << std::endl;
+        m_textures.pop_back();
+        return nullptr;
+    }
+
+    // Not reserved as pending memory, it is uploaded right away
+    loadedLevels.memory = 0;
+
+    // Mutable storage, so the memory of the fine levels can be released. Levels under BaseLevel are not defined
+    streamedTexture.texture = std::make_shared<Texture2DObject>();
+    streamedTexture.texture->Bind();
+    streamedTexture.texture->SetParameter(TextureObject::ParameterEnum::MinFilter, GL_LINEAR_MIPMAP_LINEAR);
+    streamedTexture.texture->SetParameter(TextureObject::ParameterEnum::MagFilter, GL_LINEAR);
+    streamedTexture.texture->SetParameter(TextureObject::ParameterInt::MaxLevel, streamedTexture.levelCount - 1);
+    Texture2DObject::Unbind();
+    UploadLevels(loadedLevels);
+
+    m_pathIndices[streamedTexture.path] = textureIndex;
+    m_textureIndices[streamedTexture.texture.get()] = textureIndex;
+    return streamedTexture.texture;
+}
+
+unsigned int TextureStreamer::GetFeedbackId(const Material& material)
+{
+    auto itMaterial = m_materialFeedbackIds.find(&material);
+    if (itMaterial != m_materialFeedbackIds.end())
+    {
+        return itMaterial->second;
+    }
+
+    // Group the streamed textures of the material, they get the same feedback
+    std::vector<std::shared_ptr<const TextureObject>> textures;
+    material.GetTextures(textures);
+    std::vector<unsigned int> textureIndices;
+    for (const std::shared_ptr<const TextureObject>& texture : textures)
+    {
+        auto itTexture = m_textureIndices.find(texture.get());
+        if (itTexture != m_textureIndices.end())
+        {
+            textureIndices.push_back(itTexture->second);
+        }
+    }
+
+    unsigned int feedbackId = 0;
+    if (!textureIndices.empty())
+    {
+        m_feedbackGroups.push_back(std::move(textureIndices));
+        feedbackId = static_cast<unsigned int>(m_feedbackGroups.size());
+    }
+    m_materialFeedbackIds[&material] = feedbackId;
+    return feedbackId;
+}
+
+void TextureStreamer::ProcessFeedback(std::span<const float> feedback)
+{
+    m_feedbackFrame++;
+
+    // Finest derivative of each group, as the level it would need in a 1x1 texture
+    std::vector<float> groupLevels(m_feedbackGroups.size(), FLT_MAX);
+    for (size_t i = 0; i + 1 < feedback.size(); i += 2)
+    {
+        unsigned int feedbackId = static_cast<unsigned int>(feedback[i]);
+        if (feedbackId > 0 && feedbackId <= groupLevels.size())
+        {
+            groupLevels[feedbackId - 1] = std::min(groupLevels[feedbackId - 1], feedback[i + 1]);
+        }
+    }
+
+    // Textures not sampled in this frame don't request anything
+    for (StreamedTexture& streamedTexture : m_textures)
+    {
+        streamedTexture.requestedLevel = streamedTexture.levelCount - 1;
+    }
+
+    for (size_t group = 0; group < m_feedbackGroups.size(); ++group)
+    {
+        if (groupLevels[group] == FLT_MAX)
+        {
+            continue;
+        }
+        for (unsigned int textureIndex : m_feedbackGroups[group])
+        {
+            // Scale from a 1x1 texture to the size of the texture
+            StreamedTexture& streamedTexture = m_textures[textureIndex];
+            float level = groupLevels[group] + std::log2(static_cast<float>(std::max(streamedTexture.width, streamedTexture.height)));
+            int requestedLevel = std::clamp(static_cast<int>(std::floor(level)), 0, streamedTexture.levelCount - 1);
+            streamedTexture.requestedLevel = std::min(streamedTexture.requestedLevel, requestedLevel);
+            streamedTexture.lastUsedFrame = m_feedbackFrame;
+        }
+    }
+}
+
+void TextureStreamer::Update()
+{
+    // Upload the levels finished by the background thread
+    std::vector<LoadedLevels> loadedLevels;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        loadedLevels.swap(m_loadedLevels);
+    }
+    for (const LoadedLevels& levels : loadedLevels)
+    {
+        UploadLevels(levels);
+    }
+
+    // Request first the textures that are furthest from the level they need
+    std::vector<unsigned int> candidates;
+    for (unsigned int textureIndex = 0; textureIndex < m_textures.size(); ++textureIndex)
+    {
+        const StreamedTexture& streamedTexture = m_textures[textureIndex];
+        if (!streamedTexture.loading && !streamedTexture.failed && streamedTexture.requestedLevel < streamedTexture.residentLevel)
+        {
+            candidates.push_back(textureIndex);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [this](unsigned int a, unsigned int b)
+        {
+            return m_textures[a].residentLevel - m_textures[a].requestedLevel > m_textures[b].residentLevel - m_textures[b].requestedLevel;
+        });
+
+    std::vector<LoadRequest> requests;
+    for (unsigned int textureIndex : candidates)
+    {
+        StreamedTexture& streamedTexture = m_textures[textureIndex];
+        LoadRequest request = CreateRequest(textureIndex, streamedTexture.requestedLevel, streamedTexture.residentLevel);
+
+        // Only textures not sampled in the last feedback give memory to the new levels
+        if (!ReleaseMemory(request.memory, m_feedbackFrame))
+        {
+            break;
+        }
+        m_pendingMemory += request.memory;
+        streamedTexture.loading = true;
+        requests.push_back(std::move(request));
+    }
+
+    if (!requests.empty())
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            std::move(requests.begin(), requests.end(), std::back_inserter(m_requests));
+        }
+        m_condition.notify_one();
+    }
+
+    // If the budget was reduced, any texture can lose levels
+    ReleaseMemory(0, UINT_MAX);
+}
+
+bool TextureStreamer::LoadInfo(StreamedTexture& streamedTexture)
+{
+    std::string compressedPath = FindCompressedPath(streamedTexture.path);
+    if (!compressedPath.empty())
+    {
+        DDSFile ddsFile;
+        if (!ddsFile.LoadHeader(compressedPath.c_str()))
+        {
+            return false;
+        }
+
+        streamedTexture.internalFormat = ddsFile.GetInternalFormat();
+        streamedTexture.width = ddsFile.GetWidth();
+        streamedTexture.height = ddsFile.GetHeight();
+        streamedTexture.levelCount = ddsFile.GetLevelCount();
+        streamedTexture.pixelSize = 0;
+        return true;
+    }
+
+    Data::Type dataType;
+    if (!TextureLoaderUtils::GetTexture2DInfo(streamedTexture.path.c_str(), streamedTexture.width, streamedTexture.height, dataType, streamedTexture.internalFormat))
+    {
+        return false;
+    }
+
+    streamedTexture.levelCount = MipmapGenerator::GetLevelCount(streamedTexture.width, streamedTexture.height);
+    streamedTexture.pixelSize = TextureObject::GetComponentCount(streamedTexture.format) * Data::GetTypeSize(dataType);
+    return true;
+}
+
+bool TextureStreamer::LoadLevels(const LoadRequest& request, LoadedLevels& loadedLevels)
+{
+    loadedLevels.textureIndex = request.textureIndex;
+    loadedLevels.memory = request.memory;
+
+    // Compressed files already contain all the levels, the finer ones are not read
+    std::string compressedPath = FindCompressedPath(request.path);
+    if (!compressedPath.empty())
+    {
+        DDSFile ddsFile;
+        if (!ddsFile.Load(compressedPath.c_str(), request.firstLevel))
+        {
+            return false;
+        }
+
+        loadedLevels.levelCount = ddsFile.GetLevelCount();
+        loadedLevels.compressed = true;
+        loadedLevels.dataType = Data::Type::None;
+        loadedLevels.firstLevel = std::min(request.firstLevel, loadedLevels.levelCount);
+        int lastLevel = std::min(request.lastLevel, loadedLevels.levelCount);
+        loadedLevels.levels.clear();
+        for (int level = loadedLevels.firstLevel; level < lastLevel; ++level)
+        {
+            std::span<const std::byte> data = ddsFile.GetLevelData(level);
+            loadedLevels.levels.push_back(MipmapGenerator::Level{ ddsFile.GetLevelWidth(level), ddsFile.GetLevelHeight(level),
+                std::vector<std::byte>(data.begin(), data.end()) });
+        }
+        return true;
+    }
+
+    // The image is decoded whole, but only the levels from the first requested are generated
+    Texture2DLoader::MipChain mipChain;
+    if (!Texture2DLoader::LoadMipChain(request.path.c_str(), request.format, request.internalFormat, request.flipVertical, &request.generator,
+        mipChain, request.firstLevel))
+    {
+        return false;
+    }
+
+    loadedLevels.levelCount = mipChain.firstLevel + static_cast<int>(mipChain.levels.size());
+    loadedLevels.compressed = false;
+    loadedLevels.dataType = mipChain.dataType;
+    loadedLevels.firstLevel = mipChain.firstLevel;
+    int lastLevel = std::clamp(request.lastLevel, loadedLevels.firstLevel, loadedLevels.levelCount);
+    loadedLevels.levels.assign(std::make_move_iterator(mipChain.levels.begin()),
+        std::make_move_iterator(mipChain.levels.begin() + (lastLevel - loadedLevels.firstLevel)));
+    return true;
+}
+
+void TextureStreamer::UploadLevels(const LoadedLevels& loadedLevels)
+{
+    StreamedTexture& streamedTexture = m_textures[loadedLevels.textureIndex];
+    m_pendingMemory -= loadedLevels.memory;
+    streamedTexture.loading = false;
+
+    // The levels must connect with the resident ones, and the file must not have changed
+    int lastLevel = loadedLevels.firstLevel + static_cast<int>(loadedLevels.levels.size());
+    if (loadedLevels.levels.empty() || lastLevel != streamedTexture.residentLevel || loadedLevels.levelCount != streamedTexture.levelCount)
+    {
+        streamedTexture.failed = true;
+        return;
+    }
+
+    Texture2DObject& texture = *streamedTexture.texture;
+    texture.Bind();
+
+    // Rows of the small levels are not aligned to 4 bytes
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (size_t i = 0; i < loadedLevels.levels.size(); ++i)
+    {
+        const MipmapGenerator::Level& level = loadedLevels.levels[i];
+        GLint levelIndex = loadedLevels.firstLevel + static_cast<GLint>(i);
+        if (loadedLevels.compressed)
+        {
+            texture.SetCompressedImage(levelIndex, level.width, level.height, streamedTexture.internalFormat, level.data);
+        }
+        else
+        {
+            texture.SetImage<std::byte>(levelIndex, level.width, level.height, streamedTexture.format, streamedTexture.internalFormat, level.data, loadedLevels.dataType);
+        }
+        m_residentMemory += GetLevelMemory(streamedTexture, levelIndex);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    streamedTexture.residentLevel = loadedLevels.firstLevel;
+    texture.SetParameter(TextureObject::ParameterInt::BaseLevel, streamedTexture.residentLevel);
+    Texture2DObject::Unbind();
+}
+
+void TextureStreamer::ReleaseLevel(StreamedTexture& streamedTexture)
+{
+    assert(streamedTexture.residentLevel < streamedTexture.minResidentLevel);
+
+    Texture2DObject& texture = *streamedTexture.texture;
+    texture.Bind();
+    texture.SetParameter(TextureObject::ParameterInt::BaseLevel, streamedTexture.residentLevel + 1);
+    texture.ReleaseImage(streamedTexture.residentLevel, streamedTexture.format, streamedTexture.internalFormat);
+    Texture2DObject::Unbind();
+
+    m_residentMemory -= GetLevelMemory(streamedTexture, streamedTexture.residentLevel);
+    streamedTexture.residentLevel++;
+}
+
+bool TextureStreamer::ReleaseMemory(size_t requiredMemory, unsigned int protectedFrame)
+{
+    while (m_residentMemory + m_pendingMemory + requiredMemory > m_memoryBudget)
+    {
+        // Find the least recently used texture that has levels to release
+        StreamedTexture* leastRecentlyUsed = nullptr;
+        for (StreamedTexture& streamedTexture : m_textures)
+        {
+            if (!streamedTexture.loading && streamedTexture.residentLevel < streamedTexture.minResidentLevel &&
+                streamedTexture.lastUsedFrame < protectedFrame &&
+                (!leastRecentlyUsed || streamedTexture.lastUsedFrame < leastRecentlyUsed->lastUsedFrame))
+            {
+                leastRecentlyUsed = &streamedTexture;
+            }
+        }
+
+        if (!leastRecentlyUsed)
+        {
+            return false;
+        }
+        ReleaseLevel(*leastRecentlyUsed);
+    }
+    return true;
+}
+
+size_t TextureStreamer::GetLevelMemory(const StreamedTexture& streamedTexture, int level)
+{
+    GLsizei width = std::max(streamedTexture.width >> level, 1);
+    GLsizei height = std::max(streamedTexture.height >> level, 1);
+    return streamedTexture.pixelSize > 0 ? static_cast<size_t>(width) * height * streamedTexture.pixelSize
+        : TextureObject::GetCompressedImageSize(streamedTexture.internalFormat, width, height);
+}
+
+std::string TextureStreamer::FindCompressedPath(const std::string& path)
+{
+    std::string compressedPath = Texture2DLoader::GetCompressedPath(path.c_str());
+    return compressedPath == path || std::filesystem::exists(compressedPath) ? compressedPath : std::string();
+}
+
+TextureStreamer::LoadRequest TextureStreamer::CreateRequest(unsigned int textureIndex, int firstLevel, int lastLevel) const
+{
+    const StreamedTexture& streamedTexture = m_textures[textureIndex];
+
+    LoadRequest request;
+    request.textureIndex = textureIndex;
+    request.path = streamedTexture.path;
+    request.format = streamedTexture.format;
+    request.internalFormat = streamedTexture.internalFormat;
+    request.flipVertical = streamedTexture.flipVertical;
+    request.generator = m_mipmapGenerator;
+    request.generator.SetInternalFormat(streamedTexture.internalFormat);
+    request.generator.SetNormalMap(streamedTexture.normalMap);
+    request.firstLevel = firstLevel;
+    request.lastLevel = lastLevel;
+    request.memory = 0;
+    if (lastLevel <= streamedTexture.levelCount)
+    {
+        for (int level = firstLevel; level < lastLevel; ++level)
+        {
+            request.memory += GetLevelMemory(streamedTexture, level);
+        }
+    }
+    return request;
+}
+
+void TextureStreamer::ProcessRequests()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_condition.wait(lock, [this]() { return m_stop || !m_requests.empty(); });
+        if (m_stop)
+        {
+            break;
+        }
+
+        LoadRequest request = std::move(m_requests.front());
+        m_requests.pop_front();
+
+        // Decode without holding the lock
+        lock.unlock();
+        LoadedLevels loadedLevels;
+        if (!LoadLevels(request, loadedLevels))
+        {
+            // An empty result still clears the loading state
+            loadedLevels.levels.clear();
+        }
+        lock.lock();
+
+        m_loadedLevels.push_back(std::move(loadedLevels));
+    }
+}
@@ -63,3 +63,38 @@ void BufferObject::UpdateData(std::span<const std::byte> data, size_t offset)
     Target target = GetTarget();
     glBufferSubData(target, offset, data.size_bytes(), data.data());
 }
+
+std::span<std::byte> BufferObject::MapData(size_t size, size_t offset)
+{
+    assert(IsBound());
+    Target target = GetTarget();
+    void* data = glMapBufferRange(target, offset, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    return data ? std::span<std::byte>(static_cast<std::byte*>(data), size) : std::span<std::byte>();
+}
+
+bool BufferObject::UnmapData()
+{
+    assert(IsBound());
+    Target target = GetTarget();
+    return glUnmapBuffer(target) == GL_TRUE;
+}
+
+// Use the copy targets, so the buffers bound to the other targets are not modified
+void BufferObject::CopyData(const BufferObject& source, size_t size, size_t sourceOffset, size_t offset)
+{
+    glBindBuffer(GL_COPY_READ_BUFFER, source.GetHandle());
+    glBindBuffer(GL_COPY_WRITE_BUFFER, GetHandle());
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, sourceOffset, offset, size);
+    glBindBuffer(GL_COPY_READ_BUFFER, NullHandle);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, NullHandle);
+}
+
+void BufferObject::BindBase(Target target, GLuint index) const
+{
+    glBindBufferBase(target, index, GetHandle());
+}
+
+void BufferObject::UnbindBase(Target target, GLuint index)
+{
+    glBindBufferBase(target, index, NullHandle);
+}
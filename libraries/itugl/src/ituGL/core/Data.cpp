@@ -18,3 +18,8 @@ unsigned int Data::GetTypeSize(Type type)
         return 4;
     }
 }
+
+bool Data::IsPacked(Type type)
+{
+    return type == Type::Int2101010Rev || type == Type::UInt2101010Rev;
+}
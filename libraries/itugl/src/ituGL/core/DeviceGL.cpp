@@ -82,6 +82,13 @@ void DeviceGL::Clear(bool clearColor, const Color& color, bool clearDepth, GLdou
     glClear(mask);
 }
 
+// Check if an OpenGL extension is supported by the current context
+bool DeviceGL::IsExtensionSupported(const char* extension) const
+{
+    assert(m_contextLoaded);
+    return glfwExtensionSupported(extension) == GLFW_TRUE;
+}
+
 // Get if a feature is enabled
 bool DeviceGL::IsFeatureEnabled(GLenum feature) const
 {
@@ -0,0 +1,237 @@
+#include <ituGL/geometry/Bvh.h>
+
+#include <algorithm>
+#include <numeric>
+#include <cassert>
+
+Bvh::Bvh()
+{
+}
+
+void Bvh::Build(std::span<const glm::vec3> boundsMin, std::span<const glm::vec3> boundsMax, unsigned int maxLeafSize)
+{
+    assert(boundsMin.size() == boundsMax.size());
+    assert(maxLeafSize > 0);
+
+    m_nodes.clear();
+    m_primitiveIndices.resize(boundsMin.size());
+    std::iota(m_primitiveIndices.begin(), m_primitiveIndices.end(), 0u);
+    if (boundsMin.empty())
+        return;
+
+    // A binary tree with leaves of at least one primitive has less than 2 nodes per primitive
+    m_nodes.reserve(2 * boundsMin.size());
+    m_nodes.push_back(Node{ glm::vec3(0.0f), 0, glm::vec3(0.0f), static_cast<unsigned int>(boundsMin.size()) });
+
+    // Nodes are split in the order they are created, so children always come after their parent
+    std::vector<std::pair<unsigned int, unsigned int>> stack;
+    stack.emplace_back(0, 0);
+    while (!stack.empty())
+    {
+        auto [nodeIndex, depth] = stack.back();
+        stack.pop_back();
+
+        // Deep nodes are split in the middle, to keep the traversal stack bounded
+        UpdateLeafBounds(m_nodes[nodeIndex], boundsMin, boundsMax);
+        if (SplitNode(nodeIndex, boundsMin, boundsMax, depth < s_maxDepth / 2 ? maxLeafSize : 0))
+        {
+            unsigned int firstChild = m_nodes[nodeIndex].firstIndex;
+            stack.emplace_back(firstChild + 1, depth + 1);
+            stack.emplace_back(firstChild, depth + 1);
+        }
+    }
+}
+
+bool Bvh::SplitNode(unsigned int nodeIndex, std::span<const glm::vec3> boundsMin, std::span<const glm::vec3> boundsMax, unsigned int maxLeafSize)
+{
+    Node node = m_nodes[nodeIndex];
+    unsigned int first = node.firstIndex;
+    unsigned int count = node.primitiveCount;
+    if (count <= 1)
+        return false;
+
+    auto GetCentroid = [&](unsigned int primitive) { return (boundsMin[primitive] + boundsMax[primitive]) * 0.5f; };
+
+    glm::vec3 centroidMin(std::numeric_limits<float>::max());
+    glm::vec3 centroidMax(std::numeric_limits<float>::lowest());
+    for (unsigned int i = first; i < first + count; ++i)
+    {
+        glm::vec3 centroid = GetCentroid(m_primitiveIndices[i]);
+        centroidMin = glm::min(centroidMin, centroid);
+        centroidMax = glm::max(centroidMax, centroid);
+    }
+
+    // Evaluate the cost of splitting between the bins of each axis
+    int bestAxis = -1;
+    unsigned int bestSplit = 0;
+    float bestCost = std::numeric_limits<float>::max();
+    if (maxLeafSize > 0)
+    {
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            float extent = centroidMax[axis] - centroidMin[axis];
+            if (extent <= 0.0f)
+                continue;
+
+            struct Bin
+            {
+                glm::vec3 boundsMin = glm::vec3(std::numeric_limits<float>::max());
+                glm::vec3 boundsMax = glm::vec3(std::numeric_limits<float>::lowest());
+                unsigned int count = 0;
+            };
+            Bin bins[s_binCount];
+            float binScale = s_binCount / extent;
+            for (unsigned int i = first; i < first + count; ++i)
+            {
+                unsigned int primitive = m_primitiveIndices[i];
+                unsigned int binIndex = std::min(static_cast<unsigned int>((GetCentroid(primitive)[axis] - centroidMin[axis]) * binScale), s_binCount - 1);
+                Bin& bin = bins[binIndex];
+                bin.boundsMin = glm::min(bin.boundsMin, boundsMin[primitive]);
+                bin.boundsMax = glm::max(bin.boundsMax, boundsMax[primitive]);
+                ++bin.count;
+            }
+
+            // Sweep from the right to get the area and count on that side of each split
+            float rightAreas[s_binCount];
+            unsigned int rightCounts[s_binCount];
+            Bin right;
+            for (unsigned int i = s_binCount - 1; i > 0; --i)
+            {
+                right.boundsMin = glm::min(right.boundsMin, bins[i].boundsMin);
+                right.boundsMax = glm::max(right.boundsMax, bins[i].boundsMax);
+                right.count += bins[i].count;
+                rightAreas[i] = right.count > 0 ? GetSurfaceArea(right.boundsMin, right.boundsMax) : 0.0f;
+                rightCounts[i] = right.count;
+            }
+
+            Bin left;
+            for (unsigned int i = 0; i < s_binCount - 1; ++i)
+            {
+                left.boundsMin = glm::min(left.boundsMin, bins[i].boundsMin);
+                left.boundsMax = glm::max(left.boundsMax, bins[i].boundsMax);
+                left.count += bins[i].count;
+                if (left.count == 0 || rightCounts[i + 1] == 0)
+                    continue;
+
+                float cost = GetSurfaceArea(left.boundsMin, left.boundsMax) * left.count + rightAreas[i + 1] * rightCounts[i + 1];
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = i + 1;
+                }
+            }
+        }
+    }
+
+    unsigned int* begin = m_primitiveIndices.data() + first;
+    unsigned int* end = begin + count;
+    unsigned int* middle = nullptr;
+    if (bestAxis >= 0)
+    {
+        // Keep the node as a leaf if testing all its primitives is cheaper than traversing the split
+        float nodeArea = GetSurfaceArea(node.boundsMin, node.boundsMax);
+        float splitCost = 1.0f + (nodeArea > 0.0f ? bestCost / nodeArea : static_cast<float>(count));
+        if (count <= maxLeafSize && splitCost >= static_cast<float>(count))
+            return false;
+
+        float binScale = s_binCount / (centroidMax[bestAxis] - centroidMin[bestAxis]);
+        middle = std::partition(begin, end, [&](unsigned int primitive)
+            {
+                unsigned int binIndex = std::min(static_cast<unsigned int>((GetCentroid(primitive)[bestAxis] - centroidMin[bestAxis]) * binScale), s_binCount - 1);
+                return binIndex < bestSplit;
+            });
+    }
+    else
+    {
+        if (maxLeafSize > 0 && count <= maxLeafSize)
+            return false;
+
+        // No useful split, or too deep: split by count along the longest axis of the centroids
+        glm::vec3 extent = centroidMax - centroidMin;
+        int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+        middle = begin + count / 2;
+        std::nth_element(begin, middle, end, [&](unsigned int a, unsigned int b) { return GetCentroid(a)[axis] < GetCentroid(b)[axis]; });
+    }
+
+    unsigned int leftCount = static_cast<unsigned int>(middle - begin);
+    assert(leftCount > 0 && leftCount < count);
+
+    unsigned int firstChild = static_cast<unsigned int>(m_nodes.size());
+    m_nodes.push_back(Node{ glm::vec3(0.0f), first, glm::vec3(0.0f), leftCount });
+    m_nodes.push_back(Node{ glm::vec3(0.0f), first + leftCount, glm::vec3(0.0f), count - leftCount });
+
+    Node& splitNode = m_nodes[nodeIndex];
+    splitNode.firstIndex = firstChild;
+    splitNode.primitiveCount = 0;
+    return true;
+}
+
+void Bvh::UpdateLeafBounds(Node& node, std::span<const glm::vec3> boundsMin, std::span<const glm::vec3> boundsMax) const
+{
+    node.boundsMin = glm::vec3(std::numeric_limits<float>::max());
+    node.boundsMax = glm::vec3(std::numeric_limits<float>::lowest());
+    for (unsigned int i = node.firstIndex; i < node.firstIndex + node.primitiveCount; ++i)
+    {
+        unsigned int primitive = m_primitiveIndices[i];
+        node.boundsMin = glm::min(node.boundsMin, boundsMin[primitive]);
+        node.boundsMax = glm::max(node.boundsMax, boundsMax[primitive]);
+    }
+}
+
+void Bvh::Refit(std::span<const glm::vec3> boundsMin, std::span<const glm::vec3> boundsMax)
+{
+    assert(boundsMin.size() == m_primitiveIndices.size());
+    assert(boundsMax.size() == m_primitiveIndices.size());
+
+    // Children come after their parent, so going backwards updates them first
+    for (auto it = m_nodes.rbegin(); it != m_nodes.rend(); ++it)
+    {
+        Node& node = *it;
+        if (node.IsLeaf())
+        {
+            UpdateLeafBounds(node, boundsMin, boundsMax);
+        }
+        else
+        {
+            const Node& first = m_nodes[node.firstIndex];
+            const Node& second = m_nodes[node.firstIndex + 1];
+            node.boundsMin = glm::min(first.boundsMin, second.boundsMin);
+            node.boundsMax = glm::max(first.boundsMax, second.boundsMax);
+        }
+    }
+}
+
+float Bvh::GetCost() const
+{
+    if (m_nodes.empty())
+        return 0.0f;
+
+    // Traversing a node costs as much as testing a primitive, weighted by the probability of reaching it
+    float cost = 0.0f;
+    for (const Node& node : m_nodes)
+    {
+        cost += GetSurfaceArea(node.boundsMin, node.boundsMax) * (node.IsLeaf() ? node.primitiveCount : 1.0f);
+    }
+    float rootArea = GetSurfaceArea(m_nodes[0].boundsMin, m_nodes[0].boundsMax);
+    return rootArea > 0.0f ? cost / rootArea : static_cast<float>(m_nodes.size());
+}
+
+bool Bvh::IntersectsRay(const glm::vec3& boundsMin, const glm::vec3& boundsMax,
+    const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance, float& distance)
+{
+    glm::vec3 t0 = (boundsMin - origin) * inverseDirection;
+    glm::vec3 t1 = (boundsMax - origin) * inverseDirection;
+    glm::vec3 tNear = glm::min(t0, t1);
+    glm::vec3 tFar = glm::max(t0, t1);
+    float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+    float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+    distance = enter;
+    return enter <= exit;
+}
+
+float Bvh::GetSurfaceArea(const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+    glm::vec3 size = glm::max(boundsMax - boundsMin, glm::vec3(0.0f));
+    return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
@@ -42,3 +42,36 @@ void Drawcall::Draw() const
         glDrawElements(primitive, m_count, static_cast<GLenum>(m_eboType), basePointer + m_first);
     }
 }
+
+void Drawcall::DrawInstanced(GLsizei instanceCount) const
+{
+    assert(IsValid());
+    assert(VertexArrayObject::IsAnyBound());
+    assert(instanceCount >= 0);
+
+    GLenum primitive = static_cast<GLenum>(m_primitive);
+    if (m_eboType == Data::Type::None)
+    {
+        glDrawArraysInstanced(primitive, m_first, m_count, instanceCount);
+    }
+    else
+    {
+        assert(ElementBufferObject::IsSupportedType(m_eboType));
+        const char* basePointer = nullptr; // Actual element pointer is in VAO
+        glDrawElementsInstanced(primitive, m_count, static_cast<GLenum>(m_eboType), basePointer + m_first, instanceCount);
+    }
+}
+
+void Drawcall::DrawRanges(std::span<const void* const> elementOffsets, std::span<const GLsizei> counts) const
+{
+    assert(IsValid());
+    assert(VertexArrayObject::IsAnyBound());
+    assert(ElementBufferObject::IsSupportedType(m_eboType));
+    assert(elementOffsets.size() == counts.size());
+
+    if (!counts.empty())
+    {
+        glMultiDrawElements(static_cast<GLenum>(m_primitive), counts.data(), static_cast<GLenum>(m_eboType),
+            elementOffsets.data(), static_cast<GLsizei>(counts.size()));
+    }
+}
@@ -1,6 +1,10 @@
 #include <ituGL/geometry/Mesh.h>
 
-Mesh::Mesh()
+#include <glm/geometric.hpp>
+#include <cassert>
+#include <cmath>
+
+Mesh::Mesh() : m_hasBounds(false), m_bounds{}, m_boundsVersion(0)
 {
 }
 
@@ -26,6 +30,17 @@ unsigned int Mesh::AddSubmesh(unsigned int vaoIndex, const Drawcall& drawcall)
     Submesh& submesh = m_submeshes.emplace_back();
     submesh.vaoIndex = vaoIndex;
     submesh.drawcall = drawcall;
+    submesh.hasLocalMatrix = false;
+    submesh.localMatrix = glm::mat4(1.0f);
+    submesh.hasBounds = false;
+    submesh.bounds = MeshBounds{};
+
+    // The new submesh has no bounds yet
+    if (m_hasBounds)
+    {
+        m_hasBounds = false;
+        ++m_boundsVersion;
+    }
     return submeshIndex;
 }
 
@@ -35,6 +50,176 @@ unsigned int Mesh::AddSubmesh(unsigned int vaoIndex,
     return AddSubmesh(vaoIndex, Drawcall(primitive, count, eboType, first));
 }
 
+void Mesh::SetSubmeshLocalMatrix(unsigned int submeshIndex, const glm::mat4& localMatrix)
+{
+    Submesh& submesh = GetSubmesh(submeshIndex);
+    submesh.hasLocalMatrix = true;
+    submesh.localMatrix = localMatrix;
+}
+
+void Mesh::SetSubmeshMeshlets(unsigned int submeshIndex, std::vector<Meshlet> meshlets)
+{
+    GetSubmesh(submeshIndex).meshlets = std::move(meshlets);
+}
+
+void Mesh::SetSubmeshBounds(unsigned int submeshIndex, const MeshBounds& bounds)
+{
+    Submesh& submesh = GetSubmesh(submeshIndex);
+    submesh.hasBounds = true;
+    submesh.bounds = bounds;
+    UpdateBounds();
+}
+
+void Mesh::UpdateBounds()
+{
+    m_hasBounds = !m_submeshes.empty();
+    for (const Submesh& submesh : m_submeshes)
+    {
+        m_hasBounds = m_hasBounds && submesh.hasBounds;
+    }
+    ++m_boundsVersion;
+    if (!m_hasBounds)
+    {
+        return;
+    }
+
+    m_bounds = m_submeshes[0].bounds;
+    if (m_submeshes.size() == 1)
+    {
+        return;
+    }
+
+    glm::vec3 boundsMin = m_bounds.aabbCenter - m_bounds.aabbExtents;
+    glm::vec3 boundsMax = m_bounds.aabbCenter + m_bounds.aabbExtents;
+    for (size_t submeshIndex = 1; submeshIndex < m_submeshes.size(); ++submeshIndex)
+    {
+        const MeshBounds& bounds = m_submeshes[submeshIndex].bounds;
+        boundsMin = glm::min(boundsMin, bounds.aabbCenter - bounds.aabbExtents);
+        boundsMax = glm::max(boundsMax, bounds.aabbCenter + bounds.aabbExtents);
+
+        // Smallest sphere around both spheres
+        glm::vec3 offset = bounds.sphereCenter - m_bounds.sphereCenter;
+        float distance = glm::length(offset);
+        if (distance + bounds.sphereRadius <= m_bounds.sphereRadius)
+        {
+            continue;
+        }
+        if (distance + m_bounds.sphereRadius <= bounds.sphereRadius)
+        {
+            m_bounds.sphereCenter = bounds.sphereCenter;
+            m_bounds.sphereRadius = bounds.sphereRadius;
+            continue;
+        }
+        float radius = 0.5f * (distance + m_bounds.sphereRadius + bounds.sphereRadius);
+        m_bounds.sphereCenter += offset * ((radius - m_bounds.sphereRadius) / distance);
+        m_bounds.sphereRadius = radius;
+    }
+    m_bounds.aabbCenter = 0.5f * (boundsMin + boundsMax);
+    m_bounds.aabbExtents = 0.5f * (boundsMax - boundsMin);
+
+    // The sphere around the corners of the box can be smaller than the merged spheres
+    float boxRadius = glm::length(m_bounds.aabbExtents);
+    if (boxRadius < m_bounds.sphereRadius)
+    {
+        m_bounds.sphereCenter = m_bounds.aabbCenter;
+        m_bounds.sphereRadius = boxRadius;
+    }
+
+    m_bounds.boxCenter = m_bounds.aabbCenter;
+    m_bounds.boxAxes = glm::mat3(1.0f);
+    m_bounds.boxExtents = m_bounds.aabbExtents;
+}
+
+void Mesh::SetSubmeshTriangles(unsigned int submeshIndex, std::vector<glm::vec3> positions, std::vector<unsigned int> indices)
+{
+    assert(indices.size() % 3 == 0);
+    Submesh& submesh = GetSubmesh(submeshIndex);
+    submesh.trianglePositions = std::move(positions);
+    submesh.triangleIndices = std::move(indices);
+    submesh.triangleBvh.reset();
+}
+
+const Bvh& Mesh::GetSubmeshTriangleBvh(unsigned int submeshIndex) const
+{
+    const Submesh& submesh = GetSubmesh(submeshIndex);
+    if (!submesh.triangleBvh)
+    {
+        std::span<const glm::vec3> positions = submesh.trianglePositions;
+        std::span<const unsigned int> indices = submesh.triangleIndices;
+        size_t triangleCount = indices.size() / 3;
+        std::vector<glm::vec3> boundsMin(triangleCount), boundsMax(triangleCount);
+        for (size_t i = 0; i < triangleCount; ++i)
+        {
+            const glm::vec3& v0 = positions[indices[3 * i]];
+            const glm::vec3& v1 = positions[indices[3 * i + 1]];
+            const glm::vec3& v2 = positions[indices[3 * i + 2]];
+            boundsMin[i] = glm::min(v0, glm::min(v1, v2));
+            boundsMax[i] = glm::max(v0, glm::max(v1, v2));
+        }
+        submesh.triangleBvh = std::make_unique<Bvh>();
+        submesh.triangleBvh->Build(boundsMin, boundsMax);
+    }
+    return *submesh.triangleBvh;
+}
+
+bool Mesh::IntersectSubmesh(unsigned int submeshIndex, const glm::vec3& origin, const glm::vec3& direction, float& maxDistance,
+    unsigned int& triangleIndex, glm::vec2& barycentrics) const
+{
+    const Submesh& submesh = GetSubmesh(submeshIndex);
+    std::span<const glm::vec3> positions = submesh.trianglePositions;
+    std::span<const unsigned int> indices = submesh.triangleIndices;
+
+    bool hit = false;
+    float closestDistance = maxDistance;
+    GetSubmeshTriangleBvh(submeshIndex).TraverseRay(origin, direction, maxDistance, [&](std::span<const unsigned int> triangles, float& leafMaxDistance)
+        {
+            for (unsigned int triangle : triangles)
+            {
+                float distance;
+                glm::vec2 triangleBarycentrics;
+                if (IntersectTriangle(origin, direction, positions[indices[3 * triangle]], positions[indices[3 * triangle + 1]], positions[indices[3 * triangle + 2]],
+                    distance, triangleBarycentrics) && distance < leafMaxDistance)
+                {
+                    leafMaxDistance = distance;
+                    closestDistance = distance;
+                    triangleIndex = triangle;
+                    barycentrics = triangleBarycentrics;
+                    hit = true;
+                }
+            }
+        });
+    maxDistance = closestDistance;
+    return hit;
+}
+
+bool Mesh::IntersectTriangle(const glm::vec3& origin, const glm::vec3& direction,
+    const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, float& distance, glm::vec2& barycentrics)
+{
+    glm::vec3 edge1 = v1 - v0;
+    glm::vec3 edge2 = v2 - v0;
+    glm::vec3 p = glm::cross(direction, edge2);
+    float determinant = glm::dot(edge1, p);
+
+    // Both faces are hit. Rays parallel to the triangle miss it
+    if (std::abs(determinant) < std::numeric_limits<float>::min())
+        return false;
+
+    float inverseDeterminant = 1.0f / determinant;
+    glm::vec3 t = origin - v0;
+    float u = glm::dot(t, p) * inverseDeterminant;
+    if (u < 0.0f || u > 1.0f)
+        return false;
+
+    glm::vec3 q = glm::cross(t, edge1);
+    float v = glm::dot(direction, q) * inverseDeterminant;
+    if (v < 0.0f || u + v > 1.0f)
+        return false;
+
+    distance = glm::dot(edge2, q) * inverseDeterminant;
+    barycentrics = glm::vec2(u, v);
+    return distance >= 0.0f;
+}
+
 // Bind the VAO and render the drawcall of the submesh
 void Mesh::DrawSubmesh(int submeshIndex) const
 {
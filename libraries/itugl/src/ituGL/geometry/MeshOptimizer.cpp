@@ -0,0 +1,662 @@
+#include <ituGL/geometry/MeshOptimizer.h>
+
+#include <glm/vec4.hpp>
+#include <glm/geometric.hpp>
+#include <glm/matrix.hpp>
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <cstring>
+#include <cmath>
+#include <cassert>
+
+unsigned int MeshOptimizer::Optimize(std::span<unsigned int> indices, std::span<GLubyte> vertexData, size_t vertexSize, size_t positionOffset,
+    unsigned int cacheSize)
+{
+    assert(indices.size() % 3 == 0);
+    unsigned int vertexCount = static_cast<unsigned int>(vertexData.size() / vertexSize);
+
+    std::vector<unsigned int> clusterStarts;
+    OptimizeVertexCache(indices, vertexCount, cacheSize, &clusterStarts);
+    OptimizeOverdraw(indices, clusterStarts, vertexData, vertexSize, positionOffset, cacheSize);
+
+    // Triangle order is final, vertices follow it
+    return OptimizeVertexFetch(indices, vertexData, vertexSize);
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::span<unsigned int> indices, unsigned int vertexCount,
+    unsigned int cacheSize, std::vector<unsigned int>* clusterStarts)
+{
+    assert(indices.size() % 3 == 0);
+    unsigned int triangleCount = static_cast<unsigned int>(indices.size() / 3);
+    if (triangleCount == 0)
+    {
+        return;
+    }
+
+    // Triangles that use each vertex, stored as ranges of one array
+    std::vector<unsigned int> adjacencyOffsets(vertexCount + 1, 0);
+    for (unsigned int index : indices)
+    {
+        assert(index < vertexCount);
+        adjacencyOffsets[index + 1]++;
+    }
+    std::partial_sum(adjacencyOffsets.begin(), adjacencyOffsets.end(), adjacencyOffsets.begin());
+
+    // The live count is the number of triangles not emitted yet for each vertex
+    std::vector<unsigned int> liveCounts(vertexCount);
+    std::vector<unsigned int> adjacency(indices.size());
+    for (unsigned int vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        liveCounts[vertex] = adjacencyOffsets[vertex + 1] - adjacencyOffsets[vertex];
+    }
+    {
+        std::vector<unsigned int> fillOffsets(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (unsigned int i = 0; i < indices.size(); ++i)
+        {
+            adjacency[fillOffsets[indices[i]]++] = i / 3;
+        }
+    }
+
+    // A vertex is in the cache if less than cacheSize vertices were transformed after it
+    std::vector<unsigned int> cacheTimes(vertexCount, 0);
+    unsigned int time = cacheSize + 1;
+
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<unsigned int> deadEndStack;
+    std::vector<unsigned int> candidates;
+    std::vector<unsigned int> output;
+    output.reserve(indices.size());
+
+    // Next vertex to check when there are no candidates left
+    unsigned int cursor = 0;
+    while (cursor < vertexCount && liveCounts[cursor] == 0)
+    {
+        cursor++;
+    }
+
+    int fanVertex = cursor < vertexCount ? static_cast<int>(cursor) : -1;
+    bool newCluster = true;
+    while (fanVertex >= 0)
+    {
+        if (newCluster && clusterStarts)
+        {
+            clusterStarts->push_back(static_cast<unsigned int>(output.size() / 3));
+        }
+
+        // Emit all the triangles around the fan vertex
+        candidates.clear();
+        for (unsigned int i = adjacencyOffsets[fanVertex]; i < adjacencyOffsets[fanVertex + 1]; ++i)
+        {
+            unsigned int triangle = adjacency[i];
+            if (emitted[triangle])
+            {
+                continue;
+            }
+            emitted[triangle] = true;
+
+            for (unsigned int corner = 0; corner < 3; ++corner)
+            {
+                unsigned int vertex = indices[triangle * 3 + corner];
+                output.push_back(vertex);
+                deadEndStack.push_back(vertex);
+                candidates.push_back(vertex);
+                liveCounts[vertex]--;
+                if (time - cacheTimes[vertex] > cacheSize)
+                {
+                    cacheTimes[vertex] = time++;
+                }
+            }
+        }
+
+        // Next fan: the candidate that stays in the cache while its triangles are emitted, the oldest first
+        int nextVertex = -1;
+        int bestPriority = -1;
+        for (unsigned int vertex : candidates)
+        {
+            if (liveCounts[vertex] > 0)
+            {
+                int priority = 0;
+                if (time - cacheTimes[vertex] + 2 * liveCounts[vertex] <= cacheSize)
+                {
+                    priority = static_cast<int>(time - cacheTimes[vertex]);
+                }
+                if (priority > bestPriority)
+                {
+                    bestPriority = priority;
+                    nextVertex = static_cast<int>(vertex);
+                }
+            }
+        }
+
+        newCluster = nextVertex < 0;
+        if (nextVertex < 0)
+        {
+            // Dead end: go back to the most recent vertex with triangles left
+            while (!deadEndStack.empty() && nextVertex < 0)
+            {
+                unsigned int vertex = deadEndStack.back();
+                deadEndStack.pop_back();
+                if (liveCounts[vertex] > 0)
+                {
+                    nextVertex = static_cast<int>(vertex);
+                }
+            }
+        }
+        if (nextVertex < 0)
+        {
+            // Nothing left nearby, jump to the next vertex in input order
+            while (cursor < vertexCount && liveCounts[cursor] == 0)
+            {
+                cursor++;
+            }
+            nextVertex = cursor < vertexCount ? static_cast<int>(cursor) : -1;
+        }
+        fanVertex = nextVertex;
+    }
+
+    assert(output.size() == indices.size());
+    std::copy(output.begin(), output.end(), indices.begin());
+}
+
+void MeshOptimizer::OptimizeOverdraw(std::span<unsigned int> indices, std::span<const unsigned int> clusterStarts,
+    std::span<const GLubyte> vertexData, size_t vertexSize, size_t positionOffset,
+    unsigned int cacheSize, float threshold)
+{
+    assert(indices.size() % 3 == 0);
+    unsigned int triangleCount = static_cast<unsigned int>(indices.size() / 3);
+    unsigned int vertexCount = static_cast<unsigned int>(vertexData.size() / vertexSize);
+    if (triangleCount == 0 || clusterStarts.empty())
+    {
+        return;
+    }
+
+    std::vector<unsigned int> cacheTimes(vertexCount, 0);
+    unsigned int time = cacheSize + 1;
+    auto GetTriangleMisses = [&](unsigned int triangle)
+    {
+        unsigned int misses = 0;
+        for (unsigned int corner = 0; corner < 3; ++corner)
+        {
+            unsigned int vertex = indices[triangle * 3 + corner];
+            if (time - cacheTimes[vertex] > cacheSize)
+            {
+                cacheTimes[vertex] = time++;
+                misses++;
+            }
+        }
+        return misses;
+    };
+    auto ClearCache = [&]() { time += cacheSize + 1; };
+
+    // Split the clusters into smaller ones, as long as they keep a cache efficiency close to the whole cluster
+    std::vector<unsigned int> splitStarts;
+    for (size_t clusterIndex = 0; clusterIndex < clusterStarts.size(); ++clusterIndex)
+    {
+        unsigned int start = clusterStarts[clusterIndex];
+        unsigned int end = clusterIndex + 1 < clusterStarts.size() ? clusterStarts[clusterIndex + 1] : triangleCount;
+
+        ClearCache();
+        unsigned int clusterMisses = 0;
+        for (unsigned int triangle = start; triangle < end; ++triangle)
+        {
+            clusterMisses += GetTriangleMisses(triangle);
+        }
+        float clusterThreshold = threshold * clusterMisses / (end - start);
+
+        size_t firstSplit = splitStarts.size();
+        splitStarts.push_back(start);
+        ClearCache();
+        unsigned int splitMisses = 0;
+        for (unsigned int triangle = start; triangle < end; ++triangle)
+        {
+            splitMisses += GetTriangleMisses(triangle);
+            if (triangle + 1 < end && static_cast<float>(splitMisses) / (triangle + 1 - splitStarts.back()) <= clusterThreshold)
+            {
+                splitStarts.push_back(triangle + 1);
+                splitMisses = 0;
+                ClearCache();
+            }
+        }
+
+        // The last split gets the leftovers and is usually bad, merge it with the previous one
+        if (splitStarts.size() - firstSplit > 1)
+        {
+            splitStarts.pop_back();
+        }
+    }
+
+    // Mesh center, weighted by triangle area
+    glm::vec3 meshCenter(0.0f);
+    float meshArea = 0.0f;
+    std::vector<glm::vec3> triangleCenters(triangleCount);
+    std::vector<glm::vec3> triangleNormals(triangleCount);
+    for (unsigned int triangle = 0; triangle < triangleCount; ++triangle)
+    {
+        glm::vec3 p0 = GetPosition(vertexData, vertexSize, positionOffset, indices[triangle * 3 + 0]);
+        glm::vec3 p1 = GetPosition(vertexData, vertexSize, positionOffset, indices[triangle * 3 + 1]);
+        glm::vec3 p2 = GetPosition(vertexData, vertexSize, positionOffset, indices[triangle * 3 + 2]);
+
+        // The length of the cross product is twice the area, the factor cancels out
+        triangleNormals[triangle] = glm::cross(p1 - p0, p2 - p0);
+        triangleCenters[triangle] = (p0 + p1 + p2) / 3.0f;
+        float area = glm::length(triangleNormals[triangle]);
+        meshCenter += triangleCenters[triangle] * area;
+        meshArea += area;
+    }
+    meshCenter = meshArea > 0.0f ? meshCenter / meshArea : glm::vec3(0.0f);
+
+    // Clusters far from the center and facing outwards are likely to occlude the rest, so they go first
+    std::vector<float> sortKeys(splitStarts.size());
+    for (size_t clusterIndex = 0; clusterIndex < splitStarts.size(); ++clusterIndex)
+    {
+        unsigned int start = splitStarts[clusterIndex];
+        unsigned int end = clusterIndex + 1 < splitStarts.size() ? splitStarts[clusterIndex + 1] : triangleCount;
+
+        glm::vec3 clusterCenter(0.0f);
+        glm::vec3 clusterNormal(0.0f);
+        float clusterArea = 0.0f;
+        for (unsigned int triangle = start; triangle < end; ++triangle)
+        {
+            float area = glm::length(triangleNormals[triangle]);
+            clusterCenter += triangleCenters[triangle] * area;
+            clusterNormal += triangleNormals[triangle];
+            clusterArea += area;
+        }
+        float normalLength = glm::length(clusterNormal);
+        if (clusterArea > 0.0f && normalLength > 0.0f)
+        {
+            sortKeys[clusterIndex] = glm::dot(clusterCenter / clusterArea - meshCenter, clusterNormal / normalLength);
+        }
+        else
+        {
+            sortKeys[clusterIndex] = 0.0f;
+        }
+    }
+
+    std::vector<unsigned int> clusterOrder(splitStarts.size());
+    std::iota(clusterOrder.begin(), clusterOrder.end(), 0);
+    std::stable_sort(clusterOrder.begin(), clusterOrder.end(),
+        [&](unsigned int a, unsigned int b) { return sortKeys[a] > sortKeys[b]; });
+
+    std::vector<unsigned int> output;
+    output.reserve(indices.size());
+    for (unsigned int clusterIndex : clusterOrder)
+    {
+        unsigned int start = splitStarts[clusterIndex];
+        unsigned int end = clusterIndex + 1 < splitStarts.size() ? splitStarts[clusterIndex + 1] : triangleCount;
+        output.insert(output.end(), indices.begin() + start * 3, indices.begin() + end * 3);
+    }
+    std::copy(output.begin(), output.end(), indices.begin());
+}
+
+unsigned int MeshOptimizer::OptimizeVertexFetch(std::span<unsigned int> indices, std::span<GLubyte> vertexData, size_t vertexSize)
+{
+    unsigned int vertexCount = static_cast<unsigned int>(vertexData.size() / vertexSize);
+
+    // New position of each vertex, in order of first use
+    const unsigned int unused = ~0u;
+    std::vector<unsigned int> remap(vertexCount, unused);
+    unsigned int usedCount = 0;
+    for (unsigned int& index : indices)
+    {
+        assert(index < vertexCount);
+        if (remap[index] == unused)
+        {
+            remap[index] = usedCount++;
+        }
+        index = remap[index];
+    }
+
+    std::vector<GLubyte> reordered(usedCount * vertexSize);
+    for (unsigned int vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        if (remap[vertex] != unused)
+        {
+            std::memcpy(&reordered[remap[vertex] * vertexSize], &vertexData[vertex * vertexSize], vertexSize);
+        }
+    }
+    std::copy(reordered.begin(), reordered.end(), vertexData.begin());
+
+    return usedCount;
+}
+
+MeshOptimizer::CacheStatistics MeshOptimizer::AnalyzeVertexCache(std::span<const unsigned int> indices, unsigned int vertexCount,
+    unsigned int cacheSize)
+{
+    CacheStatistics statistics = { 0.0f, 0.0f };
+    if (indices.size() < 3)
+    {
+        return statistics;
+    }
+
+    std::vector<unsigned int> cacheTimes(vertexCount, 0);
+    unsigned int time = cacheSize + 1;
+    std::vector<bool> used(vertexCount, false);
+    unsigned int usedCount = 0;
+    unsigned int misses = 0;
+    for (unsigned int index : indices)
+    {
+        if (time - cacheTimes[index] > cacheSize)
+        {
+            cacheTimes[index] = time++;
+            misses++;
+        }
+        if (!used[index])
+        {
+            used[index] = true;
+            usedCount++;
+        }
+    }
+
+    statistics.acmr = static_cast<float>(misses) / (indices.size() / 3);
+    statistics.atvr = static_cast<float>(misses) / usedCount;
+    return statistics;
+}
+
+std::vector<Meshlet> MeshOptimizer::BuildMeshlets(std::span<const unsigned int> indices, std::span<const GLubyte> vertexData, size_t vertexSize,
+    size_t positionOffset, unsigned int maxVertices, unsigned int maxTriangles)
+{
+    assert(indices.size() % 3 == 0);
+    assert(maxVertices >= 3 && maxTriangles >= 1);
+    unsigned int vertexCount = static_cast<unsigned int>(vertexData.size() / vertexSize);
+
+    std::vector<Meshlet> meshlets;
+
+    // Last meshlet that used each vertex, to count the vertices of the current one without clearing anything
+    const unsigned int noMeshlet = ~0u;
+    std::vector<unsigned int> vertexMeshlets(vertexCount, noMeshlet);
+
+    Meshlet meshlet = {};
+    unsigned int meshletVertexCount = 0;
+    auto AddMeshlet = [&]()
+    {
+        ComputeMeshletBounds(meshlet, indices, vertexData, vertexSize, positionOffset);
+        meshlets.push_back(meshlet);
+        meshlet = {};
+        meshlet.firstElement = meshlets.back().firstElement + meshlets.back().elementCount;
+        meshletVertexCount = 0;
+    };
+
+    for (size_t triangle = 0; triangle < indices.size(); triangle += 3)
+    {
+        unsigned int meshletIndex = static_cast<unsigned int>(meshlets.size());
+
+        // Count the vertices that the triangle would add to the meshlet
+        unsigned int newVertexCount = 0;
+        for (size_t corner = 0; corner < 3; ++corner)
+        {
+            unsigned int index = indices[triangle + corner];
+            bool repeated = (corner > 0 && index == indices[triangle]) || (corner > 1 && index == indices[triangle + 1]);
+            if (vertexMeshlets[index] != meshletIndex && !repeated)
+            {
+                newVertexCount++;
+            }
+        }
+
+        if (meshletVertexCount + newVertexCount > maxVertices || meshlet.elementCount / 3 == maxTriangles)
+        {
+            AddMeshlet();
+            meshletIndex++;
+            newVertexCount = 0;
+            for (size_t corner = 0; corner < 3; ++corner)
+            {
+                unsigned int index = indices[triangle + corner];
+                bool repeated = (corner > 0 && index == indices[triangle]) || (corner > 1 && index == indices[triangle + 1]);
+                newVertexCount += repeated ? 0 : 1;
+            }
+        }
+
+        for (size_t corner = 0; corner < 3; ++corner)
+        {
+            vertexMeshlets[indices[triangle + corner]] = meshletIndex;
+        }
+        meshletVertexCount += newVertexCount;
+        meshlet.elementCount += 3;
+    }
+
+    if (meshlet.elementCount > 0)
+    {
+        AddMeshlet();
+    }
+
+    return meshlets;
+}
+
+void MeshOptimizer::ComputeMeshletBounds(Meshlet& meshlet, std::span<const unsigned int> indices, std::span<const GLubyte> vertexData,
+    size_t vertexSize, size_t positionOffset)
+{
+    std::span<const unsigned int> meshletIndices = indices.subspan(meshlet.firstElement, meshlet.elementCount);
+    assert(!meshletIndices.empty());
+
+    // Sphere around the center of the box, it is close enough to the minimal one for small clusters
+    glm::vec3 boundsMin = GetPosition(vertexData, vertexSize, positionOffset, meshletIndices[0]);
+    glm::vec3 boundsMax = boundsMin;
+    for (unsigned int index : meshletIndices)
+    {
+        glm::vec3 position = GetPosition(vertexData, vertexSize, positionOffset, index);
+        boundsMin = glm::min(boundsMin, position);
+        boundsMax = glm::max(boundsMax, position);
+    }
+    meshlet.center = 0.5f * (boundsMin + boundsMax);
+    float radiusSquared = 0.0f;
+    for (unsigned int index : meshletIndices)
+    {
+        glm::vec3 offset = GetPosition(vertexData, vertexSize, positionOffset, index) - meshlet.center;
+        radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+    }
+    meshlet.radius = std::sqrt(radiusSquared);
+
+    // The cone axis is the average of the triangle normals, and its angle covers all of them
+    std::vector<glm::vec4> planes;
+    planes.reserve(meshletIndices.size() / 3);
+    glm::vec3 normalSum(0.0f);
+    for (size_t triangle = 0; triangle < meshletIndices.size(); triangle += 3)
+    {
+        glm::vec3 p0 = GetPosition(vertexData, vertexSize, positionOffset, meshletIndices[triangle]);
+        glm::vec3 p1 = GetPosition(vertexData, vertexSize, positionOffset, meshletIndices[triangle + 1]);
+        glm::vec3 p2 = GetPosition(vertexData, vertexSize, positionOffset, meshletIndices[triangle + 2]);
+        glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+        float length = glm::length(normal);
+
+        // Degenerate triangles are never visible, they don't limit the cone
+        if (length > 0.0f)
+        {
+            normal /= length;
+            normalSum += normal;
+            planes.emplace_back(normal, glm::dot(normal, p0));
+        }
+    }
+
+    meshlet.coneApex = meshlet.center;
+    meshlet.coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+    meshlet.coneCutoff = 1.0f;
+    float normalSumLength = glm::length(normalSum);
+    if (planes.empty() || normalSumLength <= 0.0f)
+    {
+        return;
+    }
+    meshlet.coneAxis = normalSum / normalSumLength;
+
+    float minDot = 1.0f;
+    for (const glm::vec4& plane : planes)
+    {
+        minDot = std::min(minDot, glm::dot(glm::vec3(plane), meshlet.coneAxis));
+    }
+
+    // Normals close to 90 degrees from the axis or more, the cluster has front faces from almost everywhere
+    if (minDot <= 0.1f)
+    {
+        return;
+    }
+
+    // Move the apex back along the axis, until it is behind the planes of all the triangles
+    float maxDistance = 0.0f;
+    for (const glm::vec4& plane : planes)
+    {
+        float distance = (glm::dot(glm::vec3(plane), meshlet.center) - plane.w) / glm::dot(glm::vec3(plane), meshlet.coneAxis);
+        maxDistance = std::max(maxDistance, distance);
+    }
+    meshlet.coneApex = meshlet.center - meshlet.coneAxis * maxDistance;
+    meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+}
+
+MeshBounds MeshOptimizer::ComputeBounds(std::span<const GLubyte> vertexData, size_t vertexSize, size_t positionOffset)
+{
+    MeshBounds bounds{ glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.0f), 0.0f, glm::vec3(0.0f), glm::mat3(1.0f), glm::vec3(0.0f) };
+    unsigned int vertexCount = static_cast<unsigned int>(vertexData.size() / vertexSize);
+    if (vertexCount == 0)
+    {
+        return bounds;
+    }
+
+    // Box, the vertices at the extremes of each axis, and the mean for the covariance
+    glm::vec3 boundsMin = GetPosition(vertexData, vertexSize, positionOffset, 0);
+    glm::vec3 boundsMax = boundsMin;
+    unsigned int minVertices[3] = {};
+    unsigned int maxVertices[3] = {};
+    glm::vec3 mean(0.0f);
+    for (unsigned int vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        glm::vec3 position = GetPosition(vertexData, vertexSize, positionOffset, vertex);
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            if (position[axis] < boundsMin[axis])
+            {
+                boundsMin[axis] = position[axis];
+                minVertices[axis] = vertex;
+            }
+            if (position[axis] > boundsMax[axis])
+            {
+                boundsMax[axis] = position[axis];
+                maxVertices[axis] = vertex;
+            }
+        }
+        mean += position;
+    }
+    mean /= static_cast<float>(vertexCount);
+    bounds.aabbCenter = 0.5f * (boundsMin + boundsMax);
+    bounds.aabbExtents = 0.5f * (boundsMax - boundsMin);
+
+    // Ritter's sphere: start with the most distant pair of extreme vertices, and grow it to cover the vertices left outside
+    glm::vec3 sphereStart(0.0f), sphereEnd(0.0f);
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        glm::vec3 start = GetPosition(vertexData, vertexSize, positionOffset, minVertices[axis]);
+        glm::vec3 end = GetPosition(vertexData, vertexSize, positionOffset, maxVertices[axis]);
+        if (axis == 0 || glm::dot(end - start, end - start) > glm::dot(sphereEnd - sphereStart, sphereEnd - sphereStart))
+        {
+            sphereStart = start;
+            sphereEnd = end;
+        }
+    }
+    glm::vec3 center = 0.5f * (sphereStart + sphereEnd);
+    float radius = 0.5f * glm::length(sphereEnd - sphereStart);
+    float boxRadiusSquared = 0.0f;
+    glm::mat3 covariance(0.0f);
+    for (unsigned int vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        glm::vec3 position = GetPosition(vertexData, vertexSize, positionOffset, vertex);
+        glm::vec3 offset = position - center;
+        float distanceSquared = glm::dot(offset, offset);
+        if (distanceSquared > radius * radius)
+        {
+            // Move the center towards the vertex, keeping the opposite side of the sphere in place
+            float distance = std::sqrt(distanceSquared);
+            float newRadius = 0.5f * (radius + distance);
+            center += offset * ((newRadius - radius) / distance);
+            radius = newRadius;
+        }
+
+        glm::vec3 boxOffset = position - bounds.aabbCenter;
+        boxRadiusSquared = std::max(boxRadiusSquared, glm::dot(boxOffset, boxOffset));
+
+        glm::vec3 meanOffset = position - mean;
+        covariance += glm::outerProduct(meanOffset, meanOffset);
+    }
+
+    // The sphere around the box is smaller for some shapes, like boxes
+    float boxRadius = std::sqrt(boxRadiusSquared);
+    bounds.sphereCenter = boxRadius < radius ? bounds.aabbCenter : center;
+    bounds.sphereRadius = std::min(boxRadius, radius);
+
+    // Oriented box along the directions of largest and smallest spread of the vertices
+    glm::mat3 axes = ComputeEigenvectors(covariance);
+    glm::vec3 localMin(std::numeric_limits<float>::max());
+    glm::vec3 localMax(std::numeric_limits<float>::lowest());
+    glm::mat3 inverseAxes = glm::transpose(axes);
+    for (unsigned int vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        glm::vec3 localPosition = inverseAxes * GetPosition(vertexData, vertexSize, positionOffset, vertex);
+        localMin = glm::min(localMin, localPosition);
+        localMax = glm::max(localMax, localPosition);
+    }
+    glm::vec3 localExtents = 0.5f * (localMax - localMin);
+    auto GetVolume = [](const glm::vec3& extents) { return extents.x * extents.y * extents.z; };
+    if (GetVolume(localExtents) < GetVolume(bounds.aabbExtents))
+    {
+        bounds.boxCenter = axes * (0.5f * (localMin + localMax));
+        bounds.boxAxes = axes;
+        bounds.boxExtents = localExtents;
+    }
+    else
+    {
+        bounds.boxCenter = bounds.aabbCenter;
+        bounds.boxExtents = bounds.aabbExtents;
+    }
+
+    return bounds;
+}
+
+glm::mat3 MeshOptimizer::ComputeEigenvectors(glm::mat3 matrix)
+{
+    glm::mat3 eigenvectors(1.0f);
+    for (int sweep = 0; sweep < 32; ++sweep)
+    {
+        float offDiagonal = std::abs(matrix[1][0]) + std::abs(matrix[2][0]) + std::abs(matrix[2][1]);
+        float diagonal = std::abs(matrix[0][0]) + std::abs(matrix[1][1]) + std::abs(matrix[2][2]);
+        if (offDiagonal <= diagonal * 1e-7f)
+        {
+            break;
+        }
+
+        // Rotate in the plane of each pair of axes to zero their element
+        const int pairs[3][2] = { { 0, 1 }, { 0, 2 }, { 1, 2 } };
+        for (const auto& pair : pairs)
+        {
+            int p = pair[0], q = pair[1];
+            float element = matrix[q][p];
+            if (element == 0.0f)
+            {
+                continue;
+            }
+
+            float theta = (matrix[q][q] - matrix[p][p]) / (2.0f * element);
+            float t = (theta >= 0.0f ? 1.0f : -1.0f) / (std::abs(theta) + std::sqrt(theta * theta + 1.0f));
+            float c = 1.0f / std::sqrt(t * t + 1.0f);
+            float s = t * c;
+
+            glm::mat3 rotation(1.0f);
+            rotation[p][p] = c;
+            rotation[q][q] = c;
+            rotation[q][p] = s;
+            rotation[p][q] = -s;
+            matrix = glm::transpose(rotation) * matrix * rotation;
+            eigenvectors = eigenvectors * rotation;
+        }
+    }
+
+    // Keep a right handed basis, so it can be used as a rotation
+    if (glm::determinant(eigenvectors) < 0.0f)
+    {
+        eigenvectors[2] = -eigenvectors[2];
+    }
+    return eigenvectors;
+}
+
+glm::vec3 MeshOptimizer::GetPosition(std::span<const GLubyte> vertexData, size_t vertexSize, size_t positionOffset, unsigned int vertex)
+{
+    glm::vec3 position;
+    std::memcpy(&position, &vertexData[vertex * vertexSize + positionOffset], sizeof(position));
+    return position;
+}
@@ -0,0 +1,74 @@
+#include <ituGL/geometry/TransformFeedbackObject.h>
+
+#include <ituGL/core/BufferObject.h>
+#include <ituGL/geometry/VertexArrayObject.h>
+#include <cassert>
+
+#ifndef NDEBUG
+TransformFeedbackObject::Handle TransformFeedbackObject::s_boundHandle = TransformFeedbackObject::NullHandle;
+#endif
+
+TransformFeedbackObject::TransformFeedbackObject() : Object(NullHandle)
+{
+    Handle& handle = GetHandle();
+    glGenTransformFeedbacks(1, &handle);
+}
+
+TransformFeedbackObject::~TransformFeedbackObject()
+{
+    Handle& handle = GetHandle();
+    glDeleteTransformFeedbacks(1, &handle);
+}
+
+TransformFeedbackObject::TransformFeedbackObject(TransformFeedbackObject&& transformFeedback) noexcept : Object(std::move(transformFeedback))
+{
+}
+
+TransformFeedbackObject& TransformFeedbackObject::operator = (TransformFeedbackObject&& transformFeedback) noexcept
+{
+    Object::operator=(std::move(transformFeedback));
+    return *this;
+}
+
+void TransformFeedbackObject::Bind() const
+{
+    Handle handle = GetHandle();
+    glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, handle);
+#ifndef NDEBUG
+    s_boundHandle = handle;
+#endif
+}
+
+void TransformFeedbackObject::Unbind()
+{
+    Handle handle = NullHandle;
+    glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, handle);
+#ifndef NDEBUG
+    s_boundHandle = handle;
+#endif
+}
+
+// The indexed binding is part of the state of the bound object
+void TransformFeedbackObject::SetBuffer(GLuint index, const BufferObject& buffer)
+{
+    assert(IsBound());
+    buffer.BindBase(BufferObject::TransformFeedbackBuffer, index);
+}
+
+void TransformFeedbackObject::Begin(Drawcall::Primitive primitive)
+{
+    assert(IsBound());
+    glBeginTransformFeedback(static_cast<GLenum>(primitive));
+}
+
+void TransformFeedbackObject::End()
+{
+    assert(IsBound());
+    glEndTransformFeedback();
+}
+
+void TransformFeedbackObject::Draw(Drawcall::Primitive primitive) const
+{
+    assert(VertexArrayObject::IsAnyBound());
+    glDrawTransformFeedback(static_cast<GLenum>(primitive), GetHandle());
+}
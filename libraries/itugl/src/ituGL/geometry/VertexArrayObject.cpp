@@ -54,7 +54,7 @@ void VertexArrayObject::Unbind()
 }
 
 // Sets the VertexAttribute pointer and enables the VertexAttribute in that location
-void VertexArrayObject::SetAttribute(GLuint location, const VertexAttribute& attribute, GLint offset, GLsizei stride)
+void VertexArrayObject::SetAttribute(GLuint location, const VertexAttribute& attribute, GLint offset, GLsizei stride, GLuint divisor)
 {
     assert(IsBound());
     assert(VertexBufferObject::IsAnyBound());
@@ -78,6 +78,9 @@ void VertexArrayObject::SetAttribute(GLuint location, const VertexAttribute& att
         glVertexAttribIPointer(location, components, type, stride, pointer);
     }
 
+    // Per instance attributes
+    glVertexAttribDivisor(location, divisor);
+
     // Finally, we enable the VertexAttribute in this location
     glEnableVertexAttribArray(location);
 }
@@ -12,6 +12,8 @@ void VertexFormat::Clear()
 
 void VertexFormat::AddVertexAttribute(Data::Type type, int components, bool normalized, VertexAttribute::Semantic semantic)
 {
+    // Packed types always have 4 components
+    assert(!Data::IsPacked(type) || components == 4);
     m_attributes.emplace_back(type, components, normalized, semantic);
     int attributeSize = m_attributes.back().GetSize();
     m_size += attributeSize;
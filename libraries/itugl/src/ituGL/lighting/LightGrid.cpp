@@ -0,0 +1,212 @@
+#include <ituGL/lighting/LightGrid.h>
+
+#include <ituGL/lighting/Light.h>
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+LightGrid::LightGrid() : m_cellSize(0.0f), m_buildCellSize(1.0f), m_queryIndex(0)
+{
+}
+
+void LightGrid::Build(std::span<const Light* const> lights)
+{
+    m_lights.assign(lights.begin(), lights.end());
+    m_lightSpheres.clear();
+    m_globalLights.clear();
+    m_entries.clear();
+
+    // Lights with a distance range have a sphere of influence, the others reach everything
+    float rangeSum = 0.0f;
+    unsigned int rangeCount = 0;
+    for (const Light* light : m_lights)
+    {
+        glm::vec4 attenuation = light->GetAttenuation();
+        float radius = attenuation.y > 0.0f ? attenuation.y : -1.0f;
+        m_lightSpheres.push_back(glm::vec4(light->GetPosition(), radius));
+        if (radius > 0.0f)
+        {
+            rangeSum += radius;
+            rangeCount++;
+        }
+    }
+
+    // By default, cells are as big as the average light, so each light covers a few of them
+    m_buildCellSize = m_cellSize > 0.0f ? m_cellSize : (rangeCount > 0 ? 2.0f * rangeSum / rangeCount : 1.0f);
+
+    // Collect the cells of each light first, to know how many buckets are needed
+    std::vector<glm::ivec3> lightCells;
+    for (unsigned int lightIndex = 0; lightIndex < m_lights.size(); ++lightIndex)
+    {
+        glm::vec4& sphere = m_lightSpheres[lightIndex];
+        glm::vec3 minPosition = glm::vec3(sphere) - sphere.w;
+        glm::vec3 maxPosition = glm::vec3(sphere) + sphere.w;
+        if (sphere.w < 0.0f || GetCellCount(minPosition, maxPosition) > s_maxLightCells)
+        {
+            sphere.w = -1.0f;
+            m_globalLights.push_back(lightIndex);
+            continue;
+        }
+
+        glm::ivec3 minCell = GetCell(minPosition);
+        glm::ivec3 maxCell = GetCell(maxPosition);
+        for (int z = minCell.z; z <= maxCell.z; ++z)
+        {
+            for (int y = minCell.y; y <= maxCell.y; ++y)
+            {
+                for (int x = minCell.x; x <= maxCell.x; ++x)
+                {
+                    lightCells.push_back(glm::ivec3(x, y, z));
+                    m_entries.push_back(glm::uvec2(0, lightIndex));
+                }
+            }
+        }
+    }
+
+    // Twice as many buckets as entries keeps few collisions, a power of two makes the hash a mask
+    unsigned int bucketCount = std::bit_ceil(std::max(2u * static_cast<unsigned int>(m_entries.size()), 1u));
+    m_bucketOffsets.assign(bucketCount + 1, 0);
+    for (unsigned int entryIndex = 0; entryIndex < m_entries.size(); ++entryIndex)
+    {
+        m_entries[entryIndex].x = GetBucket(lightCells[entryIndex]);
+        m_bucketOffsets[m_entries[entryIndex].x + 1]++;
+    }
+
+    // Counting sort of the entries by bucket
+    for (unsigned int bucket = 0; bucket < bucketCount; ++bucket)
+    {
+        m_bucketOffsets[bucket + 1] += m_bucketOffsets[bucket];
+    }
+    m_bucketLights.resize(m_entries.size());
+    std::vector<unsigned int> bucketEnds(m_bucketOffsets.begin(), m_bucketOffsets.end() - 1);
+    for (const glm::uvec2& entry : m_entries)
+    {
+        m_bucketLights[bucketEnds[entry.x]++] = entry.y;
+    }
+
+    m_lightQueries.assign(m_lights.size(), 0);
+    m_queryIndex = 0;
+}
+
+void LightGrid::Query(const glm::vec3& center, float radius, unsigned int maxLights, std::vector<unsigned int>& lightIndices)
+{
+    lightIndices.clear();
+    m_candidates.clear();
+    if (m_lights.empty())
+        return;
+
+    // Stamps are reset when the counter wraps around
+    if (++m_queryIndex == 0)
+    {
+        std::fill(m_lightQueries.begin(), m_lightQueries.end(), 0);
+        m_queryIndex = 1;
+    }
+
+    auto AddCandidate = [&](unsigned int lightIndex)
+    {
+        if (m_lightQueries[lightIndex] == m_queryIndex)
+            return;
+        m_lightQueries[lightIndex] = m_queryIndex;
+
+        // Lights that do not reach the bounds add nothing
+        float contribution = EstimateContribution(*m_lights[lightIndex], center, radius);
+        if (contribution > 0.0f)
+        {
+            m_candidates.push_back(std::make_pair(contribution, lightIndex));
+        }
+    };
+
+    glm::vec3 minPosition = center - radius;
+    glm::vec3 maxPosition = center + radius;
+    if (radius < 0.0f || GetCellCount(minPosition, maxPosition) > s_maxQueryCells)
+    {
+        // Visiting the cells would take longer than testing the lights
+        for (unsigned int lightIndex = 0; lightIndex < m_lights.size(); ++lightIndex)
+        {
+            AddCandidate(lightIndex);
+        }
+    }
+    else
+    {
+        for (unsigned int lightIndex : m_globalLights)
+        {
+            AddCandidate(lightIndex);
+        }
+
+        glm::ivec3 minCell = GetCell(minPosition);
+        glm::ivec3 maxCell = GetCell(maxPosition);
+        for (int z = minCell.z; z <= maxCell.z; ++z)
+        {
+            for (int y = minCell.y; y <= maxCell.y; ++y)
+            {
+                for (int x = minCell.x; x <= maxCell.x; ++x)
+                {
+                    // Buckets can have lights of other cells, they are discarded by their contribution
+                    unsigned int bucket = GetBucket(glm::ivec3(x, y, z));
+                    for (unsigned int i = m_bucketOffsets[bucket]; i < m_bucketOffsets[bucket + 1]; ++i)
+                    {
+                        AddCandidate(m_bucketLights[i]);
+                    }
+                }
+            }
+        }
+    }
+
+    // Keep the strongest lights, in order
+    auto IsStronger = [](const std::pair<float, unsigned int>& a, const std::pair<float, unsigned int>& b)
+    {
+        return a.first > b.first || (a.first == b.first && a.second < b.second);
+    };
+    if (maxLights > 0 && m_candidates.size() > maxLights)
+    {
+        std::partial_sort(m_candidates.begin(), m_candidates.begin() + maxLights, m_candidates.end(), IsStronger);
+        m_candidates.resize(maxLights);
+    }
+    else
+    {
+        std::sort(m_candidates.begin(), m_candidates.end(), IsStronger);
+    }
+
+    for (const auto& candidate : m_candidates)
+    {
+        lightIndices.push_back(candidate.second);
+    }
+}
+
+float LightGrid::EstimateContribution(const Light& light, const glm::vec3& center, float radius)
+{
+    glm::vec3 color = light.GetColor();
+    float contribution = light.GetIntensity() * std::max(color.r, std::max(color.g, color.b));
+
+    // Same distance attenuation as the shaders. The angle of spot lights is ignored, so they are never underestimated
+    glm::vec4 attenuation = light.GetAttenuation();
+    if (attenuation.y > 0.0f && radius >= 0.0f)
+    {
+        float distance = std::max(glm::distance(light.GetPosition(), center) - radius, 0.0f);
+        contribution *= glm::smoothstep(attenuation.y, attenuation.x, distance);
+    }
+    return contribution;
+}
+
+glm::ivec3 LightGrid::GetCell(const glm::vec3& position) const
+{
+    return glm::ivec3(glm::floor(position / m_buildCellSize));
+}
+
+unsigned int LightGrid::GetBucket(const glm::ivec3& cell) const
+{
+    // Usual spatial hash, with a large prime for each axis
+    unsigned int hash = (static_cast<unsigned int>(cell.x) * 73856093u) ^ (static_cast<unsigned int>(cell.y) * 19349663u)
+        ^ (static_cast<unsigned int>(cell.z) * 83492791u);
+    unsigned int bucketCount = static_cast<unsigned int>(m_bucketOffsets.size()) - 1;
+    assert(std::has_single_bit(bucketCount));
+    return hash & (bucketCount - 1);
+}
+
+float LightGrid::GetCellCount(const glm::vec3& minPosition, const glm::vec3& maxPosition) const
+{
+    glm::vec3 cells = glm::floor(maxPosition / m_buildCellSize) - glm::floor(minPosition / m_buildCellSize) + 1.0f;
+    return cells.x * cells.y * cells.z;
+}
@@ -0,0 +1,248 @@
+#include <ituGL/particles/CpuParticleSystem.h>
+
+#include <ituGL/utils/ParallelUtils.h>
+#include <algorithm>
+#include <cassert>
+
+CpuParticleSystem::CpuParticleSystem()
+    : m_count(0)
+    , m_capacity(0)
+    , m_gravity(0.0f, -9.8f, 0.0f)
+    , m_drag(0.0f)
+{
+}
+
+void CpuParticleSystem::Initialize(unsigned int capacity)
+{
+    m_count = 0;
+    m_capacity = capacity;
+
+    for (unsigned int attribute = 0; attribute < AttributeCount; ++attribute)
+    {
+        m_particles[attribute].assign(capacity, 0.0f);
+    }
+    m_runSources.assign(capacity, 0);
+    m_runOffsets.assign(capacity, 0);
+}
+
+bool CpuParticleSystem::Emit(const glm::vec3& position, const glm::vec3& velocity, const glm::vec3& color, float size, float lifetime)
+{
+    if (m_count >= m_capacity)
+        return false;
+
+    unsigned int index = m_count++;
+    m_particles[PositionX][index] = position.x;
+    m_particles[PositionY][index] = position.y;
+    m_particles[PositionZ][index] = position.z;
+    m_particles[VelocityX][index] = velocity.x;
+    m_particles[VelocityY][index] = velocity.y;
+    m_particles[VelocityZ][index] = velocity.z;
+    m_particles[Age][index] = 0.0f;
+    m_particles[Lifetime][index] = lifetime;
+    m_particles[Size][index] = size;
+    m_particles[ColorR][index] = color.r;
+    m_particles[ColorG][index] = color.g;
+    m_particles[ColorB][index] = color.b;
+    return true;
+}
+
+void CpuParticleSystem::Update(float deltaTime)
+{
+    if (m_count == 0)
+        return;
+
+    // Find the particles that survive this update, and the runs they form in each block
+    unsigned int blockCount = GetBlockCount();
+    m_blockLiveCounts.resize(blockCount);
+    m_blockRunCounts.resize(blockCount);
+    ParallelUtils::For(blockCount, [&](unsigned int block)
+        {
+            unsigned int begin = block * s_blockSize;
+            unsigned int end = std::min(begin + s_blockSize, m_count);
+            m_blockLiveCounts[block] = FindLiveRuns(begin, end, deltaTime, m_blockRunCounts[block]);
+        });
+
+    // Prefix sum of the counts gives where the live particles of each block go
+    m_blockOffsets.resize(blockCount);
+    unsigned int liveCount = 0;
+    for (unsigned int block = 0; block < blockCount; ++block)
+    {
+        m_blockOffsets[block] = liveCount;
+        liveCount += m_blockLiveCounts[block];
+    }
+
+    // Integrate the live particles while their runs move down to close the gaps, so each array is read and written once
+    // Each task goes through all the blocks in order for one attribute. Runs only move down, over particles that were
+    // already moved or are dead, so nothing is overwritten before it is read
+    ParallelUtils::For(AttributeCount, [&](unsigned int attribute)
+        {
+            if (attribute <= PositionZ)
+            {
+                MoveAxis(attribute - PositionX, deltaTime);
+            }
+            else if (attribute == Age)
+            {
+                MoveAge(deltaTime);
+            }
+            else if (attribute > VelocityZ)
+            {
+                MoveAttribute(static_cast<Attribute>(attribute));
+            }
+            // Velocities are integrated with the positions
+        });
+
+    m_count = liveCount;
+}
+
+unsigned int CpuParticleSystem::FindLiveRuns(unsigned int begin, unsigned int end, float deltaTime, unsigned int& runCount)
+{
+    const float* age = m_particles[Age].data();
+    const float* lifetime = m_particles[Lifetime].data();
+    unsigned int* runSources = m_runSources.data() + begin;
+    unsigned int* runOffsets = m_runOffsets.data() + begin;
+    unsigned int liveCount = 0;
+    unsigned int previousAlive = 0;
+    runCount = 0;
+    for (unsigned int group = begin; group < end; group += s_groupSize)
+    {
+        // Most groups have no deaths, and only extend the current run
+        unsigned int groupEnd = std::min(group + s_groupSize, end);
+        if (previousAlive && groupEnd - group == s_groupSize)
+        {
+            const float* groupAge = age + group;
+            const float* groupLifetime = lifetime + group;
+            unsigned int groupLiveCount = 0;
+            for (unsigned int k = 0; k < s_groupSize; ++k)
+            {
+                groupLiveCount += groupAge[k] + deltaTime < groupLifetime[k] ? 1 : 0;
+            }
+            if (groupLiveCount == s_groupSize)
+            {
+                liveCount += s_groupSize;
+                continue;
+            }
+        }
+
+        // Every particle is stored as a run, but only the ones that start a run advance, so there are no branches
+        for (unsigned int i = group; i < groupEnd; ++i)
+        {
+            unsigned int alive = age[i] + deltaTime < lifetime[i] ? 1 : 0;
+            runSources[runCount] = i;
+            runOffsets[runCount] = liveCount;
+            runCount += alive & ~previousAlive;
+            liveCount += alive;
+            previousAlive = alive;
+        }
+    }
+    return liveCount;
+}
+
+template<typename TFunction>
+void CpuParticleSystem::ForEachRun(TFunction&& function) const
+{
+    for (unsigned int block = 0; block < GetBlockCount(); ++block)
+    {
+        unsigned int begin = block * s_blockSize;
+        const unsigned int* runSources = m_runSources.data() + begin;
+        const unsigned int* runOffsets = m_runOffsets.data() + begin;
+        unsigned int runCount = m_blockRunCounts[block];
+        for (unsigned int run = 0; run < runCount; ++run)
+        {
+            unsigned int runEnd = run + 1 < runCount ? runOffsets[run + 1] : m_blockLiveCounts[block];
+            function(runSources[run], m_blockOffsets[block] + runOffsets[run], runEnd - runOffsets[run]);
+        }
+    }
+}
+
+void CpuParticleSystem::MoveAxis(unsigned int axis, float deltaTime)
+{
+    float* position = m_particles[PositionX + axis].data();
+    float* velocity = m_particles[VelocityX + axis].data();
+    float gravity = m_gravity[axis];
+    float drag = m_drag;
+    ForEachRun([&](unsigned int source, unsigned int destination, unsigned int count)
+        {
+            // Semi-implicit Euler. Each group is copied to local arrays, so the compiler knows that they don't overlap and
+            // uses SIMD instructions without checking it at runtime. The group is read before it is written, so it can
+            // overlap with its destination
+            unsigned int i = 0;
+            for (; i + s_groupSize <= count; i += s_groupSize)
+            {
+                float groupPosition[s_groupSize];
+                float groupVelocity[s_groupSize];
+                std::copy_n(position + source + i, s_groupSize, groupPosition);
+                std::copy_n(velocity + source + i, s_groupSize, groupVelocity);
+                for (unsigned int k = 0; k < s_groupSize; ++k)
+                {
+                    groupVelocity[k] += (gravity - drag * groupVelocity[k]) * deltaTime;
+                    groupPosition[k] += groupVelocity[k] * deltaTime;
+                }
+                std::copy_n(groupPosition, s_groupSize, position + destination + i);
+                std::copy_n(groupVelocity, s_groupSize, velocity + destination + i);
+            }
+            for (; i < count; ++i)
+            {
+                float particleVelocity = velocity[source + i] + (gravity - drag * velocity[source + i]) * deltaTime;
+                position[destination + i] = position[source + i] + particleVelocity * deltaTime;
+                velocity[destination + i] = particleVelocity;
+            }
+        });
+}
+
+void CpuParticleSystem::MoveAge(float deltaTime)
+{
+    float* age = m_particles[Age].data();
+    ForEachRun([&](unsigned int source, unsigned int destination, unsigned int count)
+        {
+            // Same groups as the positions, to use SIMD instructions
+            unsigned int i = 0;
+            for (; i + s_groupSize <= count; i += s_groupSize)
+            {
+                float groupAge[s_groupSize];
+                std::copy_n(age + source + i, s_groupSize, groupAge);
+                for (unsigned int k = 0; k < s_groupSize; ++k)
+                {
+                    groupAge[k] += deltaTime;
+                }
+                std::copy_n(groupAge, s_groupSize, age + destination + i);
+            }
+            for (; i < count; ++i)
+            {
+                age[destination + i] = age[source + i] + deltaTime;
+            }
+        });
+}
+
+void CpuParticleSystem::MoveAttribute(Attribute attribute)
+{
+    float* values = m_particles[attribute].data();
+    ForEachRun([&](unsigned int source, unsigned int destination, unsigned int count)
+        {
+            // Runs before the first death are already in place. The destination is before the source, so copying
+            // forward is safe when they overlap
+            if (source != destination)
+            {
+                std::copy_n(values + source, count, values + destination);
+            }
+        });
+}
+
+void CpuParticleSystem::WriteVertices(std::span<Vertex> vertices) const
+{
+    assert(vertices.size() >= m_count);
+
+    // Each block is written sequentially. Mapped memory is often uncached, and only fast to write in order
+    ParallelUtils::For(GetBlockCount(), [&](unsigned int block)
+        {
+            unsigned int begin = block * s_blockSize;
+            unsigned int end = std::min(begin + s_blockSize, m_count);
+            for (unsigned int i = begin; i < end; ++i)
+            {
+                Vertex& vertex = vertices[i];
+                vertex.position = glm::vec3(m_particles[PositionX][i], m_particles[PositionY][i], m_particles[PositionZ][i]);
+                vertex.size = m_particles[Size][i];
+                vertex.color = glm::vec4(m_particles[ColorR][i], m_particles[ColorG][i], m_particles[ColorB][i],
+                    1.0f - m_particles[Age][i] / m_particles[Lifetime][i]);
+            }
+        });
+}
@@ -0,0 +1,184 @@
+#include <ituGL/particles/GpuParticleSystem.h>
+
+#include <ituGL/core/DeviceGL.h>
+#include <ituGL/asset/ShaderLoader.h>
+#include <ituGL/geometry/VertexAttribute.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cassert>
+
+GpuParticleSystem::GpuParticleSystem()
+    : m_capacity(0)
+    , m_currentBuffer(0)
+    , m_hasParticles(false)
+    , m_emitCount(0)
+    , m_gravity(0.0f, -9.8f, 0.0f)
+    , m_drag(0.0f)
+    , m_attractors{}
+    , m_deltaTimeLocation(-1)
+    , m_emitLocation(-1)
+    , m_randomSeedLocation(-1)
+    , m_gravityLocation(-1)
+    , m_dragLocation(-1)
+    , m_attractorsLocation(-1)
+    , m_emitterPositionLocation(-1)
+    , m_emitterVelocityLocation(-1)
+    , m_emitterColorMinLocation(-1)
+    , m_emitterColorMaxLocation(-1)
+    , m_emitterLifetimeSizeLocation(-1)
+    , m_viewProjMatrixLocation(-1)
+{
+    m_emitter.position = glm::vec3(0.0f);
+    m_emitter.positionSpread = 0.0f;
+    m_emitter.velocity = glm::vec3(0.0f, 1.0f, 0.0f);
+    m_emitter.velocitySpread = 0.5f;
+    m_emitter.colorMin = glm::vec3(0.0f);
+    m_emitter.colorMax = glm::vec3(1.0f);
+    m_emitter.lifetime = glm::vec2(1.0f, 2.0f);
+    m_emitter.size = glm::vec2(1.0f, 4.0f);
+}
+
+void GpuParticleSystem::Initialize(unsigned int capacity)
+{
+    m_capacity = capacity;
+    m_currentBuffer = 0;
+    m_hasParticles = false;
+    m_emitCount = 0;
+
+    InitializeBuffers();
+    InitializeShaderPrograms();
+}
+
+void GpuParticleSystem::InitializeBuffers()
+{
+    VertexAttribute attribute(Data::Type::Float, 4);
+    for (unsigned int i = 0; i < 2; ++i)
+    {
+        // Each buffer is read as vertices by the update and the draw, and written by the update of the other buffer
+        m_vaos[i].Bind();
+        m_vbos[i].Bind();
+        m_vbos[i].AllocateData(m_capacity * sizeof(Particle), BufferObject::StreamCopy);
+        m_vaos[i].SetAttribute(0, attribute, offsetof(Particle, positionAge), sizeof(Particle));
+        m_vaos[i].SetAttribute(1, attribute, offsetof(Particle, velocityLifetime), sizeof(Particle));
+        m_vaos[i].SetAttribute(2, attribute, offsetof(Particle, colorSize), sizeof(Particle));
+        VertexArrayObject::Unbind();
+        VertexBufferObject::Unbind();
+
+        m_transformFeedbacks[i].Bind();
+        m_transformFeedbacks[i].SetBuffer(0, m_vbos[i]);
+        TransformFeedbackObject::Unbind();
+    }
+}
+
+void GpuParticleSystem::InitializeShaderPrograms()
+{
+    // Update: the vertex shader integrates or creates each particle, the geometry shader only outputs the ones alive
+    {
+        Shader vertexShader = ShaderLoader::Load(Shader::VertexShader, "shaders/particles/update.vert");
+        Shader geometryShader = ShaderLoader::Load(Shader::GeometryShader, "shaders/particles/update.geom");
+        Shader fragmentShader = ShaderLoader::Load(Shader::FragmentShader, "shaders/particles/empty.frag");
+
+        // The outputs are written in the same layout as Particle
+        std::array<const char*, 3> varyings = { "NextPositionAge", "NextVelocityLifetime", "NextColorSize" };
+        m_updateProgram.SetTransformFeedbackVaryings(varyings);
+        m_updateProgram.Build(vertexShader, fragmentShader, geometryShader);
+
+        m_deltaTimeLocation = m_updateProgram.GetUniformLocation("DeltaTime");
+        m_emitLocation = m_updateProgram.GetUniformLocation("Emit");
+        m_randomSeedLocation = m_updateProgram.GetUniformLocation("RandomSeed");
+        m_gravityLocation = m_updateProgram.GetUniformLocation("Gravity");
+        m_dragLocation = m_updateProgram.GetUniformLocation("Drag");
+        m_attractorsLocation = m_updateProgram.GetUniformLocation("Attractors");
+        m_emitterPositionLocation = m_updateProgram.GetUniformLocation("EmitterPosition");
+        m_emitterVelocityLocation = m_updateProgram.GetUniformLocation("EmitterVelocity");
+        m_emitterColorMinLocation = m_updateProgram.GetUniformLocation("EmitterColorMin");
+        m_emitterColorMaxLocation = m_updateProgram.GetUniformLocation("EmitterColorMax");
+        m_emitterLifetimeSizeLocation = m_updateProgram.GetUniformLocation("EmitterLifetimeSize");
+    }
+
+    // Draw
+    {
+        Shader vertexShader = ShaderLoader::Load(Shader::VertexShader, "shaders/particles/draw.vert");
+        Shader fragmentShader = ShaderLoader::Load(Shader::FragmentShader, "shaders/particles/draw.frag");
+        m_drawProgram.Build(vertexShader, fragmentShader);
+
+        m_viewProjMatrixLocation = m_drawProgram.GetUniformLocation("ViewProjMatrix");
+    }
+}
+
+void GpuParticleSystem::SetAttractor(unsigned int index, const glm::vec3& position, float strength)
+{
+    assert(index < s_maxAttractors);
+    m_attractors[index] = glm::vec4(position, strength);
+}
+
+void GpuParticleSystem::Emit(unsigned int count)
+{
+    // More than the capacity would be dropped anyway
+    m_emitCount = std::min(m_emitCount + count, m_capacity);
+}
+
+void GpuParticleSystem::Update(float deltaTime)
+{
+    if (!m_hasParticles && m_emitCount == 0)
+        return;
+
+    m_updateProgram.Use();
+    m_updateProgram.SetUniform(m_deltaTimeLocation, deltaTime);
+    m_updateProgram.SetUniform(m_randomSeedLocation, static_cast<GLuint>(rand()));
+    m_updateProgram.SetUniform(m_gravityLocation, m_gravity);
+    m_updateProgram.SetUniform(m_dragLocation, m_drag);
+    m_updateProgram.SetUniforms(m_attractorsLocation, std::span<const glm::vec4>(m_attractors));
+    m_updateProgram.SetUniform(m_emitterPositionLocation, glm::vec4(m_emitter.position, m_emitter.positionSpread));
+    m_updateProgram.SetUniform(m_emitterVelocityLocation, glm::vec4(m_emitter.velocity, m_emitter.velocitySpread));
+    m_updateProgram.SetUniform(m_emitterColorMinLocation, m_emitter.colorMin);
+    m_updateProgram.SetUniform(m_emitterColorMaxLocation, m_emitter.colorMax);
+    m_updateProgram.SetUniform(m_emitterLifetimeSizeLocation, glm::vec4(m_emitter.lifetime, m_emitter.size));
+
+    // Nothing is rasterized, the particles are only captured in the next buffer
+    DeviceGL& device = DeviceGL::GetInstance();
+    device.SetFeatureEnabled(GL_RASTERIZER_DISCARD, true);
+
+    unsigned int nextBuffer = 1 - m_currentBuffer;
+    TransformFeedbackObject& transformFeedback = m_transformFeedbacks[nextBuffer];
+    transformFeedback.Bind();
+    transformFeedback.Begin(Drawcall::Primitive::Points);
+
+    // The particles alive are written first, with the number that the last update captured
+    if (m_hasParticles)
+    {
+        m_updateProgram.SetUniform(m_emitLocation, 0);
+        m_vaos[m_currentBuffer].Bind();
+        m_transformFeedbacks[m_currentBuffer].Draw(Drawcall::Primitive::Points);
+    }
+
+    // New particles are appended after them, until the buffer is full
+    if (m_emitCount > 0)
+    {
+        m_updateProgram.SetUniform(m_emitLocation, 1);
+        m_emitVAO.Bind();
+        Drawcall(Drawcall::Primitive::Points, m_emitCount).Draw();
+    }
+
+    transformFeedback.End();
+    TransformFeedbackObject::Unbind();
+    VertexArrayObject::Unbind();
+    device.SetFeatureEnabled(GL_RASTERIZER_DISCARD, false);
+
+    m_currentBuffer = nextBuffer;
+    m_hasParticles = true;
+    m_emitCount = 0;
+}
+
+void GpuParticleSystem::Draw(const glm::mat4& viewProjMatrix) const
+{
+    if (!m_hasParticles)
+        return;
+
+    m_drawProgram.Use();
+    m_drawProgram.SetUniform(m_viewProjMatrixLocation, viewProjMatrix);
+
+    m_vaos[m_currentBuffer].Bind();
+    m_transformFeedbacks[m_currentBuffer].Draw(Drawcall::Primitive::Points);
+    VertexArrayObject::Unbind();
+}
@@ -0,0 +1,121 @@
+#include <ituGL/particles/ParticleSorter.h>
+
+#include <ituGL/utils/ParallelUtils.h>
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+ParticleSorter::ParticleSorter() : m_count(0)
+{
+}
+
+void ParticleSorter::Sort(std::span<const float> positionX, std::span<const float> positionY, std::span<const float> positionZ,
+    const glm::mat4& viewMatrix)
+{
+    assert(positionX.size() == positionY.size() && positionX.size() == positionZ.size());
+    m_count = static_cast<unsigned int>(positionX.size());
+    if (m_keys.size() < m_count)
+    {
+        m_keys.resize(m_count);
+        m_indices.resize(m_count);
+        m_nextKeys.resize(m_count);
+        m_nextIndices.resize(m_count);
+    }
+
+    ComputeKeys(positionX, positionY, positionZ, viewMatrix);
+
+    // Least significant digit first. Each pass is stable, so the order of the previous digits is kept
+    for (unsigned int shift = 0; shift < 32; shift += s_digitBits)
+    {
+        if (SortDigit(shift))
+        {
+            std::swap(m_keys, m_nextKeys);
+            std::swap(m_indices, m_nextIndices);
+        }
+    }
+}
+
+unsigned int ParticleSorter::GetSortableKey(float value)
+{
+    // Positive floats already sort as integers once the sign bit is set. Negative ones sort reversed, so all their bits flip
+    unsigned int bits = std::bit_cast<unsigned int>(value);
+    unsigned int mask = (bits & 0x80000000u) ? 0xFFFFFFFFu : 0x80000000u;
+    return bits ^ mask;
+}
+
+void ParticleSorter::ComputeKeys(std::span<const float> positionX, std::span<const float> positionY, std::span<const float> positionZ,
+    const glm::mat4& viewMatrix)
+{
+    // The camera looks down -Z, so the farthest particles have the lowest depth and go first
+    glm::vec4 depthRow(viewMatrix[0][2], viewMatrix[1][2], viewMatrix[2][2], viewMatrix[3][2]);
+
+    unsigned int blockCount = (m_count + s_blockSize - 1) / s_blockSize;
+    ParallelUtils::For(blockCount, [&](unsigned int block)
+        {
+            unsigned int begin = block * s_blockSize;
+            unsigned int end = std::min(begin + s_blockSize, m_count);
+            for (unsigned int i = begin; i < end; ++i)
+            {
+                float depth = depthRow.x * positionX[i] + depthRow.y * positionY[i] + depthRow.z * positionZ[i] + depthRow.w;
+                m_keys[i] = GetSortableKey(depth);
+                m_indices[i] = i;
+            }
+        });
+}
+
+bool ParticleSorter::SortDigit(unsigned int shift)
+{
+    unsigned int blockCount = (m_count + s_blockSize - 1) / s_blockSize;
+    m_blockHistograms.resize(blockCount);
+
+    // Each pass has two parallel steps. With few blocks, waking the workers twice per pass costs about as much as
+    // the work, so the calling thread does it alone
+    unsigned int threadCount = blockCount >= s_minParallelBlockCount ? ParallelUtils::GetDefaultThreadCount() : 1;
+
+    // Count the digits of each block
+    ParallelUtils::For(blockCount, [&](unsigned int block)
+        {
+            std::array<unsigned int, s_digitCount>& histogram = m_blockHistograms[block];
+            histogram.fill(0);
+            unsigned int begin = block * s_blockSize;
+            unsigned int end = std::min(begin + s_blockSize, m_count);
+            for (unsigned int i = begin; i < end; ++i)
+            {
+                histogram[(m_keys[i] >> shift) & (s_digitCount - 1)]++;
+            }
+        }, threadCount);
+
+    // Turn the counts into the first output position of each digit in each block: all the smaller digits go before,
+    // and the same digit in previous blocks too
+    unsigned int offset = 0;
+    for (unsigned int digit = 0; digit < s_digitCount; ++digit)
+    {
+        unsigned int digitOffset = offset;
+        for (unsigned int block = 0; block < blockCount; ++block)
+        {
+            unsigned int count = m_blockHistograms[block][digit];
+            m_blockHistograms[block][digit] = offset;
+            offset += count;
+        }
+
+        // Skip the pass if this digit has all the keys, it would not move anything
+        if (offset - digitOffset == m_count)
+            return false;
+    }
+
+    // Scatter each block to its positions
+    ParallelUtils::For(blockCount, [&](unsigned int block)
+        {
+            std::array<unsigned int, s_digitCount>& positions = m_blockHistograms[block];
+            unsigned int begin = block * s_blockSize;
+            unsigned int end = std::min(begin + s_blockSize, m_count);
+            for (unsigned int i = begin; i < end; ++i)
+            {
+                unsigned int key = m_keys[i];
+                unsigned int position = positions[(key >> shift) & (s_digitCount - 1)]++;
+                m_nextKeys[position] = key;
+                m_nextIndices[position] = m_indices[i];
+            }
+        }, threadCount);
+    return true;
+}
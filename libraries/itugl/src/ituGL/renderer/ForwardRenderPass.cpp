@@ -20,7 +20,6 @@ void ForwardRenderPass::Render()
     Renderer& renderer = GetRenderer();
 
     const Camera& camera = renderer.GetCurrentCamera();
-    const auto& lights = renderer.GetLights();
     const auto& drawcallCollection = renderer.GetDrawcalls(m_drawcallCollectionIndex);
 
     // for all drawcalls
@@ -29,9 +28,10 @@ void ForwardRenderPass::Render()
         // Prepare drawcall states
         renderer.PrepareDrawcall(drawcallInfo);
 
-        std::shared_ptr<const ShaderProgram> shaderProgram = drawcallInfo.GetMaterial().GetShaderProgram();
+        std::shared_ptr<const ShaderProgram> shaderProgram = drawcallInfo.GetMaterial().GetUsedMaterial().GetShaderProgram();
 
-        //for all lights
+        //for all lights that reach the drawcall
+        std::span<const Light* const> lights = renderer.GetDrawcallLights(drawcallInfo);
         bool first = true;
         unsigned int lightIndex = 0;
         while (renderer.UpdateLights(shaderProgram, lights, lightIndex))
@@ -40,7 +40,7 @@ void ForwardRenderPass::Render()
             renderer.SetLightingRenderStates(first);
 
             // Draw
-            drawcallInfo.GetDrawcall().Draw();
+            renderer.Draw(drawcallInfo);
 
             first = false;
         }
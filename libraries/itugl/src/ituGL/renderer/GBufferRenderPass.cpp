@@ -102,7 +102,7 @@ void GBufferRenderPass::Render()
         renderer.PrepareDrawcall(drawcallInfo);
 
         // Render drawcall
-        drawcallInfo.GetDrawcall().Draw();
+        renderer.Draw(drawcallInfo);
     }
 
     renderer.GetDevice().SetFeatureEnabled(GL_FRAMEBUFFER_SRGB, wasSRGB);
@@ -9,15 +9,27 @@
 #include <ituGL/camera/Camera.h>
 #include <ituGL/texture/FramebufferObject.h>
 #include <ituGL/renderer/RenderPass.h>
+#include <ituGL/scene/FrustumCulling.h>
+#include <ituGL/utils/ParallelUtils.h>
+#include <glm/matrix.hpp>
+#include <glm/geometric.hpp>
 #include <span>
 #include <algorithm>
 #include <cassert>
 
-Renderer::DrawcallInfo::DrawcallInfo(const Material& material, unsigned int worldMatrixIndex, const VertexArrayObject& vao, const Drawcall& drawcall)
-    : m_material(material), m_worldMatrixIndex(worldMatrixIndex), m_vao(vao), m_drawcall(drawcall)
+Renderer::DrawcallInfo::DrawcallInfo(const Material& material, unsigned int worldMatrixIndex, unsigned int lightListIndex,
+    const VertexArrayObject& vao, const Drawcall& drawcall, std::span<const Meshlet> meshlets)
+    : m_material(material), m_worldMatrixIndex(worldMatrixIndex), m_lightListIndex(lightListIndex), m_vao(vao), m_drawcall(drawcall)
+    , m_meshlets(meshlets)
 {
 }
 
+// Most lights per drawcall by default, enough for the usual scenes with forward lighting
+static const unsigned int s_defaultMaxDrawcallLights = 8;
+
+// Meshlets are culled in blocks of this size, each block is one index of ParallelUtils::For
+static const unsigned int s_meshletCullingBlockSize = 4096;
+
 Renderer::DrawcallCollection::DrawcallCollection(const DrawcallSupportedFunction& isSupported) : m_isSupported(isSupported)
 {
 }
@@ -49,8 +61,14 @@ void Renderer::DrawcallCollection::Clear()
 Renderer::Renderer(DeviceGL& device)
     : m_device(device)
     , m_currentCamera(nullptr)
+    , m_batchMaterial(nullptr)
+    , m_meshletCulling(true)
+    , m_testedMeshletCount(0)
+    , m_drawnMeshletCount(0)
+    , m_culledDrawcall(nullptr)
     , m_defaultFramebuffer(FramebufferObject::GetDefault())
     , m_currentFramebuffer(m_defaultFramebuffer)
+    , m_maxDrawcallLights(s_defaultMaxDrawcallLights)
     , m_drawcallCollections(1)
 {
     InitializeFullscreenMesh();
@@ -106,9 +124,17 @@ void Renderer::Render()
 {
     assert(m_currentCamera);
 
+    m_testedMeshletCount = 0;
+    m_drawnMeshletCount = 0;
+
+    AssignLights();
+
     for (auto& pass : m_passes)
     {
         SetCurrentFramebuffer(pass->GetTargetFramebuffer());
+
+        // Passes can use other programs and textures, batches don't continue between them
+        m_batchMaterial = nullptr;
         pass->Render();
     }
 
@@ -119,6 +145,9 @@ void Renderer::Reset()
 {
     m_worldMatrices.clear();
     m_lights.clear();
+    m_lightListBounds.clear();
+    m_lightListOffsets.clear();
+    m_lightListLights.clear();
 
     for (auto& collection : m_drawcallCollections)
     {
@@ -126,6 +155,7 @@ void Renderer::Reset()
     }
 
     m_currentCamera = nullptr;
+    m_culledDrawcall = nullptr;
 }
 
 int Renderer::AddRenderPass(std::unique_ptr<RenderPass> renderPass)
@@ -225,6 +255,37 @@ void Renderer::AddLight(const Light& light)
     m_lights.push_back(&light);
 }
 
+std::span<const Light* const> Renderer::GetDrawcallLights(const DrawcallInfo& drawcallInfo) const
+{
+    // Before the lists are assigned, all the lights are used
+    unsigned int lightListIndex = drawcallInfo.GetLightListIndex();
+    if (lightListIndex + 1 >= m_lightListOffsets.size())
+    {
+        return m_lights;
+    }
+
+    unsigned int first = m_lightListOffsets[lightListIndex];
+    unsigned int count = m_lightListOffsets[lightListIndex + 1] - first;
+    return std::span<const Light* const>(m_lightListLights).subspan(first, count);
+}
+
+void Renderer::AssignLights()
+{
+    m_lightGrid.Build(m_lights);
+
+    m_lightListOffsets.assign(1, 0);
+    m_lightListLights.clear();
+    for (const glm::vec4& bounds : m_lightListBounds)
+    {
+        m_lightGrid.Query(glm::vec3(bounds), bounds.w, m_maxDrawcallLights, m_lightIndices);
+        for (unsigned int lightIndex : m_lightIndices)
+        {
+            m_lightListLights.push_back(m_lights[lightIndex]);
+        }
+        m_lightListOffsets.push_back(static_cast<unsigned int>(m_lightListLights.size()));
+    }
+}
+
 std::span<const Renderer::DrawcallInfo> Renderer::GetDrawcalls(unsigned int collectionIndex) const
 {
     return m_drawcallCollections[collectionIndex].GetDrawcalls();
@@ -238,8 +299,29 @@ void Renderer::AddModel(const Model& model, const glm::mat4& worldMatrix)
     const Mesh& mesh = model.GetMesh();
     for (unsigned int submeshIndex = 0; submeshIndex < mesh.GetSubmeshCount(); ++submeshIndex)
     {
-        DrawcallInfo drawcallInfo(model.GetMaterial(submeshIndex), worldMatrixIndex,
-            mesh.GetSubmeshVertexArray(submeshIndex), mesh.GetSubmeshDrawcall(submeshIndex));
+        // Submeshes with their own local matrix need a world matrix of their own
+        unsigned int submeshWorldMatrixIndex = worldMatrixIndex;
+        if (mesh.HasSubmeshLocalMatrix(submeshIndex))
+        {
+            submeshWorldMatrixIndex = static_cast<unsigned int>(m_worldMatrices.size());
+            m_worldMatrices.push_back(worldMatrix * mesh.GetSubmeshLocalMatrix(submeshIndex));
+        }
+
+        // Bounding sphere in world space, to find the lights that reach the submesh
+        // The bounds are in model space, with the local matrix already applied, so only the world matrix transforms them
+        glm::vec4 boundingSphere(glm::vec3(m_worldMatrices[submeshWorldMatrixIndex][3]), -1.0f);
+        if (mesh.HasSubmeshBounds(submeshIndex))
+        {
+            const MeshBounds& bounds = mesh.GetSubmeshBounds(submeshIndex);
+            float scale = std::max(glm::length(glm::vec3(worldMatrix[0])),
+                std::max(glm::length(glm::vec3(worldMatrix[1])), glm::length(glm::vec3(worldMatrix[2]))));
+            boundingSphere = glm::vec4(glm::vec3(worldMatrix * glm::vec4(bounds.sphereCenter, 1.0f)), bounds.sphereRadius * scale);
+        }
+        unsigned int lightListIndex = static_cast<unsigned int>(m_lightListBounds.size());
+        m_lightListBounds.push_back(boundingSphere);
+
+        DrawcallInfo drawcallInfo(model.GetMaterial(submeshIndex), submeshWorldMatrixIndex, lightListIndex,
+            mesh.GetSubmeshVertexArray(submeshIndex), mesh.GetSubmeshDrawcall(submeshIndex), mesh.GetSubmeshMeshlets(submeshIndex));
 
         for (DrawcallCollection& collection : m_drawcallCollections)
         {
@@ -283,14 +365,44 @@ bool Renderer::IsFrontToBack(const DrawcallInfo& a, const DrawcallInfo& b) const
     return IsBackToFront(b, a);
 }
 
+bool Renderer::IsBatchOrder(const DrawcallInfo& a, const DrawcallInfo& b) const
+{
+    // Materials that are not ready are drawn with their placeholders, so they go in the batch of the placeholder
+    const Material& aMaterial = a.GetMaterial().GetUsedMaterial();
+    const Material& bMaterial = b.GetMaterial().GetUsedMaterial();
+    if (aMaterial.GetShaderProgram() != bMaterial.GetShaderProgram())
+    {
+        return aMaterial.GetShaderProgram() < bMaterial.GetShaderProgram();
+    }
+
+    int textureOrder = aMaterial.CompareTextures(bMaterial);
+    if (textureOrder != 0)
+    {
+        return textureOrder < 0;
+    }
+
+    // Inside the batch, keep the drawcalls of the same VAO together
+    return std::less<const VertexArrayObject*>()(&a.GetVAO(), &b.GetVAO());
+}
+
 void Renderer::PrepareDrawcall(const DrawcallInfo& drawcallInfo, Material::OverrideFlags materialOverride)
 {
-    std::shared_ptr<const ShaderProgram> shaderProgram = drawcallInfo.GetMaterial().GetShaderProgram();
+    const Material& material = drawcallInfo.GetMaterial();
+    // Program that the material uses, the one of its placeholder if it is not ready
+    std::shared_ptr<const ShaderProgram> shaderProgram = material.GetUsedMaterial().GetShaderProgram();
 
-    // TODO: Room for optimization here, caching current material, current worldMatrixIndex and current VAO
+    // TODO: Room for optimization here, caching current worldMatrixIndex and current VAO
 
-    // Setup material
-    drawcallInfo.GetMaterial().Use(materialOverride);
+    // Setup material. If it shares program and textures with the previous one, only the data uniforms change
+    if (m_batchMaterial && material.IsBatchCompatible(*m_batchMaterial))
+    {
+        material.UseBatched(materialOverride);
+    }
+    else
+    {
+        material.Use(materialOverride);
+    }
+    m_batchMaterial = &material;
 
     // Setup world matrix
     // Setup camera
@@ -298,6 +410,103 @@ void Renderer::PrepareDrawcall(const DrawcallInfo& drawcallInfo, Material::Overr
 
     // Setup VAO
     drawcallInfo.GetVAO().Bind();
+
+    CullMeshlets(drawcallInfo);
+}
+
+void Renderer::Draw(const DrawcallInfo& drawcallInfo) const
+{
+    const Drawcall& drawcall = drawcallInfo.GetDrawcall();
+    if (m_culledDrawcall == &drawcall)
+    {
+        drawcall.DrawRanges(m_meshletOffsets, m_meshletCounts);
+    }
+    else
+    {
+        drawcall.Draw();
+    }
+}
+
+void Renderer::CullMeshlets(const DrawcallInfo& drawcallInfo)
+{
+    m_culledDrawcall = nullptr;
+
+    std::span<const Meshlet> meshlets = drawcallInfo.GetMeshlets();
+    const Drawcall& drawcall = drawcallInfo.GetDrawcall();
+    if (!m_meshletCulling || meshlets.empty() || drawcall.GetEboType() == Data::Type::None)
+    {
+        return;
+    }
+
+    const Camera& camera = GetCurrentCamera();
+    const glm::mat4& worldMatrix = GetWorldMatrix(drawcallInfo);
+
+    // Frustum planes in object space, so the meshlet bounds don't need to be transformed
+    FrustumCulling::Planes planes = FrustumCulling::GetPlanes(camera.GetViewProjectionMatrix() * worldMatrix);
+
+    // The cone test needs a perspective camera, and a world matrix that keeps the angles
+    glm::vec3 scale(glm::length(glm::vec3(worldMatrix[0])), glm::length(glm::vec3(worldMatrix[1])), glm::length(glm::vec3(worldMatrix[2])));
+    float minScale = std::min(std::min(scale.x, scale.y), scale.z);
+    float maxScale = std::max(std::max(scale.x, scale.y), scale.z);
+    bool coneCulling = camera.GetProjectionMatrix()[3][3] == 0.0f && maxScale <= minScale * 1.01f;
+    glm::vec3 cameraPosition = glm::vec3(glm::inverse(worldMatrix) * glm::vec4(camera.ExtractTranslation(), 1.0f));
+
+    auto CullBlock = [&](unsigned int blockIndex)
+    {
+        size_t first = static_cast<size_t>(blockIndex) * s_meshletCullingBlockSize;
+        size_t last = std::min(first + s_meshletCullingBlockSize, meshlets.size());
+        for (size_t meshletIndex = first; meshletIndex < last; ++meshletIndex)
+        {
+            const Meshlet& meshlet = meshlets[meshletIndex];
+            bool visible = true;
+            for (const glm::vec4& plane : planes)
+            {
+                visible = visible && glm::dot(glm::vec3(plane), meshlet.center) + plane.w >= -meshlet.radius;
+            }
+            if (visible && coneCulling)
+            {
+                glm::vec3 direction = meshlet.coneApex - cameraPosition;
+                float distance = glm::length(direction);
+                visible = distance <= 0.0f || glm::dot(direction, meshlet.coneAxis) < meshlet.coneCutoff * distance;
+            }
+            m_meshletVisibility[meshletIndex] = visible ? 1 : 0;
+        }
+    };
+
+    m_meshletVisibility.resize(meshlets.size());
+    unsigned int blockCount = static_cast<unsigned int>((meshlets.size() + s_meshletCullingBlockSize - 1) / s_meshletCullingBlockSize);
+    // A single block runs on this thread, more blocks are shared with the persistent worker pool
+    ParallelUtils::For(blockCount, CullBlock);
+
+    // Consecutive visible meshlets are consecutive in the EBO too, they are drawn as a single range
+    m_meshletOffsets.clear();
+    m_meshletCounts.clear();
+    const char* basePointer = nullptr;
+    unsigned int elementSize = Data::GetTypeSize(drawcall.GetEboType());
+    unsigned int rangeEnd = ~0u;
+    for (size_t meshletIndex = 0; meshletIndex < meshlets.size(); ++meshletIndex)
+    {
+        if (!m_meshletVisibility[meshletIndex])
+        {
+            continue;
+        }
+
+        const Meshlet& meshlet = meshlets[meshletIndex];
+        if (meshlet.firstElement == rangeEnd)
+        {
+            m_meshletCounts.back() += meshlet.elementCount;
+        }
+        else
+        {
+            m_meshletOffsets.push_back(basePointer + drawcall.GetFirst() + meshlet.firstElement * elementSize);
+            m_meshletCounts.push_back(meshlet.elementCount);
+        }
+        rangeEnd = meshlet.firstElement + meshlet.elementCount;
+        m_drawnMeshletCount++;
+    }
+    m_testedMeshletCount += static_cast<unsigned int>(meshlets.size());
+
+    m_culledDrawcall = &drawcall;
 }
 
 void Renderer::SetLightingRenderStates(bool firstPass)
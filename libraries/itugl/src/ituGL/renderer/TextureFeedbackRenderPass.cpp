@@ -0,0 +1,129 @@
+#include <ituGL/renderer/TextureFeedbackRenderPass.h>
+
+#include <ituGL/renderer/Renderer.h>
+#include <ituGL/camera/Camera.h>
+#include <ituGL/asset/ShaderLoader.h>
+#include <ituGL/asset/TextureStreamer.h>
+#include <ituGL/geometry/VertexArrayObject.h>
+#include <ituGL/texture/Texture2DObject.h>
+#include <ituGL/texture/FramebufferObject.h>
+#include <cmath>
+
+TextureFeedbackRenderPass::TextureFeedbackRenderPass(std::shared_ptr<TextureStreamer> textureStreamer, int width, int height, int drawcallCollectionIndex)
+    : m_textureStreamer(textureStreamer)
+    , m_width(width)
+    , m_height(height)
+    , m_drawcallCollectionIndex(drawcallCollectionIndex)
+    , m_frameInterval(4)
+    , m_frameIndex(0)
+    , m_worldViewProjMatrixLocation(-1)
+    , m_feedbackIdLocation(-1)
+    , m_lodBiasLocation(-1)
+    , m_shaderProgramRegistered(false)
+{
+    InitTextures();
+    InitFramebuffer();
+    InitShaderProgram();
+    m_feedback.resize(static_cast<size_t>(width) * height * 2);
+}
+
+void TextureFeedbackRenderPass::InitTextures()
+{
+    m_depthTexture = std::make_shared<Texture2DObject>();
+    m_depthTexture->Bind();
+    m_depthTexture->SetImage(0, m_width, m_height, TextureObject::FormatDepth, TextureObject::InternalFormatDepth);
+    m_depthTexture->SetParameter(TextureObject::ParameterEnum::MinFilter, GL_NEAREST);
+    m_depthTexture->SetParameter(TextureObject::ParameterEnum::MagFilter, GL_NEAREST);
+
+    // Feedback id and derivatives, with float precision
+    m_feedbackTexture = std::make_shared<Texture2DObject>();
+    m_feedbackTexture->Bind();
+    m_feedbackTexture->SetImage(0, m_width, m_height, TextureObject::FormatRG, TextureObject::InternalFormatRG32F);
+    m_feedbackTexture->SetParameter(TextureObject::ParameterEnum::MinFilter, GL_NEAREST);
+    m_feedbackTexture->SetParameter(TextureObject::ParameterEnum::MagFilter, GL_NEAREST);
+
+    Texture2DObject::Unbind();
+}
+
+void TextureFeedbackRenderPass::InitFramebuffer()
+{
+    std::shared_ptr<FramebufferObject> targetFramebuffer = std::make_shared<FramebufferObject>();
+
+    targetFramebuffer->Bind();
+    targetFramebuffer->SetTexture(FramebufferObject::Target::Draw, FramebufferObject::Attachment::Depth, *m_depthTexture);
+    targetFramebuffer->SetTexture(FramebufferObject::Target::Draw, FramebufferObject::Attachment::Color0, *m_feedbackTexture);
+
+    m_targetFramebuffer = targetFramebuffer;
+
+    FramebufferObject::Unbind();
+}
+
+void TextureFeedbackRenderPass::InitShaderProgram()
+{
+    // Load shaders and build shader program
+    Shader vertexShader = ShaderLoader(Shader::VertexShader).Load("shaders/renderer/texturefeedback.vert");
+    Shader fragmentShader = ShaderLoader(Shader::FragmentShader).Load("shaders/renderer/texturefeedback.frag");
+    m_shaderProgram = std::make_shared<ShaderProgram>();
+    m_shaderProgram->Build(vertexShader, fragmentShader);
+
+    // Get uniform locations
+    m_worldViewProjMatrixLocation = m_shaderProgram->GetUniformLocation("WorldViewProjMatrix");
+    m_feedbackIdLocation = m_shaderProgram->GetUniformLocation("FeedbackId");
+    m_lodBiasLocation = m_shaderProgram->GetUniformLocation("LodBias");
+}
+
+void TextureFeedbackRenderPass::Render()
+{
+    if (m_frameIndex++ % m_frameInterval != 0)
+    {
+        return;
+    }
+
+    Renderer& renderer = GetRenderer();
+
+    // The renderer is not available in the constructor
+    if (!m_shaderProgramRegistered)
+    {
+        ShaderProgram::Location worldViewProjMatrixLocation = m_worldViewProjMatrixLocation;
+        renderer.RegisterShaderProgram(m_shaderProgram,
+            [=](const ShaderProgram& shaderProgram, const glm::mat4& worldMatrix, const Camera& camera, bool cameraChanged)
+            {
+                shaderProgram.SetUniform(worldViewProjMatrixLocation, camera.GetViewProjectionMatrix() * worldMatrix);
+            },
+            nullptr);
+        m_shaderProgramRegistered = true;
+    }
+
+    // Render at the feedback size, and restore the viewport after
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    renderer.GetDevice().SetViewport(0, 0, m_width, m_height);
+    renderer.GetDevice().Clear(true, Color(0.0f, 0.0f, 0.0f, 0.0f), true, 1.0f);
+
+    renderer.GetDevice().EnableFeature(GL_DEPTH_TEST);
+    renderer.GetDevice().DisableFeature(GL_BLEND);
+    glDepthFunc(GL_LESS);
+    glDepthMask(GL_TRUE);
+
+    m_shaderProgram->Use();
+
+    // Derivatives are bigger than on screen by the ratio between the sizes
+    m_shaderProgram->SetUniform(m_lodBiasLocation, std::log2(static_cast<float>(m_width) / viewport[2]));
+
+    for (const Renderer::DrawcallInfo& drawcallInfo : renderer.GetDrawcalls(m_drawcallCollectionIndex))
+    {
+        // Drawcalls without streamed textures write id 0, but they still occlude the others
+        unsigned int feedbackId = m_textureStreamer->GetFeedbackId(drawcallInfo.GetMaterial());
+        m_shaderProgram->SetUniform(m_feedbackIdLocation, static_cast<float>(feedbackId));
+
+        renderer.UpdateTransforms(m_shaderProgram, drawcallInfo.GetWorldMatrixIndex());
+        drawcallInfo.GetVAO().Bind();
+        drawcallInfo.GetDrawcall().Draw();
+    }
+
+    // Small target, so reading it back synchronously is cheap
+    glReadPixels(0, 0, m_width, m_height, GL_RG, GL_FLOAT, m_feedback.data());
+    m_textureStreamer->ProcessFeedback(m_feedback);
+
+    renderer.GetDevice().SetViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
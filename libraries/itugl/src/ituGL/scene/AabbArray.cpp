@@ -0,0 +1,56 @@
+#include <ituGL/scene/AabbArray.h>
+
+#include <cassert>
+
+AabbArray::AabbArray()
+{
+}
+
+void AabbArray::Resize(unsigned int size)
+{
+    m_centerX.resize(size);
+    m_centerY.resize(size);
+    m_centerZ.resize(size);
+    m_extentsX.resize(size);
+    m_extentsY.resize(size);
+    m_extentsZ.resize(size);
+}
+
+void AabbArray::Set(unsigned int index, const glm::vec3& center, const glm::vec3& extents)
+{
+    m_centerX[index] = center.x;
+    m_centerY[index] = center.y;
+    m_centerZ[index] = center.z;
+    m_extentsX[index] = extents.x;
+    m_extentsY[index] = extents.y;
+    m_extentsZ[index] = extents.z;
+}
+
+void AabbArray::PushBack(const glm::vec3& center, const glm::vec3& extents)
+{
+    Resize(GetSize() + 1);
+    Set(GetSize() - 1, center, extents);
+}
+
+void AabbArray::PopBack()
+{
+    assert(GetSize() > 0);
+    Resize(GetSize() - 1);
+}
+
+void AabbArray::Copy(unsigned int from, unsigned int to)
+{
+    Set(to, GetCenter(from), GetExtents(from));
+}
+
+void AabbArray::Permute(std::span<const unsigned int> order)
+{
+    assert(order.size() == GetSize());
+    AabbArray permuted;
+    permuted.Resize(GetSize());
+    for (unsigned int i = 0; i < GetSize(); ++i)
+    {
+        permuted.Set(i, GetCenter(order[i]), GetExtents(order[i]));
+    }
+    *this = std::move(permuted);
+}
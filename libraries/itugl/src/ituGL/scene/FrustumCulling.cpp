@@ -0,0 +1,140 @@
+#include <ituGL/scene/FrustumCulling.h>
+
+#include <ituGL/scene/AabbArray.h>
+#include <glm/gtc/matrix_access.hpp>
+#include <glm/geometric.hpp>
+#include <glm/common.hpp>
+#include <algorithm>
+#include <limits>
+#include <bit>
+#include <cassert>
+
+// Run testBlock(first, count, distances) on each block of bounds, and pack the results in the visibility mask
+// The test writes in distances[i] the lowest signed distance of bounds i to the planes, so they are visible if it is positive
+template<unsigned int BlockSize, typename TTestBlock>
+static unsigned int CullBlocks(unsigned int count, std::vector<unsigned int>& visibilityMask, TTestBlock&& testBlock)
+{
+    visibilityMask.resize((count + BlockSize - 1) / BlockSize);
+
+    unsigned int visibleCount = 0;
+    for (unsigned int blockIndex = 0; blockIndex < visibilityMask.size(); ++blockIndex)
+    {
+        unsigned int first = blockIndex * BlockSize;
+        unsigned int blockCount = std::min(BlockSize, count - first);
+
+        // Full blocks get a loop of constant length
+        float distances[BlockSize];
+        if (blockCount == BlockSize)
+        {
+            testBlock(first, BlockSize, distances);
+        }
+        else
+        {
+            testBlock(first, blockCount, distances);
+        }
+
+        unsigned int word = 0;
+        for (unsigned int i = 0; i < blockCount; ++i)
+        {
+            word |= (distances[i] >= 0.0f ? 1u : 0u) << i;
+        }
+        visibilityMask[blockIndex] = word;
+        visibleCount += std::popcount(word);
+    }
+    return visibleCount;
+}
+
+FrustumCulling::Planes FrustumCulling::GetPlanes(const glm::mat4& viewProjectionMatrix)
+{
+    glm::vec4 row0 = glm::row(viewProjectionMatrix, 0);
+    glm::vec4 row1 = glm::row(viewProjectionMatrix, 1);
+    glm::vec4 row2 = glm::row(viewProjectionMatrix, 2);
+    glm::vec4 row3 = glm::row(viewProjectionMatrix, 3);
+    Planes planes = { row3 + row0, row3 - row0, row3 + row1, row3 - row1, row3 + row2, row3 - row2 };
+    for (glm::vec4& plane : planes)
+    {
+        plane /= glm::length(glm::vec3(plane));
+    }
+    return planes;
+}
+
+unsigned int FrustumCulling::CullAabbs(const Planes& planes, const AabbArray& bounds, std::vector<unsigned int>& visibilityMask)
+{
+    const float* centerX = bounds.GetCenterX().data();
+    const float* centerY = bounds.GetCenterY().data();
+    const float* centerZ = bounds.GetCenterZ().data();
+    const float* extentsX = bounds.GetExtentsX().data();
+    const float* extentsY = bounds.GetExtentsY().data();
+    const float* extentsZ = bounds.GetExtentsZ().data();
+
+    // The box is outside if it is behind any plane, even at its corner furthest along the normal
+    Planes absPlanes;
+    std::transform(planes.begin(), planes.end(), absPlanes.begin(), [](const glm::vec4& plane) { return glm::abs(plane); });
+    auto GetDistance = [&](unsigned int planeIndex, unsigned int index)
+    {
+        const glm::vec4& plane = planes[planeIndex];
+        const glm::vec4& absPlane = absPlanes[planeIndex];
+        return plane.x * centerX[index] + plane.y * centerY[index] + plane.z * centerZ[index] + plane.w
+            + absPlane.x * extentsX[index] + absPlane.y * extentsY[index] + absPlane.z * extentsZ[index];
+    };
+
+    // The planes are written out, so each iteration is straight code that the compiler can vectorize
+    // glm::min returns a value. std::min returns a reference, and GCC doesn't vectorize the loop at -O2 with it
+    return CullBlocks<s_blockSize>(bounds.GetSize(), visibilityMask, [&](unsigned int first, unsigned int count, float* distances)
+        {
+            for (unsigned int i = 0; i < count; ++i)
+            {
+                unsigned int index = first + i;
+                distances[i] = glm::min(glm::min(glm::min(GetDistance(0, index), GetDistance(1, index)), glm::min(GetDistance(2, index), GetDistance(3, index))),
+                    glm::min(GetDistance(4, index), GetDistance(5, index)));
+            }
+        });
+}
+
+unsigned int FrustumCulling::CullSpheres(const Planes& planes, std::span<const float> centerX, std::span<const float> centerY,
+    std::span<const float> centerZ, std::span<const float> radius, std::vector<unsigned int>& visibilityMask)
+{
+    assert(centerY.size() == centerX.size() && centerZ.size() == centerX.size() && radius.size() == centerX.size());
+
+    const float* x = centerX.data();
+    const float* y = centerY.data();
+    const float* z = centerZ.data();
+    const float* r = radius.data();
+
+    auto GetDistance = [&](unsigned int planeIndex, unsigned int index)
+    {
+        const glm::vec4& plane = planes[planeIndex];
+        return plane.x * x[index] + plane.y * y[index] + plane.z * z[index] + plane.w;
+    };
+
+    return CullBlocks<s_blockSize>(static_cast<unsigned int>(centerX.size()), visibilityMask, [&](unsigned int first, unsigned int count, float* distances)
+        {
+            for (unsigned int i = 0; i < count; ++i)
+            {
+                unsigned int index = first + i;
+                distances[i] = glm::min(glm::min(glm::min(GetDistance(0, index), GetDistance(1, index)), glm::min(GetDistance(2, index), GetDistance(3, index))),
+                    glm::min(GetDistance(4, index), GetDistance(5, index))) + r[index];
+            }
+        });
+}
+
+bool FrustumCulling::IsAabbVisible(const Planes& planes, const glm::vec3& center, const glm::vec3& extents)
+{
+    for (const glm::vec4& plane : planes)
+    {
+        glm::vec3 normal(plane);
+        if (glm::dot(normal, center) + glm::dot(glm::abs(normal), extents) + plane.w < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+bool FrustumCulling::IsSphereVisible(const Planes& planes, const glm::vec3& center, float radius)
+{
+    for (const glm::vec4& plane : planes)
+    {
+        if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+            return false;
+    }
+    return true;
+}
@@ -1,12 +1,17 @@
 #include <ituGL/scene/RendererSceneVisitor.h>
 
 #include <ituGL/renderer/Renderer.h>
+#include <ituGL/scene/Scene.h>
 #include <ituGL/scene/SceneCamera.h>
 #include <ituGL/scene/SceneLight.h>
 #include <ituGL/scene/SceneModel.h>
 #include <ituGL/scene/Transform.h>
+#include <ituGL/scene/FrustumCulling.h>
+#include <ituGL/camera/Camera.h>
+#include <ituGL/geometry/Model.h>
+#include <ituGL/geometry/Mesh.h>
 
-RendererSceneVisitor::RendererSceneVisitor(Renderer& renderer) : m_renderer(renderer)
+RendererSceneVisitor::RendererSceneVisitor(Renderer& renderer) : m_renderer(renderer), m_frustumCulling(true)
 {
 }
 
@@ -26,3 +31,38 @@ void RendererSceneVisitor::VisitModel(SceneModel& sceneModel)
     assert(sceneModel.GetTransform());
     m_renderer.AddModel(*sceneModel.GetModel(), sceneModel.GetTransform()->GetTransformMatrix());
 }
+
+void RendererSceneVisitor::VisitScene(const Scene& scene)
+{
+    for (const std::shared_ptr<Camera>& camera : scene.GetCameras())
+    {
+        assert(!m_renderer.HasCamera()); // Currently, only one camera per scene supported
+        m_renderer.SetCurrentCamera(*camera);
+    }
+
+    for (const std::shared_ptr<Light>& light : scene.GetLights())
+    {
+        m_renderer.AddLight(*light);
+    }
+
+    // Test the bounds of all the entities in one batch. Meshes without bounds don't know their size, so they are never culled
+    bool frustumCulling = m_frustumCulling && m_renderer.HasCamera();
+    if (frustumCulling)
+    {
+        FrustumCulling::Planes planes = FrustumCulling::GetPlanes(m_renderer.GetCurrentCamera().GetViewProjectionMatrix());
+        FrustumCulling::CullAabbs(planes, scene.GetBounds(), m_visibilityMask);
+    }
+
+    std::span<const std::shared_ptr<Model>> models = scene.GetModels();
+    std::span<const Scene::EntityId> modelEntities = scene.GetModelEntities();
+    std::span<const glm::mat4> worldMatrices = scene.GetWorldMatrices();
+    for (size_t i = 0; i < models.size(); ++i)
+    {
+        unsigned int index = scene.GetEntityIndex(modelEntities[i]);
+        if (frustumCulling && models[i]->GetMesh().HasBounds() && !FrustumCulling::IsVisible(m_visibilityMask, index))
+        {
+            continue;
+        }
+        m_renderer.AddModel(*models[i], worldMatrices[index]);
+    }
+}
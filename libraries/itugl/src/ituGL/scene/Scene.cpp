@@ -1,72 +1,611 @@
 #include <ituGL/scene/Scene.h>
 
 #include <ituGL/scene/SceneNode.h>
+#include <ituGL/scene/SceneCamera.h>
+#include <ituGL/scene/SceneLight.h>
+#include <ituGL/scene/SceneModel.h>
 #include <ituGL/scene/SceneVisitor.h>
+#include <ituGL/scene/Transform.h>
+#include <ituGL/geometry/Model.h>
+#include <ituGL/geometry/Mesh.h>
+#include <ituGL/utils/ParallelUtils.h>
+#include <glm/common.hpp>
+#include <glm/matrix.hpp>
 #include <cassert>
 
-Scene::Scene()
+// Copies the components of each type of node to its entity
+class SceneComponentVisitor : public SceneVisitor
+{
+public:
+    SceneComponentVisitor(Scene& scene, Scene::EntityId entity) : m_scene(scene), m_entity(entity) {}
+
+    void VisitCamera(SceneCamera& sceneCamera) override { m_scene.SetEntityCamera(m_entity, sceneCamera.GetCamera()); }
+    void VisitLight(SceneLight& sceneLight) override { m_scene.SetEntityLight(m_entity, sceneLight.GetLight()); }
+    void VisitModel(SceneModel& sceneModel) override { m_scene.SetEntityModel(m_entity, sceneModel.GetModel()); }
+
+private:
+    Scene& m_scene;
+    Scene::EntityId m_entity;
+};
+
+// Reorder the values so that values[i] is the old values[order[i]]
+template<typename T>
+static void PermuteValues(std::vector<T>& values, const std::vector<unsigned int>& order)
+{
+    std::vector<T> permutedValues;
+    permutedValues.reserve(values.size());
+    for (unsigned int index : order)
+    {
+        permutedValues.push_back(std::move(values[index]));
+    }
+    values = std::move(permutedValues);
+}
+
+Scene::Scene() : m_hierarchyChanged(false), m_transformThreadCount(1), m_updatedTransformCount(0)
 {
 }
 
 Scene::~Scene()
 {
-    for (auto& pair : m_nodes)
+    for (const std::shared_ptr<SceneNode>& node : m_nodes.GetComponents())
     {
-        pair.second->SetOwnerScene(nullptr);
+        node->SetOwnerScene(nullptr, InvalidEntity);
     }
 }
 
-std::shared_ptr<SceneNode> Scene::GetSceneNode(const std::string& name) const
+Scene::EntityId Scene::CreateEntity(std::shared_ptr<Transform> transform)
+{
+    EntityId entity;
+    if (!m_freeEntities.empty())
+    {
+        entity = m_freeEntities.back();
+        m_freeEntities.pop_back();
+    }
+    else
+    {
+        entity = static_cast<EntityId>(m_entityIndices.size());
+        m_entityIndices.push_back(InvalidIndex);
+    }
+
+    m_entityIndices[entity] = static_cast<unsigned int>(m_entities.size());
+    m_entities.push_back(entity);
+    m_transforms.push_back(transform);
+    glm::mat4 worldMatrix = transform ? transform->GetTransformMatrix() : glm::mat4(1.0f);
+    m_worldMatrices.push_back(worldMatrix);
+    m_localBoundsCenters.push_back(glm::vec3(0.0f));
+    m_localBoundsExtents.push_back(glm::vec3(0.0f));
+    m_localBoundsVersions.push_back(0);
+    m_bounds.PushBack(glm::vec3(worldMatrix[3]), glm::vec3(0.0f));
+    m_parentIndices.push_back(InvalidIndex);
+    m_transformVersions.push_back(transform ? transform->GetVersion() : 0);
+    m_dirtyFlags.push_back(1);
+
+    if (transform)
+    {
+        assert(m_transformEntities.find(transform.get()) == m_transformEntities.end());
+        m_transformEntities[transform.get()] = entity;
+    }
+    m_hierarchyChanged = true;
+
+    return entity;
+}
+
+void Scene::DestroyEntity(EntityId entity)
+{
+    assert(IsValidEntity(entity));
+
+    if (const std::shared_ptr<SceneNode>* node = m_nodes.Find(entity))
+    {
+        (*node)->SetOwnerScene(nullptr, InvalidEntity);
+    }
+    m_models.Remove(entity);
+    m_lights.Remove(entity);
+    m_cameras.Remove(entity);
+    m_nodes.Remove(entity);
+    RemoveEntityName(entity);
+
+    unsigned int index = m_entityIndices[entity];
+    if (m_transforms[index])
+    {
+        m_transformEntities.erase(m_transforms[index].get());
+    }
+
+    // Move the last entity into the hole to keep the arrays dense
+    unsigned int lastIndex = static_cast<unsigned int>(m_entities.size() - 1);
+    if (index != lastIndex)
+    {
+        m_entities[index] = m_entities[lastIndex];
+        m_transforms[index] = std::move(m_transforms[lastIndex]);
+        m_worldMatrices[index] = m_worldMatrices[lastIndex];
+        m_localBoundsCenters[index] = m_localBoundsCenters[lastIndex];
+        m_localBoundsExtents[index] = m_localBoundsExtents[lastIndex];
+        m_localBoundsVersions[index] = m_localBoundsVersions[lastIndex];
+        m_bounds.Copy(lastIndex, index);
+        m_transformVersions[index] = m_transformVersions[lastIndex];
+        m_dirtyFlags[index] = m_dirtyFlags[lastIndex];
+        m_entityIndices[m_entities[index]] = index;
+    }
+    m_entities.pop_back();
+    m_transforms.pop_back();
+    m_worldMatrices.pop_back();
+    m_localBoundsCenters.pop_back();
+    m_localBoundsExtents.pop_back();
+    m_localBoundsVersions.pop_back();
+    m_bounds.PopBack();
+    m_parentIndices.pop_back();
+    m_transformVersions.pop_back();
+    m_dirtyFlags.pop_back();
+
+    m_entityIndices[entity] = InvalidIndex;
+    m_freeEntities.push_back(entity);
+
+    // The moved entity breaks the order, and the children of the entity lose their parent
+    m_hierarchyChanged = true;
+}
+
+bool Scene::IsValidEntity(EntityId entity) const
+{
+    return entity < m_entityIndices.size() && m_entityIndices[entity] != InvalidIndex;
+}
+
+unsigned int Scene::GetEntityIndex(EntityId entity) const
+{
+    assert(IsValidEntity(entity));
+    return m_entityIndices[entity];
+}
+
+std::shared_ptr<Transform> Scene::GetEntityTransform(EntityId entity) const
+{
+    return m_transforms[GetEntityIndex(entity)];
+}
+
+void Scene::SetEntityTransform(EntityId entity, std::shared_ptr<Transform> transform)
+{
+    unsigned int index = GetEntityIndex(entity);
+    if (m_transforms[index])
+    {
+        m_transformEntities.erase(m_transforms[index].get());
+    }
+    m_transforms[index] = transform;
+    if (transform)
+    {
+        assert(m_transformEntities.find(transform.get()) == m_transformEntities.end());
+        m_transformEntities[transform.get()] = entity;
+        m_transformVersions[index] = transform->GetVersion();
+    }
+    m_dirtyFlags[index] = 1;
+    m_hierarchyChanged = true;
+}
+
+void Scene::SetEntityLocalBounds(EntityId entity, const glm::vec3& center, const glm::vec3& extents)
+{
+    unsigned int index = GetEntityIndex(entity);
+    m_localBoundsCenters[index] = center;
+    m_localBoundsExtents[index] = extents;
+    m_dirtyFlags[index] = 1;
+}
+
+const glm::mat4& Scene::GetEntityWorldMatrix(EntityId entity) const
+{
+    return m_worldMatrices[GetEntityIndex(entity)];
+}
+
+glm::vec3 Scene::GetEntityBoundsCenter(EntityId entity) const
+{
+    return m_bounds.GetCenter(GetEntityIndex(entity));
+}
+
+glm::vec3 Scene::GetEntityBoundsExtents(EntityId entity) const
+{
+    return m_bounds.GetExtents(GetEntityIndex(entity));
+}
+
+void Scene::UpdateTransforms()
+{
+    // Meshes that are still loading get new bounds with each submesh
+    std::span<const std::shared_ptr<Model>> models = m_models.GetComponents();
+    std::span<const EntityId> modelEntities = m_models.GetEntities();
+    for (size_t i = 0; i < models.size(); ++i)
+    {
+        unsigned int index = GetEntityIndex(modelEntities[i]);
+        if (models[i]->GetMesh().GetBoundsVersion() != m_localBoundsVersions[index])
+        {
+            UpdateModelBounds(index, *models[i]);
+        }
+    }
+
+    // Find the transforms that changed since the last update, and if their parent changed
+    unsigned int entityCount = GetEntityCount();
+    for (unsigned int i = 0; i < entityCount; ++i)
+    {
+        const Transform* transform = m_transforms[i].get();
+        if (transform && transform->GetVersion() != m_transformVersions[i])
+        {
+            m_transformVersions[i] = transform->GetVersion();
+            m_dirtyFlags[i] = 1;
+            m_hierarchyChanged |= FindParentIndex(i) != m_parentIndices[i];
+        }
+    }
+
+    if (m_hierarchyChanged)
+    {
+        SortHierarchy();
+    }
+
+    for (unsigned int i = 0; i < entityCount; ++i)
+    {
+        const Transform* transform = m_transforms[i].get();
+        if (transform && transform->GetParent() && m_parentIndices[i] == InvalidIndex)
+        {
+            // The parent is not in the scene, so it can change without notice. Update its cached matrix here,
+            // so the threads only read it
+            transform->GetParent()->GetTransformMatrix();
+            m_dirtyFlags[i] = 1;
+        }
+    }
+
+    // Each level only depends on the previous ones, so the entities in a level can be updated in any order
+    m_updatedTransformCount = 0;
+    for (size_t level = 0; level + 1 < m_levelOffsets.size(); ++level)
+    {
+        unsigned int levelBegin = m_levelOffsets[level];
+        unsigned int levelEnd = m_levelOffsets[level + 1];
+        unsigned int blockCount = (levelEnd - levelBegin + s_transformBlockSize - 1) / s_transformBlockSize;
+        if (m_transformThreadCount > 1 && blockCount > 1)
+        {
+            ParallelUtils::For(blockCount, [&](unsigned int block)
+                {
+                    unsigned int blockBegin = levelBegin + block * s_transformBlockSize;
+                    unsigned int blockEnd = std::min(blockBegin + s_transformBlockSize, levelEnd);
+                    for (unsigned int i = blockBegin; i < blockEnd; ++i)
+                    {
+                        UpdateTransform(i);
+                    }
+                }, m_transformThreadCount);
+        }
+        else
+        {
+            for (unsigned int i = levelBegin; i < levelEnd; ++i)
+            {
+                UpdateTransform(i);
+            }
+        }
+    }
+
+    // Flags are cleared at the end, because the children read the flags of their parents
+    for (unsigned int i = 0; i < entityCount; ++i)
+    {
+        m_updatedTransformCount += m_dirtyFlags[i];
+    }
+    std::fill(m_dirtyFlags.begin(), m_dirtyFlags.end(), 0);
+
+    m_bvh.Update(*this);
+}
+
+void Scene::UpdateTransform(unsigned int index)
+{
+    unsigned int parentIndex = m_parentIndices[index];
+    if (parentIndex != InvalidIndex)
+    {
+        m_dirtyFlags[index] |= m_dirtyFlags[parentIndex];
+    }
+    if (!m_dirtyFlags[index])
+    {
+        return;
+    }
+
+    const Transform* transform = m_transforms[index].get();
+    glm::mat4& worldMatrix = m_worldMatrices[index];
+    worldMatrix = transform ? transform->GetLocalMatrix() : glm::mat4(1.0f);
+    if (parentIndex != InvalidIndex)
+    {
+        worldMatrix = m_worldMatrices[parentIndex] * worldMatrix;
+    }
+    else if (transform && transform->GetParent())
+    {
+        worldMatrix = transform->GetParent()->GetTransformMatrix() * worldMatrix;
+    }
+
+    // Transform the center, and project the extents on the world axes
+    const glm::vec3& extents = m_localBoundsExtents[index];
+    m_bounds.Set(index, glm::vec3(worldMatrix * glm::vec4(m_localBoundsCenters[index], 1.0f)),
+        glm::abs(glm::vec3(worldMatrix[0])) * extents.x
+        + glm::abs(glm::vec3(worldMatrix[1])) * extents.y
+        + glm::abs(glm::vec3(worldMatrix[2])) * extents.z);
+}
+
+void Scene::UpdateModelBounds(unsigned int index, const Model& model)
+{
+    const Mesh& mesh = model.GetMesh();
+    if (mesh.HasBounds())
+    {
+        m_localBoundsCenters[index] = mesh.GetBounds().aabbCenter;
+        m_localBoundsExtents[index] = mesh.GetBounds().aabbExtents;
+    }
+    else
+    {
+        m_localBoundsCenters[index] = glm::vec3(0.0f);
+        m_localBoundsExtents[index] = glm::vec3(1.0f);
+    }
+    m_localBoundsVersions[index] = mesh.GetBoundsVersion();
+    m_dirtyFlags[index] = 1;
+}
+
+unsigned int Scene::FindParentIndex(unsigned int index) const
+{
+    const Transform* transform = m_transforms[index].get();
+    if (transform && transform->GetParent())
+    {
+        auto it = m_transformEntities.find(transform->GetParent().get());
+        if (it != m_transformEntities.end())
+        {
+            return m_entityIndices[it->second];
+        }
+    }
+    return InvalidIndex;
+}
+
+void Scene::SortHierarchy()
+{
+    unsigned int entityCount = GetEntityCount();
+
+    std::vector<unsigned int> parentIndices(entityCount);
+    for (unsigned int i = 0; i < entityCount; ++i)
+    {
+        parentIndices[i] = FindParentIndex(i);
+    }
+
+    // Depth of each entity, walking up until an entity with known depth
+    std::vector<unsigned int> depths(entityCount, InvalidIndex);
+    std::vector<unsigned int> chain;
+    unsigned int levelCount = 0;
+    for (unsigned int i = 0; i < entityCount; ++i)
+    {
+        unsigned int index = i;
+        while (index != InvalidIndex && depths[index] == InvalidIndex)
+        {
+            chain.push_back(index);
+            index = parentIndices[index];
+            assert(chain.size() <= entityCount); // Cycle in the hierarchy
+        }
+        unsigned int depth = index != InvalidIndex ? depths[index] + 1 : 0;
+        for (auto it = chain.rbegin(); it != chain.rend(); ++it)
+        {
+            depths[*it] = depth++;
+        }
+        levelCount = std::max(levelCount, depth);
+        chain.clear();
+    }
+
+    // Counting sort by depth. It is stable, so the order within each level is kept
+    m_levelOffsets.assign(levelCount + 1, 0);
+    for (unsigned int depth : depths)
+    {
+        ++m_levelOffsets[depth + 1];
+    }
+    for (unsigned int level = 0; level < levelCount; ++level)
+    {
+        m_levelOffsets[level + 1] += m_levelOffsets[level];
+    }
+    std::vector<unsigned int> order(entityCount);
+    std::vector<unsigned int> newIndices(entityCount);
+    std::vector<unsigned int> levelEnds(m_levelOffsets.begin(), m_levelOffsets.end() - 1);
+    for (unsigned int i = 0; i < entityCount; ++i)
+    {
+        unsigned int newIndex = levelEnds[depths[i]]++;
+        order[newIndex] = i;
+        newIndices[i] = newIndex;
+    }
+
+    PermuteValues(m_entities, order);
+    PermuteValues(m_transforms, order);
+    PermuteValues(m_worldMatrices, order);
+    PermuteValues(m_localBoundsCenters, order);
+    PermuteValues(m_localBoundsExtents, order);
+    PermuteValues(m_localBoundsVersions, order);
+    m_bounds.Permute(order);
+    PermuteValues(m_transformVersions, order);
+
+    for (unsigned int i = 0; i < entityCount; ++i)
+    {
+        m_entityIndices[m_entities[i]] = i;
+        unsigned int parentIndex = parentIndices[order[i]];
+        m_parentIndices[i] = parentIndex != InvalidIndex ? newIndices[parentIndex] : InvalidIndex;
+    }
+
+    std::fill(m_dirtyFlags.begin(), m_dirtyFlags.end(), 1);
+    m_hierarchyChanged = false;
+}
+
+bool Scene::Raycast(const glm::vec3& origin, const glm::vec3& direction, RaycastHit& hit, float maxDistance) const
+{
+    std::span<const unsigned int> bvhEntities = m_bvh.GetEntities();
+    std::span<const glm::vec3> bvhBoundsMin = m_bvh.GetBoundsMin();
+    std::span<const glm::vec3> bvhBoundsMax = m_bvh.GetBoundsMax();
+    glm::vec3 inverseDirection = 1.0f / direction;
+
+    bool found = false;
+    m_bvh.GetBvh().TraverseRay(origin, direction, maxDistance, [&](std::span<const unsigned int> primitives, float& leafMaxDistance)
+        {
+            for (unsigned int primitive : primitives)
+            {
+                float distance;
+                if (!Bvh::IntersectsRay(bvhBoundsMin[primitive], bvhBoundsMax[primitive], origin, inverseDirection, leafMaxDistance, distance))
+                    continue;
+
+                EntityId entity = bvhEntities[primitive];
+                const Mesh& mesh = GetEntityModel(entity)->GetMesh();
+
+                // Affine transforms keep the distances along the ray, so the ray is not normalized in model space
+                glm::mat4 inverseWorldMatrix = glm::inverse(GetEntityWorldMatrix(entity));
+                glm::vec3 modelOrigin = glm::vec3(inverseWorldMatrix * glm::vec4(origin, 1.0f));
+                glm::vec3 modelDirection = glm::vec3(inverseWorldMatrix * glm::vec4(direction, 0.0f));
+
+                for (unsigned int submeshIndex = 0; submeshIndex < mesh.GetSubmeshCount(); ++submeshIndex)
+                {
+                    unsigned int triangleIndex;
+                    glm::vec2 barycentrics;
+                    if (mesh.HasSubmeshTriangles(submeshIndex) &&
+                        mesh.IntersectSubmesh(submeshIndex, modelOrigin, modelDirection, leafMaxDistance, triangleIndex, barycentrics))
+                    {
+                        hit.entity = entity;
+                        hit.submeshIndex = submeshIndex;
+                        hit.triangleIndex = triangleIndex;
+                        hit.barycentrics = barycentrics;
+                        hit.distance = leafMaxDistance;
+                        found = true;
+                    }
+                }
+            }
+        });
+
+    if (found)
+    {
+        hit.position = origin + direction * hit.distance;
+    }
+    return found;
+}
+
+std::shared_ptr<Model> Scene::GetEntityModel(EntityId entity) const
+{
+    const std::shared_ptr<Model>* model = m_models.Find(entity);
+    return model ? *model : nullptr;
+}
+
+void Scene::SetEntityModel(EntityId entity, std::shared_ptr<Model> model)
 {
-    auto it = m_nodes.find(name);
-    if (it != m_nodes.end())
+    assert(IsValidEntity(entity));
+    if (model)
     {
-        return it->second;
+        UpdateModelBounds(GetEntityIndex(entity), *model);
+        m_models.Set(entity, model);
     }
-    return nullptr;
+    else
+    {
+        m_models.Remove(entity);
+    }
+}
+
+std::shared_ptr<Light> Scene::GetEntityLight(EntityId entity) const
+{
+    const std::shared_ptr<Light>* light = m_lights.Find(entity);
+    return light ? *light : nullptr;
+}
+
+void Scene::SetEntityLight(EntityId entity, std::shared_ptr<Light> light)
+{
+    assert(IsValidEntity(entity));
+    if (light)
+    {
+        m_lights.Set(entity, light);
+    }
+    else
+    {
+        m_lights.Remove(entity);
+    }
+}
+
+std::shared_ptr<Camera> Scene::GetEntityCamera(EntityId entity) const
+{
+    const std::shared_ptr<Camera>* camera = m_cameras.Find(entity);
+    return camera ? *camera : nullptr;
+}
+
+void Scene::SetEntityCamera(EntityId entity, std::shared_ptr<Camera> camera)
+{
+    assert(IsValidEntity(entity));
+    if (camera)
+    {
+        m_cameras.Set(entity, camera);
+    }
+    else
+    {
+        m_cameras.Remove(entity);
+    }
+}
+
+Scene::EntityId Scene::FindEntity(const std::string& name) const
+{
+    auto it = m_names.find(name);
+    return it != m_names.end() ? it->second : InvalidEntity;
+}
+
+void Scene::SetEntityName(EntityId entity, const std::string& name)
+{
+    assert(IsValidEntity(entity));
+    assert(m_names.find(name) == m_names.end() || m_names.find(name)->second == entity);
+    RemoveEntityName(entity);
+    m_names[name] = entity;
+    m_entityNames[entity] = name;
+}
+
+void Scene::RemoveEntityName(EntityId entity)
+{
+    auto it = m_entityNames.find(entity);
+    if (it != m_entityNames.end())
+    {
+        m_names.erase(it->second);
+        m_entityNames.erase(it);
+    }
+}
+
+std::shared_ptr<SceneNode> Scene::GetSceneNode(const std::string& name) const
+{
+    EntityId entity = FindEntity(name);
+    return entity != InvalidEntity ? GetSceneNode(entity) : nullptr;
+}
+
+std::shared_ptr<SceneNode> Scene::GetSceneNode(EntityId entity) const
+{
+    const std::shared_ptr<SceneNode>* node = m_nodes.Find(entity);
+    return node ? *node : nullptr;
 }
 
 bool Scene::AddSceneNode(std::shared_ptr<SceneNode> node)
 {
     assert(node);
-    assert(m_nodes.find(node->GetName()) == m_nodes.end());
-    m_nodes[node->GetName()] = node;
-    node->SetOwnerScene(this);
+    assert(!node->GetOwnerScene());
+    assert(FindEntity(node->GetName()) == InvalidEntity);
+
+    EntityId entity = CreateEntity(node->GetTransform());
+    SetEntityName(entity, node->GetName());
+    m_nodes.Set(entity, node);
+    node->SetOwnerScene(this, entity);
+
+    SceneComponentVisitor componentVisitor(*this, entity);
+    node->AcceptVisitor(componentVisitor);
     return true;
 }
 
 bool Scene::RemoveSceneNode(std::shared_ptr<SceneNode> node)
 {
-    assert(m_nodes.find(node->GetName()) == m_nodes.end() || m_nodes.find(node->GetName())->second == node);
-    return RemoveSceneNode(node->GetName());
+    assert(node);
+    if (node->GetOwnerScene() != this)
+    {
+        return false;
+    }
+    DestroyEntity(node->GetEntity());
+    return true;
 }
 
 bool Scene::RemoveSceneNode(const std::string& name)
 {
-    auto it = m_nodes.find(name);
-    if (it != m_nodes.end())
-    {
-        assert(it->second);
-        assert(it->second->GetOwnerScene() == this);
-        it->second->SetOwnerScene(nullptr);
-        m_nodes.erase(it);
-        return true;
-    }
-    return false;
+    std::shared_ptr<SceneNode> node = GetSceneNode(name);
+    return node ? RemoveSceneNode(node) : false;
 }
 
 void Scene::AcceptVisitor(SceneVisitor& visitor)
 {
-    for (auto& pair : m_nodes)
+    for (const std::shared_ptr<SceneNode>& node : m_nodes.GetComponents())
     {
-        pair.second->AcceptVisitor(visitor);
+        node->AcceptVisitor(visitor);
     }
 }
 
 void Scene::AcceptVisitor(SceneVisitor& visitor) const
 {
-    for (auto& pair : m_nodes)
+    for (const std::shared_ptr<SceneNode>& node : m_nodes.GetComponents())
     {
-        pair.second->AcceptVisitor(visitor);
+        node->AcceptVisitor(visitor);
     }
 }
@@ -0,0 +1,159 @@
+#include <ituGL/scene/SceneBvh.h>
+
+#include <ituGL/scene/Scene.h>
+#include <ituGL/scene/FrustumCulling.h>
+#include <glm/geometric.hpp>
+#include <algorithm>
+#include <chrono>
+
+SceneBvh::SceneBvh() : m_buildCost(0.0f), m_rebuildThreshold(1.5f)
+{
+}
+
+SceneBvh::~SceneBvh()
+{
+    if (m_rebuild.valid())
+    {
+        m_rebuild.wait();
+    }
+}
+
+void SceneBvh::Update(const Scene& scene)
+{
+    // Take the tree built in the background. It was built with older bounds, so it is refitted below
+    bool refit = scene.GetUpdatedTransformCount() > 0;
+    if (m_rebuild.valid() && m_rebuild.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+    {
+        BuildResult result = m_rebuild.get();
+        m_bvh = std::move(result.bvh);
+        m_entities = std::move(result.entities);
+        m_buildCost = result.cost;
+        refit = true;
+    }
+
+    // New or removed models need a new tree
+    std::span<const unsigned int> modelEntities = scene.GetModelEntities();
+    if (!std::equal(modelEntities.begin(), modelEntities.end(), m_entities.begin(), m_entities.end()))
+    {
+        Rebuild(scene);
+        return;
+    }
+
+    if (refit && !m_bvh.IsEmpty())
+    {
+        CollectBounds(scene, m_entities, m_boundsMin, m_boundsMax);
+        m_bvh.Refit(m_boundsMin, m_boundsMax);
+
+        if (!IsRebuilding() && m_bvh.GetCost() > m_buildCost * m_rebuildThreshold)
+        {
+            StartRebuild(scene);
+        }
+    }
+}
+
+void SceneBvh::Rebuild(const Scene& scene)
+{
+    // A background build would be for an older set of entities
+    if (m_rebuild.valid())
+    {
+        m_rebuild.get();
+    }
+
+    std::span<const unsigned int> modelEntities = scene.GetModelEntities();
+    m_entities.assign(modelEntities.begin(), modelEntities.end());
+    CollectBounds(scene, m_entities, m_boundsMin, m_boundsMax);
+    m_bvh.Build(m_boundsMin, m_boundsMax);
+    m_buildCost = m_bvh.GetCost();
+}
+
+void SceneBvh::StartRebuild(const Scene& scene)
+{
+    // The background thread gets its own copy of the entities and bounds
+    std::vector<unsigned int> entities(m_entities);
+    std::vector<glm::vec3> boundsMin, boundsMax;
+    CollectBounds(scene, entities, boundsMin, boundsMax);
+    m_rebuild = std::async(std::launch::async, &SceneBvh::Build, std::move(entities), std::move(boundsMin), std::move(boundsMax));
+}
+
+SceneBvh::BuildResult SceneBvh::Build(std::vector<unsigned int> entities, std::vector<glm::vec3> boundsMin, std::vector<glm::vec3> boundsMax)
+{
+    BuildResult result;
+    result.bvh.Build(boundsMin, boundsMax);
+    result.entities = std::move(entities);
+    result.cost = result.bvh.GetCost();
+    return result;
+}
+
+void SceneBvh::CollectBounds(const Scene& scene, std::span<const unsigned int> entities,
+    std::vector<glm::vec3>& boundsMin, std::vector<glm::vec3>& boundsMax)
+{
+    const AabbArray& bounds = scene.GetBounds();
+    boundsMin.resize(entities.size());
+    boundsMax.resize(entities.size());
+    for (size_t i = 0; i < entities.size(); ++i)
+    {
+        unsigned int index = scene.GetEntityIndex(entities[i]);
+        glm::vec3 center = bounds.GetCenter(index);
+        glm::vec3 extents = bounds.GetExtents(index);
+        boundsMin[i] = center - extents;
+        boundsMax[i] = center + extents;
+    }
+}
+
+template<typename TTest>
+void SceneBvh::Query(TTest&& test, std::vector<unsigned int>& entities) const
+{
+    // Leaves can have several primitives, so each one is tested again with its own bounds
+    m_bvh.Traverse(test, [&](std::span<const unsigned int> primitives)
+        {
+            for (unsigned int primitive : primitives)
+            {
+                if (test(m_boundsMin[primitive], m_boundsMax[primitive]))
+                {
+                    entities.push_back(m_entities[primitive]);
+                }
+            }
+        });
+}
+
+void SceneBvh::QueryFrustum(const glm::mat4& viewProjectionMatrix, std::vector<unsigned int>& entities) const
+{
+    FrustumCulling::Planes planes = FrustumCulling::GetPlanes(viewProjectionMatrix);
+    Query([&](const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+        {
+            return FrustumCulling::IsAabbVisible(planes, (boundsMin + boundsMax) * 0.5f, (boundsMax - boundsMin) * 0.5f);
+        }, entities);
+}
+
+void SceneBvh::QuerySphere(const glm::vec3& center, float radius, std::vector<unsigned int>& entities) const
+{
+    Query([&](const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+        {
+            glm::vec3 offset = glm::clamp(center, boundsMin, boundsMax) - center;
+            return glm::dot(offset, offset) <= radius * radius;
+        }, entities);
+}
+
+void SceneBvh::QueryAabb(const glm::vec3& queryMin, const glm::vec3& queryMax, std::vector<unsigned int>& entities) const
+{
+    Query([&](const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+        {
+            return glm::all(glm::lessThanEqual(boundsMin, queryMax)) && glm::all(glm::lessThanEqual(queryMin, boundsMax));
+        }, entities);
+}
+
+void SceneBvh::QueryRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, std::vector<unsigned int>& entities) const
+{
+    glm::vec3 inverseDirection = 1.0f / direction;
+    m_bvh.TraverseRay(origin, direction, maxDistance, [&](std::span<const unsigned int> primitives, float& leafMaxDistance)
+        {
+            for (unsigned int primitive : primitives)
+            {
+                float distance;
+                if (Bvh::IntersectsRay(m_boundsMin[primitive], m_boundsMax[primitive], origin, inverseDirection, leafMaxDistance, distance))
+                {
+                    entities.push_back(m_entities[primitive]);
+                }
+            }
+        });
+}
@@ -29,6 +29,10 @@ std::shared_ptr<const Camera> SceneCamera::GetCamera() const
 void SceneCamera::SetCamera(std::shared_ptr<Camera> camera)
 {
     m_camera = camera;
+    if (Scene* scene = GetOwnerScene())
+    {
+        scene->SetEntityCamera(GetEntity(), camera);
+    }
 }
 
 void SceneCamera::AcceptVisitor(SceneVisitor& visitor)
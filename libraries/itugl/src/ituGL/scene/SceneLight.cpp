@@ -24,6 +24,10 @@ std::shared_ptr<Light> SceneLight::GetLight() const
 void SceneLight::SetLight(std::shared_ptr<Light> light)
 {
     m_light = light;
+    if (Scene* scene = GetOwnerScene())
+    {
+        scene->SetEntityLight(GetEntity(), light);
+    }
 }
 
 void SceneLight::AcceptVisitor(SceneVisitor& visitor)
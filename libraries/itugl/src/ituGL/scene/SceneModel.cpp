@@ -4,6 +4,8 @@
 #include <ituGL/geometry/Mesh.h>
 #include <ituGL/scene/Transform.h>
 #include <ituGL/scene/SceneVisitor.h>
+#include <glm/geometric.hpp>
+#include <algorithm>
 #include <cassert>
 
 SceneModel::SceneModel(const std::string& name, std::shared_ptr<Model> model) : SceneNode(name), m_model(model)
@@ -22,6 +24,10 @@ std::shared_ptr<Model> SceneModel::GetModel() const
 void SceneModel::SetModel(std::shared_ptr<Model> model)
 {
     m_model = model;
+    if (Scene* scene = GetOwnerScene())
+    {
+        scene->SetEntityModel(GetEntity(), model);
+    }
 }
 
 /*glm::mat4 SceneModel::GetWorldMatrix() const
@@ -45,19 +51,63 @@ const Drawcall& SceneModel::GetDrawcall(int index, const VertexArrayObject*& vao
 
 SphereBounds SceneModel::GetSphereBounds() const
 {
-    return SphereBounds(GetBoxBounds());
+    assert(m_transform);
+    assert(m_model);
+    const Mesh& mesh = m_model->GetMesh();
+    if (!mesh.HasBounds())
+    {
+        return SphereBounds(GetBoxBounds());
+    }
+
+    // The largest scale of the axes covers the sphere in any direction
+    glm::mat4 worldMatrix = m_transform->GetTransformMatrix();
+    float scale = std::max(std::max(glm::length(glm::vec3(worldMatrix[0])), glm::length(glm::vec3(worldMatrix[1]))), glm::length(glm::vec3(worldMatrix[2])));
+    const MeshBounds& bounds = mesh.GetBounds();
+    return SphereBounds(glm::vec3(worldMatrix * glm::vec4(bounds.sphereCenter, 1.0f)), bounds.sphereRadius * scale);
 }
 
 AabbBounds SceneModel::GetAabbBounds() const
 {
-    return AabbBounds(GetBoxBounds());
+    assert(m_transform);
+    assert(m_model);
+    const Mesh& mesh = m_model->GetMesh();
+    if (!mesh.HasBounds())
+    {
+        return AabbBounds(GetBoxBounds());
+    }
+
+    // Project the extents of the box on the world axes
+    glm::mat4 worldMatrix = m_transform->GetTransformMatrix();
+    const MeshBounds& bounds = mesh.GetBounds();
+    glm::vec3 extents = glm::abs(glm::vec3(worldMatrix[0])) * bounds.aabbExtents.x
+        + glm::abs(glm::vec3(worldMatrix[1])) * bounds.aabbExtents.y
+        + glm::abs(glm::vec3(worldMatrix[2])) * bounds.aabbExtents.z;
+    return AabbBounds(glm::vec3(worldMatrix * glm::vec4(bounds.aabbCenter, 1.0f)), extents);
 }
 
 BoxBounds SceneModel::GetBoxBounds() const
 {
     assert(m_transform);
     assert(m_model);
-    return BoxBounds(m_transform->GetTranslation(), m_transform->GetRotationMatrix(), m_transform->GetScale() /* * m_model->GetSize()*/);
+    const Mesh& mesh = m_model->GetMesh();
+    if (!mesh.HasBounds())
+    {
+        // Without bounds, the scale of the transform stands for the size of the model
+        return BoxBounds(m_transform->GetTranslation(), m_transform->GetRotationMatrix(), m_transform->GetScale());
+    }
+
+    // Transform the axes of the oriented box, and keep their scale as its size
+    glm::mat4 worldMatrix = m_transform->GetTransformMatrix();
+    const MeshBounds& bounds = mesh.GetBounds();
+    glm::mat3 axes = glm::mat3(worldMatrix) * bounds.boxAxes;
+    glm::vec3 size(0.0f);
+    for (int i = 0; i < 3; ++i)
+    {
+        float length = glm::length(axes[i]);
+        size[i] = bounds.boxExtents[i] * length;
+        axes[i] = length > 0.0f ? axes[i] / length : glm::vec3(0.0f);
+    }
+    return BoxBounds(glm::vec3(worldMatrix * glm::vec4(bounds.boxCenter, 1.0f)), axes, size);
 }
 
 void SceneModel::AcceptVisitor(SceneVisitor& visitor)
@@ -7,7 +7,7 @@ SceneNode::SceneNode(const std::string& name) : SceneNode(name, std::make_shared
 {
 }
 
-SceneNode::SceneNode(const std::string& name, std::shared_ptr<Transform> transform) : m_scene(nullptr), m_name(name), m_transform(transform)
+SceneNode::SceneNode(const std::string& name, std::shared_ptr<Transform> transform) : m_scene(nullptr), m_entity(Scene::InvalidEntity), m_name(name), m_transform(transform)
 {
 }
 
@@ -22,17 +22,10 @@ const std::string& SceneNode::GetName() const
 
 void SceneNode::Rename(const std::string& name)
 {
-    std::shared_ptr<SceneNode> sceneNode;
-    if (m_scene)
-    {
-        sceneNode = m_scene->GetSceneNode(m_name);
-        assert(sceneNode.get() == this);
-        m_scene->RemoveSceneNode(m_name);
-    }
     m_name = name;
     if (m_scene)
     {
-        m_scene->AddSceneNode(sceneNode);
+        m_scene->SetEntityName(m_entity, name);
     }
 }
 
@@ -49,6 +42,10 @@ std::shared_ptr<const Transform> SceneNode::GetTransform() const
 void SceneNode::SetTransform(std::shared_ptr<Transform> transform)
 {
     m_transform = transform;
+    if (m_scene)
+    {
+        m_scene->SetEntityTransform(m_entity, transform);
+    }
 }
 
 Scene* SceneNode::GetOwnerScene() const
@@ -56,9 +53,10 @@ Scene* SceneNode::GetOwnerScene() const
     return m_scene;
 }
 
-void SceneNode::SetOwnerScene(Scene* scene)
+void SceneNode::SetOwnerScene(Scene* scene, Scene::EntityId entity)
 {
     m_scene = scene;
+    m_entity = entity;
 }
 
 SphereBounds SceneNode::GetSphereBounds() const
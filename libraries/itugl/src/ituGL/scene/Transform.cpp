@@ -1,8 +1,9 @@
 #include <ituGL/scene/Transform.h>
 
 #include <glm/ext/matrix_transform.hpp>
+#include <cmath>
 
-Transform::Transform() : m_translation(0, 0, 0), m_rotation(0, 0, 0), m_scale(1, 1, 1), m_matrix(1.0f), m_dirty(false)
+Transform::Transform() : m_translation(0, 0, 0), m_rotation(0, 0, 0), m_scale(1, 1, 1), m_matrix(1.0f), m_dirty(false), m_version(0)
 {
 }
 
@@ -13,10 +14,14 @@ glm::mat4 Transform::GetTranslationMatrix() const
 
 glm::mat4 Transform::GetRotationMatrix() const
 {
-    glm::mat4 matrix = glm::identity<glm::mat4>();
-    matrix = glm::rotate(matrix, m_rotation.y, glm::vec3(0, 1, 0));
-    matrix = glm::rotate(matrix, m_rotation.x, glm::vec3(1, 0, 0));
-    matrix = glm::rotate(matrix, m_rotation.z, glm::vec3(0, 0, 1));
+    // Same as rotating around Y, then X, then Z, but built directly from the sines and cosines
+    float sx = std::sin(m_rotation.x), cx = std::cos(m_rotation.x);
+    float sy = std::sin(m_rotation.y), cy = std::cos(m_rotation.y);
+    float sz = std::sin(m_rotation.z), cz = std::cos(m_rotation.z);
+    glm::mat4 matrix(1.0f);
+    matrix[0] = glm::vec4(cy * cz + sy * sx * sz, cx * sz, -sy * cz + cy * sx * sz, 0.0f);
+    matrix[1] = glm::vec4(-cy * sz + sy * sx * cz, cx * cz, sy * sz + cy * sx * cz, 0.0f);
+    matrix[2] = glm::vec4(sy * cx, -sx, cy * cx, 0.0f);
     return matrix;
 }
 
@@ -25,11 +30,21 @@ glm::mat4 Transform::GetScaleMatrix() const
     return glm::scale(glm::identity<glm::mat4>(), m_scale);
 }
 
+glm::mat4 Transform::GetLocalMatrix() const
+{
+    glm::mat4 matrix = GetRotationMatrix();
+    matrix[0] *= m_scale.x;
+    matrix[1] *= m_scale.y;
+    matrix[2] *= m_scale.z;
+    matrix[3] = glm::vec4(m_translation, 1.0f);
+    return matrix;
+}
+
 glm::mat4 Transform::GetTransformMatrix() const
 {
     if (IsDirty())
     {
-        m_matrix = GetTranslationMatrix() * GetRotationMatrix() * GetScaleMatrix();
+        m_matrix = GetLocalMatrix();
         if (m_parent)
         {
             m_matrix = m_parent->GetTransformMatrix() * m_matrix;
@@ -26,6 +26,32 @@ void Material::SetShaderSetupFunction(ShaderSetupFunction shaderSetupFunction)
     m_shaderSetupFunction = shaderSetupFunction;
 }
 
+bool Material::IsReady() const
+{
+    return m_shaderProgram != nullptr;
+}
+
+std::shared_ptr<const Material> Material::GetPlaceholder() const
+{
+    return m_placeholder;
+}
+
+void Material::SetPlaceholder(std::shared_ptr<const Material> placeholder)
+{
+    assert(!placeholder || placeholder->IsReady());
+    m_placeholder = placeholder;
+}
+
+const Material& Material::GetUsedMaterial() const
+{
+    if (IsReady())
+    {
+        return *this;
+    }
+    assert(m_placeholder);
+    return *m_placeholder;
+}
+
 Material::TestFunction Material::GetDepthTestFunction() const
 {
     return m_depthTestFunction;
@@ -197,7 +223,11 @@ void Material::SetBlendColor(Color blendColor)
 
 void Material::Use(OverrideFlags overrideFlags) const
 {
-    assert(m_shaderProgram);
+    if (!IsReady())
+    {
+        GetUsedMaterial().Use(overrideFlags);
+        return;
+    }
 
     // Set the shader program as the one currently in use
     m_shaderProgram->Use();
@@ -205,6 +235,27 @@ void Material::Use(OverrideFlags overrideFlags) const
     // Set the value of all the uniforms stored as properties
     SetUniforms();
 
+    UseStates(overrideFlags);
+}
+
+bool Material::IsBatchCompatible(const Material& other) const
+{
+    // Materials that are not ready use their placeholders, and those are not known to be the same
+    return IsReady() && m_shaderProgram == other.m_shaderProgram && CompareTextures(other) == 0;
+}
+
+void Material::UseBatched(OverrideFlags overrideFlags) const
+{
+    assert(m_shaderProgram);
+
+    // Shader program and textures are already set, only data uniforms can change
+    SetDataUniforms();
+
+    UseStates(overrideFlags);
+}
+
+void Material::UseStates(OverrideFlags overrideFlags) const
+{
     if (m_shaderSetupFunction)
     {
         // if needed, do extra set up for the shader
@@ -2,6 +2,10 @@
 
 #include <cassert>
 
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
 Shader::Shader(Type type) : Object(NullHandle)
 {
     Handle& handle = GetHandle();
@@ -62,6 +66,14 @@ bool Shader::Compile()
     return IsCompiled();
 }
 
+// Start compiling the shader source code, without waiting for the result
+void Shader::BeginCompile()
+{
+    assert(IsValid());
+
+    glCompileShader(GetHandle());
+}
+
 // Check if the shader has been successfully compiled
 bool Shader::IsCompiled() const
 {
@@ -72,6 +84,16 @@ bool Shader::IsCompiled() const
     return success;
 }
 
+// Check if the compilation has finished, without blocking. Requires GL_KHR_parallel_shader_compile
+bool Shader::IsCompilationComplete() const
+{
+    assert(IsValid());
+
+    GLint complete;
+    glGetShaderiv(GetHandle(), GL_COMPLETION_STATUS_KHR, &complete);
+    return complete;
+}
+
 // Get compilation error messages in case of a failure
 void Shader::GetCompilationErrors(std::span<char> errors) const
 {
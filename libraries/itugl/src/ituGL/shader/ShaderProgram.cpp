@@ -4,6 +4,10 @@
 #include <ituGL/texture/TextureObject.h>
 #include <cassert>
 
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
 #ifndef NDEBUG
 ShaderProgram::Handle ShaderProgram::s_usedHandle = ShaderProgram::NullHandle;
 #endif
@@ -82,6 +86,19 @@ bool ShaderProgram::Build(const Shader& vertexShader, const Shader& fragmentShad
     return Link();
 }
 
+// Attach the shaders and start linking, without waiting for the compilation or linking to finish
+void ShaderProgram::BeginBuild(const Shader& vertexShader, const Shader& fragmentShader)
+{
+    assert(IsValid());
+    assert(vertexShader.IsValid());
+    assert(fragmentShader.IsValid());
+
+    // Don't use AttachShader, checking the compilation status would wait for the compiler
+    glAttachShader(GetHandle(), vertexShader.GetHandle());
+    glAttachShader(GetHandle(), fragmentShader.GetHandle());
+    glLinkProgram(GetHandle());
+}
+
 // Attach a shader to be linked
 void ShaderProgram::AttachShader(const Shader& shader)
 {
@@ -110,6 +127,56 @@ bool ShaderProgram::IsLinked() const
     return success;
 }
 
+// Check if the linking has finished, without blocking. Requires GL_KHR_parallel_shader_compile
+bool ShaderProgram::IsLinkingComplete() const
+{
+    assert(IsValid());
+
+    GLint complete;
+    glGetProgramiv(GetHandle(), GL_COMPLETION_STATUS_KHR, &complete);
+    return complete;
+}
+
+// Hint the driver that the binary will be retrieved after linking. Call before building the program
+void ShaderProgram::SetBinaryRetrievable(bool retrievable)
+{
+    assert(IsValid());
+    glProgramParameteri(GetHandle(), GL_PROGRAM_BINARY_RETRIEVABLE_HINT, retrievable ? GL_TRUE : GL_FALSE);
+}
+
+void ShaderProgram::SetTransformFeedbackVaryings(std::span<const char* const> varyings)
+{
+    assert(IsValid());
+    glTransformFeedbackVaryings(GetHandle(), static_cast<GLsizei>(varyings.size()), varyings.data(), GL_INTERLEAVED_ATTRIBS);
+}
+
+// Get the driver specific binary of a linked program, so it can be stored and loaded with LoadBinary
+bool ShaderProgram::GetBinary(GLenum& binaryFormat, std::vector<GLubyte>& binary) const
+{
+    assert(IsValid());
+    assert(IsLinked());
+
+    GLint binaryLength = 0;
+    glGetProgramiv(GetHandle(), GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+    binary.resize(binaryLength);
+    if (binaryLength > 0)
+    {
+        GLsizei length = 0;
+        glGetProgramBinary(GetHandle(), binaryLength, &length, &binaryFormat, binary.data());
+        binary.resize(length);
+    }
+    return !binary.empty();
+}
+
+// Load a binary previously obtained with GetBinary, instead of building the program
+// Returns false if the driver rejects the binary (for example, after a driver update)
+bool ShaderProgram::LoadBinary(GLenum binaryFormat, std::span<const GLubyte> binary)
+{
+    assert(IsValid());
+    glProgramBinary(GetHandle(), binaryFormat, binary.data(), static_cast<GLsizei>(binary.size()));
+    return IsLinked();
+}
+
 // Get a string with linking error messages
 // The max length of the string returned is determined by the capacity of the span
 void ShaderProgram::GetLinkingErrors(std::span<char> errors) const
@@ -1,6 +1,8 @@
 #include <ituGL/shader/ShaderUniformCollection.h>
 #include <cassert>
 #include <array>
+#include <algorithm>
+#include <functional>
 
 ShaderUniformCollection::ShaderUniformCollection() : m_shaderProgram(nullptr)
 {
@@ -8,7 +10,11 @@ ShaderUniformCollection::ShaderUniformCollection() : m_shaderProgram(nullptr)
 
 ShaderUniformCollection::ShaderUniformCollection(std::shared_ptr<ShaderProgram> shaderProgram, const NameSet& filteredUniforms) : m_shaderProgram(shaderProgram)
 {
-    ExtractUniforms(filteredUniforms);
+    // Without a program the collection stays empty, until ChangeShader is called
+    if (m_shaderProgram)
+    {
+        ExtractUniforms(filteredUniforms);
+    }
 }
 
 std::shared_ptr<ShaderProgram> ShaderUniformCollection::GetShaderProgram()
@@ -33,9 +39,21 @@ ShaderProgram::Location ShaderUniformCollection::GetAttributeLocation(const char
     return m_shaderProgram->GetAttributeLocation(name);
 }
 
-ShaderProgram::Location ShaderUniformCollection::GetUniformLocation(const char* name) const
+ShaderProgram::Location ShaderUniformCollection::GetUniformLocation(UniformId id) const
 {
-    return m_shaderProgram->GetUniformLocation(name);
+    // Binary search in the sorted list of names. Different names can have the same hash, so the name must match too
+    auto it = std::lower_bound(m_uniformNames.begin(), m_uniformNames.end(), id.GetHash(),
+        [](const UniformName& uniformName, unsigned int hash) { return uniformName.hash < hash; });
+    for (; it != m_uniformNames.end() && it->hash == id.GetHash(); ++it)
+    {
+        if (it->name == id.GetName())
+        {
+            return it->location;
+        }
+    }
+
+    // Not in the collection, ask OpenGL
+    return m_shaderProgram ? m_shaderProgram->GetUniformLocation(id.GetName()) : -1;
 }
 
 ShaderUniformCollection::DataUniform& ShaderUniformCollection::GetDataUniform(ShaderProgram::Location location)
@@ -45,7 +63,9 @@ ShaderUniformCollection::DataUniform& ShaderUniformCollection::GetDataUniform(Sh
 
 const ShaderUniformCollection::DataUniform& ShaderUniformCollection::GetDataUniform(ShaderProgram::Location location) const
 {
-    int uniformIndex = m_locationDataIndex.at(location);
+    assert(location >= 0 && location < static_cast<int>(m_locationDataIndex.size()));
+    int uniformIndex = m_locationDataIndex[location];
+    assert(uniformIndex >= 0);
     const DataUniform& uniform = m_dataUniforms[uniformIndex];
     assert(uniform.location == location);
     return uniform;
@@ -58,12 +78,27 @@ ShaderUniformCollection::TextureUniform& ShaderUniformCollection::GetTextureUnif
 
 const ShaderUniformCollection::TextureUniform& ShaderUniformCollection::GetTextureUniform(ShaderProgram::Location location) const
 {
-    int uniformIndex = m_locationTextureIndex.at(location);
+    assert(location >= 0 && location < static_cast<int>(m_locationTextureIndex.size()));
+    int uniformIndex = m_locationTextureIndex[location];
+    assert(uniformIndex >= 0);
     const TextureUniform& uniform = m_textureUniforms[uniformIndex];
     assert(uniform.location == location);
     return uniform;
 }
 
+void ShaderUniformCollection::AddUniformId(const char* name, ShaderProgram::Location location)
+{
+    m_uniformNames.push_back(UniformName{ UniformId(name).GetHash(), location, name });
+
+    // Arrays are reported with the name of the first element. Register also the name without the suffix
+    size_t length = std::strlen(name);
+    if (length > 3 && std::strcmp(name + length - 3, "[0]") == 0)
+    {
+        std::string arrayName(name, length - 3);
+        m_uniformNames.push_back(UniformName{ UniformId(arrayName.c_str()).GetHash(), location, arrayName });
+    }
+}
+
 void ShaderUniformCollection::ExtractUniforms(const NameSet& filteredUniforms)
 {
     assert(m_shaderProgram);
@@ -86,7 +121,7 @@ void ShaderUniformCollection::ExtractUniforms(const NameSet& filteredUniforms)
             continue;
 
         // Get the uniform location
-        ShaderProgram::Location location = GetUniformLocation(uniformName);
+        ShaderProgram::Location location = shaderProgram.GetUniformLocation(uniformName);
         assert(location >= 0);
 
         Data::Type type;
@@ -101,6 +136,7 @@ void ShaderUniformCollection::ExtractUniforms(const NameSet& filteredUniforms)
             uniform.dimension = dimension;
             uniform.count = size;
             AddUniform(uniform);
+            AddUniformId(uniformName, location);
         }
         else if (IsTextureUniform(glType, target))
         {
@@ -109,6 +145,7 @@ void ShaderUniformCollection::ExtractUniforms(const NameSet& filteredUniforms)
             uniform.location = location;
             uniform.target = target;
             AddUniform(uniform);
+            AddUniformId(uniformName, location);
         }
         else
         {
@@ -116,6 +153,10 @@ void ShaderUniformCollection::ExtractUniforms(const NameSet& filteredUniforms)
             assert(false);
         }
     }
+
+    // Sort the names by hash to find them with binary search
+    std::sort(m_uniformNames.begin(), m_uniformNames.end(),
+        [](const UniformName& a, const UniformName& b) { return a.hash < b.hash; });
 }
 
 bool ShaderUniformCollection::IsDataUniform(GLenum glType, Data::Type& type, UniformDimension& dimension)
@@ -282,17 +323,67 @@ void ShaderUniformCollection::AddUniform(const DataUniform& uniform)
 
 void ShaderUniformCollection::AddUniform(const TextureUniform& uniform)
 {
-    m_locationTextureIndex.insert(std::make_pair(uniform.location, static_cast<int>(m_textureUniforms.size())));
+    assert(uniform.location >= 0);
+    if (uniform.location >= static_cast<int>(m_locationTextureIndex.size()))
+    {
+        m_locationTextureIndex.resize(uniform.location + 1, -1);
+    }
+    m_locationTextureIndex[uniform.location] = static_cast<int>(m_textureUniforms.size());
     m_textureUniforms.push_back(uniform);
 }
 
+void ShaderUniformCollection::GetTextures(std::vector<std::shared_ptr<const TextureObject>>& textures) const
+{
+    for (const TextureUniform& uniform : m_textureUniforms)
+    {
+        if (uniform.texture)
+        {
+            textures.push_back(uniform.texture);
+        }
+    }
+}
+
+int ShaderUniformCollection::CompareTextures(const ShaderUniformCollection& other) const
+{
+    assert(m_shaderProgram == other.m_shaderProgram);
+
+    // Collections of the same program can filter different uniforms. Then their textures are not bound the same way
+    if (m_textureUniforms.size() != other.m_textureUniforms.size())
+    {
+        return m_textureUniforms.size() < other.m_textureUniforms.size() ? -1 : 1;
+    }
+
+    for (size_t i = 0; i < m_textureUniforms.size(); ++i)
+    {
+        ShaderProgram::Location location = m_textureUniforms[i].location;
+        ShaderProgram::Location otherLocation = other.m_textureUniforms[i].location;
+        if (location != otherLocation)
+        {
+            return location < otherLocation ? -1 : 1;
+        }
+
+        const TextureObject* texture = m_textureUniforms[i].texture.get();
+        const TextureObject* otherTexture = other.m_textureUniforms[i].texture.get();
+        if (texture != otherTexture)
+        {
+            return std::less<const TextureObject*>()(texture, otherTexture) ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
 void ShaderUniformCollection::SetUniforms() const
 {
-    for (const DataUniform& uniform : m_dataUniforms)
+    SetDataUniforms();
+    for (const TextureUniform& uniform : m_textureUniforms)
     {
         UseUniform(uniform);
     }
-    for (const TextureUniform& uniform : m_textureUniforms)
+}
+
+void ShaderUniformCollection::SetDataUniforms() const
+{
+    for (const DataUniform& uniform : m_dataUniforms)
     {
         UseUniform(uniform);
     }
@@ -443,6 +534,7 @@ void ShaderUniformCollection::Reset()
     m_textureUniforms.clear();
     m_locationDataIndex.clear();
     m_locationTextureIndex.clear();
+    m_uniformNames.clear();
     m_intDataValues.clear();
     m_uintDataValues.clear();
     m_floatDataValues.clear();
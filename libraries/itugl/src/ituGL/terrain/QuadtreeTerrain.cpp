@@ -0,0 +1,293 @@
+#include <ituGL/terrain/QuadtreeTerrain.h>
+
+#include <ituGL/geometry/VertexFormat.h>
+#include <ituGL/geometry/VertexAttribute.h>
+#include <ituGL/texture/Texture2DObject.h>
+#include <ituGL/shader/Material.h>
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+
+QuadtreeTerrain::QuadtreeTerrain()
+    : m_origin(0.0f)
+    , m_size(1.0f)
+    , m_heightScale(1.0f)
+    , m_lodCount(0)
+    , m_lodDistanceFactor(4.0f)
+    , m_heightmapSize(0)
+    , m_cameraPosition(0.0f)
+    , m_frustumPlanes{}
+{
+}
+
+void QuadtreeTerrain::Initialize(std::span<const float> heights, unsigned int width, unsigned int height,
+    const glm::vec3& origin, float size, float heightScale, unsigned int lodCount)
+{
+    assert(heights.size() == width * height && width > 1 && height > 1);
+    assert(lodCount > 0);
+
+    m_origin = origin;
+    m_size = size;
+    m_heightScale = heightScale;
+    m_lodCount = lodCount;
+    m_heights.assign(heights.begin(), heights.end());
+    m_heightmapSize = glm::uvec2(width, height);
+
+    // The heightmap is sampled with bilinear filtering in the vertex shader, always from the top level
+    m_heightmap = std::make_shared<Texture2DObject>();
+    m_heightmap->Bind();
+    m_heightmap->SetImage<float>(0, width, height, TextureObject::FormatR, TextureObject::InternalFormatR32F, heights);
+    m_heightmap->SetParameter(TextureObject::ParameterEnum::MinFilter, GL_LINEAR);
+    m_heightmap->SetParameter(TextureObject::ParameterEnum::MagFilter, GL_LINEAR);
+    m_heightmap->SetParameter(TextureObject::ParameterEnum::WrapS, GL_CLAMP_TO_EDGE);
+    m_heightmap->SetParameter(TextureObject::ParameterEnum::WrapT, GL_CLAMP_TO_EDGE);
+    Texture2DObject::Unbind();
+
+    ComputeNodeHeights(heights);
+
+    CreateGridMesh(m_gridMeshes[WholeNode], m_nodeVBOs[WholeNode], s_gridSize);
+    CreateGridMesh(m_gridMeshes[QuadrantNode], m_nodeVBOs[QuadrantNode], s_gridSize / 2);
+}
+
+void QuadtreeTerrain::CreateGridMesh(Mesh& mesh, VertexBufferObject& nodeVBO, unsigned int gridSize)
+{
+    // Vertices are only the position in the grid, the node and the heightmap give the rest
+    VertexFormat vertexFormat;
+    vertexFormat.AddVertexAttribute<float>(2);
+
+    std::vector<glm::vec2> vertices;
+    std::vector<unsigned int> indices;
+    unsigned int rowSize = gridSize + 1;
+    for (unsigned int j = 0; j <= gridSize; ++j)
+    {
+        for (unsigned int i = 0; i <= gridSize; ++i)
+        {
+            vertices.push_back(glm::vec2(i, j) / static_cast<float>(gridSize));
+
+            if (i > 0 && j > 0)
+            {
+                unsigned int topRight = j * rowSize + i;
+                unsigned int topLeft = topRight - 1;
+                unsigned int bottomRight = topRight - rowSize;
+                unsigned int bottomLeft = bottomRight - 1;
+
+                indices.push_back(bottomLeft);
+                indices.push_back(bottomRight);
+                indices.push_back(topLeft);
+
+                indices.push_back(bottomRight);
+                indices.push_back(topLeft);
+                indices.push_back(topRight);
+            }
+        }
+    }
+
+    mesh.AddSubmesh<glm::vec2, unsigned int, VertexFormat::LayoutIterator>(Drawcall::Primitive::Triangles, vertices, indices,
+        vertexFormat.LayoutBegin(static_cast<int>(vertices.size()), true /* interleaved */), vertexFormat.LayoutEnd());
+
+    // The selected nodes are read as instance attributes of the same VAO
+    VertexArrayObject& vao = mesh.GetVertexArray(0);
+    vao.Bind();
+    nodeVBO.Bind();
+    nodeVBO.AllocateData(sizeof(Node), BufferObject::StreamDraw);
+    vao.SetAttribute(s_nodeLocation, VertexAttribute(Data::Type::Float, 4), offsetof(Node, cornerSizeGrid), sizeof(Node), 1);
+    vao.SetAttribute(s_morphLocation, VertexAttribute(Data::Type::Float, 2), offsetof(Node, morphRange), sizeof(Node), 1);
+    VertexArrayObject::Unbind();
+    VertexBufferObject::Unbind();
+}
+
+void QuadtreeTerrain::ComputeNodeHeights(std::span<const float> heights)
+{
+    m_nodeHeights.resize(m_lodCount);
+
+    // Leaves take the range of the samples they cover, including the ones on their borders
+    unsigned int leafCount = GetNodesPerSide(0);
+    std::vector<glm::vec2>& leafHeights = m_nodeHeights[0];
+    leafHeights.assign(leafCount * leafCount, glm::vec2(0.0f));
+    glm::vec2 samplesPerNode = glm::vec2(m_heightmapSize - 1u) / static_cast<float>(leafCount);
+    for (unsigned int y = 0; y < leafCount; ++y)
+    {
+        unsigned int minSampleY = static_cast<unsigned int>(std::floor(y * samplesPerNode.y));
+        unsigned int maxSampleY = std::min(static_cast<unsigned int>(std::ceil((y + 1) * samplesPerNode.y)), m_heightmapSize.y - 1);
+        for (unsigned int x = 0; x < leafCount; ++x)
+        {
+            unsigned int minSampleX = static_cast<unsigned int>(std::floor(x * samplesPerNode.x));
+            unsigned int maxSampleX = std::min(static_cast<unsigned int>(std::ceil((x + 1) * samplesPerNode.x)), m_heightmapSize.x - 1);
+
+            glm::vec2 range(heights[minSampleY * m_heightmapSize.x + minSampleX]);
+            for (unsigned int j = minSampleY; j <= maxSampleY; ++j)
+            {
+                for (unsigned int i = minSampleX; i <= maxSampleX; ++i)
+                {
+                    float sample = heights[j * m_heightmapSize.x + i];
+                    range = glm::vec2(std::min(range.x, sample), std::max(range.y, sample));
+                }
+            }
+            leafHeights[y * leafCount + x] = range;
+        }
+    }
+
+    // Each parent takes the range of its 4 children
+    for (unsigned int lod = 1; lod < m_lodCount; ++lod)
+    {
+        unsigned int count = GetNodesPerSide(lod);
+        const std::vector<glm::vec2>& childHeights = m_nodeHeights[lod - 1];
+        std::vector<glm::vec2>& nodeHeights = m_nodeHeights[lod];
+        nodeHeights.resize(count * count);
+        for (unsigned int y = 0; y < count; ++y)
+        {
+            for (unsigned int x = 0; x < count; ++x)
+            {
+                glm::vec2 range = childHeights[(2 * y) * (2 * count) + 2 * x];
+                for (unsigned int child = 1; child < 4; ++child)
+                {
+                    const glm::vec2& childRange = childHeights[(2 * y + child / 2) * (2 * count) + 2 * x + child % 2];
+                    range = glm::vec2(std::min(range.x, childRange.x), std::max(range.y, childRange.y));
+                }
+                nodeHeights[y * count + x] = range;
+            }
+        }
+    }
+}
+
+float QuadtreeTerrain::GetHeight(const glm::vec2& position) const
+{
+    if (m_heights.empty())
+        return m_origin.y;
+
+    // Same bilinear interpolation as the texture sampler
+    glm::vec2 samplePosition = glm::clamp((position - glm::vec2(m_origin.x, m_origin.z)) / m_size, 0.0f, 1.0f);
+    samplePosition *= glm::vec2(m_heightmapSize - 1u);
+    glm::uvec2 sample0 = glm::min(glm::uvec2(samplePosition), m_heightmapSize - 2u);
+    glm::vec2 weight = samplePosition - glm::vec2(sample0);
+
+    auto GetSample = [&](unsigned int i, unsigned int j) { return m_heights[(sample0.y + j) * m_heightmapSize.x + sample0.x + i]; };
+    float height0 = glm::mix(GetSample(0, 0), GetSample(1, 0), weight.x);
+    float height1 = glm::mix(GetSample(0, 1), GetSample(1, 1), weight.x);
+    return m_origin.y + glm::mix(height0, height1, weight.y) * m_heightScale;
+}
+
+void QuadtreeTerrain::SetMaterialUniforms(Material& material) const
+{
+    material.SetUniformValue("Heightmap", m_heightmap);
+    material.SetUniformValue("HeightmapSize", glm::vec2(m_heightmapSize));
+    material.SetUniformValue("TerrainOrigin", m_origin);
+    material.SetUniformValue("TerrainSize", m_size);
+    material.SetUniformValue("HeightScale", m_heightScale);
+    material.SetUniformValue("CameraPosition", m_cameraPosition);
+}
+
+void QuadtreeTerrain::SelectNodes(const glm::vec3& cameraPosition, const glm::mat4& viewProjMatrix)
+{
+    for (std::vector<Node>& nodes : m_nodes)
+    {
+        nodes.clear();
+    }
+    if (m_lodCount == 0)
+        return;
+
+    m_cameraPosition = cameraPosition;
+    m_frustumPlanes = FrustumCulling::GetPlanes(viewProjMatrix);
+
+    // Each level is used up to twice the distance of the previous one, since its nodes are twice as big
+    m_lodDistances.resize(m_lodCount);
+    for (unsigned int lod = 0; lod < m_lodCount; ++lod)
+    {
+        m_lodDistances[lod] = m_lodDistanceFactor * GetNodeSize(lod);
+    }
+
+    SelectNode(m_lodCount - 1, 0, 0);
+
+    for (unsigned int type = 0; type < NodeTypeCount; ++type)
+    {
+        if (!m_nodes[type].empty())
+        {
+            m_nodeVBOs[type].Bind();
+            m_nodeVBOs[type].AllocateData(std::span<const Node>(m_nodes[type]), BufferObject::StreamDraw);
+        }
+    }
+    VertexBufferObject::Unbind();
+}
+
+void QuadtreeTerrain::SelectNode(unsigned int lod, unsigned int x, unsigned int y)
+{
+    glm::vec3 minPosition, maxPosition;
+    GetNodeBox(lod, x, y, minPosition, maxPosition);
+    if (!IsNodeVisible(minPosition, maxPosition))
+        return;
+
+    // Far enough from the camera, the node is drawn with the detail of its level
+    if (lod == 0 || !IsNodeInRange(minPosition, maxPosition, m_lodDistances[lod - 1]))
+    {
+        AddNode(WholeNode, lod, x, y, lod);
+        return;
+    }
+
+    // Children in range of the next level are refined, the others are drawn as quadrants of this one
+    for (unsigned int child = 0; child < 4; ++child)
+    {
+        unsigned int childX = 2 * x + child % 2;
+        unsigned int childY = 2 * y + child / 2;
+        GetNodeBox(lod - 1, childX, childY, minPosition, maxPosition);
+        if (IsNodeInRange(minPosition, maxPosition, m_lodDistances[lod - 1]))
+        {
+            SelectNode(lod - 1, childX, childY);
+        }
+        else if (IsNodeVisible(minPosition, maxPosition))
+        {
+            AddNode(QuadrantNode, lod - 1, childX, childY, lod);
+        }
+    }
+}
+
+void QuadtreeTerrain::AddNode(NodeType type, unsigned int lod, unsigned int x, unsigned int y, unsigned int drawLod)
+{
+    float nodeSize = GetNodeSize(lod);
+    glm::vec2 corner = glm::vec2(m_origin.x, m_origin.z) + glm::vec2(x, y) * nodeSize;
+    unsigned int gridSize = type == QuadrantNode ? s_gridSize / 2 : s_gridSize;
+
+    // Vertices morph to the grid of the next level when they get close to the end of the range of their level
+    float previousDistance = drawLod > 0 ? m_lodDistances[drawLod - 1] : 0.0f;
+    float distance = m_lodDistances[drawLod];
+
+    Node node;
+    node.cornerSizeGrid = glm::vec4(corner, nodeSize, static_cast<float>(gridSize));
+    node.morphRange = glm::vec2(glm::mix(previousDistance, distance, s_morphStart), distance);
+    m_nodes[type].push_back(node);
+}
+
+void QuadtreeTerrain::GetNodeBox(unsigned int lod, unsigned int x, unsigned int y, glm::vec3& minPosition, glm::vec3& maxPosition) const
+{
+    float nodeSize = GetNodeSize(lod);
+    glm::vec2 heights = m_nodeHeights[lod][y * GetNodesPerSide(lod) + x] * m_heightScale + m_origin.y;
+    minPosition = glm::vec3(m_origin.x + x * nodeSize, heights.x, m_origin.z + y * nodeSize);
+    maxPosition = glm::vec3(minPosition.x + nodeSize, heights.y, minPosition.z + nodeSize);
+}
+
+bool QuadtreeTerrain::IsNodeVisible(const glm::vec3& minPosition, const glm::vec3& maxPosition) const
+{
+    return FrustumCulling::IsAabbVisible(m_frustumPlanes, 0.5f * (minPosition + maxPosition), 0.5f * (maxPosition - minPosition));
+}
+
+bool QuadtreeTerrain::IsNodeInRange(const glm::vec3& minPosition, const glm::vec3& maxPosition, float distance) const
+{
+    glm::vec3 closestPosition = glm::clamp(m_cameraPosition, minPosition, maxPosition);
+    glm::vec3 offset = closestPosition - m_cameraPosition;
+    return glm::dot(offset, offset) <= distance * distance;
+}
+
+void QuadtreeTerrain::Draw() const
+{
+    for (unsigned int type = 0; type < NodeTypeCount; ++type)
+    {
+        if (m_nodes[type].empty())
+            continue;
+
+        const Mesh& mesh = m_gridMeshes[type];
+        mesh.GetSubmeshVertexArray(0).Bind();
+        mesh.GetSubmeshDrawcall(0).DrawInstanced(static_cast<GLsizei>(m_nodes[type].size()));
+    }
+    VertexArrayObject::Unbind();
+}
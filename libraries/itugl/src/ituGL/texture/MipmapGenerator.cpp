@@ -0,0 +1,518 @@
+#include <ituGL/texture/MipmapGenerator.h>
+
+#include <ituGL/utils/ParallelUtils.h>
+#include <cmath>
+#include <cstring>
+#include <cassert>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define MIPMAP_GENERATOR_SSE2
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define MIPMAP_GENERATOR_NEON
+#endif
+
+// The 4 float components of a pixel, using SIMD registers when available
+struct Float4
+{
+#if defined(MIPMAP_GENERATOR_SSE2)
+    __m128 value;
+    static inline Float4 Zero() { return Float4{ _mm_setzero_ps() }; }
+    static inline Float4 Load(const float* pixel) { return Float4{ _mm_loadu_ps(pixel) }; }
+    inline void Store(float* pixel) const { _mm_storeu_ps(pixel, value); }
+    inline void MultiplyAdd(const Float4& a, float b) { value = _mm_add_ps(value, _mm_mul_ps(a.value, _mm_set1_ps(b))); }
+#elif defined(MIPMAP_GENERATOR_NEON)
+    float32x4_t value;
+    static inline Float4 Zero() { return Float4{ vdupq_n_f32(0.0f) }; }
+    static inline Float4 Load(const float* pixel) { return Float4{ vld1q_f32(pixel) }; }
+    inline void Store(float* pixel) const { vst1q_f32(pixel, value); }
+    inline void MultiplyAdd(const Float4& a, float b) { value = vmlaq_n_f32(value, a.value, b); }
+#else
+    float value[4];
+    static inline Float4 Zero() { return Float4{ { 0.0f, 0.0f, 0.0f, 0.0f } }; }
+    static inline Float4 Load(const float* pixel) { return Float4{ { pixel[0], pixel[1], pixel[2], pixel[3] } }; }
+    inline void Store(float* pixel) const { std::memcpy(pixel, value, sizeof(value)); }
+    inline void MultiplyAdd(const Float4& a, float b) { for (int i = 0; i < 4; ++i) value[i] += a.value[i] * b; }
+#endif
+};
+
+// Lookup tables for the sRGB conversions
+class SRGBTables
+{
+public:
+    SRGBTables()
+    {
+        for (int i = 0; i < 256; ++i)
+        {
+            float value = i / 255.0f;
+            m_toLinear[i] = value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+        }
+        for (int i = 0; i < s_toSRGBSize; ++i)
+        {
+            float value = static_cast<float>(i) / (s_toSRGBSize - 1);
+            value = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+            m_toSRGB[i] = static_cast<unsigned char>(std::clamp(value * 255.0f + 0.5f, 0.0f, 255.0f));
+        }
+    }
+
+    inline float ToLinear(unsigned char value) const { return m_toLinear[value]; }
+    inline unsigned char ToSRGB(float value) const { return m_toSRGB[static_cast<int>(std::clamp(value, 0.0f, 1.0f) * (s_toSRGBSize - 1) + 0.5f)]; }
+
+    static const SRGBTables& Get()
+    {
+        static const SRGBTables s_tables;
+        return s_tables;
+    }
+
+private:
+    static const int s_toSRGBSize = 16384;
+    float m_toLinear[256];
+    unsigned char m_toSRGB[s_toSRGBSize];
+};
+
+// Half width of the Kaiser filter, in destination pixels
+static const float s_kaiserWidth = 2.0f;
+// Shape of the Kaiser window
+static const float s_kaiserAlpha = 4.0f;
+
+// Modified Bessel function of the first kind, used by the Kaiser window
+static float BesselI0(float x)
+{
+    float sum = 1.0f, term = 1.0f;
+    for (int k = 1; k < 32 && term > sum * 1e-8f; ++k)
+    {
+        float factor = x / (2.0f * k);
+        term *= factor * factor;
+        sum += term;
+    }
+    return sum;
+}
+
+static float KaiserSinc(float x)
+{
+    float t = x / s_kaiserWidth;
+    if (t * t >= 1.0f)
+    {
+        return 0.0f;
+    }
+    const float pi = 3.14159265f;
+    float sinc = x == 0.0f ? 1.0f : std::sin(pi * x) / (pi * x);
+    return sinc * BesselI0(s_kaiserAlpha * std::sqrt(1.0f - t * t)) / BesselI0(s_kaiserAlpha);
+}
+
+// Find the texel of the cubemap for coordinates that can be outside the face, following the direction into the neighbour face
+static const float* FetchCubemapPixel(const std::array<std::vector<float>, 6>& faces, int side, int face, int x, int y)
+{
+    if (x < 0 || y < 0 || x >= side || y >= side)
+    {
+        // Direction of the texel center, using the face layout from the GL specification
+        float sc = 2.0f * (x + 0.5f) / side - 1.0f;
+        float tc = 2.0f * (y + 0.5f) / side - 1.0f;
+        float direction[3];
+        switch (face)
+        {
+        case 0: direction[0] = 1.0f; direction[1] = -tc; direction[2] = -sc; break;
+        case 1: direction[0] = -1.0f; direction[1] = -tc; direction[2] = sc; break;
+        case 2: direction[0] = sc; direction[1] = 1.0f; direction[2] = tc; break;
+        case 3: direction[0] = sc; direction[1] = -1.0f; direction[2] = -tc; break;
+        case 4: direction[0] = sc; direction[1] = -tc; direction[2] = 1.0f; break;
+        default: direction[0] = -sc; direction[1] = -tc; direction[2] = -1.0f; break;
+        }
+
+        // Project the direction again on the face of the major axis
+        float absX = std::abs(direction[0]), absY = std::abs(direction[1]), absZ = std::abs(direction[2]);
+        float majorAxis;
+        if (absX >= absY && absX >= absZ)
+        {
+            face = direction[0] > 0.0f ? 0 : 1;
+            majorAxis = absX;
+            sc = direction[0] > 0.0f ? -direction[2] : direction[2];
+            tc = -direction[1];
+        }
+        else if (absY >= absZ)
+        {
+            face = direction[1] > 0.0f ? 2 : 3;
+            majorAxis = absY;
+            sc = direction[0];
+            tc = direction[1] > 0.0f ? direction[2] : -direction[2];
+        }
+        else
+        {
+            face = direction[2] > 0.0f ? 4 : 5;
+            majorAxis = absZ;
+            sc = direction[2] > 0.0f ? direction[0] : -direction[0];
+            tc = -direction[1];
+        }
+        x = std::clamp(static_cast<int>(std::floor((sc / majorAxis + 1.0f) * 0.5f * side)), 0, side - 1);
+        y = std::clamp(static_cast<int>(std::floor((tc / majorAxis + 1.0f) * 0.5f * side)), 0, side - 1);
+    }
+    return &faces[face][(static_cast<size_t>(y) * side + x) * 4];
+}
+
+MipmapGenerator::MipmapGenerator()
+    : m_filter(Filter::Box)
+    , m_srgb(false)
+    , m_normalMap(false)
+    , m_alphaCoverageReference(0.0f)
+    , m_wrap(false)
+    , m_threadCount(ParallelUtils::GetDefaultThreadCount())
+{
+}
+
+void MipmapGenerator::SetInternalFormat(TextureObject::InternalFormat internalFormat)
+{
+    switch (internalFormat)
+    {
+    case TextureObject::InternalFormatSRGB8:
+    case TextureObject::InternalFormatSRGBA8:
+    case TextureObject::InternalFormatSRGBCompressed:
+    case TextureObject::InternalFormatSRGBACompressed:
+        m_srgb = true;
+        break;
+    default:
+        m_srgb = false;
+        break;
+    }
+}
+
+int MipmapGenerator::GetLevelCount(GLsizei width, GLsizei height)
+{
+    int levelCount = 1;
+    while (width > 1 || height > 1)
+    {
+        width = std::max(width / 2, 1);
+        height = std::max(height / 2, 1);
+        levelCount++;
+    }
+    return levelCount;
+}
+
+std::vector<MipmapGenerator::Level> MipmapGenerator::Generate(std::span<const std::byte> data, GLsizei width, GLsizei height, int componentCount, Data::Type dataType,
+    int firstLevel) const
+{
+    std::vector<Level> levels;
+    int levelCount = GetLevelCount(width, height);
+    assert(firstLevel >= 0 && firstLevel < levelCount);
+    levels.reserve(levelCount - firstLevel);
+
+    // Level 0 keeps the original data, without conversions
+    if (firstLevel == 0)
+    {
+        levels.push_back(Level{ width, height, std::vector<std::byte>(data.begin(), data.end()) });
+    }
+
+    Image image = ConvertToImage(data, width, height, componentCount, dataType);
+    bool preserveCoverage = m_alphaCoverageReference > 0.0f && componentCount == 4;
+    float alphaCoverage = preserveCoverage ? ComputeAlphaCoverage(image, 1.0f) : -1.0f;
+    for (int level = std::max(firstLevel, 1); level < levelCount; ++level)
+    {
+        // Each level is filtered from the previous one. The first one generated can come directly from the source
+        image = Resize(image, std::max(width >> level, 1), std::max(height >> level, 1));
+        PostProcess(image);
+        float alphaScale = alphaCoverage >= 0.0f ? ComputeAlphaScale(image, alphaCoverage) : 1.0f;
+        levels.push_back(ConvertToLevel(image, alphaScale, componentCount, dataType));
+    }
+    return levels;
+}
+
+std::array<std::vector<MipmapGenerator::Level>, 6> MipmapGenerator::GenerateCubemap(const std::array<std::span<const std::byte>, 6>& faces, GLsizei side, int componentCount, Data::Type dataType) const
+{
+    std::array<std::vector<Level>, 6> faceLevels;
+    std::array<Image, 6> images;
+    int levelCount = GetLevelCount(side, side);
+    bool preserveCoverage = m_alphaCoverageReference > 0.0f && componentCount == 4;
+    std::array<float, 6> alphaCoverages;
+    for (int face = 0; face < 6; ++face)
+    {
+        faceLevels[face].reserve(levelCount);
+        faceLevels[face].push_back(Level{ side, side, std::vector<std::byte>(faces[face].begin(), faces[face].end()) });
+        images[face] = ConvertToImage(faces[face], side, side, componentCount, dataType);
+        alphaCoverages[face] = preserveCoverage ? ComputeAlphaCoverage(images[face], 1.0f) : -1.0f;
+    }
+
+    for (int level = 1; level < levelCount; ++level)
+    {
+        images = DownsampleCubemap(images);
+        for (int face = 0; face < 6; ++face)
+        {
+            PostProcess(images[face]);
+            float alphaScale = alphaCoverages[face] >= 0.0f ? ComputeAlphaScale(images[face], alphaCoverages[face]) : 1.0f;
+            faceLevels[face].push_back(ConvertToLevel(images[face], alphaScale, componentCount, dataType));
+        }
+    }
+    return faceLevels;
+}
+
+MipmapGenerator::Image MipmapGenerator::ConvertToImage(std::span<const std::byte> data, GLsizei width, GLsizei height, int componentCount, Data::Type dataType) const
+{
+    assert(dataType == Data::Type::UByte || dataType == Data::Type::Float);
+    assert(componentCount >= 1 && componentCount <= 4);
+    assert(data.size() == static_cast<size_t>(width) * height * componentCount * Data::GetTypeSize(dataType));
+
+    Image image;
+    image.width = width;
+    image.height = height;
+    image.pixels.resize(static_cast<size_t>(width) * height * 4);
+
+    const SRGBTables& srgbTables = SRGBTables::Get();
+    int colorComponentCount = m_srgb ? std::min(componentCount, 3) : 0;
+    ParallelUtils::For(height, [&](unsigned int y)
+        {
+            size_t firstPixel = static_cast<size_t>(y) * width;
+            for (size_t i = firstPixel; i < firstPixel + width; ++i)
+            {
+                // Missing components are 0, except alpha that is 1
+                float* pixel = &image.pixels[i * 4];
+                pixel[0] = pixel[1] = pixel[2] = 0.0f;
+                pixel[3] = 1.0f;
+                for (int c = 0; c < componentCount; ++c)
+                {
+                    if (dataType == Data::Type::UByte)
+                    {
+                        unsigned char value = static_cast<unsigned char>(data[i * componentCount + c]);
+                        pixel[c] = c < colorComponentCount ? srgbTables.ToLinear(value) : value / 255.0f;
+                    }
+                    else
+                    {
+                        std::memcpy(&pixel[c], &data[(i * componentCount + c) * sizeof(float)], sizeof(float));
+                    }
+                }
+            }
+        }, m_threadCount);
+    return image;
+}
+
+MipmapGenerator::Level MipmapGenerator::ConvertToLevel(const Image& image, float alphaScale, int componentCount, Data::Type dataType) const
+{
+    Level level;
+    level.width = image.width;
+    level.height = image.height;
+    level.data.resize(static_cast<size_t>(image.width) * image.height * componentCount * Data::GetTypeSize(dataType));
+
+    const SRGBTables& srgbTables = SRGBTables::Get();
+    int colorComponentCount = m_srgb ? std::min(componentCount, 3) : 0;
+    ParallelUtils::For(image.height, [&](unsigned int y)
+        {
+            size_t firstPixel = static_cast<size_t>(y) * image.width;
+            for (size_t i = firstPixel; i < firstPixel + image.width; ++i)
+            {
+                float pixel[4];
+                std::memcpy(pixel, &image.pixels[i * 4], sizeof(pixel));
+                pixel[3] = alphaScale != 1.0f ? std::min(pixel[3] * alphaScale, 1.0f) : pixel[3];
+                for (int c = 0; c < componentCount; ++c)
+                {
+                    if (dataType == Data::Type::UByte)
+                    {
+                        unsigned char value = c < colorComponentCount ? srgbTables.ToSRGB(pixel[c])
+                            : static_cast<unsigned char>(std::clamp(pixel[c] * 255.0f + 0.5f, 0.0f, 255.0f));
+                        level.data[i * componentCount + c] = static_cast<std::byte>(value);
+                    }
+                    else
+                    {
+                        std::memcpy(&level.data[(i * componentCount + c) * sizeof(float)], &pixel[c], sizeof(float));
+                    }
+                }
+            }
+        }, m_threadCount);
+    return level;
+}
+
+MipmapGenerator::FilterTaps MipmapGenerator::ComputeTaps(int sourceSize, int destinationSize) const
+{
+    // Size of a destination pixel, in source pixels
+    float scale = static_cast<float>(sourceSize) / destinationSize;
+    float halfWidth = m_filter == Filter::Kaiser ? s_kaiserWidth : 0.5f;
+    float radius = halfWidth * scale;
+
+    FilterTaps taps;
+    taps.tapCount = static_cast<int>(std::ceil(2.0f * radius)) + 1;
+    taps.firstIndices.resize(destinationSize);
+    taps.weights.resize(static_cast<size_t>(destinationSize) * taps.tapCount);
+    for (int i = 0; i < destinationSize; ++i)
+    {
+        float center = (i + 0.5f) * scale;
+        int firstIndex = static_cast<int>(std::floor(center - radius));
+        taps.firstIndices[i] = firstIndex;
+
+        float* weights = &taps.weights[static_cast<size_t>(i) * taps.tapCount];
+        float weightSum = 0.0f;
+        for (int k = 0; k < taps.tapCount; ++k)
+        {
+            float sourceCenter = firstIndex + k + 0.5f;
+            if (m_filter == Filter::Kaiser)
+            {
+                weights[k] = KaiserSinc((sourceCenter - center) / scale);
+            }
+            else
+            {
+                // Box filter: how much the source pixel overlaps the destination pixel
+                float overlapStart = std::max(sourceCenter - 0.5f, center - radius);
+                float overlapEnd = std::min(sourceCenter + 0.5f, center + radius);
+                weights[k] = std::max(overlapEnd - overlapStart, 0.0f);
+            }
+            weightSum += weights[k];
+        }
+        for (int k = 0; k < taps.tapCount; ++k)
+        {
+            weights[k] /= weightSum;
+        }
+    }
+    return taps;
+}
+
+MipmapGenerator::Image MipmapGenerator::Resize(const Image& image, GLsizei width, GLsizei height) const
+{
+    FilterTaps tapsX = ComputeTaps(image.width, width);
+    FilterTaps tapsY = ComputeTaps(image.height, height);
+
+    auto ResolveIndex = [this](int index, int size)
+    {
+        return m_wrap ? ((index % size) + size) % size : std::clamp(index, 0, size - 1);
+    };
+
+    // Horizontal pass, from source width to destination width
+    std::vector<float> horizontal(static_cast<size_t>(width) * image.height * 4);
+    ParallelUtils::For(image.height, [&](unsigned int y)
+        {
+            const float* sourceRow = &image.pixels[static_cast<size_t>(y) * image.width * 4];
+            float* destinationRow = &horizontal[static_cast<size_t>(y) * width * 4];
+            for (int x = 0; x < width; ++x)
+            {
+                const float* weights = &tapsX.weights[static_cast<size_t>(x) * tapsX.tapCount];
+                Float4 sum = Float4::Zero();
+                for (int k = 0; k < tapsX.tapCount; ++k)
+                {
+                    int sourceX = ResolveIndex(tapsX.firstIndices[x] + k, image.width);
+                    sum.MultiplyAdd(Float4::Load(&sourceRow[sourceX * 4]), weights[k]);
+                }
+                sum.Store(&destinationRow[x * 4]);
+            }
+        }, m_threadCount);
+
+    // Vertical pass, accumulating whole rows to read the memory in order
+    Image result;
+    result.width = width;
+    result.height = height;
+    result.pixels.resize(static_cast<size_t>(width) * height * 4);
+    ParallelUtils::For(height, [&](unsigned int y)
+        {
+            const float* weights = &tapsY.weights[static_cast<size_t>(y) * tapsY.tapCount];
+            float* destinationRow = &result.pixels[static_cast<size_t>(y) * width * 4];
+            for (int k = 0; k < tapsY.tapCount; ++k)
+            {
+                int sourceY = ResolveIndex(tapsY.firstIndices[y] + k, image.height);
+                const float* sourceRow = &horizontal[static_cast<size_t>(sourceY) * width * 4];
+                for (int x = 0; x < width; ++x)
+                {
+                    Float4 sum = k == 0 ? Float4::Zero() : Float4::Load(&destinationRow[x * 4]);
+                    sum.MultiplyAdd(Float4::Load(&sourceRow[x * 4]), weights[k]);
+                    sum.Store(&destinationRow[x * 4]);
+                }
+            }
+        }, m_threadCount);
+
+    return result;
+}
+
+std::array<MipmapGenerator::Image, 6> MipmapGenerator::DownsampleCubemap(const std::array<Image, 6>& faces) const
+{
+    GLsizei sourceSide = faces[0].width;
+    GLsizei side = std::max(sourceSide / 2, 1);
+    FilterTaps taps = ComputeTaps(sourceSide, side);
+
+    std::array<std::vector<float>, 6> sourcePixels;
+    std::array<Image, 6> result;
+    for (int face = 0; face < 6; ++face)
+    {
+        assert(faces[face].width == sourceSide && faces[face].height == sourceSide);
+        sourcePixels[face] = faces[face].pixels;
+        result[face].width = side;
+        result[face].height = side;
+        result[face].pixels.resize(static_cast<size_t>(side) * side * 4);
+    }
+
+    // Non separable filter, because the pixels outside the face come from different faces for each row
+    ParallelUtils::For(6 * side, [&](unsigned int row)
+        {
+            int face = row / side;
+            int y = row % side;
+            const float* weightsY = &taps.weights[static_cast<size_t>(y) * taps.tapCount];
+            for (int x = 0; x < side; ++x)
+            {
+                const float* weightsX = &taps.weights[static_cast<size_t>(x) * taps.tapCount];
+                Float4 sum = Float4::Zero();
+                for (int ky = 0; ky < taps.tapCount; ++ky)
+                {
+                    int sourceY = taps.firstIndices[y] + ky;
+                    for (int kx = 0; kx < taps.tapCount; ++kx)
+                    {
+                        int sourceX = taps.firstIndices[x] + kx;
+                        const float* pixel = FetchCubemapPixel(sourcePixels, sourceSide, face, sourceX, sourceY);
+                        sum.MultiplyAdd(Float4::Load(pixel), weightsY[ky] * weightsX[kx]);
+                    }
+                }
+                sum.Store(&result[face].pixels[(static_cast<size_t>(y) * side + x) * 4]);
+            }
+        }, m_threadCount);
+
+    return result;
+}
+
+void MipmapGenerator::PostProcess(Image& image) const
+{
+    // The negative lobes of the Kaiser filter can go below 0
+    for (float& value : image.pixels)
+    {
+        value = std::max(value, 0.0f);
+    }
+
+    if (m_normalMap)
+    {
+        for (size_t i = 0; i < image.pixels.size(); i += 4)
+        {
+            float* pixel = &image.pixels[i];
+            float normal[3] = { pixel[0] * 2.0f - 1.0f, pixel[1] * 2.0f - 1.0f, pixel[2] * 2.0f - 1.0f };
+            float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+            if (length > 0.0f)
+            {
+                for (int c = 0; c < 3; ++c)
+                {
+                    pixel[c] = normal[c] / length * 0.5f + 0.5f;
+                }
+            }
+        }
+    }
+}
+
+float MipmapGenerator::ComputeAlphaScale(const Image& image, float alphaCoverage) const
+{
+    // Binary search of the smallest scale that reaches the coverage of level 0
+    float minScale = 0.0f, maxScale = 4.0f;
+    for (int iteration = 0; iteration < 16; ++iteration)
+    {
+        float scale = 0.5f * (minScale + maxScale);
+        if (ComputeAlphaCoverage(image, scale) < alphaCoverage)
+        {
+            minScale = scale;
+        }
+        else
+        {
+            maxScale = scale;
+        }
+    }
+
+    // Keep alpha unchanged if scaling doesn't improve the coverage, instead of moving values to the edge of the reference
+    float coverageError = std::abs(ComputeAlphaCoverage(image, maxScale) - alphaCoverage);
+    return std::abs(ComputeAlphaCoverage(image, 1.0f) - alphaCoverage) <= coverageError ? 1.0f : maxScale;
+}
+
+float MipmapGenerator::ComputeAlphaCoverage(const Image& image, float alphaScale) const
+{
+    size_t coveredCount = 0;
+    for (size_t i = 3; i < image.pixels.size(); i += 4)
+    {
+        coveredCount += image.pixels[i] * alphaScale > m_alphaCoverageReference ? 1 : 0;
+    }
+    return static_cast<float>(coveredCount) / (image.pixels.size() / 4);
+}
@@ -0,0 +1,53 @@
+#include <ituGL/texture/Texture2DArrayObject.h>
+
+#include <algorithm>
+#include <cassert>
+
+Texture2DArrayObject::Texture2DArrayObject()
+{
+}
+
+void Texture2DArrayObject::SetImage(GLint level, GLsizei width, GLsizei height, GLsizei layerCount, Format format, InternalFormat internalFormat)
+{
+    assert(IsBound());
+    assert(IsValidFormat(format, internalFormat));
+    glTexImage3D(GetTarget(), level, internalFormat, width, height, layerCount, 0, format, GL_BYTE, nullptr);
+}
+
+void Texture2DArrayObject::SetStorage(GLsizei levelCount, GLsizei width, GLsizei height, GLsizei layerCount, Format format, InternalFormat internalFormat)
+{
+    assert(IsBound());
+    assert(levelCount > 0);
+    assert(layerCount > 0 && layerCount <= GetMaxLayerCount());
+    InternalFormat sizedInternalFormat = GetSizedInternalFormat(internalFormat);
+    if (IsImmutableStorageSupported() && sizedInternalFormat != InternalFormatInvalid)
+    {
+        glTexStorage3D(GetTarget(), levelCount, sizedInternalFormat, width, height, layerCount);
+    }
+    else
+    {
+        // Same result with mutable storage, one level at a time. Layers are not reduced
+        for (GLint level = 0; level < levelCount; ++level)
+        {
+            SetImage(level, width, height, layerCount, format, internalFormat);
+            width = std::max(width / 2, 1);
+            height = std::max(height / 2, 1);
+        }
+        SetParameter(TextureObject::ParameterInt::MaxLevel, levelCount - 1);
+    }
+}
+
+void Texture2DArrayObject::SetSubImage(GLint level, GLint layer, GLsizei width, GLsizei height, Format format, std::span<const std::byte> data, Data::Type type)
+{
+    assert(IsBound());
+    assert(type != Data::Type::None);
+    assert(data.size_bytes() == width * height * GetComponentCount(format) * Data::GetTypeSize(type));
+    glTexSubImage3D(GetTarget(), level, 0, 0, layer, width, height, 1, format, static_cast<GLenum>(type), data.data());
+}
+
+GLsizei Texture2DArrayObject::GetMaxLayerCount()
+{
+    GLint maxLayerCount = 0;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayerCount);
+    return maxLayerCount;
+}
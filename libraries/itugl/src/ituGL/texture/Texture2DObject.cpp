@@ -1,5 +1,6 @@
 #include <ituGL/texture/Texture2DObject.h>
 
+#include <algorithm>
 #include <cassert>
 
 Texture2DObject::Texture2DObject()
@@ -20,3 +21,54 @@ void Texture2DObject::SetImage(GLint level, GLsizei width, GLsizei height, Forma
 {
     SetImage<float>(level, width, height, format, internalFormat, std::span<float>());
 }
+
+void Texture2DObject::SetCompressedImage(GLint level, GLsizei width, GLsizei height, InternalFormat internalFormat, std::span<const std::byte> data)
+{
+    assert(IsBound());
+    assert(IsBlockCompressed(internalFormat));
+    assert(data.size_bytes() == GetCompressedImageSize(internalFormat, width, height));
+    glCompressedTexImage2D(GetTarget(), level, internalFormat, width, height, 0, static_cast<GLsizei>(data.size_bytes()), data.data());
+}
+
+void Texture2DObject::ReleaseImage(GLint level, Format format, InternalFormat internalFormat)
+{
+    assert(IsBound());
+    if (IsBlockCompressed(internalFormat))
+    {
+        glCompressedTexImage2D(GetTarget(), level, internalFormat, 0, 0, 0, 0, nullptr);
+    }
+    else
+    {
+        SetImage(level, 0, 0, format, internalFormat);
+    }
+}
+
+void Texture2DObject::SetStorage(GLsizei levelCount, GLsizei width, GLsizei height, Format format, InternalFormat internalFormat)
+{
+    assert(IsBound());
+    assert(levelCount > 0);
+    InternalFormat sizedInternalFormat = GetSizedInternalFormat(internalFormat);
+    if (IsImmutableStorageSupported() && sizedInternalFormat != InternalFormatInvalid)
+    {
+        glTexStorage2D(GetTarget(), levelCount, sizedInternalFormat, width, height);
+    }
+    else
+    {
+        // Same result with mutable storage, one level at a time
+        for (GLint level = 0; level < levelCount; ++level)
+        {
+            SetImage(level, width, height, format, internalFormat);
+            width = std::max(width / 2, 1);
+            height = std::max(height / 2, 1);
+        }
+        SetParameter(TextureObject::ParameterInt::MaxLevel, levelCount - 1);
+    }
+}
+
+void Texture2DObject::SetSubImage(GLint level, GLint x, GLint y, GLsizei width, GLsizei height, Format format, std::span<const std::byte> data, Data::Type type)
+{
+    assert(IsBound());
+    assert(type != Data::Type::None);
+    assert(data.size_bytes() == width * height * GetComponentCount(format) * Data::GetTypeSize(type));
+    glTexSubImage2D(GetTarget(), level, x, y, width, height, format, static_cast<GLenum>(type), data.data());
+}
@@ -1,5 +1,6 @@
 #include <ituGL/texture/TextureCubemapObject.h>
 
+#include <algorithm>
 #include <cassert>
 
 TextureCubemapObject::TextureCubemapObject()
@@ -26,3 +27,32 @@ void TextureCubemapObject::SetImage(GLint level, GLsizei side, Format format, In
     SetImage<std::byte>(level, Face::Front, side, format, internalFormat, empty, Data::Type::None);
     SetImage<std::byte>(level, Face::Back, side, format, internalFormat, empty, Data::Type::None);
 }
+
+void TextureCubemapObject::SetStorage(GLsizei levelCount, GLsizei side, Format format, InternalFormat internalFormat)
+{
+    assert(IsBound());
+    assert(levelCount > 0);
+    InternalFormat sizedInternalFormat = GetSizedInternalFormat(internalFormat);
+    if (IsImmutableStorageSupported() && sizedInternalFormat != InternalFormatInvalid)
+    {
+        glTexStorage2D(GetTarget(), levelCount, sizedInternalFormat, side, side);
+    }
+    else
+    {
+        // Same result with mutable storage, one level at a time
+        for (GLint level = 0; level < levelCount; ++level)
+        {
+            SetImage(level, side, format, internalFormat);
+            side = std::max(side / 2, 1);
+        }
+        SetParameter(TextureObject::ParameterInt::MaxLevel, levelCount - 1);
+    }
+}
+
+void TextureCubemapObject::SetSubImage(GLint level, Face face, GLsizei side, Format format, std::span<const std::byte> data, Data::Type type)
+{
+    assert(IsBound());
+    assert(type != Data::Type::None);
+    assert(data.size_bytes() == side * side * GetComponentCount(format) * Data::GetTypeSize(type));
+    glTexSubImage2D(static_cast<GLenum>(face), level, 0, 0, side, side, format, static_cast<GLenum>(type), data.data());
+}
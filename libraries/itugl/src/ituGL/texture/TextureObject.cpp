@@ -1,6 +1,7 @@
 #include <ituGL/texture/TextureObject.h>
 
 #include <cassert>
+#include <algorithm>
 
 TextureObject::TextureObject() : Object(NullHandle)
 {
@@ -250,3 +251,72 @@ int TextureObject::GetDataComponentCount(InternalFormat internalFormat)
         return 0;
     }
 }
+
+bool TextureObject::IsBlockCompressed(InternalFormat internalFormat)
+{
+    return GetBlockSize(internalFormat) != 0;
+}
+
+int TextureObject::GetBlockSize(InternalFormat internalFormat)
+{
+    switch (internalFormat)
+    {
+    case InternalFormatBC1:
+    case InternalFormatBC1SRGB:
+    case InternalFormatBC4:
+        return 8;
+    case InternalFormatBC3:
+    case InternalFormatBC3SRGB:
+    case InternalFormatBC5:
+    case InternalFormatBC7:
+    case InternalFormatBC7SRGB:
+        return 16;
+    default:
+        //Not block compressed
+        return 0;
+    }
+}
+
+size_t TextureObject::GetCompressedImageSize(InternalFormat internalFormat, GLsizei width, GLsizei height)
+{
+    // Partial blocks at the borders use a full block
+    size_t blockCountX = (std::max(width, 1) + 3) / 4;
+    size_t blockCountY = (std::max(height, 1) + 3) / 4;
+    return blockCountX * blockCountY * GetBlockSize(internalFormat);
+}
+
+bool TextureObject::IsImmutableStorageSupported()
+{
+    // The functions are only loaded when the context supports them. With GLAD_DEBUG, glTexStorage2D is a wrapper
+    // that is never null, so the loaded pointers are checked instead
+    return glad_glTexStorage2D != nullptr && glad_glTexStorage3D != nullptr;
+}
+
+TextureObject::InternalFormat TextureObject::GetSizedInternalFormat(InternalFormat internalFormat)
+{
+    switch (internalFormat)
+    {
+    case InternalFormatR:
+        return InternalFormatR8;
+    case InternalFormatRG:
+        return InternalFormatRG8;
+    case InternalFormatRGB:
+        return InternalFormatRGB8;
+    case InternalFormatRGBA:
+        return InternalFormatRGBA8;
+    case InternalFormatDepth:
+        return InternalFormatDepth24;
+    case InternalFormatDepthStencil:
+        return InternalFormatDepth24Stencil8;
+    case InternalFormatRCompressed:
+    case InternalFormatRGCompressed:
+    case InternalFormatRGBCompressed:
+    case InternalFormatRGBACompressed:
+    case InternalFormatSRGBCompressed:
+    case InternalFormatSRGBACompressed:
+        return InternalFormatInvalid;
+    default:
+        // Already sized
+        return internalFormat;
+    }
+}
@@ -0,0 +1,97 @@
+#include <ituGL/utils/MappedFile.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() : m_data(nullptr), m_size(0)
+#ifdef _WIN32
+    , m_mappingHandle(nullptr)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+bool MappedFile::Open(const char* path)
+{
+    Close();
+
+#ifdef _WIN32
+    HANDLE fileHandle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (GetFileSizeEx(fileHandle, &fileSize) && fileSize.QuadPart > 0)
+    {
+        // The mapping keeps its own reference to the file, so the file handle can be closed
+        m_mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (m_mappingHandle)
+        {
+            m_data = static_cast<const std::byte*>(MapViewOfFile(m_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+            m_size = static_cast<size_t>(fileSize.QuadPart);
+        }
+    }
+    CloseHandle(fileHandle);
+#else
+    int fileDescriptor = open(path, O_RDONLY);
+    if (fileDescriptor == -1)
+    {
+        return false;
+    }
+
+    struct stat fileStat;
+    if (fstat(fileDescriptor, &fileStat) == 0 && fileStat.st_size > 0)
+    {
+        // The mapping keeps its own reference to the file, so the descriptor can be closed
+        void* data = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+        if (data != MAP_FAILED)
+        {
+            m_data = static_cast<const std::byte*>(data);
+            m_size = static_cast<size_t>(fileStat.st_size);
+        }
+    }
+    close(fileDescriptor);
+#endif
+
+    if (!m_data)
+    {
+        Close();
+    }
+    return IsOpen();
+}
+
+void MappedFile::Close()
+{
+#ifdef _WIN32
+    if (m_data)
+    {
+        UnmapViewOfFile(m_data);
+    }
+    if (m_mappingHandle)
+    {
+        CloseHandle(m_mappingHandle);
+        m_mappingHandle = nullptr;
+    }
+#else
+    if (m_data)
+    {
+        munmap(const_cast<std::byte*>(m_data), m_size);
+    }
+#endif
+    m_data = nullptr;
+    m_size = 0;
+}
@@ -0,0 +1,167 @@
+#include <ituGL/utils/ParallelUtils.h>
+
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <vector>
+
+// Indices of a single For, shared by the threads that take part
+struct ParallelJob
+{
+    void (*function)(void* context, unsigned int index);
+    void* context;
+    unsigned int count;
+    std::atomic<unsigned int> nextIndex;
+};
+
+// Set while the thread processes indices, so nested calls don't wait for threads that are already busy
+static thread_local bool s_insideJob = false;
+
+static void ProcessIndices(ParallelJob& job)
+{
+    bool wasInsideJob = s_insideJob;
+    s_insideJob = true;
+    for (unsigned int index = job.nextIndex++; index < job.count; index = job.nextIndex++)
+    {
+        job.function(job.context, index);
+    }
+    s_insideJob = wasInsideJob;
+}
+
+// Threads that wait for jobs. Only one job runs at a time, started by the thread that owns the pool while it runs
+class ParallelWorkerPool
+{
+public:
+    ParallelWorkerPool(unsigned int workerCount) : m_job(nullptr), m_jobId(0), m_freeSlots(0), m_busyWorkers(0), m_stop(false)
+    {
+        m_workers.reserve(workerCount);
+        for (unsigned int i = 0; i < workerCount; ++i)
+        {
+            m_workers.emplace_back([this]() { WorkerLoop(); });
+        }
+    }
+
+    ~ParallelWorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_workCondition.notify_all();
+        for (std::thread& worker : m_workers)
+        {
+            worker.join();
+        }
+    }
+
+    static ParallelWorkerPool& GetInstance()
+    {
+        // The calling thread is one of the threads of each job
+        static ParallelWorkerPool instance(ParallelUtils::GetDefaultThreadCount() - 1);
+        return instance;
+    }
+
+    // Take the pool for a job. Returns false if another thread is using it
+    bool TryAcquire() { return m_ownerMutex.try_lock(); }
+    void Release() { m_ownerMutex.unlock(); }
+
+    // Process the job with up to helperCount workers, returns when all the indices are done
+    void Run(ParallelJob& job, unsigned int helperCount)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_job = &job;
+            ++m_jobId;
+            m_freeSlots = std::min(helperCount, static_cast<unsigned int>(m_workers.size()));
+        }
+        m_workCondition.notify_all();
+
+        ProcessIndices(job);
+
+        // Workers that didn't start yet can't join anymore, and the ones inside the job must finish
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_freeSlots = 0;
+        m_doneCondition.wait(lock, [this]() { return m_busyWorkers == 0; });
+        m_job = nullptr;
+    }
+
+private:
+    void WorkerLoop()
+    {
+        unsigned long long lastJobId = 0;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true)
+        {
+            m_workCondition.wait(lock, [&]() { return m_stop || (m_jobId != lastJobId && m_freeSlots > 0); });
+            if (m_stop)
+            {
+                return;
+            }
+
+            lastJobId = m_jobId;
+            --m_freeSlots;
+            ++m_busyWorkers;
+            ParallelJob& job = *m_job;
+            lock.unlock();
+
+            ProcessIndices(job);
+
+            lock.lock();
+            if (--m_busyWorkers == 0)
+            {
+                m_doneCondition.notify_one();
+            }
+        }
+    }
+
+private:
+    std::vector<std::thread> m_workers;
+
+    // Held by the thread that runs a job
+    std::mutex m_ownerMutex;
+
+    // Protects the state of the current job
+    std::mutex m_mutex;
+    std::condition_variable m_workCondition;
+    std::condition_variable m_doneCondition;
+
+    ParallelJob* m_job;
+    unsigned long long m_jobId;
+    // Workers that can still join the current job, and workers processing it
+    unsigned int m_freeSlots;
+    unsigned int m_busyWorkers;
+    bool m_stop;
+};
+
+void ParallelUtils::Run(unsigned int count, IndexFunction function, void* context, unsigned int threadCount)
+{
+    ParallelJob job{ function, context, count, 0 };
+
+    // Nested calls run here, the other threads are already busy with the outer one
+    if (s_insideJob)
+    {
+        ProcessIndices(job);
+        return;
+    }
+
+    ParallelWorkerPool& pool = ParallelWorkerPool::GetInstance();
+    if (pool.TryAcquire())
+    {
+        pool.Run(job, threadCount - 1);
+        pool.Release();
+        return;
+    }
+
+    // Another thread, like a loading thread, is using the pool. Use temporary threads to not wait for it
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount - 1);
+    for (unsigned int i = 1; i < threadCount; ++i)
+    {
+        threads.emplace_back([&job]() { ProcessIndices(job); });
+    }
+    ProcessIndices(job);
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+}
@@ -0,0 +1,150 @@
+#include <ituGL/scene/FrustumCulling.h>
+#include <ituGL/scene/AabbArray.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+// Results of culling the same bounds with the batch and the single tests
+struct CullingResult
+{
+    unsigned int visibleCount = 0;
+    // Bounds where the tests disagree, and how many of them are so close to a plane that rounding decides
+    unsigned int mismatchCount = 0;
+    unsigned int borderlineCount = 0;
+    double singleMilliseconds = 0.0;
+    double batchMilliseconds = 0.0;
+};
+
+static double GetMilliseconds(std::chrono::steady_clock::time_point startTime)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+// Lowest signed distance of the bounds to the planes, for a center and the reach of the bounds along each normal
+template<typename TGetReach>
+static float GetDistance(const FrustumCulling::Planes& planes, const glm::vec3& center, TGetReach&& getReach)
+{
+    float distance = std::numeric_limits<float>::max();
+    for (const glm::vec4& plane : planes)
+    {
+        distance = std::min(distance, glm::dot(glm::vec3(plane), center) + plane.w + getReach(glm::vec3(plane)));
+    }
+    return distance;
+}
+
+// The tests add the terms in different order. Only bounds touching a plane may get different results
+static bool IsBorderline(float distance, const glm::vec3& center)
+{
+    return std::abs(distance) <= 1e-4f * std::max(1.0f, glm::length(center));
+}
+
+static void PrintResult(const std::string& name, const CullingResult& result, unsigned int iterationCount)
+{
+    std::cout << std::left << std::setw(12) << name << std::right << std::setw(10) << result.visibleCount
+        << std::setw(12) << result.mismatchCount << std::setw(12) << result.borderlineCount << std::fixed << std::setprecision(3)
+        << std::setw(12) << result.singleMilliseconds / iterationCount << std::setw(12) << result.batchMilliseconds / iterationCount << std::endl;
+}
+
+// Usage: cullingbench [bounds] [iterations]
+// Culls random boxes and spheres against a camera that turns around, with the batch tests of FrustumCulling and with
+// IsAabbVisible and IsSphereVisible for each of them. Checks that both give the same visibility, except for bounds that
+// touch a plane within the rounding error, and reports the average time of each per iteration
+int main(int argc, char* argv[])
+{
+    unsigned int count = argc > 1 ? std::stoul(argv[1]) : 1 << 16;
+    unsigned int iterationCount = std::max(argc > 2 ? static_cast<unsigned int>(std::stoul(argv[2])) : 100u, 1u);
+
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> size(0.1f, 5.0f);
+
+    AabbArray boxes;
+    std::vector<float> centerX(count), centerY(count), centerZ(count), radius(count);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        boxes.PushBack(glm::vec3(position(random), position(random), position(random)), glm::vec3(size(random), size(random), size(random)));
+        centerX[i] = position(random);
+        centerY[i] = position(random);
+        centerZ[i] = position(random);
+        radius[i] = size(random);
+    }
+
+    glm::mat4 projectionMatrix = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 150.0f);
+
+    CullingResult boxResult, sphereResult;
+    std::vector<unsigned int> visibilityMask;
+    std::vector<unsigned int> singleMask(FrustumCulling::GetMaskSize(count));
+    for (unsigned int iteration = 0; iteration < iterationCount; ++iteration)
+    {
+        float angle = iteration * 0.1f;
+        glm::mat4 viewMatrix = glm::lookAt(glm::vec3(0.0f), glm::vec3(std::sin(angle), std::sin(angle * 0.3f) * 0.5f, std::cos(angle)), glm::vec3(0.0f, 1.0f, 0.0f));
+        FrustumCulling::Planes planes = FrustumCulling::GetPlanes(projectionMatrix * viewMatrix);
+
+        // Boxes. The single tests also fill a mask, to do the same work as the batch
+        auto startTime = std::chrono::steady_clock::now();
+        std::fill(singleMask.begin(), singleMask.end(), 0u);
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            singleMask[i / 32] |= (FrustumCulling::IsAabbVisible(planes, boxes.GetCenter(i), boxes.GetExtents(i)) ? 1u : 0u) << (i % 32);
+        }
+        boxResult.singleMilliseconds += GetMilliseconds(startTime);
+
+        startTime = std::chrono::steady_clock::now();
+        boxResult.visibleCount = FrustumCulling::CullAabbs(planes, boxes, visibilityMask);
+        boxResult.batchMilliseconds += GetMilliseconds(startTime);
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            if (FrustumCulling::IsVisible(visibilityMask, i) != FrustumCulling::IsVisible(singleMask, i))
+            {
+                glm::vec3 center = boxes.GetCenter(i);
+                glm::vec3 extents = boxes.GetExtents(i);
+                float distance = GetDistance(planes, center, [&](const glm::vec3& normal) { return glm::dot(glm::abs(normal), extents); });
+                boxResult.mismatchCount++;
+                boxResult.borderlineCount += IsBorderline(distance, center) ? 1 : 0;
+            }
+        }
+
+        // Spheres
+        startTime = std::chrono::steady_clock::now();
+        std::fill(singleMask.begin(), singleMask.end(), 0u);
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            glm::vec3 center(centerX[i], centerY[i], centerZ[i]);
+            singleMask[i / 32] |= (FrustumCulling::IsSphereVisible(planes, center, radius[i]) ? 1u : 0u) << (i % 32);
+        }
+        sphereResult.singleMilliseconds += GetMilliseconds(startTime);
+
+        startTime = std::chrono::steady_clock::now();
+        sphereResult.visibleCount = FrustumCulling::CullSpheres(planes, centerX, centerY, centerZ, radius, visibilityMask);
+        sphereResult.batchMilliseconds += GetMilliseconds(startTime);
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            if (FrustumCulling::IsVisible(visibilityMask, i) != FrustumCulling::IsVisible(singleMask, i))
+            {
+                glm::vec3 center(centerX[i], centerY[i], centerZ[i]);
+                float distance = GetDistance(planes, center, [&](const glm::vec3&) { return radius[i]; });
+                sphereResult.mismatchCount++;
+                sphereResult.borderlineCount += IsBorderline(distance, center) ? 1 : 0;
+            }
+        }
+    }
+
+    std::cout << "bounds: " << count << ", iterations: " << iterationCount << std::endl;
+    std::cout << std::left << std::setw(12) << "bounds" << std::right << std::setw(10) << "visible" << std::setw(12) << "mismatches"
+        << std::setw(12) << "borderline" << std::setw(12) << "single ms" << std::setw(12) << "batch ms" << std::endl;
+    PrintResult("boxes", boxResult, iterationCount);
+    PrintResult("spheres", sphereResult, iterationCount);
+
+    bool valid = boxResult.mismatchCount == boxResult.borderlineCount && sphereResult.mismatchCount == sphereResult.borderlineCount;
+    std::cout << (valid ? "Batch results match the single tests" : "Batch results don't match the single tests") << std::endl;
+
+    return valid ? 0 : 1;
+}
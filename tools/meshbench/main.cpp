@@ -0,0 +1,139 @@
+#include <ituGL/geometry/MeshOptimizer.h>
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstring>
+
+// Statistics of one mesh, or the sum of several
+struct MeshResult
+{
+    unsigned int triangleCount = 0;
+    unsigned int vertexCount = 0;
+    // Vertices transformed before and after the optimization, for each cache size
+    unsigned long long missesBefore[2] = {};
+    unsigned long long missesAfter[2] = {};
+    double milliseconds = 0.0;
+};
+
+static const unsigned int s_cacheSizes[2] = { 16, 32 };
+
+static void PrintResult(const std::string& name, const MeshResult& result)
+{
+    std::cout << std::left << std::setw(32) << name << std::right << std::fixed << std::setprecision(3)
+        << std::setw(10) << result.triangleCount << std::setw(10) << result.vertexCount;
+    for (int i = 0; i < 2; ++i)
+    {
+        float acmrBefore = result.triangleCount ? static_cast<float>(result.missesBefore[i]) / result.triangleCount : 0.0f;
+        float acmrAfter = result.triangleCount ? static_cast<float>(result.missesAfter[i]) / result.triangleCount : 0.0f;
+        float atvrBefore = result.vertexCount ? static_cast<float>(result.missesBefore[i]) / result.vertexCount : 0.0f;
+        float atvrAfter = result.vertexCount ? static_cast<float>(result.missesAfter[i]) / result.vertexCount : 0.0f;
+        std::cout << std::setw(9) << acmrBefore << " ->" << std::setw(6) << acmrAfter
+            << std::setw(9) << atvrBefore << " ->" << std::setw(6) << atvrAfter;
+    }
+    std::cout << std::setw(10) << std::setprecision(1) << result.milliseconds << std::endl;
+}
+
+static void Accumulate(MeshResult& total, const MeshResult& result)
+{
+    total.triangleCount += result.triangleCount;
+    total.vertexCount += result.vertexCount;
+    for (int i = 0; i < 2; ++i)
+    {
+        total.missesBefore[i] += result.missesBefore[i];
+        total.missesAfter[i] += result.missesAfter[i];
+    }
+    total.milliseconds += result.milliseconds;
+}
+
+// Run the same optimization as ModelLoader on the positions and indices of the mesh
+static MeshResult BenchmarkMesh(const aiMesh& mesh)
+{
+    MeshResult result;
+
+    std::vector<unsigned int> indices;
+    indices.reserve(mesh.mNumFaces * 3);
+    for (unsigned int faceIndex = 0; faceIndex < mesh.mNumFaces; ++faceIndex)
+    {
+        const aiFace& face = mesh.mFaces[faceIndex];
+        indices.insert(indices.end(), face.mIndices, face.mIndices + face.mNumIndices);
+    }
+
+    std::vector<GLubyte> vertexData(mesh.mNumVertices * sizeof(aiVector3D));
+    std::memcpy(vertexData.data(), mesh.mVertices, vertexData.size());
+
+    result.triangleCount = mesh.mNumFaces;
+    for (int i = 0; i < 2; ++i)
+    {
+        MeshOptimizer::CacheStatistics statistics = MeshOptimizer::AnalyzeVertexCache(indices, mesh.mNumVertices, s_cacheSizes[i]);
+        result.missesBefore[i] = static_cast<unsigned long long>(statistics.acmr * result.triangleCount + 0.5f);
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+    result.vertexCount = MeshOptimizer::Optimize(indices, vertexData, sizeof(aiVector3D), 0);
+    result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+    for (int i = 0; i < 2; ++i)
+    {
+        MeshOptimizer::CacheStatistics statistics = MeshOptimizer::AnalyzeVertexCache(indices, result.vertexCount, s_cacheSizes[i]);
+        result.missesAfter[i] = static_cast<unsigned long long>(statistics.acmr * result.triangleCount + 0.5f);
+    }
+
+    return result;
+}
+
+// Usage: meshbench files...
+// Imports the models like ModelLoader and reports the vertex cache efficiency before and after the mesh optimization
+// ACMR: vertices transformed per triangle. ATVR: vertices transformed per vertex. Both for FIFO caches of 16 and 32 entries
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cout << "Usage: meshbench files..." << std::endl;
+        return 1;
+    }
+
+    std::cout << std::left << std::setw(32) << "mesh" << std::right << std::setw(10) << "triangles" << std::setw(10) << "vertices"
+        << std::setw(18) << "ACMR(16)" << std::setw(18) << "ATVR(16)" << std::setw(18) << "ACMR(32)" << std::setw(18) << "ATVR(32)"
+        << std::setw(10) << "ms" << std::endl;
+
+    int failed = 0;
+    MeshResult total;
+    for (int argumentIndex = 1; argumentIndex < argc; ++argumentIndex)
+    {
+        Assimp::Importer importer;
+        const aiScene* scene = importer.ReadFile(argv[argumentIndex],
+            aiProcess_CalcTangentSpace | aiProcess_GenNormals | aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | aiProcess_SortByPType);
+        if (!scene)
+        {
+            std::cout << "Failed to import " << argv[argumentIndex] << std::endl;
+            failed++;
+            continue;
+        }
+
+        for (unsigned int meshIndex = 0; meshIndex < scene->mNumMeshes; ++meshIndex)
+        {
+            const aiMesh& mesh = *scene->mMeshes[meshIndex];
+            if (mesh.mPrimitiveTypes != aiPrimitiveType_TRIANGLE)
+            {
+                continue;
+            }
+
+            MeshResult result = BenchmarkMesh(mesh);
+            std::string name = std::string(argv[argumentIndex]) + ":" + std::to_string(meshIndex);
+            if (name.size() > 31)
+            {
+                name = "..." + name.substr(name.size() - 28);
+            }
+            PrintResult(name, result);
+            Accumulate(total, result);
+        }
+    }
+    PrintResult("total", total);
+
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,236 @@
+#include <ituGL/particles/CpuParticleSystem.h>
+#include <ituGL/particles/ParticleSorter.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+// Simulation of the particles one at a time, with the same equations as CpuParticleSystem, to check its results
+struct ReferenceParticles
+{
+    struct Particle
+    {
+        glm::vec3 position;
+        glm::vec3 velocity;
+        glm::vec3 color;
+        float size;
+        float age;
+        float lifetime;
+    };
+
+    void Emit(const glm::vec3& position, const glm::vec3& velocity, const glm::vec3& color, float size, float lifetime)
+    {
+        particles.push_back({ position, velocity, color, size, 0.0f, lifetime });
+    }
+
+    void Update(float deltaTime)
+    {
+        unsigned int liveCount = 0;
+        for (Particle& particle : particles)
+        {
+            particle.velocity += (gravity - drag * particle.velocity) * deltaTime;
+            particle.position += particle.velocity * deltaTime;
+            particle.age += deltaTime;
+            if (particle.age < particle.lifetime)
+            {
+                particles[liveCount++] = particle;
+            }
+        }
+        particles.resize(liveCount);
+    }
+
+    std::vector<Particle> particles;
+    glm::vec3 gravity;
+    float drag;
+};
+
+// Time spent in each step, added over all the frames
+struct Timings
+{
+    double update = 0.0;
+    double referenceUpdate = 0.0;
+    double writeVertices = 0.0;
+    double sort = 0.0;
+    double referenceSort = 0.0;
+};
+
+static double GetMilliseconds(std::chrono::steady_clock::time_point startTime)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+// Results are computed with the same operations, but the compiler may fuse them differently in each version
+static bool IsClose(float value, float expected)
+{
+    return std::abs(value - expected) <= 1e-4f * std::max(1.0f, std::abs(expected));
+}
+
+static bool CheckParticles(const CpuParticleSystem& particleSystem, const ReferenceParticles& reference,
+    std::span<const CpuParticleSystem::Vertex> vertices)
+{
+    if (particleSystem.GetCount() != reference.particles.size())
+    {
+        std::cout << "Particle count " << particleSystem.GetCount() << ", expected " << reference.particles.size() << std::endl;
+        return false;
+    }
+
+    std::span<const float> positionX = particleSystem.GetPositionX();
+    std::span<const float> positionY = particleSystem.GetPositionY();
+    std::span<const float> positionZ = particleSystem.GetPositionZ();
+    for (unsigned int i = 0; i < particleSystem.GetCount(); ++i)
+    {
+        const ReferenceParticles::Particle& particle = reference.particles[i];
+        const CpuParticleSystem::Vertex& vertex = vertices[i];
+        float alpha = 1.0f - particle.age / particle.lifetime;
+        bool valid = IsClose(positionX[i], particle.position.x) && IsClose(positionY[i], particle.position.y) && IsClose(positionZ[i], particle.position.z)
+            && vertex.position == glm::vec3(positionX[i], positionY[i], positionZ[i]) && vertex.size == particle.size
+            && glm::vec3(vertex.color) == particle.color && IsClose(vertex.color.a, alpha);
+        if (!valid)
+        {
+            std::cout << "Particle " << i << " doesn't match the reference" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// The indices must be a permutation of the particles, from the farthest to the closest
+static bool CheckSort(std::span<const unsigned int> indices, std::span<const float> depths)
+{
+    if (indices.size() != depths.size())
+    {
+        std::cout << "Sorted " << indices.size() << " indices, expected " << depths.size() << std::endl;
+        return false;
+    }
+
+    std::vector<bool> found(indices.size(), false);
+    for (unsigned int i = 0; i < indices.size(); ++i)
+    {
+        unsigned int index = indices[i];
+        if (index >= indices.size() || found[index])
+        {
+            std::cout << "Sorted indices are not a permutation, at " << i << std::endl;
+            return false;
+        }
+        found[index] = true;
+
+        if (i > 0 && depths[indices[i - 1]] > depths[index])
+        {
+            std::cout << "Sorted indices are not back to front, at " << i << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Usage: particlebench [particles] [frames]
+// Runs the same emission in CpuParticleSystem and in a scalar reference, checks that the particles and the vertices match
+// every frame, and that ParticleSorter orders them back to front. Reports the average time of each step per frame
+int main(int argc, char* argv[])
+{
+    unsigned int capacity = argc > 1 ? std::stoul(argv[1]) : 1 << 18;
+    unsigned int frameCount = argc > 2 ? std::stoul(argv[2]) : 120;
+    const float deltaTime = 1.0f / 60.0f;
+
+    CpuParticleSystem particleSystem;
+    particleSystem.Initialize(capacity);
+    particleSystem.SetDrag(0.5f);
+
+    ReferenceParticles reference;
+    reference.particles.reserve(capacity);
+    reference.gravity = particleSystem.GetGravity();
+    reference.drag = particleSystem.GetDrag();
+
+    ParticleSorter sorter;
+    std::vector<CpuParticleSystem::Vertex> vertices(capacity);
+    std::vector<float> depths;
+    std::vector<unsigned int> referenceIndices;
+
+    // Lifetimes are short enough that particles die every frame, once the system is full
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> lifetime(0.2f, 1.0f);
+    unsigned int emitCount = std::max(capacity / 30, 1u);
+
+    Timings timings;
+    bool valid = true;
+    for (unsigned int frame = 0; frame < frameCount && valid; ++frame)
+    {
+        for (unsigned int i = 0; i < emitCount; ++i)
+        {
+            glm::vec3 position(unit(random), unit(random), unit(random));
+            glm::vec3 velocity(unit(random), unit(random) + 4.0f, unit(random));
+            glm::vec3 color(unit(random) * 0.5f + 0.5f, unit(random) * 0.5f + 0.5f, unit(random) * 0.5f + 0.5f);
+            float size = unit(random) + 2.0f;
+            float particleLifetime = lifetime(random);
+            if (particleSystem.Emit(position, velocity, color, size, particleLifetime))
+            {
+                reference.Emit(position, velocity, color, size, particleLifetime);
+            }
+        }
+
+        auto startTime = std::chrono::steady_clock::now();
+        particleSystem.Update(deltaTime);
+        timings.update += GetMilliseconds(startTime);
+
+        startTime = std::chrono::steady_clock::now();
+        reference.Update(deltaTime);
+        timings.referenceUpdate += GetMilliseconds(startTime);
+
+        unsigned int count = particleSystem.GetCount();
+        startTime = std::chrono::steady_clock::now();
+        particleSystem.WriteVertices(std::span(vertices.data(), count));
+        timings.writeVertices += GetMilliseconds(startTime);
+
+        valid = CheckParticles(particleSystem, reference, std::span(vertices.data(), count));
+
+        // Camera orbiting the emitter, so the order changes every frame
+        float angle = frame * 0.05f;
+        glm::mat4 viewMatrix = glm::lookAt(glm::vec3(std::sin(angle), 0.5f, std::cos(angle)) * 10.0f, glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+        startTime = std::chrono::steady_clock::now();
+        sorter.Sort(particleSystem.GetPositionX(), particleSystem.GetPositionY(), particleSystem.GetPositionZ(), viewMatrix);
+        timings.sort += GetMilliseconds(startTime);
+
+        // The depth in view space, computed like the sorter does
+        depths.resize(count);
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            depths[i] = viewMatrix[0][2] * particleSystem.GetPositionX()[i] + viewMatrix[1][2] * particleSystem.GetPositionY()[i]
+                + viewMatrix[2][2] * particleSystem.GetPositionZ()[i] + viewMatrix[3][2];
+        }
+
+        startTime = std::chrono::steady_clock::now();
+        referenceIndices.resize(count);
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            referenceIndices[i] = i;
+        }
+        std::stable_sort(referenceIndices.begin(), referenceIndices.end(), [&](unsigned int a, unsigned int b) { return depths[a] < depths[b]; });
+        timings.referenceSort += GetMilliseconds(startTime);
+
+        valid = valid && CheckSort(sorter.GetIndices(), depths);
+        if (!valid)
+        {
+            std::cout << "Failed at frame " << frame << std::endl;
+        }
+    }
+
+    double frames = std::max(frameCount, 1u);
+    std::cout << "particles: " << particleSystem.GetCount() << " of " << capacity << ", frames: " << frameCount << std::endl;
+    std::cout << std::fixed << std::setprecision(3)
+        << std::left << std::setw(32) << "step" << std::right << std::setw(10) << "ms" << std::setw(14) << "reference ms" << std::endl
+        << std::left << std::setw(32) << "CpuParticleSystem::Update" << std::right << std::setw(10) << timings.update / frames
+        << std::setw(14) << timings.referenceUpdate / frames << std::endl
+        << std::left << std::setw(32) << "CpuParticleSystem::WriteVertices" << std::right << std::setw(10) << timings.writeVertices / frames << std::endl
+        << std::left << std::setw(32) << "ParticleSorter::Sort" << std::right << std::setw(10) << timings.sort / frames
+        << std::setw(14) << timings.referenceSort / frames << std::endl;
+    std::cout << (valid ? "Results match the reference" : "Results don't match the reference") << std::endl;
+
+    return valid ? 0 : 1;
+}
@@ -0,0 +1,443 @@
+#include "BlockEncoder.h"
+
+#include <ituGL/utils/ParallelUtils.h>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <climits>
+#include <cfloat>
+#include <cassert>
+
+// Writes values of any number of bits into a block, starting from the least significant bit
+class BlockBitWriter
+{
+public:
+    BlockBitWriter(std::byte* block, int blockSize) : m_block(block), m_bitOffset(0)
+    {
+        std::memset(block, 0, blockSize);
+    }
+
+    void Write(unsigned int value, int bitCount)
+    {
+        for (int i = 0; i < bitCount; ++i, ++m_bitOffset)
+        {
+            if (value & (1u << i))
+            {
+                m_block[m_bitOffset / 8] |= std::byte(1u << (m_bitOffset % 8));
+            }
+        }
+    }
+
+private:
+    std::byte* m_block;
+    int m_bitOffset;
+};
+
+// Interpolation weights of the 4-bit indices in BC7
+static const int s_bc7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+static unsigned short PackRGB565(const float color[4])
+{
+    unsigned int r = static_cast<unsigned int>(std::clamp(color[0], 0.0f, 255.0f) * 31.0f / 255.0f + 0.5f);
+    unsigned int g = static_cast<unsigned int>(std::clamp(color[1], 0.0f, 255.0f) * 63.0f / 255.0f + 0.5f);
+    unsigned int b = static_cast<unsigned int>(std::clamp(color[2], 0.0f, 255.0f) * 31.0f / 255.0f + 0.5f);
+    return static_cast<unsigned short>((r << 11) | (g << 5) | b);
+}
+
+static void UnpackRGB565(unsigned short packed, int color[3])
+{
+    int r = (packed >> 11) & 31;
+    int g = (packed >> 5) & 63;
+    int b = packed & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+void BlockEncoder::EncodeImage(std::span<const unsigned char> pixels, int width, int height,
+    TextureObject::InternalFormat internalFormat, std::span<std::byte> blocks, unsigned int threadCount)
+{
+    int blockSize = TextureObject::GetBlockSize(internalFormat);
+    int blockCountX = (width + 3) / 4;
+    int blockCountY = (height + 3) / 4;
+    assert(pixels.size() == static_cast<size_t>(width) * height * 4);
+    assert(blocks.size() == TextureObject::GetCompressedImageSize(internalFormat, width, height));
+
+    // Each thread takes the next row of blocks until all of them are done
+    ParallelUtils::For(blockCountY, [&](unsigned int blockY)
+        {
+            unsigned char blockPixels[64];
+            for (int blockX = 0; blockX < blockCountX; ++blockX)
+            {
+                // Partial blocks at the borders repeat the last row and column
+                for (int y = 0; y < 4; ++y)
+                {
+                    int pixelY = std::min(static_cast<int>(blockY) * 4 + y, height - 1);
+                    for (int x = 0; x < 4; ++x)
+                    {
+                        int pixelX = std::min(blockX * 4 + x, width - 1);
+                        std::memcpy(&blockPixels[(y * 4 + x) * 4], &pixels[(static_cast<size_t>(pixelY) * width + pixelX) * 4], 4);
+                    }
+                }
+                std::byte* block = &blocks[(static_cast<size_t>(blockY) * blockCountX + blockX) * blockSize];
+                EncodeBlock(blockPixels, internalFormat, block);
+            }
+        }, threadCount);
+}
+
+void BlockEncoder::EncodeBlock(const unsigned char pixels[64], TextureObject::InternalFormat internalFormat, std::byte* block)
+{
+    switch (internalFormat)
+    {
+    case TextureObject::InternalFormatBC1:
+    case TextureObject::InternalFormatBC1SRGB:
+        EncodeBC1(pixels, block);
+        break;
+    case TextureObject::InternalFormatBC3:
+    case TextureObject::InternalFormatBC3SRGB:
+        EncodeBC3(pixels, block);
+        break;
+    case TextureObject::InternalFormatBC4:
+        EncodeBC4(pixels, block);
+        break;
+    case TextureObject::InternalFormatBC5:
+        EncodeBC5(pixels, block);
+        break;
+    case TextureObject::InternalFormatBC7:
+    case TextureObject::InternalFormatBC7SRGB:
+        EncodeBC7(pixels, block);
+        break;
+    default:
+        assert(false);
+        break;
+    }
+}
+
+void BlockEncoder::EncodeBC1(const unsigned char pixels[64], std::byte block[8])
+{
+    float endpoint0[4], endpoint1[4];
+    FindEndpoints(pixels, 3, endpoint0, endpoint1);
+
+    // The first color must be greater to use the 4 color mode
+    unsigned short color0 = PackRGB565(endpoint1);
+    unsigned short color1 = PackRGB565(endpoint0);
+    if (color0 < color1)
+    {
+        std::swap(color0, color1);
+    }
+
+    unsigned int indices = 0;
+    if (color0 != color1)
+    {
+        int palette[4][3];
+        UnpackRGB565(color0, palette[0]);
+        UnpackRGB565(color1, palette[1]);
+        for (int c = 0; c < 3; ++c)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+
+        for (int i = 0; i < 16; ++i)
+        {
+            int bestIndex = 0;
+            int bestError = INT_MAX;
+            for (int index = 0; index < 4; ++index)
+            {
+                int error = 0;
+                for (int c = 0; c < 3; ++c)
+                {
+                    int difference = pixels[i * 4 + c] - palette[index][c];
+                    error += difference * difference;
+                }
+                if (error < bestError)
+                {
+                    bestError = error;
+                    bestIndex = index;
+                }
+            }
+            indices |= bestIndex << (i * 2);
+        }
+    }
+
+    BlockBitWriter writer(block, 8);
+    writer.Write(color0, 16);
+    writer.Write(color1, 16);
+    writer.Write(indices, 32);
+}
+
+void BlockEncoder::EncodeBC3(const unsigned char pixels[64], std::byte block[16])
+{
+    EncodeChannelBlock(pixels, 3, block);
+    EncodeBC1(pixels, block + 8);
+}
+
+void BlockEncoder::EncodeBC4(const unsigned char pixels[64], std::byte block[8])
+{
+    EncodeChannelBlock(pixels, 0, block);
+}
+
+void BlockEncoder::EncodeBC5(const unsigned char pixels[64], std::byte block[16])
+{
+    EncodeChannelBlock(pixels, 0, block);
+    EncodeChannelBlock(pixels, 1, block + 8);
+}
+
+void BlockEncoder::EncodeBC7(const unsigned char pixels[64], std::byte block[16])
+{
+    // Quantize the endpoints to 7 bits, choosing the p-bit that gets closer to the original value
+    auto QuantizeEndpoint = [](const float endpoint[4], unsigned int quantized[4], unsigned int& pBit)
+    {
+        // The first p-bit is always taken, so the outputs are written even if the errors can't be compared
+        float bestError = FLT_MAX;
+        for (unsigned int p = 0; p < 2; ++p)
+        {
+            float error = 0.0f;
+            unsigned int values[4];
+            for (int c = 0; c < 4; ++c)
+            {
+                float value = std::clamp(endpoint[c], 0.0f, 255.0f);
+                values[c] = static_cast<unsigned int>(std::clamp(std::round((value - p) * 0.5f), 0.0f, 127.0f));
+                float difference = static_cast<float>((values[c] << 1) | p) - value;
+                error += difference * difference;
+            }
+            if (p == 0 || error < bestError)
+            {
+                bestError = error;
+                pBit = p;
+                std::copy(values, values + 4, quantized);
+            }
+        }
+    };
+
+    // Find the closest palette entry to each pixel, returns the total error
+    auto FindIndices = [pixels](const unsigned int quantized[2][4], const unsigned int pBits[2], int indices[16])
+    {
+        int palette[16][4];
+        for (int c = 0; c < 4; ++c)
+        {
+            int value0 = (quantized[0][c] << 1) | pBits[0];
+            int value1 = (quantized[1][c] << 1) | pBits[1];
+            for (int index = 0; index < 16; ++index)
+            {
+                palette[index][c] = ((64 - s_bc7Weights[index]) * value0 + s_bc7Weights[index] * value1 + 32) >> 6;
+            }
+        }
+
+        int totalError = 0;
+        for (int i = 0; i < 16; ++i)
+        {
+            int bestError = INT_MAX;
+            for (int index = 0; index < 16; ++index)
+            {
+                int error = 0;
+                for (int c = 0; c < 4; ++c)
+                {
+                    int difference = pixels[i * 4 + c] - palette[index][c];
+                    error += difference * difference;
+                }
+                if (error < bestError)
+                {
+                    bestError = error;
+                    indices[i] = index;
+                }
+            }
+            totalError += bestError;
+        }
+        return totalError;
+    };
+
+    float endpoints[2][4];
+    FindEndpoints(pixels, 4, endpoints[0], endpoints[1]);
+
+    unsigned int quantized[2][4] = {}, pBits[2] = {};
+    QuantizeEndpoint(endpoints[0], quantized[0], pBits[0]);
+    QuantizeEndpoint(endpoints[1], quantized[1], pBits[1]);
+    int indices[16];
+    int error = FindIndices(quantized, pBits, indices);
+
+    // One least squares iteration, kept only if it reduces the error
+    float weights[16];
+    for (int i = 0; i < 16; ++i)
+    {
+        weights[i] = s_bc7Weights[indices[i]] / 64.0f;
+    }
+    if (RefineEndpoints(pixels, 4, weights, endpoints[0], endpoints[1]))
+    {
+        unsigned int refinedQuantized[2][4] = {}, refinedPBits[2] = {};
+        QuantizeEndpoint(endpoints[0], refinedQuantized[0], refinedPBits[0]);
+        QuantizeEndpoint(endpoints[1], refinedQuantized[1], refinedPBits[1]);
+        int refinedIndices[16];
+        int refinedError = FindIndices(refinedQuantized, refinedPBits, refinedIndices);
+        if (refinedError < error)
+        {
+            std::memcpy(quantized, refinedQuantized, sizeof(quantized));
+            std::memcpy(pBits, refinedPBits, sizeof(pBits));
+            std::memcpy(indices, refinedIndices, sizeof(indices));
+        }
+    }
+
+    // The most significant bit of the first index is implicit 0. Swap the endpoints if needed
+    if (indices[0] & 8)
+    {
+        std::swap(quantized[0], quantized[1]);
+        std::swap(pBits[0], pBits[1]);
+        for (int i = 0; i < 16; ++i)
+        {
+            indices[i] = 15 - indices[i];
+        }
+    }
+
+    BlockBitWriter writer(block, 16);
+    writer.Write(1u << 6, 7);
+    for (int c = 0; c < 4; ++c)
+    {
+        writer.Write(quantized[0][c], 7);
+        writer.Write(quantized[1][c], 7);
+    }
+    writer.Write(pBits[0], 1);
+    writer.Write(pBits[1], 1);
+    writer.Write(indices[0], 3);
+    for (int i = 1; i < 16; ++i)
+    {
+        writer.Write(indices[i], 4);
+    }
+}
+
+void BlockEncoder::EncodeChannelBlock(const unsigned char pixels[64], int channel, std::byte block[8])
+{
+    int maxValue = 0, minValue = 255;
+    for (int i = 0; i < 16; ++i)
+    {
+        maxValue = std::max<int>(maxValue, pixels[i * 4 + channel]);
+        minValue = std::min<int>(minValue, pixels[i * 4 + channel]);
+    }
+
+    // With the first value greater, the 6 values in between are interpolated
+    unsigned long long indices = 0;
+    if (maxValue != minValue)
+    {
+        int range = maxValue - minValue;
+        for (int i = 0; i < 16; ++i)
+        {
+            // Steps from the first value: 0 is the first value, 7 is the second value
+            int step = ((maxValue - pixels[i * 4 + channel]) * 7 + range / 2) / range;
+            unsigned long long index = step == 0 ? 0 : (step == 7 ? 1 : step + 1);
+            indices |= index << (i * 3);
+        }
+    }
+
+    BlockBitWriter writer(block, 8);
+    writer.Write(maxValue, 8);
+    writer.Write(minValue, 8);
+    writer.Write(static_cast<unsigned int>(indices), 24);
+    writer.Write(static_cast<unsigned int>(indices >> 24), 24);
+}
+
+void BlockEncoder::FindEndpoints(const unsigned char pixels[64], int channelCount, float endpoint0[4], float endpoint1[4])
+{
+    float mean[4] = {};
+    for (int i = 0; i < 16; ++i)
+    {
+        for (int c = 0; c < channelCount; ++c)
+        {
+            mean[c] += pixels[i * 4 + c] / 16.0f;
+        }
+    }
+
+    float covariance[4][4] = {};
+    for (int i = 0; i < 16; ++i)
+    {
+        for (int c0 = 0; c0 < channelCount; ++c0)
+        {
+            for (int c1 = 0; c1 < channelCount; ++c1)
+            {
+                covariance[c0][c1] += (pixels[i * 4 + c0] - mean[c0]) * (pixels[i * 4 + c1] - mean[c1]);
+            }
+        }
+    }
+
+    // Power iteration to find the principal axis
+    float axis[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    for (int iteration = 0; iteration < 8; ++iteration)
+    {
+        float newAxis[4] = {};
+        float length = 0.0f;
+        for (int c0 = 0; c0 < channelCount; ++c0)
+        {
+            for (int c1 = 0; c1 < channelCount; ++c1)
+            {
+                newAxis[c0] += covariance[c0][c1] * axis[c1];
+            }
+            length = std::max(length, std::abs(newAxis[c0]));
+        }
+        if (length <= 0.0f)
+        {
+            // All the pixels are the same
+            break;
+        }
+        for (int c = 0; c < channelCount; ++c)
+        {
+            axis[c] = newAxis[c] / length;
+        }
+    }
+
+    // The endpoints are the extreme projections along the axis
+    float axisLengthSquared = 0.0f;
+    for (int c = 0; c < channelCount; ++c)
+    {
+        axisLengthSquared += axis[c] * axis[c];
+    }
+    float minProjection = 0.0f, maxProjection = 0.0f;
+    for (int i = 0; i < 16; ++i)
+    {
+        float projection = 0.0f;
+        for (int c = 0; c < channelCount; ++c)
+        {
+            projection += (pixels[i * 4 + c] - mean[c]) * axis[c];
+        }
+        projection /= axisLengthSquared;
+        minProjection = std::min(minProjection, projection);
+        maxProjection = std::max(maxProjection, projection);
+    }
+
+    for (int c = 0; c < 4; ++c)
+    {
+        endpoint0[c] = c < channelCount ? std::clamp(mean[c] + axis[c] * minProjection, 0.0f, 255.0f) : 255.0f;
+        endpoint1[c] = c < channelCount ? std::clamp(mean[c] + axis[c] * maxProjection, 0.0f, 255.0f) : 255.0f;
+    }
+}
+
+bool BlockEncoder::RefineEndpoints(const unsigned char pixels[64], int channelCount, const float weights[16], float endpoint0[4], float endpoint1[4])
+{
+    float a = 0.0f, b = 0.0f, c = 0.0f;
+    float sum0[4] = {}, sum1[4] = {};
+    for (int i = 0; i < 16; ++i)
+    {
+        float weight1 = weights[i];
+        float weight0 = 1.0f - weight1;
+        a += weight0 * weight0;
+        b += weight0 * weight1;
+        c += weight1 * weight1;
+        for (int channel = 0; channel < channelCount; ++channel)
+        {
+            sum0[channel] += weight0 * pixels[i * 4 + channel];
+            sum1[channel] += weight1 * pixels[i * 4 + channel];
+        }
+    }
+
+    float determinant = a * c - b * b;
+    if (std::abs(determinant) < 1e-6f)
+    {
+        // All the pixels use the same weight
+        return false;
+    }
+
+    for (int channel = 0; channel < channelCount; ++channel)
+    {
+        endpoint0[channel] = std::clamp((c * sum0[channel] - b * sum1[channel]) / determinant, 0.0f, 255.0f);
+        endpoint1[channel] = std::clamp((a * sum1[channel] - b * sum0[channel]) / determinant, 0.0f, 255.0f);
+    }
+    return true;
+}
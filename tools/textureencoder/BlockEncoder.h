@@ -0,0 +1,43 @@
+#pragma once
+
+#include <ituGL/texture/TextureObject.h>
+#include <span>
+#include <cstddef>
+
+// CPU encoder for the BCn block compression formats
+// Each block is 4x4 pixels, with RGBA8 values in row-major order
+class BlockEncoder
+{
+public:
+    // Encode a whole RGBA8 image in the block compressed format, splitting the rows of blocks between threads
+    static void EncodeImage(std::span<const unsigned char> pixels, int width, int height,
+        TextureObject::InternalFormat internalFormat, std::span<std::byte> blocks, unsigned int threadCount);
+
+    // Encode a single block in the block compressed format
+    static void EncodeBlock(const unsigned char pixels[64], TextureObject::InternalFormat internalFormat, std::byte* block);
+
+    // RGB with 2 colors in 5:6:5 and 2-bit indices
+    static void EncodeBC1(const unsigned char pixels[64], std::byte block[8]);
+
+    // BC1 for RGB, plus an alpha channel encoded like BC4
+    static void EncodeBC3(const unsigned char pixels[64], std::byte block[16]);
+
+    // Single channel (red) with 2 values and 3-bit indices
+    static void EncodeBC4(const unsigned char pixels[64], std::byte block[8]);
+
+    // Two channels (red and green), each one encoded like BC4
+    static void EncodeBC5(const unsigned char pixels[64], std::byte block[16]);
+
+    // RGBA using mode 6: a single subset with 7-bit endpoints, a p-bit and 4-bit indices
+    static void EncodeBC7(const unsigned char pixels[64], std::byte block[16]);
+
+private:
+    // Encode one channel of the block with 8 interpolated values
+    static void EncodeChannelBlock(const unsigned char pixels[64], int channel, std::byte block[8]);
+
+    // Find the endpoints of the line that best fits the pixels, along their principal axis
+    static void FindEndpoints(const unsigned char pixels[64], int channelCount, float endpoint0[4], float endpoint1[4]);
+
+    // Least squares fit of the endpoints, given the interpolation weight of each pixel
+    static bool RefineEndpoints(const unsigned char pixels[64], int channelCount, const float weights[16], float endpoint0[4], float endpoint1[4]);
+};
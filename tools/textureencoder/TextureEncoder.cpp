@@ -0,0 +1,139 @@
+#include "TextureEncoder.h"
+
+#include "BlockEncoder.h"
+#include <ituGL/asset/TextureLoader.h>
+#include <ituGL/asset/Texture2DLoader.h>
+#include <ituGL/asset/DDSFile.h>
+#include <ituGL/texture/MipmapGenerator.h>
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <filesystem>
+#include <iostream>
+#include <algorithm>
+#include <array>
+
+TextureEncoder::TextureEncoder(unsigned int threadCount) : m_threadCount(threadCount), m_force(false)
+{
+}
+
+void TextureEncoder::AddTexture(const std::string& path, Usage usage)
+{
+    // The same texture can be used by several materials
+    auto it = std::find_if(m_textures.begin(), m_textures.end(), [&path](const TextureEntry& texture) { return texture.path == path; });
+    if (it == m_textures.end())
+    {
+        m_textures.push_back(TextureEntry{ path, usage });
+    }
+}
+
+bool TextureEncoder::AddModelTextures(const char* path)
+{
+    // Only the materials are needed, no post-processing
+    Assimp::Importer importer;
+    const aiScene* scene = importer.ReadFile(path, 0);
+    if (!scene)
+    {
+        std::cout << "Failed to read model " << path << std::endl;
+        return false;
+    }
+
+    // Texture paths are relative to the model, same as in ModelLoader
+    std::string baseFolder = path;
+    baseFolder.resize(baseFolder.rfind('/') + 1);
+
+    const std::array<std::pair<aiTextureType, Usage>, 3> textureTypes = {
+        std::make_pair(aiTextureType_DIFFUSE, Usage::Color),
+        std::make_pair(aiTextureType_NORMALS, Usage::Normal),
+        std::make_pair(aiTextureType_SHININESS, Usage::Specular),
+    };
+    for (unsigned int materialIndex = 0; materialIndex < scene->mNumMaterials; ++materialIndex)
+    {
+        const aiMaterial& material = *scene->mMaterials[materialIndex];
+        for (auto& textureType : textureTypes)
+        {
+            aiString texturePath;
+            if (material.GetTextureCount(textureType.first) > 0 &&
+                material.GetTexture(textureType.first, 0, &texturePath) == aiReturn_SUCCESS)
+            {
+                AddTexture(baseFolder + texturePath.C_Str(), textureType.second);
+            }
+        }
+    }
+    return true;
+}
+
+int TextureEncoder::Run() const
+{
+    int failedCount = 0;
+    for (const TextureEntry& texture : m_textures)
+    {
+        // Skip the textures that didn't change since they were encoded
+        std::string compressedPath = Texture2DLoader::GetCompressedPath(texture.path.c_str());
+        std::error_code errorCode;
+        if (!m_force && std::filesystem::exists(compressedPath, errorCode) &&
+            std::filesystem::last_write_time(compressedPath, errorCode) >= std::filesystem::last_write_time(texture.path, errorCode))
+        {
+            std::cout << "Up to date: " << compressedPath << std::endl;
+            continue;
+        }
+
+        if (Encode(texture))
+        {
+            std::cout << "Encoded: " << compressedPath << std::endl;
+        }
+        else
+        {
+            std::cout << "Failed to encode " << texture.path << std::endl;
+            failedCount++;
+        }
+    }
+    return failedCount;
+}
+
+bool TextureEncoder::Encode(const TextureEntry& texture) const
+{
+    // Decode the source image to RGBA8
+    int width, height;
+    Data::Type dataType;
+    std::span<const std::byte> data = TextureLoaderUtils::LoadTexture2DData(texture.path.c_str(), width, height, dataType,
+        TextureObject::FormatRGBA, TextureObject::InternalFormatRGBA8, false);
+    if (data.empty())
+    {
+        return false;
+    }
+
+    // Generate the mip chain before encoding, filtering in linear space
+    MipmapGenerator generator;
+    generator.SetFilter(MipmapGenerator::Filter::Kaiser);
+    generator.SetSRGB(texture.usage != Usage::Normal);
+    generator.SetNormalMap(texture.usage == Usage::Normal);
+    generator.SetThreadCount(m_threadCount);
+    std::vector<MipmapGenerator::Level> levels = generator.Generate(data, width, height, 4, dataType);
+    TextureLoaderUtils::FreeTexture2DData(data);
+
+    DDSFile ddsFile;
+    ddsFile.Reset(width, height, GetInternalFormat(texture.usage));
+    for (const MipmapGenerator::Level& level : levels)
+    {
+        std::span<std::byte> blocks = ddsFile.AddLevel();
+        std::span<const unsigned char> pixels(reinterpret_cast<const unsigned char*>(level.data.data()), level.data.size());
+        BlockEncoder::EncodeImage(pixels, level.width, level.height, ddsFile.GetInternalFormat(), blocks, m_threadCount);
+    }
+
+    return ddsFile.Save(Texture2DLoader::GetCompressedPath(texture.path.c_str()).c_str());
+}
+
+TextureObject::InternalFormat TextureEncoder::GetInternalFormat(Usage usage)
+{
+    switch (usage)
+    {
+    case Usage::Color:
+        return TextureObject::InternalFormatBC7SRGB;
+    case Usage::Normal:
+        return TextureObject::InternalFormatBC5;
+    case Usage::Specular:
+        return TextureObject::InternalFormatBC1SRGB;
+    default:
+        return TextureObject::InternalFormatInvalid;
+    }
+}
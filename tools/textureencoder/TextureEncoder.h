@@ -0,0 +1,56 @@
+#pragma once
+
+#include <ituGL/texture/TextureObject.h>
+#include <string>
+#include <vector>
+
+// Converts source images to block compressed DDS files with the full mip chain
+// The DDS file is written next to the source image, where Texture2DLoader looks for it
+class TextureEncoder
+{
+public:
+    // How the texture is used by the materials, to choose the format
+    enum class Usage
+    {
+        // sRGB BC7
+        Color,
+        // BC5, with only the X and Y components
+        Normal,
+        // sRGB BC1
+        Specular,
+    };
+
+public:
+    TextureEncoder(unsigned int threadCount);
+
+    // Encode the textures again, even if the DDS file is newer than the source image
+    inline void SetForce(bool force) { m_force = force; }
+
+    // Add a source image to be encoded
+    void AddTexture(const std::string& path, Usage usage);
+
+    // Add the textures used by the materials of a model, with the usage of each one
+    bool AddModelTextures(const char* path);
+
+    // Encode all the textures added. Returns the number of textures that failed
+    int Run() const;
+
+private:
+    struct TextureEntry
+    {
+        std::string path;
+        Usage usage;
+    };
+
+    // Encode the mip chain of a single texture
+    bool Encode(const TextureEntry& texture) const;
+
+    static TextureObject::InternalFormat GetInternalFormat(Usage usage);
+
+private:
+    std::vector<TextureEntry> m_textures;
+
+    unsigned int m_threadCount;
+
+    bool m_force;
+};
@@ -0,0 +1,78 @@
+#include "TextureEncoder.h"
+
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+// Usage: textureencoder [--force] [--threads N] [--color | --normal | --specular] files...
+// Model files (.obj, .fbx, .gltf...) add the textures of their materials, with the format chosen by the material slot
+// Image files use the format of the last --color, --normal or --specular option (--color by default)
+int main(int argc, char* argv[])
+{
+    unsigned int threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    bool force = false;
+    TextureEncoder::Usage usage = TextureEncoder::Usage::Color;
+
+    std::vector<std::string> imagePaths;
+    std::vector<TextureEncoder::Usage> imageUsages;
+    std::vector<std::string> modelPaths;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        if (argument == "--force")
+        {
+            force = true;
+        }
+        else if (argument == "--threads" && i + 1 < argc)
+        {
+            threadCount = std::max(std::stoi(argv[++i]), 1);
+        }
+        else if (argument == "--color")
+        {
+            usage = TextureEncoder::Usage::Color;
+        }
+        else if (argument == "--normal")
+        {
+            usage = TextureEncoder::Usage::Normal;
+        }
+        else if (argument == "--specular")
+        {
+            usage = TextureEncoder::Usage::Specular;
+        }
+        else
+        {
+            std::string extension = argument.substr(argument.find_last_of('.') + 1);
+            bool isModel = extension == "obj" || extension == "fbx" || extension == "gltf" || extension == "glb" || extension == "dae";
+            if (isModel)
+            {
+                modelPaths.push_back(argument);
+            }
+            else
+            {
+                imagePaths.push_back(argument);
+                imageUsages.push_back(usage);
+            }
+        }
+    }
+
+    if (imagePaths.empty() && modelPaths.empty())
+    {
+        std::cout << "Usage: textureencoder [--force] [--threads N] [--color | --normal | --specular] files..." << std::endl;
+        return 1;
+    }
+
+    TextureEncoder encoder(threadCount);
+    encoder.SetForce(force);
+    for (size_t i = 0; i < imagePaths.size(); ++i)
+    {
+        encoder.AddTexture(imagePaths[i], imageUsages[i]);
+    }
+    for (const std::string& modelPath : modelPaths)
+    {
+        encoder.AddModelTextures(modelPath.c_str());
+    }
+
+    return encoder.Run() == 0 ? 0 : 1;
+}